@@ -0,0 +1,176 @@
+#include "cipher.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+#define XTEA_DELTA UINT32_C(0x9E3779B9)
+#define XTEA_CYCLES 32
+
+static
+uint32_t load32(const uint8_t *src)
+{
+    return (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+}
+
+static
+void store32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = value >> 24;
+    dst[1] = value >> 16;
+    dst[2] = value >> 8;
+    dst[3] = value;
+}
+
+void xtea_key(uint32_t *key, const uint8_t *bytes)
+{
+    for(uint8_t i = 0; i < 4; ++i) key[i] = load32(bytes + 4 * i);
+}
+
+void xtea_encrypt(const uint32_t *key, uint8_t *block)
+{
+    uint32_t v0 = load32(block);
+    uint32_t v1 = load32(block + 4);
+    uint32_t sum = 0;
+
+    for(uint8_t i = 0; i < XTEA_CYCLES; ++i)
+    {
+        v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + key[sum & 3]);
+        sum += XTEA_DELTA;
+        v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + key[sum >> 11 & 3]);
+    }
+    store32(block, v0);
+    store32(block + 4, v1);
+}
+
+/* FIPS-197, state is column major (block byte order) */
+
+static
+const uint8_t sbox[256] PROGMEM =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B,
+    0xFE, 0xD7, 0xAB, 0x76, 0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0, 0xB7, 0xFD, 0x93, 0x26,
+    0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2,
+    0xEB, 0x27, 0xB2, 0x75, 0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84, 0x53, 0xD1, 0x00, 0xED,
+    0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F,
+    0x50, 0x3C, 0x9F, 0xA8, 0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2, 0xCD, 0x0C, 0x13, 0xEC,
+    0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14,
+    0xDE, 0x5E, 0x0B, 0xDB, 0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79, 0xE7, 0xC8, 0x37, 0x6D,
+    0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F,
+    0x4B, 0xBD, 0x8B, 0x8A, 0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E, 0xE1, 0xF8, 0x98, 0x11,
+    0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F,
+    0xB0, 0x54, 0xBB, 0x16,
+};
+
+#define SBOX(x) pgm_read_byte(sbox + (x))
+
+static
+uint8_t xtime(uint8_t x)
+{
+    return x << 1 ^ (x & 0x80 ? 0x1B : 0);
+}
+
+void aes128_key(uint8_t *round_keys, const uint8_t *bytes)
+{
+    uint8_t rcon = 0x01;
+
+    for(uint8_t i = 0; i < CIPHER_KEY_SIZE; ++i) round_keys[i] = bytes[i];
+
+    for(uint8_t i = CIPHER_KEY_SIZE; i < AES128_ROUND_KEYS_SIZE; i += 4)
+    {
+        const uint8_t *prev = round_keys + i - 4;
+        uint8_t word[4] = {prev[0], prev[1], prev[2], prev[3]};
+
+        if(!(i % CIPHER_KEY_SIZE))
+        {
+            /* RotWord, SubWord, Rcon */
+            const uint8_t first = word[0];
+
+            word[0] = SBOX(word[1]) ^ rcon;
+            word[1] = SBOX(word[2]);
+            word[2] = SBOX(word[3]);
+            word[3] = SBOX(first);
+            rcon = xtime(rcon);
+        }
+        for(uint8_t j = 0; j < 4; ++j)
+        {
+            round_keys[i + j] = round_keys[i + j - CIPHER_KEY_SIZE] ^ word[j];
+        }
+    }
+}
+
+static
+void add_round_key(uint8_t *block, const uint8_t *round_key)
+{
+    for(uint8_t i = 0; i < AES128_BLOCK_SIZE; ++i) block[i] ^= round_key[i];
+}
+
+/* SubBytes and ShiftRows (row r is rotated left by r) */
+static
+void sub_shift(uint8_t *block)
+{
+    uint8_t tmp;
+
+    for(uint8_t i = 0; i < AES128_BLOCK_SIZE; ++i) block[i] = SBOX(block[i]);
+
+    tmp = block[1];
+    block[1] = block[5];
+    block[5] = block[9];
+    block[9] = block[13];
+    block[13] = tmp;
+
+    tmp = block[2];
+    block[2] = block[10];
+    block[10] = tmp;
+    tmp = block[6];
+    block[6] = block[14];
+    block[14] = tmp;
+
+    tmp = block[15];
+    block[15] = block[11];
+    block[11] = block[7];
+    block[7] = block[3];
+    block[3] = tmp;
+}
+
+static
+void mix_columns(uint8_t *block)
+{
+    for(uint8_t i = 0; i < AES128_BLOCK_SIZE; i += 4)
+    {
+        uint8_t *col = block + i;
+        const uint8_t a0 = col[0];
+        const uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+
+        col[0] ^= all ^ xtime(col[0] ^ col[1]);
+        col[1] ^= all ^ xtime(col[1] ^ col[2]);
+        col[2] ^= all ^ xtime(col[2] ^ col[3]);
+        col[3] ^= all ^ xtime(col[3] ^ a0);
+    }
+}
+
+void aes128_encrypt(const uint8_t *round_keys, uint8_t *block)
+{
+    add_round_key(block, round_keys);
+    for(uint8_t round = 1; round < 10; ++round)
+    {
+        sub_shift(block);
+        mix_columns(block);
+        add_round_key(block, round_keys + round * AES128_BLOCK_SIZE);
+    }
+    sub_shift(block);
+    add_round_key(block, round_keys + 10 * AES128_BLOCK_SIZE);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Block ciphers for link encryption (encryption direction only, CTR mode
+ * needs no decryption).
+ *
+ * XTEA: 64b block, 128b key, 32 cycles (64 Feistel rounds), no tables,
+ * words are big endian (matches published test vectors).
+ *
+ * AES-128: 128b block, key is expanded once into 176B of round keys, S-box
+ * (256B) is in flash, byte oriented (no T-tables) to fit 8bit MCU.
+ *
+ * Plain C, same code runs on gateway (Linux). */
+
+#define CIPHER_KEY_SIZE 16
+#define XTEA_BLOCK_SIZE 8
+#define AES128_BLOCK_SIZE 16
+#define AES128_ROUND_KEYS_SIZE 176
+
+void xtea_key(uint32_t *key, const uint8_t *bytes);
+void xtea_encrypt(const uint32_t *key, uint8_t *block);
+
+void aes128_key(uint8_t *round_keys, const uint8_t *bytes);
+void aes128_encrypt(const uint8_t *round_keys, uint8_t *block);
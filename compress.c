@@ -0,0 +1,210 @@
+#include <string.h>
+
+#include "compress.h"
+
+#define WINDOW MIN(COMPRESS_LZ_WINDOW, COMPRESS_LZ_OFFSET_MAX)
+#define LEN_MIN COMPRESS_LZ_LEN_MIN
+#define LEN_MAX COMPRESS_LZ_LEN_MAX
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+static
+uint16_t zigzag(int16_t value)
+{
+    return (uint16_t)value << 1 ^ (uint16_t)(value >> 15);
+}
+
+static
+int16_t unzigzag(uint16_t value)
+{
+    return (int16_t)(value >> 1 ^ -(value & 1));
+}
+
+uint8_t *compress_delta(
+    const int16_t *begin, const int16_t *const end,
+    uint8_t stride,
+    uint8_t *out, const uint8_t *const out_end)
+{
+    for(const int16_t *curr = begin; curr != end; ++curr)
+    {
+        /* wraps around, decoder wraps back */
+        const uint16_t prev = stride && stride <= curr - begin ? curr[-stride] : 0;
+        uint16_t value = zigzag((int16_t)((uint16_t)*curr - prev));
+
+        do
+        {
+            if(out == out_end) return NULL;
+            *out++ = (value & 0x7F) | (0x7F < value ? 0x80 : 0);
+            value >>= 7;
+        } while(value);
+    }
+    return out;
+}
+
+int16_t *decompress_delta(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t stride,
+    int16_t *out, const int16_t *const out_end)
+{
+    int16_t *const out_begin = out;
+
+    while(begin != end)
+    {
+        uint16_t value = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+
+        do
+        {
+            /* 3B at most (16b) */
+            if(begin == end || 14 < shift) return NULL;
+            byte = *begin++;
+            value |= (uint16_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while(byte & 0x80);
+
+        if(out == out_end) return NULL;
+
+        const uint16_t prev = stride && stride <= out - out_begin ? out[-stride] : 0;
+
+        *out = (int16_t)(prev + (uint16_t)unzigzag(value));
+        ++out;
+    }
+    return out;
+}
+
+uint8_t *compress_lz(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end)
+{
+    const uint8_t *curr = begin;
+    uint8_t *flags = NULL;
+    uint8_t bit = 0;
+
+    while(curr != end)
+    {
+        if(!bit)
+        {
+            if(out == out_end) return NULL;
+            flags = out++;
+            *flags = 0;
+            bit = 1;
+        }
+
+        const uint8_t len_max = MIN((size_t)(end - curr), LEN_MAX);
+        const uint16_t dist = MIN((size_t)(curr - begin), WINDOW);
+        uint8_t best_len = 0;
+        uint16_t best_offset = 0;
+
+        /* nearest first, first 2 bytes are compared before full match */
+        for(uint16_t offset = 1; LEN_MIN <= len_max && offset <= dist; ++offset)
+        {
+            const uint8_t *match = curr - offset;
+
+            if(match[0] != curr[0] || match[1] != curr[1]) continue;
+
+            uint8_t len = 2;
+
+            while(len < len_max && match[len] == curr[len]) ++len;
+            if(len <= best_len) continue;
+            best_len = len;
+            best_offset = offset;
+            if(len_max == len) break;
+        }
+
+        if(LEN_MIN <= best_len)
+        {
+            const uint16_t token = (uint16_t)(best_len - LEN_MIN) << 12 | (best_offset - 1);
+
+            if(2 > out_end - out) return NULL;
+            *flags |= bit;
+            *out++ = token;
+            *out++ = token >> 8;
+            curr += best_len;
+        }
+        else
+        {
+            if(out == out_end) return NULL;
+            *out++ = *curr++;
+        }
+        bit <<= 1;
+    }
+    return out;
+}
+
+uint8_t *decompress_lz(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end)
+{
+    uint8_t *const out_begin = out;
+    uint8_t flags = 0;
+    uint8_t bit = 0;
+
+    while(begin != end)
+    {
+        if(!bit)
+        {
+            flags = *begin++;
+            bit = 1;
+            continue;
+        }
+
+        if(flags & bit)
+        {
+            if(2 > end - begin) return NULL;
+
+            const uint16_t token = begin[0] | (uint16_t)begin[1] << 8;
+            const uint16_t offset = (token & 0x0FFF) + 1;
+            uint8_t len = (token >> 12) + LEN_MIN;
+
+            begin += 2;
+            if(offset > out - out_begin || len > out_end - out) return NULL;
+            /* overlapping match repeats last offset bytes */
+            for(const uint8_t *match = out - offset; len; --len) *out++ = *match++;
+        }
+        else
+        {
+            if(out == out_end) return NULL;
+            *out++ = *begin++;
+        }
+        bit <<= 1;
+    }
+    return out;
+}
+
+uint8_t *compress_frame(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end)
+{
+    const size_t size = end - begin;
+
+    if(out == out_end) return NULL;
+
+    /* LZ output must be shorter than raw data to be used */
+    uint8_t *lz_end = compress_lz(begin, end, out + 1, out + 1 + MIN(size, (size_t)(out_end - out - 1)));
+
+    if(lz_end && (size_t)(lz_end - out - 1) < size)
+    {
+        out[0] = COMPRESS_LZ;
+        return lz_end;
+    }
+
+    if(size > (size_t)(out_end - out - 1)) return NULL;
+    out[0] = COMPRESS_RAW;
+    memcpy(out + 1, begin, size);
+    return out + 1 + size;
+}
+
+uint8_t *decompress_frame(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end)
+{
+    if(begin == end) return NULL;
+
+    const uint8_t method = *begin++;
+    const size_t size = end - begin;
+
+    if(COMPRESS_LZ == method) return decompress_lz(begin, end, out, out_end);
+    if(COMPRESS_RAW != method || size > (size_t)(out_end - out)) return NULL;
+    memcpy(out, begin, size);
+    return out + size;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Lightweight compression of messages before packetization (nRF24L01_send
+ * splits them into payloads), fewer payloads on air cost less time/energy.
+ * Plain C, same code decompresses on gateway (Linux).
+ *
+ * Delta: series of int16 samples (stride interleaved channels, i.e. records
+ * of several readings) is stored as zigzag varint (LEB128) of difference to
+ * previous sample of same channel, first sample of every channel (and
+ * every sample if stride is 0) is difference to 0. Slowly changing
+ * readings take 1B instead of 2B.
+ *
+ * LZ: LZSS, flag byte (LSb first, 1: match) precedes every 8 items, literal
+ * is 1B, match is 2B little endian: length - 3 (4b) << 12 | offset - 1
+ * (12b), lengths 3 - 18. Decoder window is its output (message), encoder
+ * needs no RAM except input/output: it searches up to COMPRESS_LZ_WINDOW
+ * bytes back (format allows 4096), cost grows with window.
+ *
+ * Frame: 1B method (COMPRESS_RAW/COMPRESS_LZ) followed by data, LZ is used
+ * only if it is shorter (incompressible data grows by 1B). */
+
+#ifndef COMPRESS_LZ_WINDOW
+#define COMPRESS_LZ_WINDOW 256
+#endif
+
+#define COMPRESS_LZ_LEN_MIN 3
+#define COMPRESS_LZ_LEN_MAX 18
+#define COMPRESS_LZ_OFFSET_MAX 4096
+
+/* worst case output size */
+#define COMPRESS_DELTA_BOUND(num) (3 * (num))
+#define COMPRESS_LZ_BOUND(size) ((size) + ((size) + 7) / 8)
+#define COMPRESS_FRAME_BOUND(size) (1 + (size))
+
+#define COMPRESS_RAW UINT8_C(0)
+#define COMPRESS_LZ UINT8_C(1)
+
+/* all functions return end of output or NULL if output does not fit
+ * (decoders also if input is malformed) */
+
+uint8_t *compress_delta(
+    const int16_t *begin, const int16_t *const end,
+    uint8_t stride,
+    uint8_t *out, const uint8_t *const out_end);
+
+int16_t *decompress_delta(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t stride,
+    int16_t *out, const int16_t *const out_end);
+
+uint8_t *compress_lz(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end);
+
+uint8_t *decompress_lz(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end);
+
+uint8_t *compress_frame(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end);
+
+uint8_t *decompress_frame(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *out, const uint8_t *const out_end);
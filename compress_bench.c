@@ -0,0 +1,228 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "compress.h"
+#include "nRF24L01.h"
+#include "xorshift.h"
+
+/* host benchmark of compression ratio and speed on typical messages
+ *
+ * sensor: records of 4 slowly changing int16 readings (temperature,
+ * humidity, pressure, battery) sent as raw little endian bytes, delta
+ * (stride 4) and both through LZ frame, log: text lines of same readings,
+ * random: incompressible bytes. Ratio, payloads (nRF24L01_send() payloads
+ * needed, 31B of data each) and cycles per byte are taken against original
+ * message, delta_lz covers both stages. Stored: LZ did not shrink data,
+ * frame carries it raw (+1B). Cycles are TSC cycles on x86 (ns elsewhere),
+ * roundtrip is verified.
+ *
+ * output: JSON line per data set and method */
+
+#define PAYLOAD_DATA_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define CHANNEL_NUM 4
+#define RECORD_MAX_NUM 64
+#define SIZE_MAX_ (RECORD_MAX_NUM * CHANNEL_NUM * 2)
+#define ITERATIONS 2000
+
+static uint32_t seed_ = 1;
+
+static
+uint32_t rnd(void)
+{
+    return xorshift32(&seed_);
+}
+
+static
+uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/* random walk around base */
+static
+void readings(int16_t *sample, uint8_t record_num)
+{
+    static const int16_t base[CHANNEL_NUM] = {2150, 4500, 10132, 3300};
+    static const uint8_t step[CHANNEL_NUM] = {3, 10, 2, 1};
+
+    for(uint8_t i = 0; i < record_num; ++i)
+    {
+        for(uint8_t j = 0; j < CHANNEL_NUM; ++j)
+        {
+            const int16_t prev = i ? sample[(i - 1) * CHANNEL_NUM + j] : base[j];
+
+            sample[i * CHANNEL_NUM + j] = prev + (int16_t)(rnd() % (2 * step[j] + 1)) - step[j];
+        }
+    }
+}
+
+static
+void report(
+    const char *set, const char *method,
+    size_t size, size_t out_size, uint8_t stored,
+    uint64_t encode, uint64_t decode)
+{
+    printf(
+        "{\"set\":\"%s\",\"method\":\"%s\",\"size\":%zu,\"out_size\":%zu"
+        ",\"ratio\":%.2f,\"payloads\":%zu,\"out_payloads\":%zu,\"stored\":%u"
+        ",\"encode_cpb\":%.1f,\"decode_cpb\":%.1f}\n",
+        set, method, size, out_size,
+        (double)size / out_size,
+        (size + PAYLOAD_DATA_SIZE - 1) / PAYLOAD_DATA_SIZE,
+        (out_size + PAYLOAD_DATA_SIZE - 1) / PAYLOAD_DATA_SIZE,
+        stored,
+        (double)encode / ITERATIONS / size,
+        (double)decode / ITERATIONS / size);
+}
+
+static
+void fail(const char *set, const char *method)
+{
+    fprintf(stderr, "%s/%s: roundtrip failed\n", set, method);
+    exit(EXIT_FAILURE);
+}
+
+static
+void bench_frame(const char *set, const char *method, const uint8_t *data, size_t size)
+{
+    uint8_t out[COMPRESS_FRAME_BOUND(SIZE_MAX_ * 2)];
+    uint8_t back[SIZE_MAX_ * 2];
+    uint8_t *out_end = NULL;
+    uint8_t *back_end = NULL;
+
+    uint64_t begin = cycles();
+
+    for(uint32_t i = 0; i < ITERATIONS; ++i) out_end = compress_frame(data, data + size, out, out + sizeof(out));
+
+    const uint64_t encode = cycles() - begin;
+
+    if(!out_end) fail(set, method);
+    begin = cycles();
+    for(uint32_t i = 0; i < ITERATIONS; ++i) back_end = decompress_frame(out, out_end, back, back + sizeof(back));
+
+    const uint64_t decode = cycles() - begin;
+
+    if(!back_end || (size_t)(back_end - back) != size || memcmp(back, data, size)) fail(set, method);
+    report(set, method, size, out_end - out, COMPRESS_RAW == out[0], encode, decode);
+}
+
+static
+void bench_sensor(uint8_t record_num)
+{
+    int16_t sample[RECORD_MAX_NUM * CHANNEL_NUM];
+    int16_t back[RECORD_MAX_NUM * CHANNEL_NUM];
+    uint8_t raw[SIZE_MAX_];
+    uint8_t delta[COMPRESS_DELTA_BOUND(RECORD_MAX_NUM * CHANNEL_NUM)];
+    uint8_t frame[COMPRESS_FRAME_BOUND(sizeof(delta))];
+    const uint16_t num = record_num * CHANNEL_NUM;
+    uint8_t *delta_end = NULL;
+    uint8_t *frame_end = NULL;
+    int16_t *back_end = NULL;
+    char set[32];
+
+    snprintf(set, sizeof(set), "sensor_%u", record_num);
+    readings(sample, record_num);
+    for(uint16_t i = 0; i < num; ++i)
+    {
+        raw[2 * i] = sample[i];
+        raw[2 * i + 1] = (uint16_t)sample[i] >> 8;
+    }
+
+    uint64_t begin = cycles();
+
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        delta_end = compress_delta(sample, sample + num, CHANNEL_NUM, delta, delta + sizeof(delta));
+    }
+
+    const uint64_t encode = cycles() - begin;
+
+    if(!delta_end) fail(set, "delta");
+    begin = cycles();
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        back_end = decompress_delta(delta, delta_end, CHANNEL_NUM, back, back + num);
+    }
+
+    const uint64_t decode = cycles() - begin;
+
+    if(back + num != back_end || memcmp(back, sample, num * sizeof(int16_t))) fail(set, "delta");
+    report(set, "delta", 2 * num, delta_end - delta, 0, encode, decode);
+    bench_frame(set, "lz", raw, 2 * num);
+
+    /* delta output framed, stored if LZ does not shrink it */
+    begin = cycles();
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        delta_end = compress_delta(sample, sample + num, CHANNEL_NUM, delta, delta + sizeof(delta));
+        frame_end = compress_frame(delta, delta_end, frame, frame + sizeof(frame));
+    }
+
+    const uint64_t encode_lz = cycles() - begin;
+
+    if(!frame_end) fail(set, "delta_lz");
+    begin = cycles();
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        delta_end = decompress_frame(frame, frame_end, delta, delta + sizeof(delta));
+        back_end = delta_end ? decompress_delta(delta, delta_end, CHANNEL_NUM, back, back + num) : NULL;
+    }
+
+    const uint64_t decode_lz = cycles() - begin;
+
+    if(back + num != back_end || memcmp(back, sample, num * sizeof(int16_t))) fail(set, "delta_lz");
+    report(set, "delta_lz", 2 * num, frame_end - frame, COMPRESS_RAW == frame[0], encode_lz, decode_lz);
+}
+
+static
+void bench_log(uint8_t line_num)
+{
+    char text[SIZE_MAX_ * 2];
+    int16_t sample[RECORD_MAX_NUM * CHANNEL_NUM];
+    size_t size = 0;
+    char set[32];
+
+    snprintf(set, sizeof(set), "log_%u", line_num);
+    readings(sample, line_num);
+    for(uint8_t i = 0; i < line_num; ++i)
+    {
+        const int16_t *s = sample + i * CHANNEL_NUM;
+
+        size += snprintf(
+            text + size, sizeof(text) - size,
+            "t=%d.%02d h=%d.%02d p=%d.%d b=%d\n",
+            s[0] / 100, s[0] % 100, s[1] / 100, s[1] % 100, s[2] / 10, s[2] % 10, s[3]);
+    }
+    bench_frame(set, "lz", (const uint8_t *)text, size);
+}
+
+static
+void bench_random(size_t size)
+{
+    uint8_t data[SIZE_MAX_];
+    char set[32];
+
+    snprintf(set, sizeof(set), "random_%zu", size);
+    for(size_t i = 0; i < size; ++i) data[i] = rnd();
+    bench_frame(set, "lz", data, size);
+}
+
+int main(void)
+{
+    bench_sensor(8);
+    bench_sensor(32);
+    bench_log(4);
+    bench_log(12);
+    bench_random(128);
+    return EXIT_SUCCESS;
+}
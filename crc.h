@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, MSb first)
+ * CRC-32/ISO-HDLC (poly 0x04C11DB7, init/xorout 0xFFFFFFFF, LSb first)
+ *
+ * Implementation is selected at compile time (trade flash for speed):
+ * CRC_IMPL_BITWISE - no table
+ * CRC_IMPL_TABLE4 - 16 entry (nibble) tables in flash, 32B + 64B
+ * CRC_IMPL_TABLE8 - 256 entry tables in flash, 512B + 1KiB
+ *
+ * Define CRC_IMPL_ALL to build all implementations (i.e. for benchmarks). */
+
+#define CRC_IMPL_BITWISE 0
+#define CRC_IMPL_TABLE4 1
+#define CRC_IMPL_TABLE8 2
+
+#ifndef CRC_IMPL
+#define CRC_IMPL CRC_IMPL_TABLE4
+#endif
+
+#define CRC16_INIT UINT16_C(0xFFFF)
+#define CRC32_INIT UINT32_C(0xFFFFFFFF)
+
+uint16_t crc16_update_bitwise(uint16_t, const uint8_t *begin, const uint8_t *const end);
+uint16_t crc16_update_table4(uint16_t, const uint8_t *begin, const uint8_t *const end);
+uint16_t crc16_update_table8(uint16_t, const uint8_t *begin, const uint8_t *const end);
+
+uint32_t crc32_update_bitwise(uint32_t, const uint8_t *begin, const uint8_t *const end);
+uint32_t crc32_update_table4(uint32_t, const uint8_t *begin, const uint8_t *const end);
+uint32_t crc32_update_table8(uint32_t, const uint8_t *begin, const uint8_t *const end);
+
+#if CRC_IMPL_BITWISE == CRC_IMPL
+#define crc16_update crc16_update_bitwise
+#define crc32_update crc32_update_bitwise
+#elif CRC_IMPL_TABLE4 == CRC_IMPL
+#define crc16_update crc16_update_table4
+#define crc32_update crc32_update_table4
+#elif CRC_IMPL_TABLE8 == CRC_IMPL
+#define crc16_update crc16_update_table8
+#define crc32_update crc32_update_table8
+#else
+#error "unsupported CRC_IMPL"
+#endif
+
+uint16_t crc16(const uint8_t *begin, const uint8_t *const end);
+uint32_t crc32(const uint8_t *begin, const uint8_t *const end);
+
+/* End-to-end integrity of (reassembled) messages.
+ * append() stores CRC right after message (2B/4B of room is required)
+ * and returns new end, check() returns end of message without CRC
+ * or NULL if CRC does not match. */
+uint8_t *crc16_append(uint8_t *begin, uint8_t *end);
+uint8_t *crc16_check(uint8_t *begin, uint8_t *end);
+uint8_t *crc32_append(uint8_t *begin, uint8_t *end);
+uint8_t *crc32_check(uint8_t *begin, uint8_t *end);
@@ -0,0 +1,72 @@
+#include <stdio.h>
+
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+#include <drv/tmr1.h>
+#include <drv/usart0.h>
+#include <drv/watchdog.h>
+
+#include <bootloader/fixed.h>
+
+#include "crc.h"
+
+/* Timer1 is clocked directly from CPU clock and used as cycle counter,
+ * DATA_SIZE is chosen so that slowest implementation fits in 16bits */
+#define DATA_SIZE 128
+
+static
+uint8_t data[DATA_SIZE];
+
+volatile uint32_t sink;
+
+#define MEASURE(name, expr) \
+    { \
+        TMR1_WR16_CNTR(0); \
+        TMR1_CLK_DIV_1(); \
+        sink = (expr); \
+        TMR1_CLK_DISABLE(); \
+        report(name, TCNT1); \
+    }
+
+static
+void report(const char *name, uint16_t cycles)
+{
+    /* cycles per byte with 2 decimal places */
+    const uint32_t cpb = (uint32_t)cycles * 100 / DATA_SIZE;
+    char str[48];
+
+    snprintf(
+        str, sizeof(str),
+        "%s %" PRIu16 " %" PRIu32 ".%02" PRIu32 "\n",
+        name, cycles, cpb / 100, cpb % 100);
+    usart0_send_str(str);
+}
+
+__attribute__((noreturn))
+void main(void)
+{
+    /* watchdog is enabled by bootloader whenever it "jumps" to app code */
+    fixed__.app_reset_code.curr = RESET_CODE_APP_IDLE;
+    watchdog_disable();
+
+    USART0_BR(CALC_BR(CPU_CLK, 19200));
+    USART0_PARITY_EVEN();
+    USART0_TX_ENABLE();
+
+    for(uint8_t i = 0; i < DATA_SIZE; ++i) data[i] = i * 7 + 3;
+
+    const uint8_t *const begin = data;
+    const uint8_t *const end = data + DATA_SIZE;
+
+    usart0_send_str("# impl cycles/128B cycles/B\n");
+    MEASURE("crc16_bitwise", crc16_update_bitwise(CRC16_INIT, begin, end));
+    MEASURE("crc16_table4", crc16_update_table4(CRC16_INIT, begin, end));
+    MEASURE("crc16_table8", crc16_update_table8(CRC16_INIT, begin, end));
+    MEASURE("crc32_bitwise", crc32_update_bitwise(CRC32_INIT, begin, end));
+    MEASURE("crc32_table4", crc32_update_table4(CRC32_INIT, begin, end));
+    MEASURE("crc32_table8", crc32_update_table8(CRC32_INIT, begin, end));
+
+    sleep_enable();
+    for(;;) sleep_cpu();
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+#include <drv/tmr1.h>
+#include <drv/usart0.h>
+#include <drv/watchdog.h>
+
+#include <bootloader/fixed.h>
+
+#include "nRF24L01_crypt.h"
+
+/* Timer1 is clocked directly from CPU clock and used as cycle counter,
+ * slowest operation (cold seal, keystream computed on the spot) fits in
+ * 16bits. Hot seal/open use keystream precomputed by idle(), both ends of
+ * link are local (radio is not used). */
+
+static
+nRF24L01_crypt_t tx;
+
+static
+nRF24L01_crypt_t rx;
+
+static
+uint8_t data[nRF24L01_CRYPT_DATA_SIZE];
+
+static
+uint8_t frame[nRF24L01_CRYPT_FRAME_SIZE];
+
+static
+uint8_t block[AES128_BLOCK_SIZE];
+
+static
+const uint8_t key[CIPHER_KEY_SIZE] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+};
+
+volatile uintptr_t sink;
+
+#define MEASURE(name, expr) \
+    { \
+        TMR1_WR16_CNTR(0); \
+        TMR1_CLK_DIV_1(); \
+        sink = (uintptr_t)(expr); \
+        TMR1_CLK_DISABLE(); \
+        report(name, TCNT1); \
+    }
+
+static
+void report(const char *name, uint16_t cycles)
+{
+    char str[48];
+
+    snprintf(str, sizeof(str), "%s %" PRIu16 "\n", name, cycles);
+    usart0_send_str(str);
+}
+
+static
+uint8_t precompute(nRF24L01_crypt_t *crypt)
+{
+    while(nRF24L01_crypt_idle(crypt));
+    return 0;
+}
+
+static
+void bench(uint8_t mode, const char *name)
+{
+    char str[24];
+
+    usart0_send_str(name);
+    usart0_send_str("\n");
+    nRF24L01_crypt_init(&tx, NULL, mode, key, 1, 2);
+    nRF24L01_crypt_init(&rx, NULL, mode, key, 2, 1);
+    precompute(&tx);
+    precompute(&rx);
+
+    if(nRF24L01_CRYPT_AES128 == mode)
+    {
+        MEASURE("key", (aes128_key(tx.key.aes128, key), 0));
+        MEASURE("block", (aes128_encrypt(tx.key.aes128, block), 0));
+    }
+    else
+    {
+        MEASURE("key", (xtea_key(tx.key.xtea, key), 0));
+        MEASURE("block", (xtea_encrypt(tx.key.xtea, block), 0));
+    }
+
+    /* hot path */
+    MEASURE("seal", nRF24L01_crypt_seal(&tx, data, data + sizeof(data), frame));
+    MEASURE("open", nRF24L01_crypt_open(&rx, frame, frame + sizeof(frame)));
+    /* keystream of single seq (tx seq which became next) */
+    MEASURE("stream", precompute(&tx));
+    precompute(&rx);
+
+    /* nothing precomputed */
+    nRF24L01_crypt_init(&tx, NULL, mode, key, 1, 2);
+    nRF24L01_crypt_init(&rx, NULL, mode, key, 2, 1);
+    MEASURE("seal_cold", nRF24L01_crypt_seal(&tx, data, data + sizeof(data), frame));
+    MEASURE("open_cold", nRF24L01_crypt_open(&rx, frame, frame + sizeof(frame)));
+
+    snprintf(str, sizeof(str), "auth %" PRIu16 "\n", rx.stat.auth);
+    usart0_send_str(str);
+}
+
+__attribute__((noreturn))
+void main(void)
+{
+    /* watchdog is enabled by bootloader whenever it "jumps" to app code */
+    fixed__.app_reset_code.curr = RESET_CODE_APP_IDLE;
+    watchdog_disable();
+
+    USART0_BR(CALC_BR(CPU_CLK, 19200));
+    USART0_PARITY_EVEN();
+    USART0_TX_ENABLE();
+
+    for(uint8_t i = 0; i < sizeof(data); ++i) data[i] = i * 7 + 3;
+
+    usart0_send_str("# op cycles\n");
+    bench(nRF24L01_CRYPT_XTEA, "xtea");
+    bench(nRF24L01_CRYPT_AES128, "aes128");
+
+    sleep_enable();
+    for(;;) sleep_cpu();
+}
@@ -1,24 +1,86 @@
 #include "cyclic_timer.h"
 
+#include <util/atomic.h>
+
 #include <drv/tmr1.h>
 
+static timer_cb_t user_cb;
+static uint16_t period_;
+static uint8_t clk_ = CYCLIC_TMR_CLK_DIV_1024;
+static volatile uint32_t elapsed; // ticks of completed periods
+
+static
+void on_compare(uintptr_t user_data)
+{
+    elapsed += (uint32_t)period_ + 1;
+    if(user_cb) (*user_cb)(user_data);
+}
+
+static
+void clk_select(uint8_t clk)
+{
+    switch(clk)
+    {
+        case CYCLIC_TMR_CLK_DIV_1: TMR1_CLK_DIV_1(); break;
+        case CYCLIC_TMR_CLK_DIV_8: TMR1_CLK_DIV_8(); break;
+        case CYCLIC_TMR_CLK_DIV_64: TMR1_CLK_DIV_64(); break;
+        case CYCLIC_TMR_CLK_DIV_256: TMR1_CLK_DIV_256(); break;
+        default: TMR1_CLK_DIV_1024(); break;
+    }
+}
+
 void cyclic_tmr_start(uint16_t period, timer_cb_t cb, uintptr_t user_data)
 {
-    timer1_cb(cb, user_data);
-    /* Clear Timer on Compare */
-    TMR1_MODE_CTC();
-    TMR1_WR16_A(period);
-    TMR1_WR16_CNTR(0);
-    TMR1_A_INT_ENABLE();
-    /* 16MHz / 64 = 250kHz == 4us
-     * 4us * 2^16 ~ 262.1ms
-     *
-     * 16MHz / 256 = 62.5kHz = 16us
-     * 16us * 2^16 ~ 1.049s
-     *
-     * 16MHz / 1024 = 15625Hz = 64us
-     * 64us * 2^16 ~ 4.194s */
-    TMR1_CLK_DIV_1024();
+    cyclic_tmr_start_clk(period, CYCLIC_TMR_CLK_DIV_1024, cb, user_data);
+}
+
+void cyclic_tmr_start_clk(
+    uint16_t period,
+    uint8_t clk,
+    timer_cb_t cb,
+    uintptr_t user_data)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        /* keep time base monotonic when timer is restarted (re-aligned) */
+        elapsed = cyclic_tmr_ticks();
+        user_cb = cb;
+        period_ = period;
+        clk_ = clk;
+        timer1_cb(on_compare, user_data);
+        /* Clear Timer on Compare */
+        TMR1_MODE_CTC();
+        TMR1_WR16_A(period);
+        TMR1_WR16_CNTR(0);
+        TMR1_A_INT_CLEAR();
+        TMR1_A_INT_ENABLE();
+        /* 16MHz / 1 = 16MHz = 62.5ns
+         * 62.5ns * 2^16 ~ 4.096ms
+         *
+         * 16MHz / 8 = 2MHz = 0.5us
+         * 0.5us * 2^16 ~ 32.77ms
+         *
+         * 16MHz / 64 = 250kHz == 4us
+         * 4us * 2^16 ~ 262.1ms
+         *
+         * 16MHz / 256 = 62.5kHz = 16us
+         * 16us * 2^16 ~ 1.049s
+         *
+         * 16MHz / 1024 = 15625Hz = 64us
+         * 64us * 2^16 ~ 4.194s */
+        clk_select(clk);
+    }
+}
+
+uint32_t cyclic_tmr_start_us_rt(uint32_t us, timer_cb_t cb, uintptr_t user_data)
+{
+    if(CYCLIC_TMR_US_MAX < us) us = CYCLIC_TMR_US_MAX;
+
+    const uint8_t clk = cyclic_tmr_us_to_clk(us);
+    const uint32_t ticks = cyclic_tmr_us_to_ticks(us, clk);
+
+    cyclic_tmr_start_clk(ticks - 1, clk, cb, user_data);
+    return cyclic_tmr_ticks_to_us(ticks, clk);
 }
 
 void cyclic_tmr_stop(void)
@@ -27,4 +89,38 @@ void cyclic_tmr_stop(void)
     TMR1_A_INT_DISABLE();
     TMR1_A_INT_CLEAR();
     timer1_cb(NULL, 0);
+    user_cb = NULL;
+}
+
+void cyclic_tmr_advance(uint16_t ticks)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TMR1_WR16_CNTR(ticks);
+    }
+}
+
+uint32_t cyclic_tmr_ticks(void)
+{
+    uint32_t ticks;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint16_t cntr = TCNT1;
+
+        ticks = elapsed;
+        /* compare match already happened but was not serviced yet */
+        if(TIFR1 & (1 << OCF1A))
+        {
+            cntr = TCNT1;
+            ticks += (uint32_t)period_ + 1;
+        }
+        ticks += cntr;
+    }
+    return ticks;
+}
+
+uint8_t cyclic_tmr_clk(void)
+{
+    return clk_;
 }
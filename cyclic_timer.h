@@ -2,5 +2,111 @@
 
 #include <drv/tmrx.h>
 
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#if F_CPU % 1000000UL
+#error "F_CPU has to be multiple of 1MHz"
+#endif
+
+#define CYCLIC_TMR_CYCLES_PER_US (F_CPU / 1000000UL)
+
+/* Timer1 clock select (CS1[2:0]) */
+#define CYCLIC_TMR_CLK_DIV_1 UINT8_C(1)
+#define CYCLIC_TMR_CLK_DIV_8 UINT8_C(2)
+#define CYCLIC_TMR_CLK_DIV_64 UINT8_C(3)
+#define CYCLIC_TMR_CLK_DIV_256 UINT8_C(4)
+#define CYCLIC_TMR_CLK_DIV_1024 UINT8_C(5)
+
+/* longest period: 2^16 ticks @ F_CPU / 1024 (~4.19s @ 16MHz) */
+#define CYCLIC_TMR_US_MAX ((UINT32_C(1) << 26) / CYCLIC_TMR_CYCLES_PER_US)
+
 void cyclic_tmr_start(uint16_t period, timer_cb_t cb, uintptr_t);
+
+/* period + 1 ticks of clk (CYCLIC_TMR_CLK_DIV_*) */
+void cyclic_tmr_start_clk(uint16_t period, uint8_t clk, timer_cb_t cb, uintptr_t);
+
 void cyclic_tmr_stop(void);
+
+/* running period is ticks old (counter is set, has to be below period),
+ * i.e. period restarted on event observed late, time base moves forward */
+void cyclic_tmr_advance(uint16_t ticks);
+
+/* free running time base: timer ticks elapsed since first start, it is not
+ * reset when timer is restarted, resolution is timer clock
+ * (64us @ 16MHz / 1024) of last start, do not mix with different clocks */
+uint32_t cyclic_tmr_ticks(void);
+
+/* clock select currently used */
+uint8_t cyclic_tmr_clk(void);
+
+static inline
+uint8_t cyclic_tmr_div_shift(uint8_t clk)
+{
+    return
+        CYCLIC_TMR_CLK_DIV_1 == clk ? 0
+        : CYCLIC_TMR_CLK_DIV_8 == clk ? 3
+        : CYCLIC_TMR_CLK_DIV_64 == clk ? 6
+        : CYCLIC_TMR_CLK_DIV_256 == clk ? 8
+        : 10;
+}
+
+/* finest clock which can count period of us (in 2^16 ticks) */
+static inline
+uint8_t cyclic_tmr_us_to_clk(uint32_t us)
+{
+    const uint32_t cycles = us * CYCLIC_TMR_CYCLES_PER_US;
+
+    return
+        UINT32_C(1) << 16 >= cycles ? CYCLIC_TMR_CLK_DIV_1
+        : UINT32_C(1) << 19 >= cycles ? CYCLIC_TMR_CLK_DIV_8
+        : UINT32_C(1) << 22 >= cycles ? CYCLIC_TMR_CLK_DIV_64
+        : UINT32_C(1) << 24 >= cycles ? CYCLIC_TMR_CLK_DIV_256
+        : CYCLIC_TMR_CLK_DIV_1024;
+}
+
+/* period of us in ticks of clk (rounded, 1 - 2^16) */
+static inline
+uint32_t cyclic_tmr_us_to_ticks(uint32_t us, uint8_t clk)
+{
+    const uint8_t shift = cyclic_tmr_div_shift(clk);
+    const uint32_t ticks =
+        (us * CYCLIC_TMR_CYCLES_PER_US + (UINT32_C(1) << shift >> 1)) >> shift;
+
+    return
+        !ticks ? 1
+        : UINT32_C(1) << 16 < ticks ? UINT32_C(1) << 16
+        : ticks;
+}
+
+/* period of ticks of clk in us (rounded) */
+static inline
+uint32_t cyclic_tmr_ticks_to_us(uint32_t ticks, uint8_t clk)
+{
+    return
+        ((ticks << cyclic_tmr_div_shift(clk)) + CYCLIC_TMR_CYCLES_PER_US / 2)
+        / CYCLIC_TMR_CYCLES_PER_US;
+}
+
+uint32_t cyclic_tmr_start_us_rt(uint32_t us, timer_cb_t cb, uintptr_t);
+
+/* period in us (up to CYCLIC_TMR_US_MAX), clock with best resolution is
+ * selected at compile time if us is constant (at runtime otherwise),
+ * returns achieved period in us (rounded, resolution is 1 tick of selected
+ * clock: 62.5ns - 64us @ 16MHz) */
+__attribute__((always_inline))
+static inline
+uint32_t cyclic_tmr_start_us(uint32_t us, timer_cb_t cb, uintptr_t user_data)
+{
+    if(__builtin_constant_p(us))
+    {
+        const uint32_t us_ = CYCLIC_TMR_US_MAX < us ? CYCLIC_TMR_US_MAX : us;
+        const uint8_t clk = cyclic_tmr_us_to_clk(us_);
+        const uint32_t ticks = cyclic_tmr_us_to_ticks(us_, clk);
+
+        cyclic_tmr_start_clk(ticks - 1, clk, cb, user_data);
+        return cyclic_tmr_ticks_to_us(ticks, clk);
+    }
+    return cyclic_tmr_start_us_rt(us, cb, user_data);
+}
@@ -0,0 +1,85 @@
+#include <util/atomic.h>
+
+#include "dlog.h"
+
+#define SIZE DLOG_SIZE
+#define MASK (DLOG_SIZE - 1)
+#define RECORD_MAX (1 + DLOG_ARGC_MAX * DLOG_ARG_SIZE)
+
+/* single writer at a time (interrupts disabled), single reader (USART
+ * interrupt or flush), indices are 8bit so both sides read them atomically */
+static struct
+{
+    uint8_t buf[SIZE];
+    volatile uint8_t head; // write index
+    volatile uint8_t tail; // read index
+    uint16_t lost;
+} dlog_;
+
+static
+uint8_t encode(uint8_t *dst, uint8_t token, uint8_t argc, const uint16_t *argv)
+{
+    uint8_t size = 0;
+
+    dst[size++] = 0x80 | token;
+    while(argc--)
+    {
+        const uint16_t value = *argv++;
+
+        dst[size++] = value & 0x7F;
+        dst[size++] = (value >> 7) & 0x7F;
+        dst[size++] = value >> 14;
+    }
+    return size;
+}
+
+void dlog_write(uint8_t token, uint8_t argc, const uint16_t *argv)
+{
+    uint8_t rec[1 + DLOG_ARG_SIZE + RECORD_MAX]; // LOST + record
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint8_t size = 0;
+
+        /* gap is reported ahead of first record which fits */
+        if(dlog_.lost) size = encode(rec, DLOG_LOST, 1, &dlog_.lost);
+        size += encode(rec + size, token, argc, argv);
+
+        const uint8_t free = SIZE - (uint8_t)(dlog_.head - dlog_.tail);
+
+        if(free < size)
+        {
+            if(UINT16_MAX > dlog_.lost) ++dlog_.lost;
+        }
+        else
+        {
+            for(uint8_t i = 0; i < size; ++i) dlog_.buf[dlog_.head++ & MASK] = rec[i];
+            dlog_.lost = 0;
+        }
+    }
+}
+
+uint8_t dlog_read(uint8_t *begin, const uint8_t *const end)
+{
+    uint8_t size = 0;
+    uint8_t tail = dlog_.tail;
+    const uint8_t head = dlog_.head;
+
+    while(begin != end && tail != head)
+    {
+        *begin++ = dlog_.buf[tail++ & MASK];
+        ++size;
+    }
+    dlog_.tail = tail;
+    return size;
+}
+
+uint8_t dlog_pending(void)
+{
+    return dlog_.head - dlog_.tail;
+}
+
+uint16_t dlog_lost(void)
+{
+    return dlog_.lost;
+}
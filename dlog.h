@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Deferred binary log (portable, AVR and host).
+ *
+ * DLOG(name, args...) copies token id and arguments to RAM ring (interrupts
+ * disabled for few cycles, can be used from ISR), no formatting on MCU.
+ * Ring is drained to USART by interrupt (dlog_usart0.h) and
+ * dlog_decode (host) turns stream back to text using dlog_tokens.h formats.
+ * Records which do not fit are dropped and counted, LOST record reports gap.
+ *
+ * Stream: record = 0x80 | token, every argument as 3 bytes of 7 bits
+ * (LS first), so record bytes below 0x80 never start record and plain text
+ * (usart0_send_str) can be interleaved between records. */
+
+#ifndef DLOG_SIZE
+#define DLOG_SIZE 128
+#endif
+
+#if DLOG_SIZE & (DLOG_SIZE - 1) || DLOG_SIZE > 128
+#error "DLOG_SIZE has to be power of 2, at most 128"
+#endif
+
+#define DLOG_ARG_SIZE 3
+#define DLOG_ARGC_MAX 4
+
+#define DLOG_TOKEN(name, argc, format) DLOG_##name,
+enum
+{
+#include "dlog_tokens.h"
+    DLOG_TOKEN_NUM
+};
+#undef DLOG_TOKEN
+
+#define DLOG_TOKEN(name, argc, format) DLOG_ARGC_##name = argc,
+enum
+{
+#include "dlog_tokens.h"
+};
+#undef DLOG_TOKEN
+
+_Static_assert(DLOG_TOKEN_NUM <= 0x80, "too many dlog tokens");
+
+void dlog_write(uint8_t token, uint8_t argc, const uint16_t *argv);
+
+#define DLOG(name, ...) \
+    do \
+    { \
+        const uint16_t argv__[] = {__VA_ARGS__}; \
+        _Static_assert( \
+            sizeof(argv__) / sizeof(uint16_t) == DLOG_ARGC_##name, \
+            "DLOG " #name " argument count"); \
+        _Static_assert(DLOG_ARGC_##name <= DLOG_ARGC_MAX, "DLOG " #name); \
+        dlog_write(DLOG_##name, DLOG_ARGC_##name, argv__); \
+    } while(0)
+
+/* drains ring, returns number of bytes copied */
+uint8_t dlog_read(uint8_t *begin, const uint8_t *const end);
+
+/* bytes waiting in ring */
+uint8_t dlog_pending(void);
+
+/* records dropped since last record which fit */
+uint16_t dlog_lost(void);
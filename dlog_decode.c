@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dlog.h"
+
+/* Decodes dlog stream (dlog.h) captured from USART to text: record becomes
+ * line formatted with dlog_tokens.h format, plain text is passed through,
+ * truncated records and unknown tokens are reported.
+ *
+ * usage: dlog_decode [CAPTURE] (stdin if omitted), i.e.
+ *  stty -F /dev/ttyUSB0 19200 parenb -parodd raw && dlog_decode /dev/ttyUSB0 */
+
+typedef struct
+{
+    const char *name;
+    uint8_t argc;
+    const char *format;
+} token_t;
+
+#define DLOG_TOKEN(name, argc, format) {#name, argc, format},
+static const token_t token_[] =
+{
+#include "dlog_tokens.h"
+};
+#undef DLOG_TOKEN
+
+static struct
+{
+    int token; // -1 outside of record
+    uint8_t size; // argument bytes received
+    uint8_t data[DLOG_ARGC_MAX * DLOG_ARG_SIZE];
+    int eol; // last output character was new line
+} decoder_ = {.token = -1, .eol = 1};
+
+static
+void line_begin(void)
+{
+    if(!decoder_.eol) putchar('\n');
+}
+
+static
+void record_end(void)
+{
+    const token_t *token = token_ + decoder_.token;
+    unsigned arg[DLOG_ARGC_MAX] = {0};
+
+    for(uint8_t i = 0; i < token->argc; ++i)
+    {
+        const uint8_t *data = decoder_.data + i * DLOG_ARG_SIZE;
+
+        arg[i] = data[0] | data[1] << 7 | (data[2] & 0x3) << 14;
+    }
+    line_begin();
+    printf(token->format, arg[0], arg[1], arg[2], arg[3]);
+    putchar('\n');
+    decoder_.eol = 1;
+    decoder_.token = -1;
+}
+
+static
+void truncated(void)
+{
+    line_begin();
+    printf("dlog: %s truncated\n", token_[decoder_.token].name);
+    decoder_.eol = 1;
+    decoder_.token = -1;
+}
+
+static
+void decode(uint8_t byte)
+{
+    if(0x80 & byte)
+    {
+        if(0 <= decoder_.token) truncated();
+
+        const uint8_t id = byte & 0x7F;
+
+        if(DLOG_TOKEN_NUM <= id)
+        {
+            line_begin();
+            printf("dlog: unknown token %u\n", id);
+            decoder_.eol = 1;
+            return;
+        }
+        decoder_.token = id;
+        decoder_.size = 0;
+    }
+    else if(0 <= decoder_.token) decoder_.data[decoder_.size++] = byte;
+    else
+    {
+        putchar(byte);
+        decoder_.eol = '\n' == byte;
+        return;
+    }
+
+    if(decoder_.size == token_[decoder_.token].argc * DLOG_ARG_SIZE) record_end();
+}
+
+int main(int argc, char *argv[])
+{
+    if(2 < argc)
+    {
+        fprintf(stderr, "usage: %s [CAPTURE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = 2 == argc ? fopen(argv[1], "rb") : stdin;
+
+    if(!file)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    for(int c; EOF != (c = fgetc(file));)
+    {
+        decode(c);
+        /* serial port capture never ends, show records as they come */
+        if(decoder_.eol) fflush(stdout);
+    }
+    if(0 <= decoder_.token) truncated();
+    if(stdin != file) fclose(file);
+    return EXIT_SUCCESS;
+}
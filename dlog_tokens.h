@@ -0,0 +1,16 @@
+/* deferred log tokens, included by dlog.h (AVR) and dlog_decode (host)
+ * DLOG_TOKEN(name, argc, format)
+ * arguments are uint16_t, format is used only by host decoder,
+ * append new tokens at the end (token id is position in the list) */
+
+DLOG_TOKEN(LOST, 1, "dlog: %u records lost")
+DLOG_TOKEN(WAKEUP, 0, "+")
+DLOG_TOKEN(EVENT, 0, "*")
+DLOG_TOKEN(RX_ERROR, 2, "on_reception_error STATUS 0x%02X FIFO_STATUS 0x%02X")
+DLOG_TOKEN(SEND_ERROR, 2, "send_err STATUS 0x%02X FIFO_STATUS 0x%02X")
+DLOG_TOKEN(RECV_ERROR, 2, "recv_err STATUS 0x%02X FIFO_STATUS 0x%02X")
+DLOG_TOKEN(RECV, 2, "recv pipe %u size %u")
+DLOG_TOKEN(RPD, 1, "RPD: %x")
+DLOG_TOKEN(TDMA_RECV, 2, "tdma src %u size %u")
+DLOG_TOKEN(TMR_WHEEL, 2, "timer %u late %u")
+DLOG_TOKEN(RECV_DATA, 4, "recv data %04X%04X%04X%04X")
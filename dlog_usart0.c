@@ -0,0 +1,37 @@
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include <drv/usart0.h>
+
+#include "dlog_usart0.h"
+
+/* sole reader of ring while armed, disarms itself once last byte is out
+ * so CPU is not woken by empty data register */
+ISR(USART_UDRE_vect)
+{
+    uint8_t data;
+
+    if(dlog_read(&data, &data + 1)) UDR0 = data;
+    if(!dlog_pending()) UCSR0B &= ~M1(UDRIE0);
+}
+
+uint8_t dlog_usart0_drain(void)
+{
+    const uint8_t pending = dlog_pending();
+
+    if(pending) UCSR0B |= M1(UDRIE0);
+    return pending;
+}
+
+void dlog_usart0_flush(void)
+{
+    uint8_t data;
+
+    /* pumped here, works with interrupts disabled too */
+    UCSR0B &= ~M1(UDRIE0);
+    while(dlog_read(&data, &data + 1))
+    {
+        while(!(UCSR0A & M1(UDRE0))) {}
+        UDR0 = data;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "dlog.h"
+
+/* Drain dlog ring to USART0 (transmitter configured by application).
+ *
+ * Ring is sent from data register empty interrupt (USART_UDRE_vect, not
+ * used by atmega328p_drv usart0.c which sends plain text by polling), main
+ * loop only arms it and goes to sleep, idle sleep mode keeps USART running:
+ *
+ *  for(;;)
+ *  {
+ *      cli(); dispatch events;
+ *      const uint8_t idle = !dlog_usart0_drain();
+ *      sei(); sleep_cpu(); // sei() lets next instruction run first
+ *      if(idle) DLOG(WAKEUP); // UDRE wakeups are not logged
+ *  }
+ *
+ * At 19200 baud byte takes ~0.57ms, interrupt takes few us of it. */
+
+/* non-blocking, arms interrupt while data is pending,
+ * returns number of bytes still waiting */
+uint8_t dlog_usart0_drain(void);
+
+/* blocking, use before plain text output (usart0_send_str) */
+void dlog_usart0_flush(void);
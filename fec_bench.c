@@ -0,0 +1,121 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nRF24L01_fec.h"
+#include "xorshift.h"
+
+/* host benchmark of Reed-Solomon encode/decode throughput, decode
+ * reconstructs erased fragments (timed including erasure) and is verified
+ * against original data, data is random (reproducible for given seed)
+ *
+ * output: JSON line per data_num:parity_num ratio
+ *
+ * usage: fec_bench [seed] */
+
+#define FRAGMENT_SIZE nRF24L01_FEC_FRAGMENT_SIZE
+#define ITERATIONS 20000
+
+static uint32_t seed_ = 1;
+
+static
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static
+void bench(uint8_t data_num, uint8_t parity_num)
+{
+    uint8_t data[RS_DATA_MAX_NUM * FRAGMENT_SIZE];
+    uint8_t orig[RS_DATA_MAX_NUM * FRAGMENT_SIZE];
+    uint8_t parity[RS_PARITY_MAX_NUM * FRAGMENT_SIZE];
+    const size_t size = (size_t)data_num * FRAGMENT_SIZE;
+    const size_t lost_size = (size_t)parity_num * FRAGMENT_SIZE;
+
+    for(size_t i = 0; i < size; ++i) data[i] = xorshift32(&seed_);
+    memcpy(orig, data, size);
+
+    double begin = now();
+
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        memset(parity, 0, sizeof(parity));
+        for(uint8_t j = 0; j < data_num; ++j)
+        {
+            rs_encode(
+                j, data + (size_t)j * FRAGMENT_SIZE, data_num,
+                parity, parity_num,
+                FRAGMENT_SIZE);
+        }
+    }
+
+    const double encode = size * ITERATIONS / (now() - begin) / 1e6;
+
+    /* worst case: first parity_num data fragments lost */
+    const uint32_t present =
+        (UINT32_MAX >> (32 - data_num)) & ~(UINT32_MAX >> (32 - parity_num));
+
+    /* lost fragments are erased so decoder has to reconstruct them */
+    memset(data, 0, lost_size);
+    if(
+        !rs_decode(
+            data, data_num, present,
+            parity, parity_num, UINT32_MAX >> (32 - parity_num),
+            FRAGMENT_SIZE)
+        || memcmp(data, orig, size))
+    {
+        fprintf(stderr, "decode mismatch\n");
+        exit(EXIT_FAILURE);
+    }
+
+    begin = now();
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        memset(data, 0, lost_size);
+        if(
+            !rs_decode(
+                data, data_num, present,
+                parity, parity_num, UINT32_MAX >> (32 - parity_num),
+                FRAGMENT_SIZE))
+        {
+            fprintf(stderr, "decode failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const double decode = size * ITERATIONS / (now() - begin) / 1e6;
+
+    if(memcmp(data, orig, size))
+    {
+        fprintf(stderr, "decode mismatch\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf(
+        "{\"data_num\":%" PRIu8 ",\"parity_num\":%" PRIu8
+        ",\"encode_mbps\":%.2f,\"decode_mbps\":%.2f}\n",
+        data_num,
+        parity_num,
+        encode,
+        decode);
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t seed = 1 < argc ? strtoul(argv[1], NULL, 0) : 1;
+
+    const uint8_t cfg[][2] =
+    {
+        {4, 1}, {4, 2}, {8, 1}, {8, 2}, {8, 4}, {16, 2}, {16, 4}, {32, 4}
+    };
+
+    seed_ = seed ? seed : 1;
+    for(size_t i = 0; i < sizeof(cfg) / sizeof(cfg[0]); ++i) bench(cfg[i][0], cfg[i][1]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>
+
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+#include <drv/spi0.h>
+#include <drv/tmr1.h>
+#include <drv/usart0.h>
+#include <drv/watchdog.h>
+
+#include <bootloader/fixed.h>
+
+#include "nRF24L01.h"
+
+/* Timer1 is clocked directly from CPU clock and used as cycle counter,
+ * driver operations against radio (wired as nRF24L01_bench_tx.c, SPI0
+ * 8MHz). Built pointer bound by default, with HAL_STATIC=1 compile-time
+ * bound (nRF24L01_hal_avr.h), compare output and flash (avr-size) of both
+ * builds. Radio is not configured, transmission is not started (CE is
+ * kept low by send() measurement, payload stays in TX FIFO).
+ *
+ * AVR comparison (cycles, avr-size) of the two builds has not been taken
+ * yet (needs avr-gcc and board or simavr), only host build
+ * (nRF24L01_hal_bench.c, host.Makefile) was measured. */
+
+// nRF CE       PC.1/PCINT9        pin: A1 pro-mini
+// SPI0 SCK     PB.5/PCINT5        pin: 13 pro-mini
+// SPI0 MISO    PB.4/PCINT4        pin: 12 pro-mini
+// SPI0 MOSI    PB.3/PCINT3        pin: 11 pro-mini
+// SPI0 !SS     PB.2/PCINT2        pin: 10 pro-mini
+
+static
+nRF24L01_t dev;
+
+static
+uint8_t data[16];
+
+static
+uint8_t buf[nRF24L01_PAYLOAD_SIZE];
+
+volatile uintptr_t sink;
+
+#define MEASURE(name, expr) \
+    { \
+        TMR1_WR16_CNTR(0); \
+        TMR1_CLK_DIV_1(); \
+        sink = (uintptr_t)(expr); \
+        TMR1_CLK_DISABLE(); \
+        report(name, TCNT1); \
+    }
+
+static
+void report(const char *name, uint16_t cycles)
+{
+    char str[48];
+
+    snprintf(str, sizeof(str), "%s %" PRIu16 "\n", name, cycles);
+    usart0_send_str(str);
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    PORTB &= ~M1(DDB2); // SPI0/!SS PB.2 low
+    spi0_xchg(begin, end);
+    PORTB |= M1(DDB2); // SPI0/!SS PB.2 high
+}
+
+static
+void ce_set(nRF24L01_ce_t state)
+{
+    if(state.CE) PORTC |= M1(DDC1);
+    else PORTC &= ~M1(DDC1);
+}
+
+static
+uint8_t cfg(void)
+{
+    nRF24L01_CFG(&dev, rf_ch, .RF_CH = 1);
+    return 0;
+}
+
+static
+uint8_t send(void)
+{
+    nRF24L01_send(&dev, data, data + sizeof(data), NULL, NULL, 0);
+    ce_set((nRF24L01_ce_t){.CE = 0});
+    return 0;
+}
+
+static
+uint8_t event(void)
+{
+    dev.updated = 1;
+    nRF24L01_event(&dev);
+    return 0;
+}
+
+__attribute__((noreturn))
+void main(void)
+{
+    /* watchdog is enabled by bootloader whenever it "jumps" to app code */
+    fixed__.app_reset_code.curr = RESET_CODE_APP_IDLE;
+    watchdog_disable();
+
+    USART0_BR(CALC_BR(CPU_CLK, 19200));
+    USART0_PARITY_EVEN();
+    USART0_TX_ENABLE();
+
+    /* PC.1 / nRF CE */
+    PORTC &= ~M1(DDC1); // to low
+    DDRC |= M1(DDC1); // to output
+
+    // PB.2 / SPI0 !SS
+    DDRB |= M1(DDB2); // output
+    PORTB |= M1(DDB2); // high
+
+    // PB.3 / SPI0 MOSI
+    PORTB |= M1(DDB3); // output
+    DDRB |= M1(DDB3); // high
+
+    // PB.5 / SPI0/CLK
+    PORTB |= M1(DDB5); // output
+    DDRB |= M1(DDB5); // high
+
+    SPI0_MASTER();
+    SPI0_CLK_DIV_2(); // 8MHz
+    SPI0_ENABLE();
+
+#ifdef nRF24L01_HAL_STATIC
+    usart0_send_str("# hal static\n");
+#else
+    usart0_send_str("# hal pointer\n");
+#endif
+    usart0_send_str("# op cycles\n");
+
+    MEASURE("init", (nRF24L01_init(&dev, ce_set, spi_xchg), 0));
+    MEASURE("status", nRF24L01_status(&dev).value);
+    MEASURE("read_register", nRF24L01_read_register(&dev, nRF24L01_ADDR_rf_ch));
+    MEASURE("cfg", cfg());
+    MEASURE("power_up", (nRF24L01_power_up(&dev), 0));
+    MEASURE("send", send());
+    /* TX path, payload pending */
+    MEASURE("event_tx", event());
+    nRF24L01_cancel(&dev);
+    nRF24L01_recv(&dev, buf, buf + sizeof(buf), NULL, NULL, 0);
+    ce_set((nRF24L01_ce_t){.CE = 0});
+    /* RX path, RX FIFO empty */
+    MEASURE("event_rx", event());
+    nRF24L01_power_down(&dev);
+
+    sleep_enable();
+    for(;;) sleep_cpu();
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/* host build of AVR sources: single threaded, block runs once */
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for(int atomic_once__ = 1; atomic_once__; atomic_once__ = 0)
@@ -1,7 +1,6 @@
 #include <string.h>
 
-#include <drv/usart0.h>
-
+#include "dlog.h"
 #include "nRF24L01.h"
 
 /* payload is always 32B in size
@@ -36,6 +35,23 @@ typedef struct
     nRF24L01_fifo_status_t fifo_status;
 } state_t;
 
+/* register access of constant tag is bound at compile time with
+ * nRF24L01_HAL_STATIC (nRF24L01_hal.h), run-time addresses use
+ * read_register()/write_register() on top of SPI_XCHG() */
+#define SPI_XCHG(dev, begin, end) nRF24L01_SPI_XCHG(dev, begin, end)
+
+#ifdef nRF24L01_HAL_STATIC
+#define CE_SET(dev, ...) nRF24L01_hal_ce_set((nRF24L01_ce_t){__VA_ARGS__})
+#define READ(dev, tag) nRF24L01_hal_read_##tag()
+#define WRITE(dev, tag, ...) nRF24L01_hal_write_##tag((nRF24L01_##tag##_t){__VA_ARGS__})
+#else
+#define CE_SET(dev, ...) (dev)->ce_set((nRF24L01_ce_t){__VA_ARGS__})
+#define READ(dev, tag) \
+    ((nRF24L01_##tag##_t){.value = read_register(dev, nRF24L01_ADDR_##tag)})
+#define WRITE(dev, tag, ...) \
+    write_register(dev, nRF24L01_ADDR_##tag, (nRF24L01_##tag##_t){__VA_ARGS__}.value)
+#endif
+
 static
 uint8_t read_register(nRF24L01_t *dev, uint8_t addr)
 {
@@ -52,7 +68,7 @@ uint8_t read_register(nRF24L01_t *dev, uint8_t addr)
         .cmd[1] = nRF24L01_NOP
     };
 
-    dev->spi_xchg(xdata.byte, xdata.byte + sizeof(xdata));
+    SPI_XCHG(dev, xdata.byte, xdata.byte + sizeof(xdata));
     return xdata.data;
 }
 
@@ -64,7 +80,7 @@ void write_register(nRF24L01_t *dev, uint8_t addr, uint8_t data)
         nRF24L01_W_REGISTER(addr),
         data
     };
-    dev->spi_xchg(wdata, wdata + sizeof(wdata));
+    SPI_XCHG(dev, wdata, wdata + sizeof(wdata));
 }
 
 static
@@ -80,7 +96,7 @@ state_t read_state(nRF24L01_t *dev)
         .cmd[1] = nRF24L01_NOP
     };
 
-    dev->spi_xchg(xdata.byte, xdata.byte + sizeof(xdata));
+    SPI_XCHG(dev, xdata.byte, xdata.byte + sizeof(xdata));
     return xdata.state;
 }
 
@@ -92,13 +108,10 @@ void tx_reset(nRF24L01_t *dev)
         {
             nRF24L01_FLUSH_TX
         };
-        dev->spi_xchg(wdata, wdata + sizeof(wdata));
+        SPI_XCHG(dev, wdata, wdata + sizeof(wdata));
     }
 
-    write_register(
-        dev,
-        nRF24L01_ADDR_status,
-        (nRF24L01_status_t){.MAX_RT = 1, .TX_DS = 1}.value);
+    WRITE(dev, status, .MAX_RT = 1, .TX_DS = 1);
 }
 
 static
@@ -118,6 +131,17 @@ void on_transmission_error(
     dev->tx.err_cb = NULL;
     dev->tx.user_data = 0;
 
+    if(dev->turnaround)
+    {
+        /* request was not delivered, no reply is expected */
+        dev->turnaround = 0;
+        dev->rx.begin = NULL;
+        dev->rx.end = NULL;
+        dev->rx.cb = NULL;
+        dev->rx.err_cb = NULL;
+        dev->rx.user_data = 0;
+    }
+
     if(err_cb) (*err_cb)(status, fifo_status, user_data);
 }
 
@@ -144,11 +168,31 @@ void write_payload(nRF24L01_t *dev)
     memcpy(xdata.data, dev->tx.begin, data_size);
     memset(xdata.data + data_size, PADDING_BYTE, MAX_DATA_SIZE - data_size);
     dev->tx.begin += data_size;
-    dev->spi_xchg(xdata.byte, xdata.byte + sizeof(xdata));
+    SPI_XCHG(dev, xdata.byte, xdata.byte + sizeof(xdata));
 }
 
 static
-void send(nRF24L01_t *dev)
+void turnaround(nRF24L01_t *dev, nRF24L01_config_t config)
+{
+    /* PRIM_RX is applied on CE rising edge (standby-I -> RX) */
+    dev->turnaround = 0;
+    CE_SET(dev, .CE = 0);
+    config.PRIM_RX = 1;
+    WRITE(dev, config, .value = config.value);
+    CE_SET(dev, .CE = 1);
+
+    if(!dev->clock) return;
+
+    const uint32_t time = (*dev->clock)() - dev->event_time + nRF24L01_SETTLE_US;
+    const uint16_t value = time < UINT16_MAX ? time : UINT16_MAX;
+
+    ++dev->stat.turnaround_num;
+    dev->stat.turnaround_sum += value;
+    if(value > dev->stat.turnaround_max) dev->stat.turnaround_max = value;
+}
+
+static
+void send(nRF24L01_t *dev, nRF24L01_config_t config)
 {
     state_t state = read_state(dev);
 
@@ -162,13 +206,28 @@ void send(nRF24L01_t *dev)
 
     if(state.status.TX_DS)
     {
-        /* clear data sent, TX FIFO interrupt */
-        write_register(dev, nRF24L01_ADDR_status, (nRF24L01_status_t){.TX_DS = 1}.value);
+        /* clear data sent, TX FIFO interrupt
+         * if payloads were queued FIFO is read after clear, payload sent in
+         * between raises TX_DS again */
+        WRITE(dev, status, .TX_DS = 1);
+        if(!state.fifo_status.TX_EMPTY) state = read_state(dev);
     }
 
-    if(dev->tx.begin == dev->tx.end) goto transmission_complete;
+    if(dev->tx.begin == dev->tx.end)
+    {
+        /* payloads written ahead are still in FIFO */
+        if(state.fifo_status.TX_EMPTY) goto transmission_complete;
+        goto exit;
+    }
 
-    write_payload(dev);
+    /* FIFO level is unknown unless empty, at least one entry is free */
+    for(
+        uint8_t free = state.fifo_status.TX_EMPTY ? nRF24L01_FIFO_SIZE : !state.status.TX_FULL;
+        free && dev->tx.begin != dev->tx.end;
+        --free)
+    {
+        write_payload(dev);
+    }
     goto exit;
 
 transmission_complete:
@@ -182,12 +241,35 @@ transmission_complete:
         dev->tx.err_cb = NULL;
         dev->tx.user_data = 0;
 
+        if(dev->turnaround) turnaround(dev, config);
         if(cb) (*cb)(user_data);
     }
 exit:
     ; // this is required by syntax
 }
 
+static
+void clear_rx_data_ready(nRF24L01_t *dev)
+{
+    /* clear RX_DR */
+    WRITE(dev, status, .RX_DR = 1);
+}
+
+static
+void rx_reset(nRF24L01_t *dev)
+{
+    {
+        uint8_t wdata[] =
+        {
+            nRF24L01_FLUSH_RX
+        };
+        SPI_XCHG(dev, wdata, wdata + sizeof(wdata));
+    }
+
+    clear_rx_data_ready(dev);
+    ++dev->stat.rx_flush;
+}
+
 static
 void on_reception_error(
     nRF24L01_t *dev,
@@ -202,15 +284,14 @@ void on_reception_error(
     dev->rx.cb = NULL;
     dev->rx.err_cb = NULL;
     dev->rx.user_data = 0;
-    usart0_send_str("on_reception_error\n");
-
-    // TODO FLUSH RX FIFO
+    DLOG(RX_ERROR, status.value, fifo_status.value);
 
     if(err_cb) (*err_cb)(status, fifo_status, user_data);
 }
 
+/* returns 0 if payload did not fit into buffer (it is removed from FIFO) */
 static
-void read_payload(nRF24L01_t *dev, uint8_t max_size)
+uint8_t read_payload(nRF24L01_t *dev, uint8_t max_size)
 {
     union {
         struct {
@@ -222,28 +303,23 @@ void read_payload(nRF24L01_t *dev, uint8_t max_size)
 
     memset(xdata.payload.data, nRF24L01_NOP, sizeof(xdata.payload.data));
 
+    /* header + as much data as fits, payload leaves FIFO anyway */
     const size_t capacity = dev->rx.end - dev->rx.begin;
-    const uint8_t size = MIN(capacity, max_size);
+    const uint8_t size = MIN(sizeof(header_t) + MIN(capacity, MAX_DATA_SIZE), max_size);
 
-    dev->spi_xchg(xdata.byte, xdata.byte + sizeof(nRF24L01_spi_cmd_t) + size);
+    SPI_XCHG(dev, xdata.byte, xdata.byte + sizeof(nRF24L01_spi_cmd_t) + size);
 
-    if(size >= xdata.payload.header.data_size)
-    {
-        memcpy(dev->rx.begin, xdata.payload.data, xdata.payload.header.data_size);
-        dev->rx.begin += xdata.payload.header.data_size;
-    }
-    else
+    const uint8_t data_size = xdata.payload.header.data_size;
+
+    if(sizeof(header_t) + data_size > size)
     {
-        /* TODO: report error */
+        ++dev->stat.rx_overflow;
+        return 0;
     }
 
-}
-
-static
-void clear_rx_data_ready(nRF24L01_t *dev)
-{
-    /* clear RX_DR */
-    write_register(dev, nRF24L01_ADDR_status, (nRF24L01_status_t){.RX_DR = 1}.value);
+    memcpy(dev->rx.begin, xdata.payload.data, data_size);
+    dev->rx.begin += data_size;
+    return 1;
 }
 
 static
@@ -253,13 +329,19 @@ void recv(nRF24L01_t *dev)
 
     if(state.fifo_status.RX_EMPTY)
     {
+        /* nothing to read (or flush), keep waiting */
         clear_rx_data_ready(dev);
-        // TODO FLUSH RX FIFO, report error
+        ++dev->stat.rx_spurious;
         goto exit;
     }
+next:
+    /* payloads arriving now are lost, reported to sender by upper layer */
+    if(state.fifo_status.RX_FULL) ++dev->stat.rx_full;
 
     if(!(nRF24L01_RX_PIPE_NUM > state.status.RX_P_NO))
     {
+        /* FIFO not empty but no pipe, content can not be trusted */
+        rx_reset(dev);
         on_reception_error(dev, state.status, state.fifo_status);
         goto exit;
     }
@@ -269,10 +351,16 @@ void recv(nRF24L01_t *dev)
         .value = read_register(dev, nRF24L01_ADDR_rx_pw_p(state.status.RX_P_NO))
     };
 
-    read_payload(dev, payload_len.RX_PW);
+    const uint8_t fit = read_payload(dev, payload_len.RX_PW);
 
     if(state.status.RX_DR) clear_rx_data_ready(dev);
 
+    if(!fit)
+    {
+        on_reception_error(dev, state.status, state.fifo_status);
+        goto exit;
+    }
+
     goto reception_complete;
 reception_complete:
     {
@@ -287,6 +375,12 @@ reception_complete:
 
         if(cb) (*cb)(begin, state.status.RX_P_NO, user_data);
     }
+    /* RX_DR is raised by new payload only, payloads already in FIFO when it
+     * was cleared are read while upper layer keeps receiving (datasheet RX
+     * procedure), FIFO would not drain otherwise */
+    if(!dev->rx.cb || dev->turnaround) goto exit;
+    state = read_state(dev);
+    if(!state.fifo_status.RX_EMPTY) goto next;
 exit:
     ; // this is required by syntax
 }
@@ -299,6 +393,7 @@ void nRF24L01_init(
     memset(dev, 0, sizeof(nRF24L01_t));
     dev->ce_set = ce_set;
     dev->spi_xchg = spi_xchg;
+    nRF24L01_TRACE_BEGIN(dev, INIT, 0);
 
     /* payload size is fixed by impl. */
     uint8_t pipe_num = nRF24L01_RX_PIPE_NUM;
@@ -306,6 +401,7 @@ void nRF24L01_init(
     {
         write_register(dev, nRF24L01_ADDR_rx_pw_p(--pipe_num), PAYLOAD_SIZE);
     } while(pipe_num);
+    nRF24L01_TRACE_END(dev, INIT);
 }
 
 void nRF24L01_event(nRF24L01_t *dev)
@@ -313,13 +409,19 @@ void nRF24L01_event(nRF24L01_t *dev)
     if(!dev->updated) return;
     else dev->updated = 0;
 
-    nRF24L01_config_t config = {.value = read_register(dev, nRF24L01_ADDR_config)};
+    nRF24L01_TRACE_BEGIN(dev, EVENT, 0);
+
+    if(dev->turnaround && dev->clock) dev->event_time = (*dev->clock)();
+
+    nRF24L01_config_t config = READ(dev, config);
 
     if(config.PRIM_RX) recv(dev);
-    else send(dev);
+    else send(dev, config);
+    nRF24L01_TRACE_END(dev, EVENT);
 }
 
-void nRF24L01_send(
+static
+void transmit(
     nRF24L01_t *dev,
     const uint8_t *begin, const uint8_t *const end,
     nRF24L01_send_cb_t cb,
@@ -332,16 +434,93 @@ void nRF24L01_send(
     dev->tx.err_cb = err_cb;
     dev->tx.user_data = user_data;
 
-    /* set to PRIM_TX if needed */
-    nRF24L01_config_t config = {.value = read_register(dev, nRF24L01_ADDR_config)};
+    /* set to PRIM_TX if needed, applied on CE rising edge */
+    nRF24L01_config_t config = READ(dev, config);
 
     if(config.PRIM_RX)
     {
+        CE_SET(dev, .CE = 0);
         config.PRIM_RX = 0;
-        write_register(dev, nRF24L01_ADDR_config, config.value);
+        WRITE(dev, config, .value = config.value);
     }
     write_payload(dev);
-    dev->ce_set((nRF24L01_ce_t){.CE = 1});
+    CE_SET(dev, .CE = 1);
+}
+
+void nRF24L01_send(
+    nRF24L01_t *dev,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    nRF24L01_TRACE_BEGIN(dev, SEND, end - begin);
+    dev->turnaround = 0;
+    transmit(dev, begin, end, cb, err_cb, user_data);
+    nRF24L01_TRACE_END(dev, SEND);
+}
+
+void nRF24L01_transceive(
+    nRF24L01_t *dev,
+    const uint8_t *tx_begin, const uint8_t *const tx_end,
+    uint8_t *rx_begin, const uint8_t *const rx_end,
+    nRF24L01_send_cb_t send_cb,
+    nRF24L01_recv_cb_t recv_cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    nRF24L01_TRACE_BEGIN(
+        dev, TRANSCEIVE,
+        MIN(tx_end - tx_begin, 0xFF) | MIN(rx_end - rx_begin, 0xFF) << 8);
+    /* reception is armed ahead, radio is switched from event */
+    dev->rx.begin = rx_begin;
+    dev->rx.end = rx_end;
+    dev->rx.cb = recv_cb;
+    dev->rx.err_cb = err_cb;
+    dev->rx.user_data = user_data;
+    dev->turnaround = 1;
+    transmit(dev, tx_begin, tx_end, send_cb, err_cb, user_data);
+    nRF24L01_TRACE_END(dev, TRANSCEIVE);
+}
+
+static
+void stop(nRF24L01_t *dev)
+{
+    CE_SET(dev, .CE = 0);
+    tx_reset(dev);
+    memset(&dev->tx, 0, sizeof(dev->tx));
+    memset(&dev->rx, 0, sizeof(dev->rx));
+    dev->turnaround = 0;
+}
+
+void nRF24L01_cancel(nRF24L01_t *dev)
+{
+    nRF24L01_TRACE_BEGIN(dev, CANCEL, 0);
+    stop(dev);
+    nRF24L01_TRACE_END(dev, CANCEL);
+}
+
+void nRF24L01_power_down(nRF24L01_t *dev)
+{
+    nRF24L01_TRACE_BEGIN(dev, POWER, 0);
+    stop(dev);
+
+    nRF24L01_config_t config = READ(dev, config);
+
+    config.PWR_UP = 0;
+    WRITE(dev, config, .value = config.value);
+    nRF24L01_TRACE_END(dev, POWER);
+}
+
+void nRF24L01_power_up(nRF24L01_t *dev)
+{
+    nRF24L01_TRACE_BEGIN(dev, POWER, 1);
+
+    nRF24L01_config_t config = READ(dev, config);
+
+    config.PWR_UP = 1;
+    WRITE(dev, config, .value = config.value);
+    nRF24L01_TRACE_END(dev, POWER);
 }
 
 void nRF24L01_recv(
@@ -351,6 +530,8 @@ void nRF24L01_recv(
     nRF24L01_err_cb_t err_cb,
     uintptr_t user_data)
 {
+    nRF24L01_TRACE_BEGIN(dev, RECV, end - begin);
+    dev->turnaround = 0;
     dev->rx.begin = begin;
     dev->rx.end = end;
     dev->rx.cb = cb;
@@ -358,17 +539,66 @@ void nRF24L01_recv(
     dev->rx.user_data = user_data;
 
     /* set to PRIM_RX if needed */
-    nRF24L01_config_t config = {.value = read_register(dev, nRF24L01_ADDR_config)};
+    nRF24L01_config_t config = READ(dev, config);
 
     if(!config.PRIM_RX)
     {
+        CE_SET(dev, .CE = 0);
         config.PRIM_RX = 1;
-        write_register(dev, nRF24L01_ADDR_config, config.value);
+        WRITE(dev, config, .value = config.value);
     }
-    dev->ce_set((nRF24L01_ce_t){.CE = 1});
+    CE_SET(dev, .CE = 1);
+    nRF24L01_TRACE_END(dev, RECV);
 }
 
 nRF24L01_rpd_t nRF24L01_rpd(nRF24L01_t *dev)
 {
-    return (nRF24L01_rpd_t){.value = read_register(dev, nRF24L01_ADDR_rpd)};
+    nRF24L01_TRACE_BEGIN(dev, RPD, 0);
+
+    const nRF24L01_rpd_t rpd = READ(dev, rpd);
+
+    nRF24L01_TRACE_END(dev, RPD);
+    return rpd;
+}
+
+nRF24L01_status_t nRF24L01_status(nRF24L01_t *dev)
+{
+    nRF24L01_TRACE_BEGIN(dev, STATUS, 0);
+
+    union {
+        nRF24L01_status_t status;
+        nRF24L01_spi_cmd_t cmd;
+        uint8_t byte[0];
+    } xdata = {.cmd = nRF24L01_NOP};
+
+    SPI_XCHG(dev, xdata.byte, xdata.byte + sizeof(xdata));
+    nRF24L01_TRACE_END(dev, STATUS);
+    return xdata.status;
+}
+
+uint8_t nRF24L01_read_register(nRF24L01_t *dev, uint8_t addr)
+{
+    nRF24L01_TRACE_BEGIN(dev, READ_REG, addr);
+
+    const uint8_t value = read_register(dev, addr);
+
+    nRF24L01_TRACE_END(dev, READ_REG);
+    return value;
+}
+
+void nRF24L01_write_register(
+    nRF24L01_t *dev,
+    uint8_t addr,
+    const uint8_t *begin, const uint8_t *const end)
+{
+    uint8_t wdata[sizeof(nRF24L01_spi_cmd_t) + sizeof(nRF24L01_addr40_t)] =
+    {
+        nRF24L01_W_REGISTER(addr)
+    };
+    const uint8_t size = MIN((size_t)(end - begin), sizeof(nRF24L01_addr40_t));
+
+    nRF24L01_TRACE_BEGIN(dev, WRITE_REG, addr);
+    memcpy(wdata + sizeof(nRF24L01_spi_cmd_t), begin, size);
+    SPI_XCHG(dev, wdata, wdata + sizeof(nRF24L01_spi_cmd_t) + size);
+    nRF24L01_TRACE_END(dev, WRITE_REG);
 }
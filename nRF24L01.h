@@ -44,6 +44,16 @@ typedef uint8_t nRF24L01_spi_cmd_t;
 
 #define nRF24L01_ADDR_rx_addr_p(i)  (nRF24L01_ADDR_rx_addr_p0 + (i))
 #define nRF24L01_ADDR_rx_pw_p(i)  (nRF24L01_ADDR_rx_pw_p0 + (i))
+
+/* X(tag) for every register: address nRF24L01_ADDR_##tag,
+ * value nRF24L01_##tag##_t */
+#define nRF24L01_REGISTERS(X) \
+    X(config) X(en_aa) X(en_rxaddr) X(setup_aw) X(setup_retr) X(rf_ch) \
+    X(rf_setup) X(status) X(observe_tx) X(rpd) \
+    X(rx_addr_p0) X(rx_addr_p1) X(rx_addr_p2) X(rx_addr_p3) X(rx_addr_p4) \
+    X(rx_addr_p5) X(tx_addr) \
+    X(rx_pw_p0) X(rx_pw_p1) X(rx_pw_p2) X(rx_pw_p3) X(rx_pw_p4) X(rx_pw_p5) \
+    X(fifo_status)
 /*----------------------------------------------------------------------------*/
 
 /* nRF24L01 registers --------------------------------------------------------*/
@@ -252,6 +262,11 @@ typedef union
 #define nRF24L01_RX_PIPE_NUM 6
 #define nRF24L01_RX_PIPE_INVALID 6
 #define nRF24L01_RX_FIFO_EMPTY 6
+#define nRF24L01_FIFO_SIZE 3
+/* TX/RX settling after CE rising edge (standby-I -> TX/RX) */
+#define nRF24L01_SETTLE_US 130
+/* crystal start-up, power down -> standby-I (150us with external clock) */
+#define nRF24L01_POWER_UP_US 1500
 
 typedef union
 {
@@ -274,11 +289,21 @@ typedef
 void (*nRF24L01_spi_xchg_t)(uint8_t *begin, const uint8_t *const end);
 typedef
 void (*nRF24L01_ce_set_t)(nRF24L01_ce_t);
+typedef
+uint32_t (*nRF24L01_clock_t)(void);
+
+#ifdef nRF24L01_TRACE
+/* only devices bound to trace wrapper are traced */
+void nRF24L01_trace_begin(nRF24L01_spi_xchg_t, uint8_t op, uint16_t arg);
+void nRF24L01_trace_end(nRF24L01_spi_xchg_t, uint8_t op);
+#endif
 
 typedef struct
 {
     nRF24L01_ce_set_t ce_set;
     nRF24L01_spi_xchg_t spi_xchg;
+    nRF24L01_clock_t clock; // optional (us), set after init to measure turnaround
+    uint32_t event_time; // event entry, turnaround pending
     struct
     {
         const uint8_t *begin;
@@ -298,18 +323,75 @@ typedef struct
     struct
     {
         uint8_t updated : 1;
-        uint8_t : 7;
+        uint8_t turnaround : 1; // transceive: switch to RX once sent
+        uint8_t : 6;
     };
+    struct
+    {
+        uint16_t rx_full; // RX FIFO found full, radio drops payloads
+        uint16_t rx_overflow; // payload larger than recv() buffer, dropped
+        uint16_t rx_flush; // RX FIFO flushed (invalid pipe)
+        uint16_t rx_spurious; // RX_DR with empty RX FIFO
+        /* transceive TX -> RX switch: event entry to CE high + settling (us),
+         * measured if clock is set */
+        uint16_t turnaround_num;
+        uint16_t turnaround_max;
+        uint32_t turnaround_sum;
+    } stat;
 } nRF24L01_t;
 
-/* SPI must be active before calling init() */
+/* SPI must be active before calling init(), with nRF24L01_HAL_STATIC
+ * driver accesses radio through nRF24L01_hal.h, ce_set/spi_xchg are kept
+ * for layers above */
 void nRF24L01_init(
     nRF24L01_t *,
     nRF24L01_ce_set_t,
     nRF24L01_spi_xchg_t);
 
+/* operation boundaries for SPI trace (nRF24L01_trace.h),
+ * compiled in with -DnRF24L01_TRACE */
+#define nRF24L01_TRACE_OP_INIT 0
+#define nRF24L01_TRACE_OP_EVENT 1
+#define nRF24L01_TRACE_OP_SEND 2
+#define nRF24L01_TRACE_OP_RECV 3
+#define nRF24L01_TRACE_OP_RPD 4
+#define nRF24L01_TRACE_OP_READ_REG 5
+#define nRF24L01_TRACE_OP_WRITE_REG 6
+#define nRF24L01_TRACE_OP_CFG 7
+#define nRF24L01_TRACE_OP_STATUS 8
+#define nRF24L01_TRACE_OP_TRANSCEIVE 9 // arg: tx size | rx size << 8 (up to 255)
+#define nRF24L01_TRACE_OP_CANCEL 10
+#define nRF24L01_TRACE_OP_POWER 11 // arg: PWR_UP
+#define nRF24L01_TRACE_OP_NUM 12
+
+#if defined(nRF24L01_TRACE) && defined(nRF24L01_HAL_STATIC)
+#error "trace wraps spi_xchg pointer, not available with nRF24L01_HAL_STATIC"
+#endif
+
+#ifdef nRF24L01_TRACE
+#define nRF24L01_TRACE_BEGIN(dev, op, arg) \
+    nRF24L01_trace_begin((dev)->spi_xchg, nRF24L01_TRACE_OP_##op, arg)
+#define nRF24L01_TRACE_END(dev, op) \
+    nRF24L01_trace_end((dev)->spi_xchg, nRF24L01_TRACE_OP_##op)
+#else
+#define nRF24L01_TRACE_BEGIN(dev, op, arg)
+#define nRF24L01_TRACE_END(dev, op)
+#endif
+
+#ifdef nRF24L01_HAL_STATIC
+#define nRF24L01_SPI_XCHG(dev, begin, end) nRF24L01_hal_spi_xchg(begin, end)
+#else
+#define nRF24L01_SPI_XCHG(dev, begin, end) (dev)->spi_xchg(begin, end)
+#endif
+
+#ifdef nRF24L01_HAL_STATIC
+/* register write accessor, no command buffer */
+#define nRF24L01_CFG(dev, tag, ...) \
+    nRF24L01_hal_write_##tag((nRF24L01_##tag##_t){__VA_ARGS__})
+#else
 #define nRF24L01_CFG(dev, tag, ...) \
     { \
+        nRF24L01_TRACE_BEGIN(dev, CFG, nRF24L01_ADDR_##tag); \
         union { \
             struct { \
                 nRF24L01_spi_cmd_t cmd; \
@@ -321,11 +403,15 @@ void nRF24L01_init(
             .cmd = nRF24L01_W_REGISTER(nRF24L01_ADDR_##tag), \
             .data = {__VA_ARGS__} \
         }; \
-        (dev)->spi_xchg(xdata__.byte, xdata__.byte + sizeof(xdata__)); \
+        nRF24L01_SPI_XCHG(dev, xdata__.byte, xdata__.byte + sizeof(xdata__)); \
+        nRF24L01_TRACE_END(dev, CFG); \
     }
+#endif
 
 void nRF24L01_event(nRF24L01_t *);
 
+/* data is split into payloads, up to nRF24L01_FIFO_SIZE are queued ahead
+ * so transmitter does not wait for MCU between payloads */
 void nRF24L01_send(
     nRF24L01_t *,
     const uint8_t *begin, const uint8_t *const end,
@@ -333,6 +419,9 @@ void nRF24L01_send(
     nRF24L01_err_cb_t,
     uintptr_t user_data);
 
+/* receives single payload, err_cb is called if payload does not fit into
+ * [begin, end) (payload is dropped) or RX FIFO is inconsistent (flushed),
+ * RX FIFO found full is only counted (dev->stat.rx_full), reception goes on */
 void nRF24L01_recv(
     nRF24L01_t *,
     uint8_t *begin, const uint8_t *const end,
@@ -340,6 +429,47 @@ void nRF24L01_recv(
     nRF24L01_err_cb_t,
     uintptr_t user_data);
 
+/* request/response: sends [tx_begin, tx_end) and once TX FIFO is empty
+ * switches to RX within same event (CE low, PRIM_RX, CE high, no round trip
+ * through application), single payload is received into [rx_begin, rx_end).
+ * send_cb is called when receiver was enabled (reply window opens
+ * nRF24L01_SETTLE_US later), recv_cb with reply, err_cb on MAX_RT or
+ * reception error. Window is bounded by caller: nRF24L01_cancel() */
+void nRF24L01_transceive(
+    nRF24L01_t *,
+    const uint8_t *tx_begin, const uint8_t *const tx_end,
+    uint8_t *rx_begin, const uint8_t *const rx_end,
+    nRF24L01_send_cb_t,
+    nRF24L01_recv_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* stops send/recv/transceive: CE low, TX FIFO flushed, callbacks dropped */
+void nRF24L01_cancel(nRF24L01_t *);
+
+/* same as cancel() and PWR_UP cleared (~1uA), registers are retained */
+void nRF24L01_power_down(nRF24L01_t *);
+
+/* PWR_UP set, radio reaches standby-I nRF24L01_POWER_UP_US later,
+ * send/recv should not be called before (schedule them, do not busy wait) */
+void nRF24L01_power_up(nRF24L01_t *);
+
 nRF24L01_rpd_t nRF24L01_rpd(nRF24L01_t *);
 
+/* STATUS register (single byte NOP transaction), status bits are set even
+ * if their interrupts are masked so FIFOs can be serviced by polling */
+nRF24L01_status_t nRF24L01_status(nRF24L01_t *);
+
+/* run-time register access (nRF24L01_CFG() requires compile-time tag),
+ * multi-byte registers (addresses) are written LSB first */
+uint8_t nRF24L01_read_register(nRF24L01_t *, uint8_t addr);
+void nRF24L01_write_register(
+    nRF24L01_t *,
+    uint8_t addr,
+    const uint8_t *begin, const uint8_t *const end);
+
 void nRF24L01_dump(nRF24L01_t *);
+
+#ifdef nRF24L01_HAL_STATIC
+#include "nRF24L01_hal.h"
+#endif
@@ -0,0 +1,437 @@
+#include <string.h>
+
+#include "nRF24L01_arq.h"
+
+#define WINDOW nRF24L01_ARQ_WINDOW
+#define FRAME_SIZE nRF24L01_ARQ_FRAME_SIZE
+#define FRAGMENT_SIZE nRF24L01_ARQ_FRAGMENT_SIZE
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define ACK_SIZE (sizeof(header_t) + 2)
+
+#define TYPE_DATA 0
+#define TYPE_ACK 1
+
+typedef struct
+{
+    uint8_t type : 1;
+    uint8_t poll : 1; // DATA: ACK requested
+    uint8_t last : 1; // DATA: last fragment, ACK: transfer complete
+    uint8_t xid : 4; // transfer id, incremented with every transfer
+    uint8_t : 1;
+    uint8_t seq; // DATA: fragment index, ACK: next expected fragment
+} header_t;
+
+typedef union
+{
+    struct
+    {
+        header_t header;
+        union
+        {
+            uint8_t data[FRAGMENT_SIZE];
+            struct
+            {
+                // ACK: bit N - fragment seq + 1 + N received
+                uint8_t bitmap;
+                uint8_t credit; // ACK: fragments allowed in flight, 0: XOFF
+            };
+        };
+    };
+    uint8_t byte[0];
+} frame_t;
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(nRF24L01_arq_t *arq)
+{
+    arq->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        arq->dev,
+        arq->frame, arq->frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)arq);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_arq_t *)user_data);
+}
+
+static
+void transmit(nRF24L01_arq_t *arq, uint8_t size, nRF24L01_send_cb_t cb)
+{
+    arq->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        arq->dev,
+        arq->frame, arq->frame + size,
+        cb,
+        NULL,
+        (uintptr_t)arq);
+}
+
+/* sender ------------------------------------------------------------------ */
+
+static
+uint8_t tx_window_has_next(const nRF24L01_arq_t *arq)
+{
+    return
+        arq->tx.next < arq->tx.frag_num
+        && arq->tx.credit > (uint8_t)(arq->tx.next - arq->tx.base);
+}
+
+static
+void tx_finish(nRF24L01_arq_t *arq, uint8_t success)
+{
+    const nRF24L01_arq_send_cb_t cb = arq->tx.cb;
+    const nRF24L01_arq_err_cb_t err_cb = arq->tx.err_cb;
+    const uintptr_t user_data = arq->tx.user_data;
+
+    arq->tx.begin = NULL;
+    arq->tx.end = NULL;
+    arq->tx.cb = NULL;
+    arq->tx.err_cb = NULL;
+    arq->tx.user_data = 0;
+    arq->tx.active = 0;
+    arq->tx.waiting = 0;
+    ++arq->tx.xid;
+
+    if(success) { if(cb) (*cb)(user_data); }
+    else { if(err_cb) (*err_cb)(user_data); }
+}
+
+static
+void on_data_sent(uintptr_t);
+
+static
+void tx_pump(nRF24L01_arq_t *arq)
+{
+    uint8_t seq;
+
+    if(arq->tx.resend)
+    {
+        uint8_t i = 0;
+
+        while(!(arq->tx.resend & (1 << i))) ++i;
+        arq->tx.resend &= ~(1 << i);
+        seq = arq->tx.base + i;
+        ++arq->tx.retransmitted;
+    }
+    else seq = arq->tx.next++;
+
+    frame_t *frame = (frame_t *)arq->frame;
+    const uint8_t *data = arq->tx.begin + (size_t)seq * FRAGMENT_SIZE;
+    const uint8_t data_size = MIN(FRAGMENT_SIZE, (size_t)(arq->tx.end - data));
+
+    /* poll for ACK with last frame of the burst */
+    arq->tx.waiting = !arq->tx.resend && !tx_window_has_next(arq);
+    arq->tx.age = 0;
+
+    frame->header = (header_t)
+    {
+        .type = TYPE_DATA,
+        .poll = arq->tx.waiting,
+        .last = seq + 1 == arq->tx.frag_num,
+        .xid = arq->tx.xid,
+        .seq = seq
+    };
+    memcpy(frame->data, data, data_size);
+    transmit(arq, sizeof(header_t) + data_size, on_data_sent);
+}
+
+static
+void on_data_sent(uintptr_t user_data)
+{
+    nRF24L01_arq_t *arq = (nRF24L01_arq_t *)user_data;
+
+    if(!arq->tx.active) return;
+    if(arq->tx.waiting) listen(arq);
+    else tx_pump(arq);
+}
+
+static
+void on_ack(nRF24L01_arq_t *arq, const frame_t *frame)
+{
+    if(!arq->tx.active || !arq->tx.waiting) goto ignore;
+    if(frame->header.xid != arq->tx.xid) goto ignore;
+
+    if(frame->header.last)
+    {
+        tx_finish(arq, 1);
+        goto exit;
+    }
+
+    if(!frame->credit)
+    {
+        /* receiver is alive but not ready, poll again after timeout */
+        ++arq->tx.xoff;
+        arq->tx.retry = 0;
+        arq->tx.age = 0;
+        goto ignore;
+    }
+    arq->tx.credit = MIN(frame->credit, WINDOW);
+
+    const uint8_t base = frame->header.seq;
+
+    if(base < arq->tx.base || base > arq->tx.next) goto ignore;
+
+    arq->tx.base = base;
+
+    if(base == arq->tx.frag_num)
+    {
+        tx_finish(arq, 1);
+        goto exit;
+    }
+
+    /* every fragment sent before the poll and not reported is lost */
+    const uint16_t acked = (uint16_t)frame->bitmap << 1;
+    const uint8_t in_flight = arq->tx.next - base;
+
+    arq->tx.resend = 0;
+    for(uint8_t i = 0; i < in_flight; ++i)
+    {
+        if(!(acked & (1 << i))) arq->tx.resend |= 1 << i;
+    }
+    arq->tx.retry = 0;
+    tx_pump(arq);
+    goto exit;
+ignore:
+    listen(arq);
+exit:
+    ; // this is required by syntax
+}
+
+/* receiver ---------------------------------------------------------------- */
+
+static
+uint8_t rx_complete(const nRF24L01_arq_t *arq)
+{
+    return arq->rx.last_valid && arq->rx.base > arq->rx.last;
+}
+
+static
+void on_ack_sent(uintptr_t user_data)
+{
+    nRF24L01_arq_t *arq = (nRF24L01_arq_t *)user_data;
+
+    listen(arq);
+
+    if(!arq->rx.active || !rx_complete(arq)) return;
+
+    uint8_t *const begin = arq->rx.begin;
+    uint8_t *const end =
+        begin + (size_t)arq->rx.last * FRAGMENT_SIZE + arq->rx.last_size;
+    const nRF24L01_arq_recv_cb_t cb = arq->rx.cb;
+    const uintptr_t rx_user_data = arq->rx.user_data;
+
+    arq->rx.begin = NULL;
+    arq->rx.end = NULL;
+    arq->rx.cb = NULL;
+    arq->rx.user_data = 0;
+    arq->rx.active = 0;
+    arq->rx.done_xid = arq->rx.xid;
+    arq->rx.done_valid = 1;
+
+    if(cb) (*cb)(begin, end, rx_user_data);
+}
+
+static
+uint8_t rx_credit(nRF24L01_arq_t *arq)
+{
+    const uint16_t rx_full = arq->dev->stat.rx_full;
+
+    /* FIFO filled up during burst: back off, otherwise probe for more */
+    if(rx_full != arq->rx.rx_full) arq->rx.credit = (arq->rx.credit + 1) / 2;
+    else if(WINDOW > arq->rx.credit) ++arq->rx.credit;
+
+    arq->rx.rx_full = rx_full;
+    return arq->rx.credit;
+}
+
+static
+void send_ack(nRF24L01_arq_t *arq, uint8_t xid, uint8_t complete)
+{
+    frame_t *frame = (frame_t *)arq->frame;
+    const uint8_t credit = arq->rx.active ? rx_credit(arq) : 0;
+
+    frame->header = (header_t)
+    {
+        .type = TYPE_ACK,
+        .last = complete,
+        .xid = xid,
+        .seq = arq->rx.base
+    };
+    frame->bitmap = arq->rx.received;
+    frame->credit = credit;
+    transmit(arq, ACK_SIZE, on_ack_sent);
+}
+
+static
+void rx_reset(nRF24L01_arq_t *arq)
+{
+    arq->rx.base = 0;
+    arq->rx.received = 0;
+    arq->rx.last = 0;
+    arq->rx.last_size = 0;
+    arq->rx.last_valid = 0;
+}
+
+static
+void on_data(nRF24L01_arq_t *arq, const frame_t *frame, uint8_t size)
+{
+    const header_t header = frame->header;
+
+    if(arq->rx.done_valid && header.xid == arq->rx.done_xid)
+    {
+        /* transfer was already delivered, ACK was lost */
+        if(header.poll) send_ack(arq, header.xid, 1);
+        else listen(arq);
+        goto exit;
+    }
+
+    if(!arq->rx.active)
+    {
+        /* XOFF */
+        if(header.poll) send_ack(arq, header.xid, 0);
+        else listen(arq);
+        goto exit;
+    }
+
+    if(header.xid != arq->rx.xid)
+    {
+        rx_reset(arq);
+        arq->rx.xid = header.xid;
+    }
+
+    const uint8_t seq = header.seq;
+    const uint8_t data_size = size - sizeof(header_t);
+    const size_t offset = (size_t)seq * FRAGMENT_SIZE;
+
+    if(seq < arq->rx.base || seq - arq->rx.base > WINDOW) goto ack;
+    if(offset + data_size > (size_t)(arq->rx.end - arq->rx.begin)) goto ack;
+
+    memcpy(arq->rx.begin + offset, frame->data, data_size);
+
+    if(header.last)
+    {
+        arq->rx.last = seq;
+        arq->rx.last_size = data_size;
+        arq->rx.last_valid = 1;
+    }
+
+    if(seq == arq->rx.base)
+    {
+        ++arq->rx.base;
+        while(arq->rx.received & 1)
+        {
+            arq->rx.received >>= 1;
+            ++arq->rx.base;
+        }
+        arq->rx.received >>= 1;
+    }
+    else arq->rx.received |= 1 << (seq - arq->rx.base - 1);
+ack:
+    if(header.poll) send_ack(arq, header.xid, rx_complete(arq));
+    else listen(arq);
+exit:
+    ; // this is required by syntax
+}
+
+/* ------------------------------------------------------------------------- */
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_arq_t *arq = (nRF24L01_arq_t *)user_data;
+    const frame_t *frame = (const frame_t *)arq->frame;
+    const uint8_t size = curr - arq->frame;
+
+    if(size < sizeof(header_t)) listen(arq);
+    else if(TYPE_ACK == frame->header.type)
+    {
+        if(ACK_SIZE > size) listen(arq);
+        else on_ack(arq, frame);
+    }
+    else on_data(arq, frame, size);
+}
+
+void nRF24L01_arq_init(
+    nRF24L01_arq_t *arq,
+    nRF24L01_t *dev,
+    uint8_t timeout,
+    uint8_t retry_max)
+{
+    memset(arq, 0, sizeof(nRF24L01_arq_t));
+    arq->dev = dev;
+    arq->timeout = timeout;
+    arq->retry_max = retry_max;
+    arq->tx.credit = WINDOW;
+    arq->rx.credit = WINDOW;
+}
+
+void nRF24L01_arq_send(
+    nRF24L01_arq_t *arq,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_arq_send_cb_t cb,
+    nRF24L01_arq_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    const size_t size = end - begin;
+
+    arq->tx.begin = begin;
+    arq->tx.end = end;
+    arq->tx.cb = cb;
+    arq->tx.err_cb = err_cb;
+    arq->tx.user_data = user_data;
+    /* empty transfer is sent as single empty fragment */
+    arq->tx.frag_num = size ? (size + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE : 1;
+    arq->tx.base = 0;
+    arq->tx.next = 0;
+    arq->tx.resend = 0;
+    arq->tx.retry = 0;
+    arq->tx.active = 1;
+    tx_pump(arq);
+}
+
+void nRF24L01_arq_recv(
+    nRF24L01_arq_t *arq,
+    uint8_t *begin, const uint8_t *const end,
+    nRF24L01_arq_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    arq->rx.begin = begin;
+    arq->rx.end = end;
+    arq->rx.cb = cb;
+    arq->rx.user_data = user_data;
+    rx_reset(arq);
+    arq->rx.active = 1;
+    listen(arq);
+}
+
+void nRF24L01_arq_tick(nRF24L01_arq_t *arq)
+{
+    if(!arq->tx.active || !arq->tx.waiting) return;
+    if(++arq->tx.age < arq->timeout) return;
+
+    if(arq->tx.retry++ >= arq->retry_max)
+    {
+        tx_finish(arq, 0);
+        return;
+    }
+
+    /* poll again with oldest fragment, ACK will report what is missing */
+    arq->tx.resend = 1;
+    tx_pump(arq);
+}
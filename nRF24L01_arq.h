@@ -0,0 +1,118 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Software reliable transport (selective repeat ARQ).
+ *
+ * Transfer is split into fragments, each sent as a single payload carrying
+ * its index. Sender keeps up to nRF24L01_ARQ_WINDOW fragments in flight and
+ * only the last fragment of each burst requests (polls) an ACK. Receiver
+ * answers with cumulative ACK (next expected fragment) and a bitmap of
+ * fragments received out of order, sender then resends only missing ones.
+ *
+ * Fragments are written by receiver directly at their offset in the
+ * destination buffer so no reordering buffer is required.
+ *
+ * Flow control: ACK carries credit, number of fragments sender may have in
+ * flight. Receiver halves credit whenever its RX FIFO was found full
+ * (payloads dropped by radio) and grows it by one after clean burst. Credit 0
+ * (XOFF) is sent when there is no receive buffer (nRF24L01_arq_recv() not
+ * called yet), sender keeps polling with oldest fragment every timeout and
+ * does not give up while receiver answers XOFF.
+ *
+ * Auto ACK (en_aa) and auto retransmit (setup_retr.ARC) are expected to be
+ * disabled. Both ends must use same payload address for TX and RX (pipe 0). */
+
+#define nRF24L01_ARQ_WINDOW 8
+/* frame is sent as single payload (driver header excluded) */
+#define nRF24L01_ARQ_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_ARQ_FRAGMENT_SIZE (nRF24L01_ARQ_FRAME_SIZE - 2)
+#define nRF24L01_ARQ_FRAGMENT_MAX_NUM 255
+#define nRF24L01_ARQ_MAX_SIZE \
+    ((size_t)nRF24L01_ARQ_FRAGMENT_MAX_NUM * nRF24L01_ARQ_FRAGMENT_SIZE)
+
+typedef
+void (*nRF24L01_arq_send_cb_t)(uintptr_t);
+typedef
+void (*nRF24L01_arq_recv_cb_t)(uint8_t *begin, uint8_t *end, uintptr_t);
+typedef
+void (*nRF24L01_arq_err_cb_t)(uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    uint8_t frame[nRF24L01_ARQ_FRAME_SIZE];
+    uint8_t timeout; // ticks to wait for ACK
+    uint8_t retry_max; // consecutive timeouts before giving up
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_arq_send_cb_t cb;
+        nRF24L01_arq_err_cb_t err_cb;
+        uintptr_t user_data;
+        uint8_t frag_num;
+        uint8_t base; // oldest not acknowledged fragment
+        uint8_t next; // next fragment never sent
+        uint8_t resend; // bit N: fragment base + N has to be resent
+        uint8_t age; // ticks since ACK was polled
+        uint8_t retry;
+        uint8_t credit; // fragments allowed in flight
+        uint16_t retransmitted; // statistics
+        uint16_t xoff; // statistics, XOFF received
+        struct
+        {
+            uint8_t active : 1;
+            uint8_t waiting : 1; // for ACK
+            uint8_t : 2;
+            uint8_t xid : 4;
+        };
+    } tx;
+    struct
+    {
+        uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_arq_recv_cb_t cb;
+        uintptr_t user_data;
+        uint8_t base; // next expected fragment
+        uint8_t received; // bit N: fragment base + 1 + N received
+        uint8_t last; // index of last fragment (valid if last_valid)
+        uint8_t last_size; // data size of last fragment
+        uint8_t credit; // granted with next ACK
+        uint16_t rx_full; // dev->stat.rx_full seen with last ACK
+        struct
+        {
+            uint8_t active : 1;
+            uint8_t last_valid : 1;
+            uint8_t done_valid : 1;
+            uint8_t : 1;
+            uint8_t xid : 4;
+            uint8_t done_xid : 4; // id of last delivered transfer
+            uint8_t : 4;
+        };
+    } rx;
+} nRF24L01_arq_t;
+
+void nRF24L01_arq_init(
+    nRF24L01_arq_t *,
+    nRF24L01_t *,
+    uint8_t timeout,
+    uint8_t retry_max);
+
+/* size of [begin, end) must not exceed nRF24L01_ARQ_MAX_SIZE */
+void nRF24L01_arq_send(
+    nRF24L01_arq_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_arq_send_cb_t,
+    nRF24L01_arq_err_cb_t,
+    uintptr_t user_data);
+
+/* starts listening, cb is called once whole transfer was received */
+void nRF24L01_arq_recv(
+    nRF24L01_arq_t *,
+    uint8_t *begin, const uint8_t *const end,
+    nRF24L01_arq_recv_cb_t,
+    uintptr_t user_data);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_arq_tick(nRF24L01_arq_t *);
@@ -0,0 +1,175 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_arq.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Selective repeat ARQ test against simulated radios (nRF24L01_sim).
+ *
+ * Sender transfers random messages (0 - nRF24L01_ARQ_MAX_SIZE) back to
+ * back over lossy air (every payload and ACK lost with loss_ppm
+ * probability). Receiver stalls every 3rd message: next receive buffer is
+ * given stall_ms after delivery, sender is answered XOFF (credit 0) in
+ * between and has to resume. Checked: every message is delivered exactly
+ * once, in order and intact (memcmp), sender never gives up.
+ *
+ * Reported: messages, bytes, payloads on air, fragments sent and
+ * retransmitted, XOFFs, sender credit (window) at the end, goodput.
+ * Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_arq_bench [loss_ppm [seed [messages [stall_ms]]]] */
+
+#define TICK_PERIOD 1000 // us
+#define TIMEOUT 3 // ticks
+#define RETRY_MAX 20
+#define TIMEOUT_US UINT64_C(600000000)
+#define FAIL(what) nRF24L01_sim_bench_fail("arq: %s (message %" PRIu32 ")", what, delivered_)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_arq_t arq;
+} node_t;
+
+static nRF24L01_sim_air_t air;
+static node_t tx_;
+static node_t rx_;
+static uint8_t msg_[nRF24L01_ARQ_MAX_SIZE];
+static uint8_t buf_[nRF24L01_ARQ_MAX_SIZE];
+static uint32_t size_; // of message in flight
+static uint32_t started_;
+static uint32_t sent_; // messages acknowledged
+static uint32_t delivered_;
+static uint32_t bytes_;
+static uint32_t fragments_;
+static uint64_t resume_; // receiver gives buffer at
+static uint32_t seed_ = 1;
+
+static
+void configure(node_t *node)
+{
+    nRF24L01_sim_bench_init(&node->dev, &node->sim, &air);
+    nRF24L01_arq_init(&node->arq, &node->dev, TIMEOUT, RETRY_MAX);
+}
+
+static
+void on_sent(uintptr_t user_data);
+
+static
+void on_send_error(uintptr_t user_data)
+{
+    FAIL("sender gave up");
+}
+
+static
+void send_next(void)
+{
+    ++started_;
+    size_ = xorshift32(&seed_) % (nRF24L01_ARQ_MAX_SIZE + 1);
+    for(uint32_t i = 0; i < size_; ++i) msg_[i] = xorshift32(&seed_);
+    /* empty message is single empty fragment */
+    fragments_ += size_ ? (size_ + nRF24L01_ARQ_FRAGMENT_SIZE - 1) / nRF24L01_ARQ_FRAGMENT_SIZE : 1;
+    nRF24L01_arq_send(&tx_.arq, msg_, msg_ + size_, on_sent, on_send_error, 0);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    ++sent_;
+}
+
+static
+void on_recv(uint8_t *begin, uint8_t *end, uintptr_t stall_us)
+{
+    if(delivered_ + 1 != started_) FAIL("delivered twice");
+    if((size_t)(end - begin) != size_ || memcmp(begin, msg_, size_)) FAIL("message corrupted");
+    ++delivered_;
+    bytes_ += size_;
+    /* XOFF until buffer is given again */
+    resume_ = air.now + (delivered_ % 3 ? 0 : stall_us);
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t loss_ppm = 1 < argc ? strtoul(argv[1], NULL, 0) : 20000;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+    const uint32_t num = 3 < argc ? strtoul(argv[3], NULL, 0) : 30;
+    const uint32_t stall_ms = 4 < argc ? strtoul(argv[4], NULL, 0) : 20;
+
+    if(loss_ppm >= 500000 || !num)
+    {
+        fprintf(stderr, "usage: %s [loss_ppm [seed [messages [stall_ms]]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    seed_ = seed ? seed : 1;
+
+    nRF24L01_sim_air_init(&air, loss_ppm, seed_);
+    configure(&tx_);
+    configure(&rx_);
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    nRF24L01_arq_recv(&rx_.arq, buf_, buf_ + sizeof(buf_), on_recv, stall_ms * 1000);
+    resume_ = nRF24L01_SIM_NEVER;
+
+    const uint64_t begin = air.now;
+    uint64_t tick = air.now + TICK_PERIOD;
+
+    send_next();
+    while((sent_ < num || delivered_ < num) && air.now < begin + TIMEOUT_US)
+    {
+        nRF24L01_sim_bench_dispatch(&tx_.dev, &tx_.sim);
+        nRF24L01_sim_bench_dispatch(&rx_.dev, &rx_.sim);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        if(resume_ <= air.now)
+        {
+            resume_ = nRF24L01_SIM_NEVER;
+            nRF24L01_arq_recv(&rx_.arq, buf_, buf_ + sizeof(buf_), on_recv, stall_ms * 1000);
+        }
+        /* next message once previous one is acknowledged and delivered
+         * (receiver delivers after its ACK is sent) */
+        if(!tx_.arq.tx.active && sent_ == started_ && delivered_ == started_ && num > sent_)
+        {
+            send_next();
+        }
+        nRF24L01_arq_tick(&tx_.arq);
+    }
+
+    if(num != sent_ || num != delivered_) FAIL("timeout");
+    if(stall_ms && num >= 3 && !tx_.arq.tx.xoff) FAIL("receiver stall not signalled");
+
+    const double time_ms = (double)(air.now - begin) / 1000;
+
+    printf(
+        "{\"loss_ppm\":%" PRIu32 ",\"messages\":%" PRIu32 ",\"bytes\":%" PRIu32
+        ",\"time_ms\":%.1f,\"payloads\":%" PRIu32 ",\"lost\":%" PRIu32
+        ",\"fragments\":%" PRIu32 ",\"retransmitted\":%" PRIu16
+        ",\"xoff\":%" PRIu16 ",\"window\":%" PRIu8 ",\"rx_full\":%" PRIu16
+        ",\"goodput_kbps\":%.1f,\"ok\":1}\n",
+        loss_ppm,
+        delivered_,
+        bytes_,
+        time_ms,
+        tx_.sim.stat.tx + rx_.sim.stat.tx,
+        tx_.sim.stat.lost + rx_.sim.stat.lost,
+        fragments_,
+        tx_.arq.tx.retransmitted,
+        tx_.arq.tx.xoff,
+        tx_.arq.tx.credit,
+        rx_.dev.stat.rx_full,
+        bytes_ * 8 / time_ms);
+
+    nRF24L01_sim_release(&tx_.sim);
+    nRF24L01_sim_release(&rx_.sim);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#include <string.h>
+
+#include "nRF24L01_batch.h"
+
+typedef struct
+{
+    // record size without header
+    uint8_t size : 5;
+    uint8_t : 3;
+} record_header_t;
+
+#define CAPACITY nRF24L01_BATCH_CAPACITY
+#define RECORD_MAX_SIZE nRF24L01_BATCH_RECORD_MAX_SIZE
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_batch_t *batch = (nRF24L01_batch_t *)user_data;
+
+    batch->busy = 0;
+
+    if(batch->pending)
+    {
+        batch->pending = 0;
+        nRF24L01_batch_flush(batch);
+    }
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_batch_t *batch = (nRF24L01_batch_t *)user_data;
+
+    /* records in flight are lost, keep collecting */
+    batch->busy = 0;
+    batch->pending = 0;
+
+    if(batch->err_cb) (*batch->err_cb)(status, fifo_status, batch->user_data);
+}
+
+void nRF24L01_batch_init(
+    nRF24L01_batch_t *batch,
+    nRF24L01_t *dev,
+    uint8_t timeout,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    memset(batch, 0, sizeof(nRF24L01_batch_t));
+    batch->dev = dev;
+    batch->timeout = timeout;
+    batch->err_cb = err_cb;
+    batch->user_data = user_data;
+}
+
+uint8_t nRF24L01_batch_push(
+    nRF24L01_batch_t *batch,
+    const uint8_t *begin, const uint8_t *const end)
+{
+    const size_t size = end - begin;
+
+    if(size > RECORD_MAX_SIZE) return 0;
+
+    if(sizeof(record_header_t) + size > CAPACITY - batch->size[batch->curr])
+    {
+        /* current buffer is full, other one is still in flight */
+        if(batch->busy) return 0;
+        nRF24L01_batch_flush(batch);
+    }
+
+    uint8_t *dst = batch->buf[batch->curr] + batch->size[batch->curr];
+
+    if(!batch->size[batch->curr]) batch->age = 0;
+
+    ((record_header_t *)dst)->size = size;
+    memcpy(dst + sizeof(record_header_t), begin, size);
+    batch->size[batch->curr] += sizeof(record_header_t) + size;
+
+    if(CAPACITY == batch->size[batch->curr]) nRF24L01_batch_flush(batch);
+    return 1;
+}
+
+void nRF24L01_batch_flush(nRF24L01_batch_t *batch)
+{
+    const uint8_t curr = batch->curr;
+
+    if(!batch->size[curr]) return;
+
+    if(batch->busy)
+    {
+        batch->pending = 1;
+        return;
+    }
+
+    batch->busy = 1;
+    batch->curr = !curr;
+    batch->size[!curr] = 0;
+
+    const uint8_t *begin = batch->buf[curr];
+    const uint8_t *end = begin + batch->size[curr];
+
+    batch->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(batch->dev, begin, end, on_sent, on_error, (uintptr_t)batch);
+}
+
+void nRF24L01_batch_tick(nRF24L01_batch_t *batch)
+{
+    if(!batch->size[batch->curr]) return;
+
+    if(batch->age >= batch->timeout) nRF24L01_batch_flush(batch);
+    else ++batch->age;
+}
+
+uint8_t nRF24L01_batch_split(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t pipe_no,
+    nRF24L01_batch_record_cb_t cb,
+    uintptr_t user_data)
+{
+    while(begin < end)
+    {
+        const uint8_t size = ((const record_header_t *)begin)->size;
+
+        begin += sizeof(record_header_t);
+        if(size > end - begin) return 0;
+        if(cb) (*cb)(begin, begin + size, pipe_no, user_data);
+        begin += size;
+    }
+    return 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Small record aggregation (Nagle-style batching).
+ *
+ * Records are packed back to back into a single payload, each one prefixed
+ * with a 1B header holding its size. Payload is sent when next record does
+ * not fit or when it is older than configured timeout (in ticks).
+ *
+ * payload: [hdr|data...][hdr|data...]...
+ *
+ * Two buffers are used: one is filled while the other is in flight. */
+
+/* capacity of single payload available for records (driver header excluded) */
+#define nRF24L01_BATCH_CAPACITY (nRF24L01_PAYLOAD_SIZE - 1)
+/* max size of single record */
+#define nRF24L01_BATCH_RECORD_MAX_SIZE (nRF24L01_BATCH_CAPACITY - 1)
+
+typedef
+void (*nRF24L01_batch_record_cb_t)(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t pipe_no,
+    uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    uint8_t buf[2][nRF24L01_BATCH_CAPACITY];
+    uint8_t size[2];
+    nRF24L01_err_cb_t err_cb;
+    uintptr_t user_data;
+    uint8_t timeout; // ticks, 0: flush on every tick
+    uint8_t age; // ticks since first record was appended to current buffer
+    struct
+    {
+        uint8_t curr : 1; // buffer being filled
+        uint8_t busy : 1; // other buffer in flight
+        uint8_t pending : 1; // flush requested while busy
+        uint8_t : 5;
+    };
+} nRF24L01_batch_t;
+
+void nRF24L01_batch_init(
+    nRF24L01_batch_t *,
+    nRF24L01_t *,
+    uint8_t timeout,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* returns 0 if record can not be accepted (too big or both buffers in use) */
+uint8_t nRF24L01_batch_push(
+    nRF24L01_batch_t *,
+    const uint8_t *begin, const uint8_t *const end);
+
+void nRF24L01_batch_flush(nRF24L01_batch_t *);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_batch_tick(nRF24L01_batch_t *);
+
+/* split received payload data back into records,
+ * returns 0 if malformed record was encountered */
+uint8_t nRF24L01_batch_split(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t pipe_no,
+    nRF24L01_batch_record_cb_t,
+    uintptr_t user_data);
@@ -0,0 +1,216 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_batch.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Record batching test against simulated radios (nRF24L01_sim).
+ *
+ * Sender pushes records of random size (mostly below 8B, up to
+ * nRF24L01_BATCH_RECORD_MAX_SIZE) as fast as batch accepts them (push
+ * refused: both buffers in use, air is run until one is free), receiver
+ * splits payloads back. Checked: records
+ * arrive whole and in order (size and data), record is not sent before
+ * timeout ticks (tick flush), oversized record is refused, split() rejects
+ * malformed payload and takes size from 5 low bits of header only.
+ *
+ * Reported: records, payloads, records per payload, refused pushes.
+ * Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_batch_bench [seed [records]] */
+
+#define TICK_PERIOD 1000 // us
+#define TIMEOUT 3 // ticks
+#define RECORD_MAX_NUM 4096
+#define LOG_SIZE (RECORD_MAX_NUM * (1 + nRF24L01_BATCH_RECORD_MAX_SIZE))
+#define FAIL(what) nRF24L01_sim_bench_fail("batch: %s", what)
+
+static nRF24L01_sim_air_t air;
+static nRF24L01_sim_t tx_sim;
+static nRF24L01_sim_t rx_sim;
+static nRF24L01_t tx_dev;
+static nRF24L01_t rx_dev;
+static nRF24L01_batch_t batch;
+static uint8_t rx_frame[nRF24L01_BATCH_CAPACITY];
+/* size, data of every record */
+static uint8_t sent_log[LOG_SIZE];
+static uint8_t recv_log[LOG_SIZE];
+static uint32_t sent_size;
+static uint32_t recv_size;
+static uint32_t recv_num;
+static uint32_t payload_num;
+static uint32_t error_num;
+static uint64_t tick;
+static uint32_t seed_ = 1;
+
+static
+void on_record(const uint8_t *begin, const uint8_t *const end, uint8_t pipe_no, uintptr_t user_data)
+{
+    const uint8_t size = end - begin;
+
+    if(recv_size + 1 + size > LOG_SIZE) FAIL("receiver log overflow");
+    recv_log[recv_size++] = size;
+    memcpy(recv_log + recv_size, begin, size);
+    recv_size += size;
+    ++recv_num;
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    ++error_num;
+    nRF24L01_recv(&rx_dev, rx_frame, rx_frame + sizeof(rx_frame), on_frame, on_rx_error, 0);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    ++payload_num;
+    if(!nRF24L01_batch_split(rx_frame, curr, pipe_no, on_record, 0)) FAIL("malformed payload");
+    nRF24L01_recv(&rx_dev, rx_frame, rx_frame + sizeof(rx_frame), on_frame, on_rx_error, 0);
+}
+
+static
+void on_tx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    ++error_num;
+}
+
+/* runs air until next tick (included) */
+static
+void step(void)
+{
+    for(;;)
+    {
+        nRF24L01_sim_bench_dispatch(&tx_dev, &tx_sim);
+        nRF24L01_sim_bench_dispatch(&rx_dev, &rx_sim);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        nRF24L01_batch_tick(&batch);
+        return;
+    }
+}
+
+static
+void check_split(void)
+{
+    /* 3 high bits are not part of size */
+    static const uint8_t high[] = {0xE3, 1, 2, 3};
+    static const uint8_t truncated[] = {2, 1, 2, 20, 1, 2, 3, 4, 5};
+    const uint32_t num = recv_num;
+
+    if(!nRF24L01_batch_split(high, high + sizeof(high), 0, NULL, 0)) FAIL("split: high header bits");
+    if(nRF24L01_batch_split(truncated, truncated + sizeof(truncated), 0, NULL, 0)) FAIL("split: truncated record");
+    if(!nRF24L01_batch_split(truncated, truncated + 3, 0, on_record, 0) || num + 1 != recv_num)
+    {
+        FAIL("split: record count");
+    }
+    recv_size = 0;
+    recv_num = 0;
+}
+
+static
+void check_timeout(void)
+{
+    static const uint8_t record[] = {1, 2, 3, 4, 5};
+
+    if(!nRF24L01_batch_push(&batch, record, record + sizeof(record))) FAIL("push refused");
+    /* age reaches timeout on TIMEOUT-th tick, flushed on next one */
+    for(uint8_t i = 0; i < TIMEOUT; ++i)
+    {
+        step();
+        if(payload_num) FAIL("flushed before timeout");
+    }
+    step();
+    step();
+    if(1 != payload_num || 1 != recv_num) FAIL("not flushed after timeout");
+    if(sizeof(record) + 1 != recv_size || memcmp(recv_log + 1, record, sizeof(record))) FAIL("timeout record");
+    recv_size = 0;
+    recv_num = 0;
+    payload_num = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t seed = 1 < argc ? strtoul(argv[1], NULL, 0) : 1;
+    const uint32_t num = 2 < argc ? strtoul(argv[2], NULL, 0) : 2000;
+    uint8_t record[nRF24L01_BATCH_RECORD_MAX_SIZE + 1];
+    uint32_t refused = 0;
+
+    if(!num || num > RECORD_MAX_NUM)
+    {
+        fprintf(stderr, "usage: %s [seed [records (1..%u)]]\n", argv[0], RECORD_MAX_NUM);
+        return EXIT_FAILURE;
+    }
+    seed_ = seed ? seed : 1;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    nRF24L01_sim_bench_init(&tx_dev, &tx_sim, &air);
+    nRF24L01_sim_bench_init(&rx_dev, &rx_sim, &air);
+    nRF24L01_batch_init(&batch, &tx_dev, TIMEOUT, on_tx_error, 0);
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    tick = air.now + TICK_PERIOD;
+    nRF24L01_recv(&rx_dev, rx_frame, rx_frame + sizeof(rx_frame), on_frame, on_rx_error, 0);
+
+    check_split();
+    check_timeout();
+    if(nRF24L01_batch_push(&batch, record, record + sizeof(record))) FAIL("oversized record accepted");
+
+    for(uint32_t i = 0; i < num; ++i)
+    {
+        /* mostly small records (aggregated), some up to max size */
+        const uint8_t size = xorshift32(&seed_) % 4 ? xorshift32(&seed_) % 8 : xorshift32(&seed_) % sizeof(record);
+
+        for(uint8_t j = 0; j < size; ++j) record[j] = xorshift32(&seed_);
+        while(!nRF24L01_batch_push(&batch, record, record + size))
+        {
+            /* both buffers in use */
+            if(!batch.busy) FAIL("push refused while idle");
+            ++refused;
+            step();
+        }
+        sent_log[sent_size++] = size;
+        memcpy(sent_log + sent_size, record, size);
+        sent_size += size;
+    }
+    /* remainder goes on timeout */
+    for(uint8_t i = 0; i < 2 * TIMEOUT; ++i) step();
+
+    if(error_num) FAIL("radio error");
+    if(num != recv_num || sent_size != recv_size || memcmp(sent_log, recv_log, sent_size))
+    {
+        FAIL("records lost or reordered");
+    }
+
+    printf(
+        "{\"records\":%" PRIu32 ",\"bytes\":%" PRIu32 ",\"payloads\":%" PRIu32
+        ",\"records_per_payload\":%.2f,\"refused\":%" PRIu32 ",\"ok\":1}\n",
+        num,
+        sent_size - num,
+        payload_num,
+        (double)num / payload_num,
+        refused);
+
+    nRF24L01_sim_release(&tx_sim);
+    nRF24L01_sim_release(&rx_sim);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,802 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nRF24L01_bench.h"
+
+#define FRAME_SIZE nRF24L01_BENCH_FRAME_SIZE
+#define BUCKET_NUM nRF24L01_BENCH_RTT_BUCKET_NUM
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+#define TYPE_SETUP UINT8_C(0x53) // 'S'
+#define TYPE_DATA UINT8_C(0x44) // 'D'
+#define TYPE_PING UINT8_C(0x50) // 'P'
+#define TYPE_QUERY UINT8_C(0x51) // 'Q'
+#define TYPE_REPORT UINT8_C(0x52) // 'R'
+
+/* us */
+#define IDLE_TIMEOUT UINT32_C(100000) // responder returns to base configuration
+#define DRAIN_TIME (IDLE_TIMEOUT + UINT32_C(50000))
+#define START_DELAY UINT32_C(5000) // responder switches to run configuration
+#define PING_TIMEOUT UINT32_C(20000)
+/* next ping waits for responder to turn echo TX around to RX (settling
+ * plus its event latency, turnaround up to ~550us on Linux loopback),
+ * without auto ACK earlier ping is lost */
+#define PING_GAP UINT32_C(1000)
+#define QUERY_TIMEOUT UINT32_C(50000)
+#define RETRY_DELAY UINT32_C(10000)
+#define TRY_MAX 100
+
+#define STATE_IDLE 0
+#define STATE_SETUP 1
+#define STATE_START 2
+#define STATE_FLOOD 3
+#define STATE_PING_TX 4
+#define STATE_PING_RX 5
+#define STATE_PING_GAP 6
+#define STATE_DRAIN 7
+#define STATE_QUERY_TX 8
+#define STATE_QUERY_RX 9
+#define STATE_DONE 10
+
+/* sweep: mode x size x rate x ack */
+static const uint8_t size_[] = {4, 16, FRAME_SIZE};
+#define SIZE_NUM (sizeof(size_) / sizeof(size_[0]))
+#define RATE_NUM 3
+#define ACK_NUM 2
+#define MODE_NUM 2
+#define RUN_NUM (MODE_NUM * SIZE_NUM * RATE_NUM * ACK_NUM)
+
+typedef union
+{
+    struct
+    {
+        uint8_t type;
+        uint8_t run_id;
+    } hdr;
+    struct
+    {
+        uint8_t type;
+        uint8_t run_id;
+        uint8_t mode;
+        uint8_t size;
+        uint8_t rate;
+        uint8_t ack;
+        uint8_t tries; // retried setup differs, radio drops duplicates
+    } setup;
+    struct
+    {
+        uint8_t type;
+        uint8_t run_id;
+        uint8_t seq[2]; // LSB first
+    } data;
+    struct
+    {
+        uint8_t type;
+        uint8_t run_id;
+        uint8_t recv[2]; // LSB first
+        uint8_t dup[2]; // LSB first
+    } report;
+    uint8_t byte[0];
+} frame_t;
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void configure(nRF24L01_t *dev, uint8_t rate, uint8_t ack)
+{
+    dev->ce_set((nRF24L01_ce_t){.CE = 0});
+
+    /* leftovers of previous run */
+    {
+        uint8_t wdata[] = {nRF24L01_FLUSH_TX};
+        dev->spi_xchg(wdata, wdata + sizeof(wdata));
+    }
+    {
+        uint8_t wdata[] = {nRF24L01_FLUSH_RX};
+        dev->spi_xchg(wdata, wdata + sizeof(wdata));
+    }
+    nRF24L01_CFG(dev, status, .RX_DR = 1, .TX_DS = 1, .MAX_RT = 1);
+
+    /* 2B CRC (required by auto ACK), interrupts not masked */
+    nRF24L01_CFG(
+        dev, config,
+        .PRIM_RX = 0,
+        .PWR_UP = 1,
+        .CRCO = 1,
+        .EN_CRC = 1,
+        .MASK_MAX_RT = 0,
+        .MASK_TX_DS = 0,
+        .MASK_RX_DR = 0);
+    nRF24L01_CFG(dev, en_aa, .ENAA_P0 = ack);
+    nRF24L01_CFG(dev, en_rxaddr, .ERX_P0 = 1);
+    /* 15 re-transmits 750us apart (ACK fits even @ 250kbps) */
+    nRF24L01_CFG(dev, setup_retr, .ARC = ack ? 15 : 0, .ARD = 2);
+    nRF24L01_CFG(
+        dev, rf_setup,
+        .RF_PWR = 3,
+        .RF_DR_HIGH = nRF24L01_BENCH_RATE_2M == rate,
+        .PLL_LOCK = 0,
+        .RF_DR_LOW = nRF24L01_BENCH_RATE_250K == rate,
+        .CONT_WAVE = 0);
+}
+
+static
+void configure_base(nRF24L01_t *dev)
+{
+    configure(dev, nRF24L01_BENCH_RATE_1M, 1);
+}
+
+/* radio stays in RX (CE high), re-arming must not restart 130us settling
+ * or back-to-back payloads are missed */
+static
+void rearm(nRF24L01_bench_t *bench)
+{
+    nRF24L01_recv(
+        bench->dev,
+        bench->rx_frame, bench->rx_frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)bench);
+}
+
+static
+void listen(nRF24L01_bench_t *bench)
+{
+    bench->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    rearm(bench);
+}
+
+static
+void send(
+    nRF24L01_bench_t *bench,
+    uint8_t size,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb)
+{
+    bench->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        bench->dev,
+        bench->tx_frame, bench->tx_frame + size,
+        cb,
+        err_cb,
+        (uintptr_t)bench);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    rearm((nRF24L01_bench_t *)user_data);
+}
+
+/* RTT histogram ------------------------------------------------------------*/
+static
+uint8_t bucket_of(uint16_t value)
+{
+    if(16 > value) return value;
+
+    uint8_t msb = 15;
+
+    while(!(value & (UINT16_C(1) << msb))) --msb;
+    return 16 + (msb - 4) * 4 + ((value >> (msb - 2)) & 3);
+}
+
+static
+uint16_t bucket_max(uint8_t bucket)
+{
+    if(16 > bucket) return bucket;
+
+    const uint8_t msb = (bucket - 16) / 4 + 4;
+    const uint8_t sub = (bucket - 16) % 4;
+
+    return ((uint32_t)(4 + sub + 1) << (msb - 2)) - 1;
+}
+
+static
+uint16_t percentile(const nRF24L01_bench_t *bench, uint8_t pct)
+{
+    const uint32_t target = ((uint32_t)bench->result.recv * pct + 99) / 100;
+    uint32_t sum = 0;
+
+    if(!target) return 0;
+
+    for(uint8_t i = 0; i < BUCKET_NUM; ++i)
+    {
+        sum += bench->rtt_hist[i];
+        if(sum >= target) return MIN(bucket_max(i), bench->result.rtt_max);
+    }
+    return bench->result.rtt_max;
+}
+/*---------------------------------------------------------------------------*/
+
+static
+void run_next(nRF24L01_bench_t *);
+
+static
+void report(nRF24L01_bench_t *bench)
+{
+    if(nRF24L01_BENCH_MODE_PING == bench->result.mode)
+    {
+        bench->result.rtt_p50 = percentile(bench, 50);
+        bench->result.rtt_p90 = percentile(bench, 90);
+        bench->result.rtt_p99 = percentile(bench, 99);
+    }
+
+    if(bench->cb) (*bench->cb)(&bench->result, bench->user_data);
+
+    ++bench->run;
+    run_next(bench);
+}
+
+static
+void on_setup_sent(uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->busy = 0;
+    bench->tries = 0;
+    configure(bench->dev, bench->result.rate, bench->result.ack);
+    bench->state = STATE_START;
+    bench->t_sent = (*bench->clock)();
+}
+
+static
+void on_setup_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->busy = 0;
+    /* retried from tick */
+    bench->t_sent = (*bench->clock)();
+    if(++bench->tries >= TRY_MAX) report(bench);
+}
+
+static
+void setup_send(nRF24L01_bench_t *bench)
+{
+    frame_t *frame = (frame_t *)bench->tx_frame;
+
+    frame->setup.type = TYPE_SETUP;
+    frame->setup.run_id = bench->run_id;
+    frame->setup.mode = bench->result.mode;
+    frame->setup.size = bench->result.size;
+    frame->setup.rate = bench->result.rate;
+    frame->setup.ack = bench->result.ack;
+    frame->setup.tries = bench->tries;
+
+    bench->state = STATE_SETUP;
+    bench->busy = 1;
+    send(bench, sizeof(frame->setup), on_setup_sent, on_setup_error);
+}
+
+static
+void run_next(nRF24L01_bench_t *bench)
+{
+    uint8_t run = bench->run;
+
+    if(RUN_NUM <= run)
+    {
+        bench->state = STATE_DONE;
+        return;
+    }
+
+    memset(&bench->result, 0, sizeof(nRF24L01_bench_result_t));
+    memset(bench->rtt_hist, 0, sizeof(bench->rtt_hist));
+
+    bench->result.ack = run % ACK_NUM;
+    run /= ACK_NUM;
+    bench->result.rate = run % RATE_NUM;
+    run /= RATE_NUM;
+    bench->result.size = size_[run % SIZE_NUM];
+    run /= SIZE_NUM;
+    bench->result.mode = run;
+
+    ++bench->run_id;
+    bench->tries = 0;
+    configure_base(bench->dev);
+    setup_send(bench);
+}
+
+static
+void data_fill(nRF24L01_bench_t *bench, uint8_t type)
+{
+    frame_t *frame = (frame_t *)bench->tx_frame;
+
+    frame->data.type = type;
+    frame->data.run_id = bench->run_id;
+    frame->data.seq[0] = bench->seq;
+    frame->data.seq[1] = bench->seq >> 8;
+
+    for(uint8_t i = sizeof(frame->data); i < bench->result.size; ++i)
+    {
+        frame->byte[i] = bench->seq + i;
+    }
+}
+
+static
+void run_end(nRF24L01_bench_t *bench)
+{
+    const uint16_t num = bench->dev->stat.turnaround_num - bench->turnaround_num;
+
+    if(num)
+    {
+        bench->result.turnaround_avg =
+            (bench->dev->stat.turnaround_sum - bench->turnaround_sum) / num;
+        bench->result.turnaround_max = bench->dev->stat.turnaround_max;
+    }
+    bench->result.duration = (*bench->clock)() - bench->t_start;
+    configure_base(bench->dev);
+    bench->state = STATE_DRAIN;
+    bench->t_sent = (*bench->clock)();
+}
+
+/* flood --------------------------------------------------------------------*/
+static
+void flood_send(nRF24L01_bench_t *);
+
+static
+void flood_next(nRF24L01_bench_t *bench)
+{
+    ++bench->result.count;
+    if(++bench->seq < nRF24L01_BENCH_FLOOD_COUNT) flood_send(bench);
+    else run_end(bench);
+}
+
+static
+void on_flood_sent(uintptr_t user_data)
+{
+    flood_next((nRF24L01_bench_t *)user_data);
+}
+
+static
+void on_flood_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    ++bench->result.tx_err;
+    flood_next(bench);
+}
+
+static
+void flood_send(nRF24L01_bench_t *bench)
+{
+    data_fill(bench, TYPE_DATA);
+    send(bench, bench->result.size, on_flood_sent, on_flood_error);
+}
+/*---------------------------------------------------------------------------*/
+
+/* ping ---------------------------------------------------------------------*/
+static
+void ping_send(nRF24L01_bench_t *);
+
+static
+void ping_next(nRF24L01_bench_t *bench)
+{
+    ++bench->result.count;
+    if(++bench->seq < nRF24L01_BENCH_PING_COUNT) ping_send(bench);
+    else run_end(bench);
+}
+
+/* driver switched to RX, echo is received into rx_frame */
+static
+void on_ping_sent(uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->state = STATE_PING_RX;
+}
+
+static
+void on_ping_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    if(STATE_PING_RX == bench->state) rearm(bench);
+    else
+    {
+        ++bench->result.tx_err;
+        ping_next(bench);
+    }
+}
+
+static
+void ping_send(nRF24L01_bench_t *bench)
+{
+    data_fill(bench, TYPE_PING);
+    bench->state = STATE_PING_TX;
+    bench->t_sent = (*bench->clock)();
+    nRF24L01_transceive(
+        bench->dev,
+        bench->tx_frame, bench->tx_frame + bench->result.size,
+        bench->rx_frame, bench->rx_frame + FRAME_SIZE,
+        on_ping_sent,
+        on_frame,
+        on_ping_error,
+        (uintptr_t)bench);
+}
+
+static
+void on_echo(nRF24L01_bench_t *bench)
+{
+    const uint32_t rtt = (*bench->clock)() - bench->t_sent;
+    const uint16_t value = MIN(rtt, UINT16_MAX);
+
+    ++bench->rtt_hist[bucket_of(value)];
+    if(value > bench->result.rtt_max) bench->result.rtt_max = value;
+    ++bench->result.recv;
+    /* next one from tick */
+    bench->state = STATE_PING_GAP;
+    bench->t_sent = (*bench->clock)();
+}
+/*---------------------------------------------------------------------------*/
+
+/* query --------------------------------------------------------------------*/
+static
+void on_query_sent(uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->state = STATE_QUERY_RX;
+    bench->t_sent = (*bench->clock)();
+}
+
+static
+void on_query_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    /* retried from tick */
+    bench->state = STATE_QUERY_RX;
+    bench->t_sent = (*bench->clock)();
+}
+
+static
+void query_send(nRF24L01_bench_t *bench)
+{
+    frame_t *frame = (frame_t *)bench->tx_frame;
+
+    frame->hdr.type = TYPE_QUERY;
+    frame->hdr.run_id = bench->run_id;
+    bench->state = STATE_QUERY_TX;
+    nRF24L01_transceive(
+        bench->dev,
+        bench->tx_frame, bench->tx_frame + sizeof(frame->hdr),
+        bench->rx_frame, bench->rx_frame + FRAME_SIZE,
+        on_query_sent,
+        on_frame,
+        on_query_error,
+        (uintptr_t)bench);
+}
+/*---------------------------------------------------------------------------*/
+
+/* returns 1 if radio was taken over (no listening) */
+static
+uint8_t initiator_frame(nRF24L01_bench_t *bench, const frame_t *frame, uint8_t size)
+{
+    if(bench->run_id != frame->hdr.run_id) return 0;
+
+    if(
+        STATE_PING_RX == bench->state
+        && TYPE_PING == frame->data.type
+        && sizeof(frame->data) <= size
+        && bench->seq == (frame->data.seq[0] | (uint16_t)frame->data.seq[1] << 8))
+    {
+        on_echo(bench);
+        return 1;
+    }
+
+    if(
+        STATE_QUERY_RX == bench->state
+        && TYPE_REPORT == frame->report.type
+        && sizeof(frame->report) <= size)
+    {
+        bench->result.recv = frame->report.recv[0] | (uint16_t)frame->report.recv[1] << 8;
+        bench->result.dup = frame->report.dup[0] | (uint16_t)frame->report.dup[1] << 8;
+        bench->result.valid = 1;
+        report(bench);
+        return 1;
+    }
+    return 0;
+}
+
+static
+void on_reply_sent(uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->busy = 0;
+    listen(bench);
+}
+
+/* driver switched to RX, next frame is received into rx_frame */
+static
+void on_echo_sent(uintptr_t user_data)
+{
+    ((nRF24L01_bench_t *)user_data)->busy = 0;
+}
+
+static
+void on_reply_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+
+    bench->busy = 0;
+    listen(bench);
+}
+
+static
+uint8_t responder_frame(nRF24L01_bench_t *bench, const frame_t *frame, uint8_t size)
+{
+    if(TYPE_SETUP == frame->setup.type && sizeof(frame->setup) <= size)
+    {
+        /* setup retried as its ACK was lost (or run has no ACK), it is
+         * acknowledged once this run goes idle */
+        if(bench->in_run && bench->run_id == frame->setup.run_id) return 0;
+
+        bench->run_id = frame->setup.run_id;
+        bench->result.mode = frame->setup.mode;
+        bench->result.size = frame->setup.size;
+        bench->result.rate = frame->setup.rate;
+        bench->result.ack = frame->setup.ack;
+        bench->result.recv = 0;
+        bench->result.dup = 0;
+        bench->expect = 0;
+        configure(bench->dev, bench->result.rate, bench->result.ack);
+        bench->in_run = 1;
+        bench->t_activity = (*bench->clock)();
+        return 0;
+    }
+
+    if(TYPE_QUERY == frame->hdr.type)
+    {
+        frame_t *reply = (frame_t *)bench->tx_frame;
+        const uint8_t match = bench->run_id == frame->hdr.run_id;
+
+        reply->report.type = TYPE_REPORT;
+        reply->report.run_id = frame->hdr.run_id;
+        reply->report.recv[0] = match ? bench->result.recv : 0;
+        reply->report.recv[1] = match ? bench->result.recv >> 8 : 0;
+        reply->report.dup[0] = match ? bench->result.dup : 0;
+        reply->report.dup[1] = match ? bench->result.dup >> 8 : 0;
+        bench->busy = 1;
+        send(bench, sizeof(reply->report), on_reply_sent, on_reply_error);
+        return 1;
+    }
+
+    if(!bench->in_run || bench->run_id != frame->hdr.run_id) return 0;
+    if(sizeof(frame->data) > size) return 0;
+
+    bench->t_activity = (*bench->clock)();
+
+    if(TYPE_DATA == frame->data.type)
+    {
+        const uint16_t seq = frame->data.seq[0] | (uint16_t)frame->data.seq[1] << 8;
+
+        if(seq < bench->expect) ++bench->result.dup;
+        else
+        {
+            ++bench->result.recv;
+            bench->expect = seq + 1;
+        }
+        return 0;
+    }
+
+    if(TYPE_PING == frame->data.type)
+    {
+        memcpy(bench->tx_frame, bench->rx_frame, size);
+        bench->busy = 1;
+        nRF24L01_transceive(
+            bench->dev,
+            bench->tx_frame, bench->tx_frame + size,
+            bench->rx_frame, bench->rx_frame + FRAME_SIZE,
+            on_echo_sent,
+            on_frame,
+            on_reply_error,
+            (uintptr_t)bench);
+        return 1;
+    }
+    return 0;
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_bench_t *bench = (nRF24L01_bench_t *)user_data;
+    const frame_t *frame = (const frame_t *)bench->rx_frame;
+    const uint8_t size = curr - bench->rx_frame;
+
+    if(sizeof(frame->hdr) > size) goto listen;
+
+    if(
+        bench->initiator
+        ? initiator_frame(bench, frame, size)
+        : responder_frame(bench, frame, size))
+    {
+        goto exit;
+    }
+listen:
+    rearm(bench);
+exit:
+    ; // this is required by syntax
+}
+
+void nRF24L01_bench_init(
+    nRF24L01_bench_t *bench,
+    nRF24L01_t *dev,
+    nRF24L01_bench_clock_t clock,
+    nRF24L01_bench_result_cb_t cb,
+    uintptr_t user_data)
+{
+    memset(bench, 0, sizeof(nRF24L01_bench_t));
+    bench->dev = dev;
+    bench->clock = clock;
+    bench->cb = cb;
+    /* driver measures TX -> RX turnaround of transceive */
+    dev->clock = clock;
+    bench->user_data = user_data;
+}
+
+void nRF24L01_bench_initiator_start(nRF24L01_bench_t *bench)
+{
+    bench->initiator = 1;
+    bench->run = 0;
+    run_next(bench);
+}
+
+void nRF24L01_bench_responder_start(nRF24L01_bench_t *bench)
+{
+    bench->initiator = 0;
+    bench->state = STATE_IDLE;
+    configure_base(bench->dev);
+    listen(bench);
+}
+
+void nRF24L01_bench_tick(nRF24L01_bench_t *bench)
+{
+    const uint32_t now = (*bench->clock)();
+    const uint32_t elapsed = now - bench->t_sent;
+
+    if(!bench->initiator)
+    {
+        if(bench->in_run && !bench->busy && IDLE_TIMEOUT <= now - bench->t_activity)
+        {
+            bench->in_run = 0;
+            configure_base(bench->dev);
+            listen(bench);
+        }
+        return;
+    }
+
+    switch(bench->state)
+    {
+        case STATE_SETUP:
+            if(!bench->busy && RETRY_DELAY <= elapsed) setup_send(bench);
+            break;
+        case STATE_START:
+            if(START_DELAY > elapsed) break;
+            bench->t_start = now;
+            bench->seq = 0;
+            bench->turnaround_num = bench->dev->stat.turnaround_num;
+            bench->turnaround_sum = bench->dev->stat.turnaround_sum;
+            bench->dev->stat.turnaround_max = 0;
+            if(nRF24L01_BENCH_MODE_FLOOD == bench->result.mode)
+            {
+                bench->state = STATE_FLOOD;
+                flood_send(bench);
+            }
+            else ping_send(bench);
+            break;
+        case STATE_PING_RX:
+            if(PING_TIMEOUT > elapsed) break;
+            /* reply window closed */
+            nRF24L01_cancel(bench->dev);
+            ping_next(bench);
+            break;
+        case STATE_PING_GAP:
+            if(PING_GAP > elapsed) break;
+            ping_next(bench);
+            break;
+        case STATE_DRAIN:
+            if(DRAIN_TIME > elapsed) break;
+            if(nRF24L01_BENCH_MODE_PING == bench->result.mode)
+            {
+                bench->result.valid = 1;
+                report(bench);
+            }
+            else
+            {
+                bench->tries = 0;
+                query_send(bench);
+            }
+            break;
+        case STATE_QUERY_RX:
+            if(QUERY_TIMEOUT > elapsed) break;
+            if(++bench->tries >= TRY_MAX) report(bench);
+            else query_send(bench);
+            break;
+        default:
+            break;
+    }
+}
+
+uint8_t nRF24L01_bench_done(const nRF24L01_bench_t *bench)
+{
+    return STATE_DONE == bench->state;
+}
+
+char *nRF24L01_bench_format(
+    const nRF24L01_bench_result_t *result,
+    char *begin, char *const end)
+{
+    static const uint16_t rate_kbps[] = {1000, 2000, 250};
+    const uint32_t duration = result->duration ? result->duration : 1;
+    const uint32_t pps = (uint64_t)result->recv * UINT32_C(1000000) / duration;
+    const uint32_t goodput =
+        (uint64_t)result->recv * result->size * UINT32_C(1000000) / duration;
+    const uint32_t loss_ppm =
+        result->count && result->recv <= result->count
+        ? (uint64_t)(result->count - result->recv) * UINT32_C(1000000) / result->count
+        : 0;
+
+    if(end <= begin) return begin;
+
+    const int len =
+        snprintf(
+            begin, end - begin,
+            "{\"mode\":\"%s\",\"size\":%" PRIu8 ",\"rate_kbps\":%" PRIu16
+            ",\"ack\":%" PRIu8 ",\"valid\":%" PRIu8
+            ",\"count\":%" PRIu16 ",\"recv\":%" PRIu16 ",\"dup\":%" PRIu16
+            ",\"tx_err\":%" PRIu16 ",\"loss_ppm\":%" PRIu32
+            ",\"duration_us\":%" PRIu32 ",\"pps\":%" PRIu32
+            ",\"goodput_Bps\":%" PRIu32
+            ",\"rtt_p50_us\":%" PRIu16 ",\"rtt_p90_us\":%" PRIu16
+            ",\"rtt_p99_us\":%" PRIu16 ",\"rtt_max_us\":%" PRIu16
+            ",\"turnaround_us\":%" PRIu16 ",\"turnaround_max_us\":%" PRIu16 "}\n",
+            nRF24L01_BENCH_MODE_FLOOD == result->mode ? "flood" : "ping",
+            result->size,
+            rate_kbps[result->rate % 3],
+            result->ack,
+            result->valid,
+            result->count,
+            result->recv,
+            result->dup,
+            result->tx_err,
+            loss_ppm,
+            result->duration,
+            pps,
+            goodput,
+            result->rtt_p50,
+            result->rtt_p90,
+            result->rtt_p99,
+            result->rtt_max,
+            result->turnaround_avg,
+            result->turnaround_max);
+
+    if(0 > len) return begin;
+    return begin + MIN((size_t)len, (size_t)(end - begin) - 1);
+}
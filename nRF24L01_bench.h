@@ -0,0 +1,120 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Throughput/latency benchmark (portable, AVR and host).
+ *
+ * Initiator runs sweep over modes, payload sizes, data rates and ACK modes,
+ * responder only follows. Every run is announced by setup frame sent in
+ * base configuration (1Mbps, auto ACK), then both switch to run
+ * configuration:
+ * - flood: initiator sends payloads back-to-back (next one from send
+ *   callback of previous), after run it queries responder for number of
+ *   payloads received (report frame in base configuration),
+ * - ping: initiator sends payload and waits for responder to echo it back,
+ *   round trip time is measured from send call to echo reception, next
+ *   ping is sent from tick once responder is back in RX.
+ * Responder returns to base configuration when run goes idle.
+ *
+ * Time is taken from clock (us), timeouts are checked from tick() so their
+ * resolution is tick period. Result of every run is passed to callback,
+ * nRF24L01_bench_format() renders it as single JSON line. */
+
+#define nRF24L01_BENCH_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+/* 0 - 2^16 us, 4 linear sub-buckets per power of 2 */
+#define nRF24L01_BENCH_RTT_BUCKET_NUM 64
+
+#ifndef nRF24L01_BENCH_FLOOD_COUNT
+#define nRF24L01_BENCH_FLOOD_COUNT 1000
+#endif
+
+#ifndef nRF24L01_BENCH_PING_COUNT
+#define nRF24L01_BENCH_PING_COUNT 200
+#endif
+
+#define nRF24L01_BENCH_MODE_FLOOD 0
+#define nRF24L01_BENCH_MODE_PING 1
+
+#define nRF24L01_BENCH_RATE_1M 0
+#define nRF24L01_BENCH_RATE_2M 1
+#define nRF24L01_BENCH_RATE_250K 2
+
+typedef
+uint32_t (*nRF24L01_bench_clock_t)(void);
+
+typedef struct
+{
+    uint8_t mode;
+    uint8_t size; // payload data size
+    uint8_t rate;
+    uint8_t ack;
+    uint8_t valid; // run was set up (and reported for flood)
+    uint16_t count; // payloads sent
+    uint16_t recv; // flood: received by responder, ping: echoes received
+    uint16_t dup; // flood: duplicates dropped by responder
+    uint16_t tx_err; // MAX_RT
+    uint32_t duration; // us
+    uint16_t rtt_p50; // us (upper bound of histogram bucket)
+    uint16_t rtt_p90;
+    uint16_t rtt_p99;
+    uint16_t rtt_max;
+    /* initiator TX -> RX switch (transceive), driver measured */
+    uint16_t turnaround_avg; // us
+    uint16_t turnaround_max;
+} nRF24L01_bench_result_t;
+
+typedef
+void (*nRF24L01_bench_result_cb_t)(const nRF24L01_bench_result_t *, uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_bench_clock_t clock;
+    nRF24L01_bench_result_cb_t cb;
+    uintptr_t user_data;
+    nRF24L01_bench_result_t result;
+    uint16_t rtt_hist[nRF24L01_BENCH_RTT_BUCKET_NUM];
+    uint32_t t_start;
+    uint32_t t_sent; // initiator: ping sent or echoed / query sent / retry scheduled
+    uint32_t t_activity; // responder: last frame of run
+    uint32_t turnaround_sum; // driver stat at run start
+    uint16_t turnaround_num;
+    uint16_t seq;
+    uint16_t expect; // responder: next sequence number
+    uint8_t run; // initiator: index in sweep
+    uint8_t run_id;
+    uint8_t state;
+    uint8_t tries;
+    uint8_t rx_frame[nRF24L01_BENCH_FRAME_SIZE];
+    uint8_t tx_frame[nRF24L01_BENCH_FRAME_SIZE];
+    struct
+    {
+        uint8_t initiator : 1;
+        uint8_t busy : 1; // send in progress
+        uint8_t in_run : 1; // responder: run configuration applied
+        uint8_t : 5;
+    };
+} nRF24L01_bench_t;
+
+/* dev has to be initialized (addresses, channel), tx_addr and rx_addr_p0
+ * must match on both sides */
+void nRF24L01_bench_init(
+    nRF24L01_bench_t *,
+    nRF24L01_t *,
+    nRF24L01_bench_clock_t,
+    nRF24L01_bench_result_cb_t,
+    uintptr_t user_data);
+
+void nRF24L01_bench_initiator_start(nRF24L01_bench_t *);
+void nRF24L01_bench_responder_start(nRF24L01_bench_t *);
+
+/* periodically (i.e. from cyclic timer callback) */
+void nRF24L01_bench_tick(nRF24L01_bench_t *);
+
+/* initiator: sweep finished */
+uint8_t nRF24L01_bench_done(const nRF24L01_bench_t *);
+
+/* JSON line (with '\n'), returns end of string (truncated to fit) */
+char *nRF24L01_bench_format(
+    const nRF24L01_bench_result_t *,
+    char *begin, char *const end);
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_bench.h"
+#include "nRF24L01_poll.h"
+#include "nRF24L01_sim.h"
+#include "nRF24L01_trace.h"
+
+/* Benchmark against simulated radios (nRF24L01_sim), initiator and
+ * responder run in single process on top of real driver, time is virtual
+ * so results are reproducible (for given loss and seed). MCU/SPI time is
+ * not modeled, results are radio bound.
+ *
+ * Initiator SPI traffic is optionally traced to file
+ * (replay with nRF24L01_trace_replay, "-" for none).
+ *
+ * Events are dispatched by nRF24L01_poll, with poll threshold (events per
+ * tick) both sides switch to polling under load, IRQ wakeups and SPI
+ * transactions show the difference.
+ *
+ * usage: nRF24L01_bench_host [loss_ppm [seed [trace [poll_threshold]]]] */
+
+#define TICK_PERIOD 1000 // us
+/* RX FIFO has to be polled faster than it fills (3 payloads @ 2Mbps) */
+#define POLL_PERIOD 250 // us
+#define DISPATCH_MAX 8
+#define TRACE_SIZE 0x8000
+#define IDLE_TICKS 4
+
+static nRF24L01_sim_air_t air;
+static uint8_t trace[TRACE_SIZE];
+static FILE *trace_file;
+
+static
+uint32_t clock_us(void)
+{
+    return air.now;
+}
+
+static
+void on_result(const nRF24L01_bench_result_t *result, uintptr_t user_data)
+{
+    char line[320];
+    const char *end = nRF24L01_bench_format(result, line, line + sizeof(line));
+
+    fwrite(line, 1, end - line, stdout);
+    fflush(stdout);
+}
+
+static
+void init(nRF24L01_t *dev, nRF24L01_sim_t *sim, uint8_t traced)
+{
+    nRF24L01_sim_init(sim, &air);
+    if(traced)
+    {
+        nRF24L01_init(
+            dev,
+            nRF24L01_trace_ce_set(nRF24L01_sim_ce_set(sim)),
+            nRF24L01_trace_spi_xchg(nRF24L01_sim_spi_xchg(sim)));
+    }
+    else nRF24L01_init(dev, nRF24L01_sim_ce_set(sim), nRF24L01_sim_spi_xchg(sim));
+
+    nRF24L01_CFG(dev, setup_aw, .AW = 3);
+    nRF24L01_CFG(dev, rf_ch, .RF_CH = 1);
+    nRF24L01_CFG(dev, rx_addr_p0, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+    nRF24L01_CFG(dev, tx_addr, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+}
+
+static
+void trace_drain(void)
+{
+    uint8_t buf[256];
+    uint16_t size;
+
+    if(!trace_file) return;
+    while((size = nRF24L01_trace_read(buf, buf + sizeof(buf))))
+    {
+        fwrite(buf, 1, size, trace_file);
+    }
+}
+
+/* same as firmware main loop: dispatch while IRQ is asserted,
+ * returns 1 if IRQ was asserted (MCU wakeup) */
+static
+uint8_t dispatch(nRF24L01_poll_t *poll, const nRF24L01_sim_t *sim, uint8_t traced)
+{
+    const uint8_t wakeup = nRF24L01_sim_irq(sim);
+
+    for(uint8_t i = 0; i < DISPATCH_MAX && nRF24L01_sim_irq(sim); ++i)
+    {
+        if(traced) nRF24L01_trace_irq();
+        nRF24L01_poll_irq(poll);
+    }
+    return wakeup;
+}
+
+static
+void stat(
+    const char *name,
+    const nRF24L01_sim_t *sim,
+    const nRF24L01_t *dev,
+    const nRF24L01_poll_t *poll,
+    uint32_t wakeup)
+{
+    fprintf(
+        stderr,
+        "%s: tx %u rx %u lost %u collided %u overflow %u dup %u"
+        " rx_full %u rx_overflow %u rx_flush %u rx_spurious %u"
+        " wakeup %u irq_event %u poll_event %u poll %u enter %u overrun %u\n",
+        name,
+        sim->stat.tx,
+        sim->stat.rx,
+        sim->stat.lost,
+        sim->stat.collided,
+        sim->stat.overflow,
+        sim->stat.dup,
+        dev->stat.rx_full,
+        dev->stat.rx_overflow,
+        dev->stat.rx_flush,
+        dev->stat.rx_spurious,
+        wakeup,
+        poll->stat.irq,
+        poll->stat.polled,
+        poll->stat.poll,
+        poll->stat.enter,
+        poll->stat.overrun);
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t loss_ppm = 1 < argc ? strtoul(argv[1], NULL, 0) : 0;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+    const char *trace_path = 3 < argc && strcmp(argv[3], "-") ? argv[3] : NULL;
+    const uint8_t poll_threshold = 4 < argc ? strtoul(argv[4], NULL, 0) : 0;
+    nRF24L01_sim_t initiator_sim;
+    nRF24L01_sim_t responder_sim;
+    nRF24L01_t initiator_dev;
+    nRF24L01_t responder_dev;
+    nRF24L01_bench_t initiator;
+    nRF24L01_bench_t responder;
+    nRF24L01_poll_t initiator_poll;
+    nRF24L01_poll_t responder_poll;
+    uint32_t initiator_wakeup = 0;
+    uint32_t responder_wakeup = 0;
+    uint64_t tick = TICK_PERIOD;
+    uint64_t poll_tick = POLL_PERIOD;
+
+    nRF24L01_sim_air_init(&air, loss_ppm, seed);
+    if(trace_path)
+    {
+        trace_file = fopen(trace_path, "wb");
+        if(!trace_file)
+        {
+            perror(trace_path);
+            return EXIT_FAILURE;
+        }
+        nRF24L01_trace_init(trace, sizeof(trace), clock_us);
+    }
+    init(&initiator_dev, &initiator_sim, 1);
+    init(&responder_dev, &responder_sim, 0);
+    /* bench sends single payloads, only reception is polled */
+    nRF24L01_poll_init(
+        &initiator_poll, &initiator_dev,
+        poll_threshold, IDLE_TICKS,
+        (nRF24L01_config_t){.MASK_RX_DR = 1});
+    nRF24L01_poll_init(
+        &responder_poll, &responder_dev,
+        poll_threshold, IDLE_TICKS,
+        (nRF24L01_config_t){.MASK_RX_DR = 1});
+
+    nRF24L01_bench_init(&initiator, &initiator_dev, clock_us, on_result, 0);
+    nRF24L01_bench_init(&responder, &responder_dev, clock_us, NULL, 0);
+    nRF24L01_bench_responder_start(&responder);
+    nRF24L01_bench_initiator_start(&initiator);
+
+    while(!nRF24L01_bench_done(&initiator))
+    {
+        initiator_wakeup += dispatch(&initiator_poll, &initiator_sim, 1);
+        responder_wakeup += dispatch(&responder_poll, &responder_sim, 0);
+        trace_drain();
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+        const uint64_t timer = poll_tick < tick ? poll_tick : tick;
+
+        nRF24L01_sim_run(&air, next < timer ? next : timer);
+
+        if(poll_tick <= air.now)
+        {
+            poll_tick += POLL_PERIOD;
+            nRF24L01_poll_tick(&initiator_poll);
+            nRF24L01_poll_tick(&responder_poll);
+        }
+        if(tick <= air.now)
+        {
+            tick += TICK_PERIOD;
+            nRF24L01_bench_tick(&initiator);
+            nRF24L01_bench_tick(&responder);
+        }
+    }
+
+    trace_drain();
+    if(trace_file) fclose(trace_file);
+    stat("initiator", &initiator_sim, &initiator_dev, &initiator_poll, initiator_wakeup);
+    stat("responder", &responder_sim, &responder_dev, &responder_poll, responder_wakeup);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,231 @@
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include <drv/spi0.h>
+#include <drv/usart0.h>
+#include <drv/watchdog.h>
+
+#include <bootloader/fixed.h>
+
+#include "cyclic_timer.h"
+#include "dlog_usart0.h"
+#include "nRF24L01.h"
+#include "nRF24L01_bench.h"
+#include "nRF24L01_spi.h"
+#ifdef BENCH_POLL
+#include "nRF24L01_poll.h"
+#endif
+
+// nRF IRQ      PC.2/PCINT10       pin: A2 pro-mini
+// nRF CE       PC.1/PCINT9        pin: A1 pro-mini
+// RLY CTL      PC.0/PCINT8        pin: A0 pro-mini
+// SPI0 SCK     PB.5/PCINT5        pin: 13 pro-mini
+// SPI0 MISO    PB.4/PCINT4        pin: 12 pro-mini
+// SPI0 MOSI    PB.3/PCINT3        pin: 11 pro-mini
+// SPI0 !SS     PB.2/PCINT2        pin: 10 pro-mini
+
+/* 10ms tick, 16MHz / 64 = 250kHz == 4us */
+#define TICK_PERIOD UINT16_C(2499)
+
+/* SPI0 clock levels: 16MHz / 128 - 2 (125kHz - 8MHz) */
+#define SPI_LEVEL_NUM 7
+#define SPI_VERIFY_PERIOD 100 // ticks
+
+/* highest reliable level (erased: none found yet) */
+static uint8_t EEMEM spi_cap_;
+static nRF24L01_spi_t spi_;
+
+#ifdef BENCH_POLL
+/* hybrid dispatch (nRF24L01_poll.h), BENCH_POLL is threshold:
+ * ~250us tick services RX FIFO (3 payloads @ 2Mbps take ~300us),
+ * benchmark ticks every POLL_DIV-th */
+#define POLL_PERIOD UINT16_C(62)
+#define POLL_DIV 40
+#define POLL_IDLE_TICKS 8
+
+static nRF24L01_poll_t poll_;
+#endif
+
+static
+void spi_chip_select_on(void)
+{
+    PORTB &= ~M1(DDB2); // SPI0/!SS PB.2 low
+}
+
+static
+void spi_chip_select_off(void)
+{
+    PORTB |= M1(DDB2); /* SPI0/!SS PB.2 high */
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    spi_chip_select_on();
+    spi0_xchg(begin, end);
+    spi_chip_select_off();
+}
+
+static
+void spi_clock(uint8_t level)
+{
+    switch(level)
+    {
+        case 0: SPI0_CLK_DIV_128(); break;
+        case 1: SPI0_CLK_DIV_64(); break;
+        case 2: SPI0_CLK_DIV_32(); break;
+        case 3: SPI0_CLK_DIV_16(); break;
+        case 4: SPI0_CLK_DIV_8(); break;
+        case 5: SPI0_CLK_DIV_4(); break;
+        default: SPI0_CLK_DIV_2(); break;
+    }
+}
+
+static
+void spi_verify(void)
+{
+    static uint8_t div;
+
+    if(SPI_VERIFY_PERIOD > ++div) return;
+    div = 0;
+
+    const uint8_t cap = spi_.cap;
+
+    nRF24L01_spi_verify(&spi_);
+    /* level found unreliable is not selected after reset */
+    if(cap != spi_.cap) eeprom_update_byte(&spi_cap_, spi_.cap);
+}
+
+static
+void ce_set(nRF24L01_ce_t state)
+{
+    if(state.CE) PORTC |= M1(DDC1);
+    else PORTC &= ~M1(DDC1);
+}
+
+static
+void init(nRF24L01_t *dev)
+{
+    /* PC.1 / nRF CE */
+    PORTC &= ~M1(DDC1); // to low
+    DDRC |= M1(DDC1); // to output
+
+    // PC.2 / nRF IRQ
+    DDRC &= ~M1(DDC2); // to input
+    PORTC |= M1(PORTC2); // pull-up
+    // PC.2 / nRF IRQ pin-change interrupt enable (PCINT10)
+    PCICR |= M1(PCIE1);
+    PCMSK1 |= M1(PCINT10);
+
+    // PB.2 / SPI0 !SS
+    DDRB |= M1(DDB2); // output
+    PORTB &= ~M1(DDB2); // low
+
+    // PB.3 / SPI0 MOSI
+    PORTB |= M1(DDB3); // output
+    DDRB |= M1(DDB3); // high
+
+    // PB.5 / SPI0/CLK
+    PORTB |= M1(DDB5); // output
+    DDRB |= M1(DDB5); // high
+
+    SPI0_MASTER();
+    SPI0_CLK_DIV_128();
+    SPI0_ENABLE();
+
+    nRF24L01_init(dev, ce_set, spi_xchg);
+
+    /* registers are rewritten, before configuration */
+    nRF24L01_spi_init(&spi_, dev, spi_clock, SPI_LEVEL_NUM, eeprom_read_byte(&spi_cap_));
+    if(!nRF24L01_spi_calibrate(&spi_)) usart0_send_str("SPI SELF-TEST FAILED\n");
+
+    /* adress width 5B */
+    nRF24L01_CFG(
+        dev, setup_aw,
+        .AW = 3);
+
+    /* channel 1 */
+    nRF24L01_CFG(
+        dev, rf_ch,
+        .RF_CH = 1);
+
+    /* rest of configuration is managed by benchmark */
+    nRF24L01_CFG(dev, rx_addr_p0, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+    nRF24L01_CFG(dev, tx_addr, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+}
+
+static
+uint32_t clock_us(void)
+{
+    return cyclic_tmr_ticks() << 2;
+}
+
+static
+void on_tick(uintptr_t user_data)
+{
+#ifdef BENCH_POLL
+    static uint8_t div;
+
+    nRF24L01_poll_tick(&poll_);
+    if(POLL_DIV > ++div) return;
+    div = 0;
+#endif
+    spi_verify();
+    nRF24L01_bench_tick((nRF24L01_bench_t *)user_data);
+}
+
+__attribute__((noreturn))
+void main(void)
+{
+    /* watchdog is enabled by bootloader whenever it "jumps" to app code */
+    fixed__.app_reset_code.curr = RESET_CODE_APP_IDLE;
+    watchdog_disable();
+
+    nRF24L01_t dev;
+    nRF24L01_bench_t bench;
+
+    USART0_BR(CALC_BR(CPU_CLK, 19200));
+    USART0_PARITY_EVEN();
+    USART0_TX_ENABLE();
+
+    init(&dev);
+    /* set SMCR SE (Sleep Enable bit) */
+    sleep_enable();
+    usart0_send_str("nRF24L01 BENCH RESPONDER\n");
+
+    nRF24L01_bench_init(&bench, &dev, clock_us, NULL, 0);
+#ifdef BENCH_POLL
+    nRF24L01_poll_init(
+        &poll_, &dev,
+        BENCH_POLL, POLL_IDLE_TICKS,
+        (nRF24L01_config_t){.MASK_RX_DR = 1});
+    cyclic_tmr_start_clk(POLL_PERIOD, CYCLIC_TMR_CLK_DIV_64, on_tick, (uintptr_t)&bench);
+#else
+    cyclic_tmr_start_clk(TICK_PERIOD, CYCLIC_TMR_CLK_DIV_64, on_tick, (uintptr_t)&bench);
+#endif
+    nRF24L01_bench_responder_start(&bench);
+
+    for(;;)
+    {
+        cli();
+        {
+            /* no debug output here, it would distort measurements */
+            while(0 == (PINC & M1(PINC2)))
+            {
+#ifdef BENCH_POLL
+                nRF24L01_poll_irq(&poll_);
+#else
+                dev.updated = 1;
+                nRF24L01_event(&dev);
+#endif
+            }
+        }
+        /* log is sent by USART interrupt while CPU sleeps */
+        dlog_usart0_drain();
+        sei();
+        sleep_cpu();
+    }
+}
+
+ISR(PCINT1_vect) {}
@@ -0,0 +1,365 @@
+#include <string.h>
+
+#include "nRF24L01_crypt.h"
+
+#define AHEAD nRF24L01_CRYPT_AHEAD
+#define FRAME_SIZE nRF24L01_CRYPT_FRAME_SIZE
+#define SEQ_SIZE nRF24L01_CRYPT_SEQ_SIZE
+#define TAG_SIZE nRF24L01_CRYPT_TAG_SIZE
+#define DATA_SIZE nRF24L01_CRYPT_DATA_SIZE
+#define STREAM_SIZE nRF24L01_CRYPT_STREAM_SIZE
+
+/* MAC field: 2^16 + 1 (prime), every 16b chunk is below it */
+#define MAC_P UINT32_C(0x10001)
+/* never a keystream block (block index is below 0xFF) */
+#define MAC_KEY_BLOCK 0xFF
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+uint8_t block_size(const nRF24L01_crypt_t *crypt)
+{
+    return nRF24L01_CRYPT_AES128 == crypt->mode ? AES128_BLOCK_SIZE : XTEA_BLOCK_SIZE;
+}
+
+static
+void encrypt(const nRF24L01_crypt_t *crypt, uint8_t *block)
+{
+    if(nRF24L01_CRYPT_AES128 == crypt->mode) aes128_encrypt(crypt->key.aes128, block);
+    else xtea_encrypt(crypt->key.xtea, block);
+}
+
+/* computes next keystream block of seq (stream is restarted if it holds
+ * other seq) */
+static
+void stream_block(
+    const nRF24L01_crypt_t *crypt,
+    nRF24L01_crypt_stream_t *stream,
+    uint32_t seq,
+    uint8_t id)
+{
+    const uint8_t size = block_size(crypt);
+
+    if(stream->seq != seq)
+    {
+        stream->seq = seq;
+        stream->len = 0;
+    }
+
+    uint8_t *block = stream->data + stream->len;
+
+    memset(block, 0, size);
+    block[0] = seq;
+    block[1] = seq >> 8;
+    block[2] = seq >> 16;
+    block[3] = seq >> 24;
+    block[4] = id;
+    block[5] = stream->len / size;
+    encrypt(crypt, block);
+    stream->len += size;
+}
+
+/* keystream of seq covering at least len bytes */
+static
+const uint8_t *stream_get(
+    nRF24L01_crypt_t *crypt,
+    nRF24L01_crypt_stream_t *stream,
+    uint32_t seq,
+    uint8_t id,
+    uint8_t len)
+{
+    if(stream->seq == seq && stream->len >= len) ++crypt->stat.hit;
+    else
+    {
+        ++crypt->stat.miss;
+        do stream_block(crypt, stream, seq, id);
+        while(stream->len < len);
+    }
+    return stream->data;
+}
+
+/* h * r + c mod 2^16 + 1, h <= 2^16 */
+static
+uint32_t mac_step(uint32_t h, uint16_t r, uint16_t c)
+{
+    if(0x10000 == h) h = MAC_P - r; // -1 * r
+    else
+    {
+        const uint32_t x = h * r;
+        const uint16_t lo = x;
+        const uint16_t hi = x >> 16;
+
+        /* 2^16 = -1 */
+        h = lo >= hi ? (uint32_t)(lo - hi) : lo + MAC_P - hi;
+    }
+    h += c;
+    return MAC_P > h ? h : h - MAC_P;
+}
+
+static
+void mac(
+    const nRF24L01_crypt_t *crypt,
+    const uint8_t *begin, const uint8_t *const end,
+    const uint8_t *pad,
+    uint8_t *tag)
+{
+    const uint8_t size = end - begin;
+    uint32_t h0 = 0;
+    uint32_t h1 = 0;
+
+    while(begin != end)
+    {
+        uint16_t chunk = *begin++;
+
+        if(begin != end) chunk |= (uint16_t)*begin++ << 8;
+        h0 = mac_step(h0, crypt->mac_key[0], chunk);
+        h1 = mac_step(h1, crypt->mac_key[1], chunk);
+    }
+    /* length, otherwise trailing zero byte would not change tag */
+    h0 = mac_step(h0, crypt->mac_key[0], size);
+    h1 = mac_step(h1, crypt->mac_key[1], size);
+
+    /* 17th bit of h is dropped, see bound in nRF24L01_crypt.h */
+    const uint16_t t0 = h0 + (pad[0] | (uint16_t)pad[1] << 8);
+    const uint16_t t1 = h1 + (pad[2] | (uint16_t)pad[3] << 8);
+
+    tag[0] = t0;
+    tag[1] = t0 >> 8;
+    tag[2] = t1;
+    tag[3] = t1 >> 8;
+}
+
+static
+void listen(nRF24L01_crypt_t *crypt)
+{
+    if(crypt->busy || !crypt->recv_cb) return;
+
+    nRF24L01_recv(
+        crypt->dev,
+        crypt->rx_frame, crypt->rx_frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)crypt);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_crypt_t *crypt = (nRF24L01_crypt_t *)user_data;
+    const uint8_t *end = nRF24L01_crypt_open(crypt, crypt->rx_frame, curr);
+
+    listen(crypt);
+    if(end) (*crypt->recv_cb)(crypt->rx_frame + SEQ_SIZE, end, crypt->recv_user_data);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_crypt_t *)user_data);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_crypt_t *crypt = (nRF24L01_crypt_t *)user_data;
+    const nRF24L01_send_cb_t cb = crypt->tx.cb;
+    const uintptr_t cb_user_data = crypt->tx.user_data;
+
+    memset(&crypt->tx, 0, sizeof(crypt->tx));
+    crypt->busy = 0;
+    listen(crypt);
+
+    if(cb) (*cb)(cb_user_data);
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_crypt_t *crypt = (nRF24L01_crypt_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = crypt->tx.err_cb;
+    const uintptr_t cb_user_data = crypt->tx.user_data;
+
+    memset(&crypt->tx, 0, sizeof(crypt->tx));
+    crypt->busy = 0;
+    listen(crypt);
+
+    if(err_cb) (*err_cb)(status, fifo_status, cb_user_data);
+}
+
+void nRF24L01_crypt_init(
+    nRF24L01_crypt_t *crypt,
+    nRF24L01_t *dev,
+    uint8_t mode,
+    const uint8_t *key,
+    uint8_t id,
+    uint8_t peer_id)
+{
+    uint8_t block[AES128_BLOCK_SIZE];
+
+    memset(crypt, 0, sizeof(nRF24L01_crypt_t));
+    crypt->dev = dev;
+    crypt->mode = mode;
+    crypt->id = id;
+    crypt->peer_id = peer_id;
+    crypt->tx_seq = 1;
+
+    if(nRF24L01_CRYPT_AES128 == mode) aes128_key(crypt->key.aes128, key);
+    else xtea_key(crypt->key.xtea, key);
+
+    memset(block, MAC_KEY_BLOCK, sizeof(block));
+    encrypt(crypt, block);
+    crypt->mac_key[0] = block[0] | (uint16_t)block[1] << 8;
+    crypt->mac_key[1] = block[2] | (uint16_t)block[3] << 8;
+    /* zero key would hash only last chunk */
+    if(!crypt->mac_key[0]) crypt->mac_key[0] = 1;
+    if(!crypt->mac_key[1]) crypt->mac_key[1] = 1;
+}
+
+uint8_t nRF24L01_crypt_idle(nRF24L01_crypt_t *crypt)
+{
+    /* sending is likely sooner than reception, nearest seqs first */
+    for(uint8_t i = 0; i < AHEAD; ++i)
+    {
+        const uint32_t tx_seq = crypt->tx_seq + i;
+        nRF24L01_crypt_stream_t *stream = crypt->tx_stream + tx_seq % AHEAD;
+
+        if(stream->seq != tx_seq || STREAM_SIZE > stream->len)
+        {
+            stream_block(crypt, stream, tx_seq, crypt->id);
+            return 1;
+        }
+
+        const uint32_t rx_seq = crypt->rx_seq + 1 + i;
+
+        stream = crypt->rx_stream + rx_seq % AHEAD;
+        if(stream->seq != rx_seq || STREAM_SIZE > stream->len)
+        {
+            stream_block(crypt, stream, rx_seq, crypt->peer_id);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t *nRF24L01_crypt_seal(
+    nRF24L01_crypt_t *crypt,
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *frame)
+{
+    if((size_t)(end - begin) > DATA_SIZE) return NULL;
+
+    const uint8_t size = end - begin;
+
+    const uint32_t seq = crypt->tx_seq++;
+    const uint8_t *stream =
+        stream_get(crypt, crypt->tx_stream + seq % AHEAD, seq, crypt->id, TAG_SIZE + size);
+    uint8_t *data = frame + SEQ_SIZE;
+
+    frame[0] = seq;
+    frame[1] = seq >> 8;
+    frame[2] = seq >> 16;
+    frame[3] = seq >> 24;
+    for(uint8_t i = 0; i < size; ++i) data[i] = begin[i] ^ stream[TAG_SIZE + i];
+    mac(crypt, data, data + size, stream, data + size);
+    return data + size + TAG_SIZE;
+}
+
+uint8_t *nRF24L01_crypt_open(
+    nRF24L01_crypt_t *crypt,
+    uint8_t *frame, const uint8_t *const end)
+{
+    if(end < frame + nRF24L01_CRYPT_OVERHEAD || end > frame + FRAME_SIZE)
+    {
+        ++crypt->stat.auth;
+        return NULL;
+    }
+
+    const uint32_t seq =
+        frame[0] | (uint32_t)frame[1] << 8 | (uint32_t)frame[2] << 16 | (uint32_t)frame[3] << 24;
+
+    if(seq <= crypt->rx_seq)
+    {
+        ++crypt->stat.replay;
+        return NULL;
+    }
+
+    uint8_t *data = frame + SEQ_SIZE;
+    const uint8_t size = end - data - TAG_SIZE;
+    const uint8_t *stream =
+        stream_get(crypt, crypt->rx_stream + seq % AHEAD, seq, crypt->peer_id, TAG_SIZE + size);
+    uint8_t tag[TAG_SIZE];
+    uint8_t diff = 0;
+
+    mac(crypt, data, data + size, stream, tag);
+    /* every byte is compared (no early exit) */
+    for(uint8_t i = 0; i < TAG_SIZE; ++i) diff |= tag[i] ^ data[size + i];
+    if(diff)
+    {
+        ++crypt->stat.auth;
+        return NULL;
+    }
+
+    for(uint8_t i = 0; i < size; ++i) data[i] ^= stream[TAG_SIZE + i];
+    crypt->rx_seq = seq;
+    return data + size;
+}
+
+void nRF24L01_crypt_start(
+    nRF24L01_crypt_t *crypt,
+    nRF24L01_crypt_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    crypt->recv_cb = cb;
+    crypt->recv_user_data = user_data;
+    listen(crypt);
+}
+
+void nRF24L01_crypt_send(
+    nRF24L01_crypt_t *crypt,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    const uint8_t *frame_end = nRF24L01_crypt_seal(crypt, begin, end, crypt->tx_frame);
+
+    if(!frame_end)
+    {
+        /* does not fit, nothing went to radio (status is empty) */
+        if(err_cb) (*err_cb)((nRF24L01_status_t){0}, (nRF24L01_fifo_status_t){0}, user_data);
+        return;
+    }
+
+    crypt->tx.cb = cb;
+    crypt->tx.err_cb = err_cb;
+    crypt->tx.user_data = user_data;
+    crypt->busy = 1;
+    nRF24L01_send(
+        crypt->dev,
+        crypt->tx_frame, frame_end,
+        on_sent,
+        on_error,
+        (uintptr_t)crypt);
+}
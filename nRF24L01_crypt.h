@@ -0,0 +1,143 @@
+#pragma once
+
+#include "nRF24L01.h"
+#include "cipher.h"
+
+/* Authenticated link encryption (point-to-point, shared 128b key).
+ *
+ * Frame: seq (4B little endian, clear) | ciphertext | tag (4B). Cipher
+ * (XTEA or AES-128, selected at init) runs in CTR mode: keystream of
+ * payload is encryption of blocks seq | sender id | block index | 0...,
+ * first nRF24L01_CRYPT_TAG_SIZE bytes of it pad the tag, following ones
+ * are XORed with data. Seq must never repeat for key and sender id (same
+ * keystream), every sealed payload consumes one, tx_seq has to be
+ * restored (i.e. from EEPROM, rounded up) after reset or key replaced.
+ *
+ * Tag is Wegman-Carter MAC: two polynomial hashes mod 2^16 + 1 (16b
+ * chunks of ciphertext, then its length, keys are derived from cipher key)
+ * each added to 16b of pad. Hash ranges over [0, 2^16] but only its low
+ * 16b are sent (0 and 2^16 are same tag), so tag difference matches up to
+ * 3 hash differences and forgery succeeds with probability at most
+ * (3 * (chunks + 1) / 2^16)^2 (2^-21 for full payload) per attempt,
+ * stat.auth counts failures. Receiver accepts only seq above last accepted one (replay;
+ * reordering and loss are tolerated, re-sent payload with same seq is
+ * dropped as replay).
+ *
+ * Keystream of next nRF24L01_CRYPT_AHEAD seqs of both directions is
+ * precomputed by nRF24L01_crypt_idle() (block by block, call from main
+ * loop while there is nothing else to do) so sealing/opening payload is
+ * single XOR pass plus MAC, no block cipher. Keystream not ready yet
+ * (stat.miss) is computed on the spot. idle() must not preempt or be
+ * preempted by seal()/open() (same context as nRF24L01_event()). */
+
+#define nRF24L01_CRYPT_XTEA 0
+#define nRF24L01_CRYPT_AES128 1
+
+#define nRF24L01_CRYPT_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_CRYPT_SEQ_SIZE 4
+#define nRF24L01_CRYPT_TAG_SIZE 4
+#define nRF24L01_CRYPT_OVERHEAD (nRF24L01_CRYPT_SEQ_SIZE + nRF24L01_CRYPT_TAG_SIZE)
+#define nRF24L01_CRYPT_DATA_SIZE (nRF24L01_CRYPT_FRAME_SIZE - nRF24L01_CRYPT_OVERHEAD)
+/* tag pad and data, whole blocks of either cipher */
+#define nRF24L01_CRYPT_STREAM_SIZE \
+    ((nRF24L01_CRYPT_TAG_SIZE + nRF24L01_CRYPT_DATA_SIZE + AES128_BLOCK_SIZE - 1) \
+     / AES128_BLOCK_SIZE * AES128_BLOCK_SIZE)
+
+/* power of 2, RAM: 2 * AHEAD * (STREAM_SIZE + 5) */
+#ifndef nRF24L01_CRYPT_AHEAD
+#define nRF24L01_CRYPT_AHEAD 2
+#endif
+
+typedef
+void (*nRF24L01_crypt_recv_cb_t)(const uint8_t *begin, const uint8_t *const end, uintptr_t);
+
+typedef struct
+{
+    uint32_t seq;
+    uint8_t len; // computed
+    uint8_t data[nRF24L01_CRYPT_STREAM_SIZE];
+} nRF24L01_crypt_stream_t;
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_crypt_recv_cb_t recv_cb;
+    uintptr_t recv_user_data;
+    uint8_t mode;
+    uint8_t id; // own (sent payloads)
+    uint8_t peer_id; // received payloads
+    uint32_t tx_seq; // next to be sent
+    uint32_t rx_seq; // last accepted
+    uint16_t mac_key[2];
+    union
+    {
+        uint32_t xtea[4];
+        uint8_t aes128[AES128_ROUND_KEYS_SIZE];
+    } key;
+    nRF24L01_crypt_stream_t tx_stream[nRF24L01_CRYPT_AHEAD]; // by seq % AHEAD
+    nRF24L01_crypt_stream_t rx_stream[nRF24L01_CRYPT_AHEAD];
+    uint8_t tx_frame[nRF24L01_CRYPT_FRAME_SIZE];
+    uint8_t rx_frame[nRF24L01_CRYPT_FRAME_SIZE];
+    struct
+    {
+        uint8_t busy : 1; // payload in flight
+        uint8_t : 7;
+    };
+    struct
+    {
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+    struct
+    {
+        uint32_t hit; // keystream was precomputed
+        uint32_t miss; // computed on the spot (cipher on hot path)
+        uint16_t auth; // tag mismatch, malformed frame
+        uint16_t replay; // seq not above last accepted
+    } stat;
+} nRF24L01_crypt_t;
+
+/* key: CIPHER_KEY_SIZE bytes, id/peer_id: distinct per sender (i.e. last
+ * address byte), tx_seq starts at 1, rx_seq at 0 (any seq accepted) */
+void nRF24L01_crypt_init(
+    nRF24L01_crypt_t *,
+    nRF24L01_t *,
+    uint8_t mode,
+    const uint8_t *key,
+    uint8_t id,
+    uint8_t peer_id);
+
+/* precomputes single keystream block, returns 0 if all keystream of next
+ * seqs is ready (nothing to do, MCU may sleep) */
+uint8_t nRF24L01_crypt_idle(nRF24L01_crypt_t *);
+
+/* encrypts [begin, end) (up to nRF24L01_CRYPT_DATA_SIZE) into frame with
+ * next tx seq, returns end of frame or NULL if data does not fit */
+uint8_t *nRF24L01_crypt_seal(
+    nRF24L01_crypt_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t *frame);
+
+/* authenticates and decrypts frame in place, returns end of data which
+ * starts at frame + nRF24L01_CRYPT_SEQ_SIZE or NULL if frame is rejected */
+uint8_t *nRF24L01_crypt_open(
+    nRF24L01_crypt_t *,
+    uint8_t *frame, const uint8_t *const end);
+
+/* starts listening, cb is called with decrypted data of every accepted
+ * payload (rejected ones are dropped) */
+void nRF24L01_crypt_start(
+    nRF24L01_crypt_t *,
+    nRF24L01_crypt_recv_cb_t,
+    uintptr_t user_data);
+
+/* seals and sends single payload, size of [begin, end) must not exceed
+ * nRF24L01_CRYPT_DATA_SIZE (err_cb is called with empty status otherwise),
+ * single payload at a time */
+void nRF24L01_crypt_send(
+    nRF24L01_crypt_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
@@ -0,0 +1,170 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nRF24L01_crypt.h"
+
+/* host benchmark of link encryption, cycles per operation for each cipher
+ *
+ * block: single cipher block, stream: keystream of one payload (what idle()
+ * precomputes), seal/open: full payload (nRF24L01_CRYPT_DATA_SIZE) with
+ * keystream precomputed (hot path) and computed on the spot (cold).
+ * Roundtrip, rejection of tampered and replayed frames and of oversized
+ * payload are verified. Cycles are TSC cycles on x86 (ns elsewhere), see
+ * crypt_test (AVR) for MCU.
+ *
+ * output: JSON line per cipher */
+
+#define ITERATIONS 20000
+
+static
+uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static
+void fail(const char *mode, const char *what)
+{
+    fprintf(stderr, "%s: %s\n", mode, what);
+    exit(EXIT_FAILURE);
+}
+
+static
+void precompute(nRF24L01_crypt_t *crypt)
+{
+    while(nRF24L01_crypt_idle(crypt));
+}
+
+static
+void on_refused(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    ++*(uint8_t *)user_data;
+}
+
+static
+void bench(uint8_t mode, const char *name)
+{
+    static const uint8_t key[CIPHER_KEY_SIZE] =
+    {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    };
+    /* sender (id 1) and receiver (id 2) ends of link */
+    static nRF24L01_crypt_t tx;
+    static nRF24L01_crypt_t rx;
+    uint8_t data[nRF24L01_CRYPT_DATA_SIZE];
+    uint8_t frame[nRF24L01_CRYPT_FRAME_SIZE];
+    uint8_t *frame_end = NULL;
+    uint8_t block[AES128_BLOCK_SIZE] = {0};
+    uint64_t t_block = 0;
+    uint64_t t_stream = 0;
+    uint64_t t_seal = 0;
+    uint64_t t_seal_cold = 0;
+    uint64_t t_open = 0;
+    uint64_t t_open_cold = 0;
+
+    nRF24L01_crypt_init(&tx, NULL, mode, key, 1, 2);
+    nRF24L01_crypt_init(&rx, NULL, mode, key, 2, 1);
+    for(uint8_t i = 0; i < sizeof(data); ++i) data[i] = i * 7 + 3;
+
+    uint64_t begin = cycles();
+
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        if(nRF24L01_CRYPT_AES128 == mode) aes128_encrypt(tx.key.aes128, block);
+        else xtea_encrypt(tx.key.xtea, block);
+    }
+    t_block = cycles() - begin;
+    precompute(&tx);
+
+    for(uint32_t i = 0; i < ITERATIONS; ++i)
+    {
+        /* sender only sends: single stream (of seq which became next) */
+        begin = cycles();
+        precompute(&tx);
+        t_stream += cycles() - begin;
+        precompute(&rx);
+
+        const uint8_t cold = i & 1;
+
+        if(cold)
+        {
+            /* invalidates precomputed keystream of both ends */
+            tx.tx_stream[tx.tx_seq % nRF24L01_CRYPT_AHEAD].len = 0;
+            rx.rx_stream[tx.tx_seq % nRF24L01_CRYPT_AHEAD].len = 0;
+        }
+
+        begin = cycles();
+        frame_end = nRF24L01_crypt_seal(&tx, data, data + sizeof(data), frame);
+        if(cold) t_seal_cold += cycles() - begin;
+        else t_seal += cycles() - begin;
+
+        if(!frame_end) fail(name, "seal failed");
+        if(!(i % 64))
+        {
+            /* tampered frame is rejected and does not advance rx seq */
+            frame[nRF24L01_CRYPT_SEQ_SIZE + i % sizeof(data)] ^= 0x01;
+            if(nRF24L01_crypt_open(&rx, frame, frame_end)) fail(name, "tampered frame accepted");
+            frame[nRF24L01_CRYPT_SEQ_SIZE + i % sizeof(data)] ^= 0x01;
+        }
+
+        begin = cycles();
+
+        const uint8_t *data_end = nRF24L01_crypt_open(&rx, frame, frame_end);
+
+        if(cold) t_open_cold += cycles() - begin;
+        else t_open += cycles() - begin;
+
+        if(
+            data_end != frame + nRF24L01_CRYPT_SEQ_SIZE + sizeof(data)
+            || memcmp(frame + nRF24L01_CRYPT_SEQ_SIZE, data, sizeof(data)))
+        {
+            fail(name, "roundtrip failed");
+        }
+        if(nRF24L01_crypt_open(&rx, frame, frame_end)) fail(name, "replay accepted");
+        ++data[i % sizeof(data)];
+    }
+
+    /* refused before radio is touched (there is none here) */
+    uint8_t refused = 0;
+
+    nRF24L01_crypt_send(&tx, frame, frame + sizeof(data) + 1, NULL, on_refused, (uintptr_t)&refused);
+    if(1 != refused) fail(name, "oversized payload not refused");
+
+    printf(
+        "{\"mode\":\"%s\",\"data_size\":%zu,\"block\":%.1f,\"stream\":%.1f"
+        ",\"seal\":%.1f,\"seal_cold\":%.1f,\"open\":%.1f,\"open_cold\":%.1f"
+        ",\"hit\":%" PRIu32 ",\"miss\":%" PRIu32 ",\"auth\":%" PRIu16 ",\"replay\":%" PRIu16 "}\n",
+        name,
+        (size_t)nRF24L01_CRYPT_DATA_SIZE,
+        (double)t_block / ITERATIONS,
+        (double)t_stream / ITERATIONS,
+        (double)t_seal / (ITERATIONS / 2),
+        (double)t_seal_cold / (ITERATIONS / 2),
+        (double)t_open / (ITERATIONS / 2),
+        (double)t_open_cold / (ITERATIONS / 2),
+        tx.stat.hit + rx.stat.hit,
+        tx.stat.miss + rx.stat.miss,
+        rx.stat.auth,
+        rx.stat.replay);
+}
+
+int main(void)
+{
+    bench(nRF24L01_CRYPT_XTEA, "xtea");
+    bench(nRF24L01_CRYPT_AES128, "aes128");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+#include <string.h>
+
+#include "nRF24L01_csma.h"
+#include "xorshift.h"
+
+#define STATE_IDLE 0
+#define STATE_BACKOFF 1
+#define STATE_SENSE 2
+#define STATE_SEND 3
+
+static
+void backoff(nRF24L01_csma_t *csma, uint32_t now)
+{
+    const uint16_t slot = xorshift32(&csma->seed) & ((UINT32_C(1) << csma->be) - 1);
+
+    csma->stat.slot += slot;
+    csma->wait = (uint32_t)slot * csma->slot_us;
+    csma->t = now;
+    csma->state = STATE_BACKOFF;
+}
+
+/* radio stays in RX between samples of same payload,
+ * RPD is valid once RX settled */
+static
+void listen(nRF24L01_csma_t *csma, uint32_t now)
+{
+    csma->state = STATE_SENSE;
+    if(csma->listening) return;
+
+    nRF24L01_t *dev = csma->dev;
+    nRF24L01_config_t config = {.value = nRF24L01_read_register(dev, nRF24L01_ADDR_config)};
+
+    if(!config.PRIM_RX)
+    {
+        /* PRIM_RX is applied on CE rising edge */
+        dev->ce_set((nRF24L01_ce_t){.CE = 0});
+        config.PRIM_RX = 1;
+        nRF24L01_write_register(dev, nRF24L01_ADDR_config, &config.value, &config.value + 1);
+    }
+    dev->ce_set((nRF24L01_ce_t){.CE = 1});
+    csma->listening = 1;
+    csma->t_rx = now;
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_csma_t *csma = (nRF24L01_csma_t *)user_data;
+    const nRF24L01_send_cb_t cb = csma->tx.cb;
+    const uintptr_t cb_user_data = csma->tx.user_data;
+
+    ++csma->stat.sent;
+    memset(&csma->tx, 0, sizeof(csma->tx));
+    csma->state = STATE_IDLE;
+
+    if(cb) (*cb)(cb_user_data);
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_csma_t *csma = (nRF24L01_csma_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = csma->tx.err_cb;
+    const uintptr_t cb_user_data = csma->tx.user_data;
+
+    if(status.MAX_RT) ++csma->stat.tx_err;
+    else ++csma->stat.fail;
+    memset(&csma->tx, 0, sizeof(csma->tx));
+    csma->state = STATE_IDLE;
+
+    if(err_cb) (*err_cb)(status, fifo_status, cb_user_data);
+}
+
+void nRF24L01_csma_init(
+    nRF24L01_csma_t *csma,
+    nRF24L01_t *dev,
+    nRF24L01_csma_clock_t clock,
+    uint32_t seed)
+{
+    memset(csma, 0, sizeof(nRF24L01_csma_t));
+    csma->dev = dev;
+    csma->clock = clock;
+    csma->seed = seed ? seed : 1;
+    csma->sense_us = nRF24L01_CSMA_SENSE_US;
+    csma->slot_us = nRF24L01_CSMA_SLOT_US;
+    csma->be_min = nRF24L01_CSMA_BE_MIN;
+    csma->be_max = nRF24L01_CSMA_BE_MAX;
+    csma->attempt_max = nRF24L01_CSMA_ATTEMPT_MAX;
+    csma->state = STATE_IDLE;
+}
+
+void nRF24L01_csma_send(
+    nRF24L01_csma_t *csma,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    const uint32_t now = (*csma->clock)();
+
+    csma->tx.begin = begin;
+    csma->tx.end = end;
+    csma->tx.cb = cb;
+    csma->tx.err_cb = err_cb;
+    csma->tx.user_data = user_data;
+    csma->be = csma->be_min;
+    csma->attempt = 0;
+    /* radio mode is unknown (application may have used it) */
+    csma->listening = 0;
+
+    backoff(csma, now);
+    if(!csma->wait) listen(csma, now);
+}
+
+uint8_t nRF24L01_csma_busy(const nRF24L01_csma_t *csma)
+{
+    return STATE_IDLE != csma->state;
+}
+
+void nRF24L01_csma_tick(nRF24L01_csma_t *csma)
+{
+    const uint32_t now = (*csma->clock)();
+
+    if(STATE_BACKOFF == csma->state)
+    {
+        if(csma->wait > now - csma->t) goto exit;
+        listen(csma, now);
+    }
+
+    if(STATE_SENSE != csma->state) goto exit;
+    if(csma->sense_us > now - csma->t_rx) goto exit;
+
+    ++csma->stat.sample;
+    if(!nRF24L01_rpd(csma->dev).RPD)
+    {
+        csma->state = STATE_SEND;
+        csma->listening = 0;
+        nRF24L01_send(
+            csma->dev,
+            csma->tx.begin, csma->tx.end,
+            on_sent,
+            on_error,
+            (uintptr_t)csma);
+        goto exit;
+    }
+
+    ++csma->stat.busy;
+    if(++csma->attempt < csma->attempt_max)
+    {
+        if(csma->be < csma->be_max) ++csma->be;
+        backoff(csma, now);
+        goto exit;
+    }
+
+    /* channel access failure */
+    on_error(
+        (nRF24L01_status_t){.value = 0},
+        (nRF24L01_fifo_status_t){.value = 0},
+        (uintptr_t)csma);
+exit:
+    ; // this is required by syntax
+}
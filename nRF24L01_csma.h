@@ -0,0 +1,91 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Listen-before-talk (CSMA/CA) transmission.
+ *
+ * Payload is not written until channel is found clear: radio is switched to
+ * RX (application reception armed by nRF24L01_recv() is not touched) and
+ * once RX has settled and AGC has measured the channel (sense_us) RPD
+ * (received power > -64dBm) is sampled. Busy channel is sampled again after
+ * binary exponential backoff: random number of slots in [0, 2^be), be starts
+ * at be_min and grows with every busy sample up to be_max. First sample is
+ * preceded by backoff too so nodes released by end of same packet do not
+ * sample (and then transmit) at once. After attempt_max busy samples payload
+ * is dropped (channel access failure).
+ *
+ * Parameters are set to defaults by init() and can be changed afterwards.
+ * slot_us should cover time from RPD sample to start of transmission
+ * (TX settling) or nodes sampling in same slot collide. Time is taken from
+ * clock (us), tick() has to be called at least once per slot. */
+
+#define nRF24L01_CSMA_SENSE_US 170 // RX settling (130us) + RPD (40us)
+#define nRF24L01_CSMA_SLOT_US 250
+#define nRF24L01_CSMA_BE_MIN 3
+#define nRF24L01_CSMA_BE_MAX 6 // up to 15
+#define nRF24L01_CSMA_ATTEMPT_MAX 8
+
+typedef
+uint32_t (*nRF24L01_csma_clock_t)(void);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_csma_clock_t clock;
+    uint32_t seed; // PRNG state
+    uint32_t t; // state entered at
+    uint32_t wait; // us, backoff duration
+    uint32_t t_rx; // RX entered at
+    uint16_t sense_us;
+    uint16_t slot_us;
+    uint8_t be_min;
+    uint8_t be_max;
+    uint8_t attempt_max;
+    uint8_t be; // current backoff exponent
+    uint8_t attempt; // busy samples of current payload
+    uint8_t state;
+    struct
+    {
+        uint8_t listening : 1; // RX entered by sensing
+        uint8_t : 7;
+    };
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+    struct
+    {
+        uint32_t sample; // RPD samples
+        uint32_t busy; // channel found busy
+        uint32_t slot; // backoff slots waited
+        uint16_t fail; // channel access failures
+        uint16_t tx_err; // MAX_RT
+        uint32_t sent;
+    } stat;
+} nRF24L01_csma_t;
+
+/* seed should differ between nodes (i.e. derived from address) */
+void nRF24L01_csma_init(
+    nRF24L01_csma_t *,
+    nRF24L01_t *,
+    nRF24L01_csma_clock_t,
+    uint32_t seed);
+
+/* same as nRF24L01_send() once channel is clear, on channel access failure
+ * err_cb is called with MAX_RT clear */
+void nRF24L01_csma_send(
+    nRF24L01_csma_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* send in progress (backoff, sensing or transmitting) */
+uint8_t nRF24L01_csma_busy(const nRF24L01_csma_t *);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_csma_tick(nRF24L01_csma_t *);
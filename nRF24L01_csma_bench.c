@@ -0,0 +1,270 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_csma.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Shared channel benchmark against simulated radios (nRF24L01_sim).
+ *
+ * Senders transmit to single sink without auto ACK, after every payload
+ * sender waits random think time (uniform, mean interval) before next one
+ * (interval 0: saturated). Same traffic is sent directly (ALOHA) and with
+ * listen-before-talk (nRF24L01_csma), payloads delivered to sink are
+ * counted. Time is virtual so results are reproducible for given seed.
+ *
+ * usage: nRF24L01_csma_bench [senders [seed [duration_ms]]] */
+
+#define SENDER_MAX (nRF24L01_SIM_DEV_MAX - 1)
+#define FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define TICK_PERIOD 50 // us
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_csma_t csma;
+    uint8_t frame[FRAME_SIZE];
+    uint64_t t_next; // next payload
+    uint16_t seq;
+    uint8_t busy;
+    uint32_t sent;
+    uint32_t fail; // channel access failures
+} sender_t;
+
+static nRF24L01_sim_air_t air;
+static sender_t sender_[SENDER_MAX];
+static nRF24L01_sim_t sink_sim;
+static nRF24L01_t sink_dev;
+static uint8_t sink_frame[FRAME_SIZE];
+static uint32_t delivered;
+static uint32_t interval_; // us, mean think time
+static uint32_t seed_;
+
+static
+uint32_t clock_us(void)
+{
+    return air.now;
+}
+
+static
+void configure(nRF24L01_t *dev, nRF24L01_sim_t *sim, uint8_t rx)
+{
+    nRF24L01_sim_bench_init(dev, sim, &air);
+    nRF24L01_CFG(
+        dev, config,
+        .PRIM_RX = rx,
+        .PWR_UP = 1,
+        .CRCO = 1,
+        .EN_CRC = 1,
+        .MASK_MAX_RT = 0,
+        .MASK_TX_DS = 0,
+        .MASK_RX_DR = 0);
+    /* senders only sense carrier */
+    nRF24L01_CFG(dev, en_rxaddr, .ERX_P0 = rx);
+    nRF24L01_CFG(
+        dev, rf_setup,
+        .RF_PWR = 3,
+        .RF_DR_HIGH = 0,
+        .PLL_LOCK = 0,
+        .RF_DR_LOW = 0,
+        .CONT_WAVE = 0);
+}
+
+static
+void on_sink_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data);
+
+static
+void on_sink_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void sink_listen(void)
+{
+    nRF24L01_recv(
+        &sink_dev,
+        sink_frame, sink_frame + sizeof(sink_frame),
+        on_sink_frame,
+        on_sink_error,
+        0);
+}
+
+static
+void on_sink_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    if(FRAME_SIZE == curr - sink_frame) ++delivered;
+    sink_listen();
+}
+
+static
+void on_sink_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    sink_listen();
+}
+
+static
+void think(sender_t *s)
+{
+    s->busy = 0;
+    s->t_next = air.now + (interval_ ? xorshift32(&seed_) % (2 * interval_) : 0);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    sender_t *s = (sender_t *)user_data;
+
+    ++s->sent;
+    think(s);
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    sender_t *s = (sender_t *)user_data;
+
+    if(!status.MAX_RT) ++s->fail;
+    think(s);
+}
+
+static
+void send(sender_t *s, uint8_t id, uint8_t csma)
+{
+    s->frame[0] = id;
+    s->frame[1] = s->seq;
+    s->frame[2] = s->seq >> 8;
+    ++s->seq;
+    s->busy = 1;
+
+    if(csma)
+    {
+        nRF24L01_csma_send(
+            &s->csma,
+            s->frame, s->frame + sizeof(s->frame),
+            on_sent, on_error, (uintptr_t)s);
+    }
+    else
+    {
+        nRF24L01_send(
+            &s->dev,
+            s->frame, s->frame + sizeof(s->frame),
+            on_sent, on_error, (uintptr_t)s);
+    }
+}
+
+static
+void run(uint8_t num, uint8_t csma, uint32_t interval, uint32_t duration)
+{
+    uint32_t sent = 0;
+    uint32_t fail = 0;
+    uint32_t sample = 0;
+    uint32_t busy = 0;
+    uint32_t slot = 0;
+    uint32_t collided;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    configure(&sink_dev, &sink_sim, 1);
+    for(uint8_t i = 0; i < num; ++i)
+    {
+        sender_t *s = sender_ + i;
+
+        memset(s, 0, sizeof(sender_t));
+        configure(&s->dev, &s->sim, 0);
+        nRF24L01_csma_init(&s->csma, &s->dev, clock_us, xorshift32(&seed_));
+    }
+    delivered = 0;
+    interval_ = interval;
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    sink_listen();
+    for(uint8_t i = 0; i < num; ++i) think(sender_ + i);
+
+    const uint64_t end = air.now + (uint64_t)duration * 1000;
+    uint64_t tick = air.now;
+
+    while(air.now < end)
+    {
+        nRF24L01_sim_bench_dispatch(&sink_dev, &sink_sim);
+        for(uint8_t i = 0; i < num; ++i) nRF24L01_sim_bench_dispatch(&sender_[i].dev, &sender_[i].sim);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        for(uint8_t i = 0; i < num; ++i)
+        {
+            sender_t *s = sender_ + i;
+
+            if(!s->busy && s->t_next <= air.now) send(s, i, csma);
+            if(csma) nRF24L01_csma_tick(&s->csma);
+        }
+    }
+
+    collided = sink_sim.stat.collided;
+    for(uint8_t i = 0; i < num; ++i)
+    {
+        const sender_t *s = sender_ + i;
+
+        sent += s->sent;
+        fail += s->fail;
+        sample += s->csma.stat.sample;
+        busy += s->csma.stat.busy;
+        slot += s->csma.stat.slot;
+        nRF24L01_sim_release(&sender_[i].sim);
+    }
+    nRF24L01_sim_release(&sink_sim);
+
+    printf(
+        "{\"mode\":\"%s\",\"senders\":%" PRIu8 ",\"interval_us\":%" PRIu32
+        ",\"sent\":%" PRIu32 ",\"delivered\":%" PRIu32 ",\"collided\":%" PRIu32
+        ",\"delivered_pps\":%" PRIu32 ",\"sample\":%" PRIu32 ",\"busy\":%" PRIu32
+        ",\"backoff_slot\":%" PRIu32 ",\"fail\":%" PRIu32 "}\n",
+        csma ? "csma" : "aloha",
+        num,
+        interval,
+        sent,
+        delivered,
+        collided,
+        (uint32_t)((uint64_t)delivered * 1000 / duration),
+        sample,
+        busy,
+        slot,
+        fail);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t interval[] = {20000, 10000, 5000, 2000, 0};
+    const uint8_t num = 1 < argc ? strtoul(argv[1], NULL, 0) : 12;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+    const uint32_t duration = 3 < argc ? strtoul(argv[3], NULL, 0) : 2000;
+
+    if(!num || SENDER_MAX < num || !duration)
+    {
+        fprintf(stderr, "usage: %s [senders (1..%u) [seed [duration_ms]]]\n", argv[0], SENDER_MAX);
+        return EXIT_FAILURE;
+    }
+
+    for(uint8_t i = 0; i < sizeof(interval) / sizeof(interval[0]); ++i)
+    {
+        for(uint8_t csma = 0; csma < 2; ++csma)
+        {
+            seed_ = seed ? seed : 1;
+            run(num, csma, interval[i], duration);
+        }
+    }
+    return EXIT_SUCCESS;
+}
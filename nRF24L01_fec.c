@@ -0,0 +1,304 @@
+#include <string.h>
+
+#include "nRF24L01_fec.h"
+
+#define FRAME_SIZE nRF24L01_FEC_FRAME_SIZE
+#define FRAGMENT_SIZE nRF24L01_FEC_FRAGMENT_SIZE
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+typedef struct
+{
+    uint8_t seq; // message sequence number
+    // [0, data_num): data, [data_num, data_num + parity_num): parity
+    uint8_t index : 6;
+    uint8_t : 2;
+    uint8_t data_num : 5; // stored as data_num - 1
+    uint8_t parity_num : 3;
+    uint8_t last_size; // size of last data fragment
+} header_t;
+
+typedef union
+{
+    struct
+    {
+        header_t header;
+        uint8_t data[FRAGMENT_SIZE];
+    };
+    uint8_t byte[0];
+} frame_t;
+
+/* sender ------------------------------------------------------------------ */
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_fec_t *fec = (nRF24L01_fec_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = fec->tx.err_cb;
+    const uintptr_t tx_user_data = fec->tx.user_data;
+
+    fec->tx.begin = NULL;
+    fec->tx.end = NULL;
+    fec->tx.cb = NULL;
+    fec->tx.err_cb = NULL;
+    fec->tx.user_data = 0;
+
+    if(err_cb) (*err_cb)(status, fifo_status, tx_user_data);
+}
+
+static
+void send_next(nRF24L01_fec_t *fec)
+{
+    frame_t *frame = (frame_t *)fec->frame;
+    const uint8_t index = fec->tx.index;
+    uint8_t size = FRAGMENT_SIZE;
+
+    if(index < fec->tx.data_num)
+    {
+        const uint8_t *data = fec->tx.begin + (size_t)index * FRAGMENT_SIZE;
+
+        size = MIN(FRAGMENT_SIZE, (size_t)(fec->tx.end - data));
+        memcpy(frame->data, data, size);
+        /* last fragment is zero padded for parity calculation only */
+        memset(frame->data + size, 0, FRAGMENT_SIZE - size);
+        rs_encode(
+            index, frame->data, fec->tx.data_num,
+            fec->parity, fec->tx.parity_num,
+            FRAGMENT_SIZE);
+    }
+    else if(index < fec->tx.data_num + fec->tx.parity_num)
+    {
+        const uint8_t i = index - fec->tx.data_num;
+
+        memcpy(frame->data, fec->parity + (size_t)i * FRAGMENT_SIZE, FRAGMENT_SIZE);
+    }
+    else
+    {
+        const nRF24L01_fec_send_cb_t cb = fec->tx.cb;
+        const uintptr_t user_data = fec->tx.user_data;
+
+        fec->tx.begin = NULL;
+        fec->tx.end = NULL;
+        fec->tx.cb = NULL;
+        fec->tx.err_cb = NULL;
+        fec->tx.user_data = 0;
+
+        if(cb) (*cb)(user_data);
+        return;
+    }
+
+    frame->header = (header_t)
+    {
+        .seq = fec->tx.seq,
+        .index = index,
+        .data_num = fec->tx.data_num - 1,
+        .parity_num = fec->tx.parity_num,
+        .last_size = fec->tx.last_size
+    };
+    ++fec->tx.index;
+
+    fec->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        fec->dev,
+        fec->frame, fec->frame + sizeof(header_t) + size,
+        on_sent,
+        on_send_error,
+        (uintptr_t)fec);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    send_next((nRF24L01_fec_t *)user_data);
+}
+
+/* receiver ---------------------------------------------------------------- */
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_recv_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(nRF24L01_fec_t *fec)
+{
+    fec->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        fec->dev,
+        fec->frame, fec->frame + FRAME_SIZE,
+        on_frame,
+        on_recv_error,
+        (uintptr_t)fec);
+}
+
+static
+void on_recv_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_fec_t *)user_data);
+}
+
+static
+void rx_start(nRF24L01_fec_t *fec, const header_t *header)
+{
+    if(fec->rx.started && !fec->rx.done) ++fec->rx.lost;
+
+    fec->rx.seq = header->seq;
+    fec->rx.data_num = header->data_num + 1;
+    fec->rx.parity_num = header->parity_num;
+    fec->rx.last_size = header->last_size;
+    fec->rx.data_present = 0;
+    fec->rx.parity_present = 0;
+    fec->rx.received = 0;
+    fec->rx.started = 1;
+    fec->rx.done = 0;
+
+    /* message does not fit, drop it */
+    if(
+        RS_PARITY_MAX_NUM < fec->rx.parity_num
+        || (size_t)fec->rx.data_num * FRAGMENT_SIZE
+            > (size_t)(fec->rx.end - fec->rx.begin))
+    {
+        ++fec->rx.lost;
+        fec->rx.done = 1;
+    }
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_fec_t *fec = (nRF24L01_fec_t *)user_data;
+    const frame_t *frame = (const frame_t *)fec->frame;
+    const uint8_t size = curr - fec->frame;
+
+    if(!fec->rx.active || size < sizeof(header_t)) goto listen;
+
+    const header_t header = frame->header;
+    const uint8_t data_size = size - sizeof(header_t);
+
+    if(!fec->rx.started || header.seq != fec->rx.seq) rx_start(fec, &header);
+    if(fec->rx.done) goto listen;
+
+    if(header.index < fec->rx.data_num)
+    {
+        const uint32_t mask = UINT32_C(1) << header.index;
+        uint8_t *dst = fec->rx.begin + (size_t)header.index * FRAGMENT_SIZE;
+
+        if(fec->rx.data_present & mask) goto listen;
+        fec->rx.data_present |= mask;
+        memcpy(dst, frame->data, data_size);
+        memset(dst + data_size, 0, FRAGMENT_SIZE - data_size);
+    }
+    else if(header.index < fec->rx.data_num + fec->rx.parity_num)
+    {
+        const uint8_t i = header.index - fec->rx.data_num;
+
+        if(fec->rx.parity_present & (1 << i)) goto listen;
+        if(FRAGMENT_SIZE != data_size) goto listen;
+        fec->rx.parity_present |= 1 << i;
+        memcpy(fec->parity + (size_t)i * FRAGMENT_SIZE, frame->data, FRAGMENT_SIZE);
+    }
+    else goto listen;
+
+    if(++fec->rx.received < fec->rx.data_num) goto listen;
+
+    const uint32_t all = UINT32_MAX >> (32 - fec->rx.data_num);
+
+    if(all != fec->rx.data_present)
+    {
+        /* not delivered, counted as lost once next message starts
+         * (rx_start) unless further fragment makes it decodable */
+        if(
+            !rs_decode(
+                fec->rx.begin, fec->rx.data_num, fec->rx.data_present,
+                fec->parity, fec->rx.parity_num, fec->rx.parity_present,
+                FRAGMENT_SIZE))
+        {
+            goto listen;
+        }
+        ++fec->rx.recovered;
+    }
+    fec->rx.done = 1;
+
+    {
+        uint8_t *const begin = fec->rx.begin;
+        uint8_t *const end =
+            begin
+            + (size_t)(fec->rx.data_num - 1) * FRAGMENT_SIZE
+            + fec->rx.last_size;
+
+        listen(fec);
+        if(fec->rx.cb) (*fec->rx.cb)(begin, end, fec->rx.user_data);
+    }
+    return;
+listen:
+    listen(fec);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void nRF24L01_fec_init(
+    nRF24L01_fec_t *fec,
+    nRF24L01_t *dev,
+    uint8_t data_num,
+    uint8_t parity_num)
+{
+    memset(fec, 0, sizeof(nRF24L01_fec_t));
+    fec->dev = dev;
+    fec->data_num = data_num;
+    fec->parity_num = parity_num;
+}
+
+void nRF24L01_fec_send(
+    nRF24L01_fec_t *fec,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_fec_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    const size_t size = end - begin;
+    const uint8_t data_num = size ? (size + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE : 1;
+    /* keep configured overhead ratio for shorter messages */
+    uint8_t parity_num =
+        ((uint16_t)data_num * fec->parity_num + fec->data_num - 1) / fec->data_num;
+
+    if(!parity_num && fec->parity_num) parity_num = 1;
+
+    fec->tx.begin = begin;
+    fec->tx.end = end;
+    fec->tx.cb = cb;
+    fec->tx.err_cb = err_cb;
+    fec->tx.user_data = user_data;
+    fec->tx.index = 0;
+    fec->tx.data_num = data_num;
+    fec->tx.parity_num = MIN(parity_num, RS_PARITY_MAX_NUM);
+    fec->tx.last_size = size - (size_t)(data_num - 1) * FRAGMENT_SIZE;
+    ++fec->tx.seq;
+    memset(fec->parity, 0, sizeof(fec->parity));
+    send_next(fec);
+}
+
+void nRF24L01_fec_recv(
+    nRF24L01_fec_t *fec,
+    uint8_t *begin, const uint8_t *const end,
+    nRF24L01_fec_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    fec->rx.begin = begin;
+    fec->rx.end = end;
+    fec->rx.cb = cb;
+    fec->rx.user_data = user_data;
+    fec->rx.active = 1;
+    listen(fec);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "nRF24L01.h"
+#include "rs.h"
+
+/* Forward error correction for one-way (no ACK) links.
+ *
+ * Message is split into data fragments which are sent as separate payloads
+ * followed by Reed-Solomon parity fragments. Receiver reconstructs message
+ * from any data_num fragments, lost payloads do not require round trip.
+ *
+ * Overhead is configured as ratio: parity_num parity fragments are sent
+ * for every data_num data fragments (rounded up, at least one).
+ *
+ * Corrupted payloads have to be dropped by the radio (EN_CRC = 1) to be
+ * handled as lost ones, FEC only recovers erasures.
+ *
+ * Frame and parity buffers are shared by both directions, instance can
+ * either send or receive at a time. */
+
+/* frame is sent as single payload (driver header excluded) */
+#define nRF24L01_FEC_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_FEC_FRAGMENT_SIZE (nRF24L01_FEC_FRAME_SIZE - 4)
+#define nRF24L01_FEC_MAX_SIZE \
+    ((size_t)RS_DATA_MAX_NUM * nRF24L01_FEC_FRAGMENT_SIZE)
+
+typedef
+void (*nRF24L01_fec_send_cb_t)(uintptr_t);
+typedef
+void (*nRF24L01_fec_recv_cb_t)(uint8_t *begin, uint8_t *end, uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    uint8_t data_num;
+    uint8_t parity_num;
+    uint8_t frame[nRF24L01_FEC_FRAME_SIZE];
+    uint8_t parity[RS_PARITY_MAX_NUM * nRF24L01_FEC_FRAGMENT_SIZE];
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_fec_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+        uint8_t seq;
+        uint8_t index;
+        uint8_t data_num;
+        uint8_t parity_num;
+        uint8_t last_size;
+    } tx;
+    struct
+    {
+        uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_fec_recv_cb_t cb;
+        uintptr_t user_data;
+        uint32_t data_present;
+        uint8_t parity_present;
+        uint8_t seq;
+        uint8_t data_num;
+        uint8_t parity_num;
+        uint8_t last_size;
+        uint8_t received;
+        uint16_t recovered; // statistics: messages which required decoding
+        uint16_t lost; // statistics: messages which could not be decoded
+        struct
+        {
+            uint8_t active : 1;
+            uint8_t started : 1; // seq is valid
+            uint8_t done : 1; // message seq was already delivered
+            uint8_t : 5;
+        };
+    } rx;
+} nRF24L01_fec_t;
+
+/* parity_num must not exceed RS_PARITY_MAX_NUM */
+void nRF24L01_fec_init(
+    nRF24L01_fec_t *,
+    nRF24L01_t *,
+    uint8_t data_num,
+    uint8_t parity_num);
+
+/* size of [begin, end) must not exceed nRF24L01_FEC_MAX_SIZE */
+void nRF24L01_fec_send(
+    nRF24L01_fec_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_fec_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* buffer is used for reconstruction so it has to hold whole fragments,
+ * messages which do not fit are dropped */
+void nRF24L01_fec_recv(
+    nRF24L01_fec_t *,
+    uint8_t *begin, const uint8_t *const end,
+    nRF24L01_fec_recv_cb_t,
+    uintptr_t user_data);
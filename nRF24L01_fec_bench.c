@@ -0,0 +1,216 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_fec.h"
+#include "nRF24L01_sim_bench.h"
+
+/* FEC packetizing test against simulated radios (nRF24L01_sim).
+ *
+ * Sender transfers random messages (0 - nRF24L01_FEC_MAX_SIZE) with
+ * data_num:parity_num overhead, for every message random 0 - parity_num
+ * fragments (data or parity, parity_num as scaled by message size) are
+ * lost on air (sent to other address). Every 8th message (but
+ * last) loses parity_num + 1 fragments. Checked: recoverable messages
+ * are delivered intact (size, memcmp), decoding is done exactly when data
+ * fragment was lost (rx.recovered), unrecoverable ones are not delivered
+ * and counted (rx.lost) unless no fragment of them arrived.
+ *
+ * Reported: messages, bytes, fragments sent and lost, recovered and
+ * unrecoverable messages. Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_fec_bench [data_num [parity_num [seed [messages]]]] */
+
+#define TIMEOUT_US UINT64_C(600000000)
+#define UNRECOVERABLE_PERIOD 8 // every n-th message
+#define FAIL(what) nRF24L01_sim_bench_fail("fec: %s (message %" PRIu32 ")", what, started_)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_fec_t fec;
+} node_t;
+
+static nRF24L01_sim_air_t air;
+static node_t tx_;
+static node_t rx_;
+static nRF24L01_spi_xchg_t tx_spi_xchg_; // sim trampoline of sender
+static uint8_t msg_[nRF24L01_FEC_MAX_SIZE];
+static uint8_t buf_[nRF24L01_FEC_MAX_SIZE];
+static uint32_t size_; // of message in flight
+static uint64_t drop_; // fragments of message in flight lost on air
+static uint32_t num_;
+static uint32_t started_;
+static uint32_t sent_;
+static uint32_t delivered_;
+static uint32_t bytes_;
+static uint32_t fragments_;
+static uint32_t dropped_;
+static uint32_t recovered_; // expected rx.recovered
+static uint32_t unrecoverable_;
+static uint32_t lost_; // expected rx.lost
+static uint32_t seed_ = 1;
+
+/* picks fragments to be lost once block size is known (first fragment) */
+static
+void pick_drop(void)
+{
+    const uint8_t data_num = tx_.fec.tx.data_num;
+    const uint8_t parity_num = tx_.fec.tx.parity_num;
+    const uint8_t num = data_num + parity_num;
+    uint8_t drop_num = xorshift32(&seed_) % (parity_num + 1);
+
+    /* last one is not, its loss is counted once next message starts */
+    if(parity_num && !(started_ % UNRECOVERABLE_PERIOD) && num_ != started_)
+    {
+        drop_num = parity_num + 1;
+        ++unrecoverable_;
+        /* receiver does not know message it got no fragment of */
+        if(drop_num < num) ++lost_;
+    }
+
+    drop_ = 0;
+    for(uint8_t i = 0; i < drop_num; ++i)
+    {
+        uint8_t index = xorshift32(&seed_) % num;
+
+        while(drop_ & (UINT64_C(1) << index)) index = (index + 1) % num;
+        drop_ |= UINT64_C(1) << index;
+    }
+    if(drop_num <= parity_num && (drop_ & (UINT64_MAX >> (64 - data_num)))) ++recovered_;
+    fragments_ += num;
+    dropped_ += drop_num;
+}
+
+static
+void tx_spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    if(nRF24L01_W_TX_PAYLOAD == *begin)
+    {
+        /* send_next() counts fragment before it is written */
+        const uint8_t index = tx_.fec.tx.index - 1;
+
+        if(!index) pick_drop();
+        /* lost: nobody listens on other address */
+        tx_.sim.tx_addr[0] = drop_ & (UINT64_C(1) << index) ? 0xC2 : 0xE7;
+    }
+    (*tx_spi_xchg_)(begin, end);
+}
+
+static
+void configure(node_t *node, uint8_t data_num, uint8_t parity_num)
+{
+    nRF24L01_sim_bench_init(&node->dev, &node->sim, &air);
+    nRF24L01_fec_init(&node->fec, &node->dev, data_num, parity_num);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    ++sent_;
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    FAIL("send error");
+}
+
+static
+void send_next(void)
+{
+    ++started_;
+    size_ = xorshift32(&seed_) % (nRF24L01_FEC_MAX_SIZE + 1);
+    for(uint32_t i = 0; i < size_; ++i) msg_[i] = xorshift32(&seed_);
+    nRF24L01_fec_send(&tx_.fec, msg_, msg_ + size_, on_sent, on_send_error, 0);
+}
+
+static
+void on_recv(uint8_t *begin, uint8_t *end, uintptr_t user_data)
+{
+    if(delivered_ + unrecoverable_ + 1 != started_) FAIL("delivered twice or unrecoverable");
+    if((size_t)(end - begin) != size_ || memcmp(begin, msg_, size_)) FAIL("message corrupted");
+    ++delivered_;
+    bytes_ += size_;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t data_num = 1 < argc ? strtoul(argv[1], NULL, 0) : 8;
+    const uint32_t parity_num = 2 < argc ? strtoul(argv[2], NULL, 0) : 2;
+    const uint32_t seed = 3 < argc ? strtoul(argv[3], NULL, 0) : 1;
+    const uint32_t num = 4 < argc ? strtoul(argv[4], NULL, 0) : 200;
+
+    if(!data_num || data_num > RS_DATA_MAX_NUM || parity_num > RS_PARITY_MAX_NUM || !num)
+    {
+        fprintf(stderr, "usage: %s [data_num [parity_num [seed [messages]]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    seed_ = seed ? seed : 1;
+    num_ = num;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    configure(&tx_, data_num, parity_num);
+    configure(&rx_, data_num, parity_num);
+    /* sender payload writes go through drop selection */
+    tx_spi_xchg_ = tx_.dev.spi_xchg;
+    tx_.dev.spi_xchg = tx_spi_xchg;
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    nRF24L01_fec_recv(&rx_.fec, buf_, buf_ + sizeof(buf_), on_recv, 0);
+
+    const uint64_t begin = air.now;
+
+    send_next();
+    while(air.now < begin + TIMEOUT_US)
+    {
+        nRF24L01_sim_bench_dispatch(&tx_.dev, &tx_.sim);
+        nRF24L01_sim_bench_dispatch(&rx_.dev, &rx_.sim);
+
+        /* next message once previous one is sent and received (if it can) */
+        if(sent_ == started_ && delivered_ + unrecoverable_ == started_)
+        {
+            if(num == started_) break;
+            send_next();
+            continue;
+        }
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        if(nRF24L01_SIM_NEVER == next) FAIL("stalled");
+        nRF24L01_sim_run(&air, next);
+    }
+
+    if(num != sent_ || num != delivered_ + unrecoverable_) FAIL("timeout");
+    if(recovered_ != rx_.fec.rx.recovered) FAIL("recovered count");
+    if(lost_ != rx_.fec.rx.lost) FAIL("lost count");
+
+    const double time_ms = (double)(air.now - begin) / 1000;
+
+    printf(
+        "{\"data_num\":%" PRIu32 ",\"parity_num\":%" PRIu32 ",\"messages\":%" PRIu32
+        ",\"bytes\":%" PRIu32 ",\"time_ms\":%.1f,\"fragments\":%" PRIu32
+        ",\"dropped\":%" PRIu32 ",\"recovered\":%" PRIu16 ",\"unrecoverable\":%" PRIu32
+        ",\"goodput_kbps\":%.1f,\"ok\":1}\n",
+        data_num,
+        parity_num,
+        delivered_,
+        bytes_,
+        time_ms,
+        fragments_,
+        dropped_,
+        rx_.fec.rx.recovered,
+        unrecoverable_,
+        bytes_ * 8 / time_ms);
+
+    nRF24L01_sim_release(&tx_.sim);
+    nRF24L01_sim_release(&rx_.sim);
+    return EXIT_SUCCESS;
+}
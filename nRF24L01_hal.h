@@ -0,0 +1,62 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Compile-time bound HAL (build with -DnRF24L01_HAL_STATIC=\"port.h\").
+ *
+ * Default build reaches radio through dev->spi_xchg/dev->ce_set (indirect
+ * call per access, transfer buffer on stack). With nRF24L01_HAL_STATIC
+ * driver (nRF24L01.c, nRF24L01_CFG()) calls port header hooks instead,
+ * port provides (nRF24L01_HAL_INLINE):
+ *   void nRF24L01_hal_select(void); // CSN low
+ *   void nRF24L01_hal_deselect(void); // CSN high
+ *   uint8_t nRF24L01_hal_xchg(uint8_t); // single byte (i.e. SPDR)
+ *   void nRF24L01_hal_ce_set(nRF24L01_ce_t);
+ * and register accessors nRF24L01_hal_read_<tag>()/nRF24L01_hal_write_<tag>()
+ * are generated for every register (nRF24L01_REGISTERS), so access inlines
+ * down to byte exchanges with constant command (forced, -Os alone keeps
+ * calls to hooks used more than once). Single radio per build. */
+
+#ifdef nRF24L01_HAL_STATIC
+#define nRF24L01_HAL_INLINE static inline __attribute__((always_inline))
+
+#include nRF24L01_HAL_STATIC
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    nRF24L01_hal_select();
+    for(; begin != end; ++begin) *begin = nRF24L01_hal_xchg(*begin);
+    nRF24L01_hal_deselect();
+}
+
+#define nRF24L01_HAL_REGISTER(tag) \
+    nRF24L01_HAL_INLINE \
+    nRF24L01_##tag##_t nRF24L01_hal_read_##tag(void) \
+    { \
+        nRF24L01_##tag##_t data; \
+        \
+        nRF24L01_hal_select(); \
+        nRF24L01_hal_xchg(nRF24L01_R_REGISTER(nRF24L01_ADDR_##tag)); \
+        for(uint8_t i = 0; i < sizeof(data); ++i) \
+        { \
+            data.byte[i] = nRF24L01_hal_xchg(nRF24L01_NOP); \
+        } \
+        nRF24L01_hal_deselect(); \
+        return data; \
+    } \
+    \
+    nRF24L01_HAL_INLINE \
+    void nRF24L01_hal_write_##tag(nRF24L01_##tag##_t data) \
+    { \
+        nRF24L01_hal_select(); \
+        nRF24L01_hal_xchg(nRF24L01_W_REGISTER(nRF24L01_ADDR_##tag)); \
+        for(uint8_t i = 0; i < sizeof(data); ++i) \
+        { \
+            nRF24L01_hal_xchg(data.byte[i]); \
+        } \
+        nRF24L01_hal_deselect(); \
+    }
+
+nRF24L01_REGISTERS(nRF24L01_HAL_REGISTER)
+#endif
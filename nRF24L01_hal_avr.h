@@ -0,0 +1,39 @@
+#pragma once
+
+#include <avr/io.h>
+
+#include <drv/spi0.h>
+
+/* nRF24L01_hal.h port for ATmega328p SPI0 (pins as in nRF24L01_bench_tx.c),
+ * build with -DnRF24L01_HAL_STATIC=\"nRF24L01_hal_avr.h\".
+ * SPI0 and pins are set up by application before nRF24L01_init(). */
+
+// nRF CE       PC.1/PCINT9        pin: A1 pro-mini
+// SPI0 !SS     PB.2/PCINT2        pin: 10 pro-mini
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_select(void)
+{
+    PORTB &= ~M1(DDB2);
+}
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_deselect(void)
+{
+    PORTB |= M1(DDB2);
+}
+
+nRF24L01_HAL_INLINE
+uint8_t nRF24L01_hal_xchg(uint8_t data)
+{
+    SPDR = data;
+    while(!(SPSR & M1(SPIF)));
+    return SPDR;
+}
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_ce_set(nRF24L01_ce_t state)
+{
+    if(state.CE) PORTC |= M1(DDC1);
+    else PORTC &= ~M1(DDC1);
+}
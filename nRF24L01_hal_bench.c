@@ -0,0 +1,156 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_hal_host.h"
+
+/* host benchmark of driver register access, pointer bound HAL (default,
+ * dev->spi_xchg/dev->ce_set) against compile-time bound one
+ * (nRF24L01_HAL_STATIC, nRF24L01_hal.h), same source built twice:
+ * nRF24L01_hal_bench and nRF24L01_hal_bench_static.
+ *
+ * SPI is replaced by register file model (nRF24L01_hal_host.h), cycles per
+ * operation (average of best of RUNS runs, event ops include model setup)
+ * are TSC cycles on x86 (ns elsewhere). Compiler barrier after every
+ * operation and cfg value varying per iteration keep static build from
+ * hoisting it out of loop. Function call overhead is smaller than on AVR
+ * (see hal_test for MCU).
+ *
+ * output: JSON line per operation */
+
+#define ITERATIONS 200000 // per run
+#define RUNS 10
+
+nRF24L01_hal_host_t nRF24L01_hal_host;
+
+volatile uintptr_t sink;
+
+#ifdef nRF24L01_HAL_STATIC
+#define HAL "static"
+#else
+#define HAL "pointer"
+#endif
+
+static
+uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    nRF24L01_hal_select();
+    for(; begin != end; ++begin) *begin = nRF24L01_hal_xchg(*begin);
+    nRF24L01_hal_deselect();
+}
+
+static
+void ce_set(nRF24L01_ce_t state)
+{
+    nRF24L01_hal_ce_set(state);
+}
+
+static
+void report(const char *op, uint64_t time)
+{
+    printf(
+        "{\"hal\":\"" HAL "\",\"op\":\"%s\",\"cycles\":%.1f}\n",
+        op, (double)time / ITERATIONS);
+}
+
+/* best run, preemption and frequency ramp only make runs slower */
+#define MEASURE(op, setup, stmt) \
+    { \
+        uint64_t best = UINT64_MAX; \
+        \
+        for(uint8_t run = 0; run < RUNS; ++run) \
+        { \
+            const uint64_t begin = cycles(); \
+            \
+            for(uint32_t i = 0; i < ITERATIONS; ++i) \
+            { \
+                setup; \
+                stmt; \
+                __asm__ volatile("" ::: "memory"); \
+            } \
+            \
+            const uint64_t time = cycles() - begin; \
+            \
+            if(best > time) best = time; \
+        } \
+        report(op, best); \
+    }
+
+int main(void)
+{
+    static const uint8_t data[16] = {0};
+    static uint8_t buf[nRF24L01_PAYLOAD_SIZE];
+    nRF24L01_hal_host_t *host = &nRF24L01_hal_host;
+    nRF24L01_t dev;
+
+    nRF24L01_init(&dev, ce_set, spi_xchg);
+    if(nRF24L01_PAYLOAD_SIZE != host->reg[nRF24L01_ADDR_rx_pw_p5][0])
+    {
+        fprintf(stderr, "init: RX_PW_P5 not written\n");
+        return EXIT_FAILURE;
+    }
+
+    MEASURE("status", , sink = nRF24L01_status(&dev).value);
+    MEASURE("read_register", , sink = nRF24L01_read_register(&dev, nRF24L01_ADDR_rf_ch));
+    MEASURE(
+        "cfg", ,
+        nRF24L01_CFG(
+            &dev, rf_setup,
+            .RF_PWR = i & 3, // ends at 3
+            .RF_DR_HIGH = 1,
+            .PLL_LOCK = 0,
+            .RF_DR_LOW = 0,
+            .CONT_WAVE = 0));
+    if((nRF24L01_rf_setup_t){.RF_PWR = 3, .RF_DR_HIGH = 1}.value != host->reg[nRF24L01_ADDR_rf_setup][0])
+    {
+        fprintf(stderr, "cfg: RF_SETUP not written\n");
+        return EXIT_FAILURE;
+    }
+    MEASURE("power_up", , nRF24L01_power_up(&dev));
+
+    /* single payload written, PRIM_RX cleared */
+    MEASURE(
+        "send",
+        (host->reg[nRF24L01_ADDR_config][0] = (nRF24L01_config_t){.PRIM_RX = 1, .PWR_UP = 1}.value),
+        nRF24L01_send(&dev, data, data + sizeof(data), NULL, NULL, 0));
+
+    /* TX_DS, TX FIFO empty: data sent */
+    MEASURE(
+        "event_tx",
+        (
+            host->reg[nRF24L01_ADDR_config][0] = (nRF24L01_config_t){.PWR_UP = 1}.value,
+            host->reg[nRF24L01_ADDR_status][0] = (nRF24L01_status_t){.TX_DS = 1}.value,
+            host->reg[nRF24L01_ADDR_fifo_status][0] = (nRF24L01_fifo_status_t){.TX_EMPTY = 1}.value,
+            dev.updated = 1),
+        nRF24L01_event(&dev));
+
+    /* RX_DR, payload in pipe 0 read */
+    MEASURE(
+        "event_rx",
+        (
+            host->reg[nRF24L01_ADDR_config][0] = (nRF24L01_config_t){.PRIM_RX = 1, .PWR_UP = 1}.value,
+            host->reg[nRF24L01_ADDR_status][0] = (nRF24L01_status_t){.RX_DR = 1}.value,
+            host->reg[nRF24L01_ADDR_fifo_status][0] = 0,
+            dev.rx.begin = buf,
+            dev.rx.end = buf + sizeof(buf),
+            dev.updated = 1),
+        nRF24L01_event(&dev));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+/* nRF24L01_hal.h port for host benchmark (nRF24L01_hal_bench.c): byte
+ * exchange drives register file model instead of SPI, same hooks back
+ * spi_xchg/ce_set of pointer build so both builds pay equal per byte cost.
+ * Register reads/writes, STATUS as first byte and payload commands (data
+ * discarded/returned as 0) are modeled, no radio behaviour. */
+
+typedef struct
+{
+    uint8_t reg[0x20][5];
+    uint8_t cmd;
+    uint8_t index; // byte of transaction
+    uint8_t ce;
+} nRF24L01_hal_host_t;
+
+extern nRF24L01_hal_host_t nRF24L01_hal_host;
+
+/* pointer build includes port directly */
+#ifndef nRF24L01_HAL_INLINE
+#define nRF24L01_HAL_INLINE static inline
+#endif
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_select(void)
+{
+    nRF24L01_hal_host.index = 0;
+}
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_deselect(void)
+{
+}
+
+nRF24L01_HAL_INLINE
+uint8_t nRF24L01_hal_xchg(uint8_t data)
+{
+    nRF24L01_hal_host_t *host = &nRF24L01_hal_host;
+    const uint8_t index = host->index++;
+
+    if(!index)
+    {
+        host->cmd = data;
+        return host->reg[0x07][0]; // STATUS
+    }
+    if(host->cmd < 0x40 && index <= sizeof(host->reg[0]))
+    {
+        uint8_t *reg = &host->reg[0x1F & host->cmd][index - 1];
+
+        if(host->cmd & 0x20) *reg = data;
+        return *reg;
+    }
+    return 0;
+}
+
+nRF24L01_HAL_INLINE
+void nRF24L01_hal_ce_set(nRF24L01_ce_t state)
+{
+    nRF24L01_hal_host.ce = state.CE;
+}
@@ -0,0 +1,370 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+
+#include "nRF24L01_linux.h"
+
+#define DEV_MAX nRF24L01_LINUX_DEV_MAX
+#define XFER_MAX nRF24L01_LINUX_BATCH_XFER_MAX
+#define BATCH_SIZE nRF24L01_LINUX_BATCH_SIZE
+/* IRQ stuck asserted (i.e. flag masked by user) must not block process */
+#define DISPATCH_MAX 8
+#define CE_UNKNOWN UINT8_C(0xFF)
+
+static nRF24L01_linux_t *dev_[DEV_MAX];
+
+/* spidev transport ----------------------------------------------------------*/
+
+static
+int spidev_transfer(
+    nRF24L01_linux_transport_t *transport,
+    struct spi_ioc_transfer *xfer,
+    uint8_t num)
+{
+    nRF24L01_linux_spidev_t *spidev = (nRF24L01_linux_spidev_t *)transport;
+
+    return 0 > ioctl(spidev->spi_fd, SPI_IOC_MESSAGE(num), xfer) ? -errno : 0;
+}
+
+static
+int spidev_ce_set(nRF24L01_linux_transport_t *transport, uint8_t value)
+{
+    nRF24L01_linux_spidev_t *spidev = (nRF24L01_linux_spidev_t *)transport;
+    struct gpio_v2_line_values values = {.bits = value ? 1 : 0, .mask = 1};
+
+    return 0 > ioctl(spidev->ce_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) ? -errno : 0;
+}
+
+static
+int spidev_irq_fd(nRF24L01_linux_transport_t *transport)
+{
+    return ((nRF24L01_linux_spidev_t *)transport)->irq_fd;
+}
+
+static
+int spidev_irq_ack(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_spidev_t *spidev = (nRF24L01_linux_spidev_t *)transport;
+    struct gpio_v2_line_event event[4];
+    int num = 0;
+
+    /* line fd is non-blocking, read until empty */
+    for(;;)
+    {
+        const ssize_t size = read(spidev->irq_fd, event, sizeof(event));
+
+        if(0 < size) num += size / sizeof(event[0]);
+        if((ssize_t)sizeof(event) == size) continue;
+        if(0 > size && EAGAIN != errno) return -errno;
+        break;
+    }
+    return num;
+}
+
+static
+int spidev_irq_get(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_spidev_t *spidev = (nRF24L01_linux_spidev_t *)transport;
+    struct gpio_v2_line_values values = {.mask = 1};
+
+    if(0 > ioctl(spidev->irq_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values)) return -errno;
+    /* active low */
+    return !(values.bits & 1);
+}
+
+static
+void spidev_close(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_spidev_t *spidev = (nRF24L01_linux_spidev_t *)transport;
+
+    if(0 <= spidev->irq_fd) close(spidev->irq_fd);
+    if(0 <= spidev->ce_fd) close(spidev->ce_fd);
+    if(0 <= spidev->spi_fd) close(spidev->spi_fd);
+    spidev->irq_fd = -1;
+    spidev->ce_fd = -1;
+    spidev->spi_fd = -1;
+}
+
+static
+int spi_setup(int fd)
+{
+    const uint8_t mode = SPI_MODE_0;
+    const uint8_t bits = 8;
+    const uint32_t speed = nRF24L01_LINUX_SPI_SPEED;
+
+    if(0 > ioctl(fd, SPI_IOC_WR_MODE, &mode)) return -errno;
+    if(0 > ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits)) return -errno;
+    if(0 > ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed)) return -errno;
+    return 0;
+}
+
+static
+int line_request(int chip_fd, uint32_t offset, const char *consumer, uint64_t flags)
+{
+    struct gpio_v2_line_request req;
+
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = offset;
+    req.num_lines = 1;
+    req.config.flags = flags;
+    strncpy(req.consumer, consumer, sizeof(req.consumer) - 1);
+
+    if(GPIO_V2_LINE_FLAG_OUTPUT & flags)
+    {
+        /* CE low until driver sets it */
+        req.config.num_attrs = 1;
+        req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        req.config.attrs[0].attr.values = 0;
+        req.config.attrs[0].mask = 1;
+    }
+
+    if(0 > ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req)) return -errno;
+    return req.fd;
+}
+
+int nRF24L01_linux_spidev_open(
+    nRF24L01_linux_spidev_t *spidev,
+    const char *spi,
+    const char *gpiochip,
+    uint32_t ce,
+    uint32_t irq)
+{
+    int r = 0;
+    int chip_fd = -1;
+
+    spidev->transport = (nRF24L01_linux_transport_t)
+    {
+        .transfer = spidev_transfer,
+        .ce_set = spidev_ce_set,
+        .irq_fd = spidev_irq_fd,
+        .irq_ack = spidev_irq_ack,
+        .irq_get = spidev_irq_get,
+        .close = spidev_close
+    };
+    spidev->spi_fd = -1;
+    spidev->ce_fd = -1;
+    spidev->irq_fd = -1;
+
+    spidev->spi_fd = open(spi, O_RDWR | O_CLOEXEC);
+    if(0 > spidev->spi_fd) goto error;
+    if(0 > (r = spi_setup(spidev->spi_fd))) goto exit;
+
+    chip_fd = open(gpiochip, O_RDWR | O_CLOEXEC);
+    if(0 > chip_fd) goto error;
+
+    r = line_request(chip_fd, ce, "nRF24L01 CE", GPIO_V2_LINE_FLAG_OUTPUT);
+    if(0 > r) goto exit;
+    spidev->ce_fd = r;
+
+    r = line_request(
+        chip_fd, irq, "nRF24L01 IRQ",
+        GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING);
+    if(0 > r) goto exit;
+    spidev->irq_fd = r;
+
+    if(0 > fcntl(spidev->irq_fd, F_SETFL, O_NONBLOCK)) goto error;
+    r = 0;
+    goto exit;
+error:
+    r = -errno;
+exit:
+    if(0 <= chip_fd) close(chip_fd);
+    if(0 > r) spidev_close(&spidev->transport);
+    return r;
+}
+/*----------------------------------------------------------------------------*/
+
+static
+uint8_t write_only(uint8_t cmd)
+{
+    return
+        nRF24L01_W_REGISTER(0) == (cmd & 0xE0)
+        || nRF24L01_W_TX_PAYLOAD == cmd
+        || nRF24L01_FLUSH_TX == cmd
+        || nRF24L01_FLUSH_RX == cmd
+        || nRF24L01_REUSE_TX_PL == cmd;
+}
+
+static
+void fail(nRF24L01_linux_t *hal, int r)
+{
+    if(0 > r && !hal->error) hal->error = r;
+}
+
+static
+void enqueue(nRF24L01_linux_t *hal, const uint8_t *tx, uint8_t *rx, size_t size)
+{
+    struct spi_ioc_transfer *xfer = hal->queue.xfer + hal->queue.num++;
+
+    memset(xfer, 0, sizeof(struct spi_ioc_transfer));
+    xfer->tx_buf = (uintptr_t)tx;
+    xfer->rx_buf = (uintptr_t)rx;
+    xfer->len = size;
+    /* CSN deasserted after every command */
+    xfer->cs_change = 1;
+}
+
+static
+void xchg(nRF24L01_linux_t *hal, uint8_t *begin, const uint8_t *const end)
+{
+    if(end == begin) return;
+
+    const size_t size = end - begin;
+
+    ++hal->stat.cmd;
+    hal->stat.byte += size;
+
+    if(hal->batch && write_only(begin[0]) && BATCH_SIZE >= size)
+    {
+        /* response is not needed, copy (caller's buffer is gone on return) */
+        if(XFER_MAX == hal->queue.num || BATCH_SIZE - size < hal->queue.size)
+        {
+            nRF24L01_linux_flush(hal);
+        }
+
+        uint8_t *buf = hal->queue.buf + hal->queue.size;
+
+        memcpy(buf, begin, size);
+        hal->queue.size += size;
+        enqueue(hal, buf, NULL, size);
+        return;
+    }
+
+    if(XFER_MAX == hal->queue.num) nRF24L01_linux_flush(hal);
+    /* spidev uses bounce buffers, exchange in place is safe */
+    enqueue(hal, begin, begin, size);
+    /* no status flags on failure */
+    if(0 > nRF24L01_linux_flush(hal)) memset(begin, 0, size);
+}
+
+static
+void ce_set(nRF24L01_linux_t *hal, nRF24L01_ce_t ce)
+{
+    /* driver sets CE on every (re)arm, level is already there mostly */
+    if(ce.CE == hal->ce) return;
+
+    /* commands issued before CE change must reach device first */
+    nRF24L01_linux_flush(hal);
+    ++hal->stat.ce;
+
+    const int r = hal->transport->ce_set(hal->transport, ce.CE);
+
+    hal->ce = 0 > r ? CE_UNKNOWN : ce.CE;
+    fail(hal, r);
+}
+
+#define TRAMPOLINE(i) \
+    static \
+    void spi_xchg_##i(uint8_t *begin, const uint8_t *const end) \
+    { \
+        xchg(dev_[i], begin, end); \
+    } \
+    static \
+    void ce_set_##i(nRF24L01_ce_t ce) \
+    { \
+        ce_set(dev_[i], ce); \
+    }
+
+TRAMPOLINE(0)
+TRAMPOLINE(1)
+TRAMPOLINE(2)
+TRAMPOLINE(3)
+
+static const nRF24L01_spi_xchg_t spi_xchg_[DEV_MAX] =
+{
+    spi_xchg_0, spi_xchg_1, spi_xchg_2, spi_xchg_3
+};
+
+static const nRF24L01_ce_set_t ce_set_[DEV_MAX] =
+{
+    ce_set_0, ce_set_1, ce_set_2, ce_set_3
+};
+
+int nRF24L01_linux_init(
+    nRF24L01_linux_t *hal,
+    nRF24L01_t *dev,
+    nRF24L01_linux_transport_t *transport)
+{
+    memset(hal, 0, sizeof(nRF24L01_linux_t));
+    hal->transport = transport;
+    hal->dev = dev;
+    hal->batch = 1;
+    hal->ce = CE_UNKNOWN;
+    hal->index = DEV_MAX;
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(dev_[i]) continue;
+        dev_[i] = hal;
+        hal->index = i;
+        break;
+    }
+    /* all trampolines taken */
+    if(DEV_MAX == hal->index) return -ENOSPC;
+
+    nRF24L01_init(dev, ce_set_[hal->index], spi_xchg_[hal->index]);
+    nRF24L01_linux_flush(hal);
+    return hal->error;
+}
+
+void nRF24L01_linux_release(nRF24L01_linux_t *hal)
+{
+    if(DEV_MAX > hal->index && hal == dev_[hal->index])
+    {
+        nRF24L01_linux_flush(hal);
+        dev_[hal->index] = NULL;
+    }
+    if(hal->transport->close) hal->transport->close(hal->transport);
+}
+
+int nRF24L01_linux_irq_fd(nRF24L01_linux_t *hal)
+{
+    return hal->transport->irq_fd(hal->transport);
+}
+
+int nRF24L01_linux_flush(nRF24L01_linux_t *hal)
+{
+    if(!hal->queue.num) return 0;
+
+    /* last command ends message, CSN is deasserted anyway */
+    hal->queue.xfer[hal->queue.num - 1].cs_change = 0;
+
+    const int r = hal->transport->transfer(hal->transport, hal->queue.xfer, hal->queue.num);
+
+    ++hal->stat.ioctl;
+    hal->queue.num = 0;
+    hal->queue.size = 0;
+    fail(hal, r);
+    return r;
+}
+
+int nRF24L01_linux_dispatch(nRF24L01_linux_t *hal)
+{
+    nRF24L01_linux_transport_t *transport = hal->transport;
+    int num = transport->irq_ack(transport);
+
+    if(0 > num) return num;
+    hal->stat.irq += num;
+
+    /* IRQ is level, it stays asserted (no new edge) until all flags are
+     * cleared, queued status clear has to be flushed before level is read */
+    for(num = 0; DISPATCH_MAX > num; ++num)
+    {
+        nRF24L01_linux_flush(hal);
+
+        const int irq = transport->irq_get(transport);
+
+        if(0 > irq) return irq;
+        if(!irq) break;
+
+        hal->dev->updated = 1;
+        nRF24L01_event(hal->dev);
+    }
+    hal->stat.event += num;
+    nRF24L01_linux_flush(hal);
+    return hal->error ? hal->error : num;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <linux/spi/spidev.h>
+
+#include "nRF24L01.h"
+
+/* Linux userspace HAL (gateway hosts).
+ *
+ * Driver SPI/CE callbacks are routed to transport:
+ * - spidev: /dev/spidevB.C ioctls, CE and IRQ lines requested from GPIO
+ *   character device (/dev/gpiochipN), IRQ falling edge is delivered as line
+ *   event so irq_fd() can be waited on with epoll (no polling),
+ * - loopback (nRF24L01_linux_loopback.h): simulated radio, no hardware.
+ *
+ * Commands without useful response (W_REGISTER, W_TX_PAYLOAD, FLUSH_TX/RX,
+ * REUSE_TX_PL) are queued and submitted together with next command which
+ * reads data (single SPI_IOC_MESSAGE ioctl, CSN toggles between commands),
+ * CE change or flush(). Status byte of queued command is not returned, driver
+ * never reads it. Queued writes must be flushed before process sleeps,
+ * dispatch() does it.
+ *
+ * spi_xchg/ce_set callbacks have no context so every device is bound to
+ * static trampoline, at most nRF24L01_LINUX_DEV_MAX devices exist at a time.
+ * Callbacks can not fail, first transport error is kept in hal->error. */
+
+#define nRF24L01_LINUX_DEV_MAX 4
+#define nRF24L01_LINUX_BATCH_XFER_MAX 16
+#define nRF24L01_LINUX_BATCH_SIZE 256
+
+#ifndef nRF24L01_LINUX_SPI_SPEED
+#define nRF24L01_LINUX_SPI_SPEED 8000000 // Hz
+#endif
+
+typedef struct nRF24L01_linux_transport nRF24L01_linux_transport_t;
+
+/* all return 0 (or value) on success, -errno on failure */
+struct nRF24L01_linux_transport
+{
+    /* transfers in order, CSN deasserted between them */
+    int (*transfer)(nRF24L01_linux_transport_t *, struct spi_ioc_transfer *, uint8_t num);
+    int (*ce_set)(nRF24L01_linux_transport_t *, uint8_t value);
+    /* readable when IRQ edge is pending */
+    int (*irq_fd)(nRF24L01_linux_transport_t *);
+    /* consume pending edges */
+    int (*irq_ack)(nRF24L01_linux_transport_t *);
+    /* 1 if IRQ is asserted (line low) */
+    int (*irq_get)(nRF24L01_linux_transport_t *);
+    void (*close)(nRF24L01_linux_transport_t *);
+};
+
+typedef struct
+{
+    nRF24L01_linux_transport_t transport;
+    int spi_fd;
+    int ce_fd; // GPIO line request
+    int irq_fd; // GPIO line request (edge events)
+} nRF24L01_linux_spidev_t;
+
+typedef struct
+{
+    nRF24L01_linux_transport_t *transport;
+    nRF24L01_t *dev;
+    uint8_t index; // trampoline
+    uint8_t batch; // queue write-only commands
+    uint8_t ce; // last CE level written
+    int error;
+    struct
+    {
+        struct spi_ioc_transfer xfer[nRF24L01_LINUX_BATCH_XFER_MAX];
+        uint8_t buf[nRF24L01_LINUX_BATCH_SIZE];
+        uint8_t num;
+        uint16_t size;
+    } queue;
+    struct
+    {
+        uint32_t ioctl; // transport transfer calls
+        uint32_t cmd; // SPI commands
+        uint32_t byte;
+        uint32_t ce; // CE level changes
+        uint32_t irq; // IRQ edges
+        uint32_t event; // nRF24L01_event() calls
+    } stat;
+} nRF24L01_linux_t;
+
+/* spi: /dev/spidevB.C, gpiochip: /dev/gpiochipN, ce/irq: line offsets,
+ * SPI mode 0 (MSB first, 8 bits per word), up to nRF24L01_LINUX_SPI_SPEED */
+int nRF24L01_linux_spidev_open(
+    nRF24L01_linux_spidev_t *,
+    const char *spi,
+    const char *gpiochip,
+    uint32_t ce,
+    uint32_t irq);
+
+/* binds dev to transport and calls nRF24L01_init(),
+ * returns -ENOSPC if all trampolines are taken */
+int nRF24L01_linux_init(
+    nRF24L01_linux_t *,
+    nRF24L01_t *,
+    nRF24L01_linux_transport_t *);
+/* transport is closed too */
+void nRF24L01_linux_release(nRF24L01_linux_t *);
+
+int nRF24L01_linux_irq_fd(nRF24L01_linux_t *);
+
+/* submit queued commands */
+int nRF24L01_linux_flush(nRF24L01_linux_t *);
+
+/* call when irq_fd() is readable (or after timeout), consumes IRQ edges,
+ * calls nRF24L01_event() while IRQ is asserted and flushes,
+ * returns number of events handled */
+int nRF24L01_linux_dispatch(nRF24L01_linux_t *);
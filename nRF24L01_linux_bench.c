@@ -0,0 +1,262 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_bench.h"
+#include "nRF24L01_linux.h"
+#include "nRF24L01_linux_loopback.h"
+
+/* Benchmark (nRF24L01_bench) on Linux HAL, single epoll loop serves IRQ
+ * of all devices and benchmark tick (timerfd), writes are flushed before
+ * process sleeps.
+ *
+ * usage:
+ *   nRF24L01_linux_bench loopback [loss_ppm [seed]]
+ *     initiator and responder on loopback transport (real time), without
+ *     configured loss any run losing payloads (or not valid) is failure
+ *   nRF24L01_linux_bench initiator|responder SPIDEV GPIOCHIP CE IRQ
+ *     single role on hardware, i.e. /dev/spidev0.0 /dev/gpiochip0 25 24 */
+
+#define TICK_PERIOD 1000 // us
+#define NODE_MAX 2
+#define EVENT_MAX 4
+
+typedef struct
+{
+    nRF24L01_t dev;
+    nRF24L01_linux_t hal;
+    nRF24L01_bench_t bench;
+    union
+    {
+        nRF24L01_linux_spidev_t spidev;
+        nRF24L01_linux_loopback_t loopback;
+    };
+} node_t;
+
+static node_t node[NODE_MAX];
+static uint8_t node_num;
+static nRF24L01_sim_air_t air;
+static uint8_t lossless_; // loopback without configured loss
+static uint16_t failed_; // runs lost payloads on lossless loopback
+
+static
+uint32_t clock_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static
+void on_result(const nRF24L01_bench_result_t *result, uintptr_t user_data)
+{
+    char line[320];
+    const char *end = nRF24L01_bench_format(result, line, line + sizeof(line));
+
+    fwrite(line, 1, end - line, stdout);
+    fflush(stdout);
+    if(lossless_ && (!result->valid || result->recv < result->count)) ++failed_;
+}
+
+static
+int node_init(node_t *n, nRF24L01_linux_transport_t *transport, uint8_t initiator)
+{
+    const int r = nRF24L01_linux_init(&n->hal, &n->dev, transport);
+
+    if(0 > r) return r;
+
+    nRF24L01_CFG(&n->dev, setup_aw, .AW = 3);
+    nRF24L01_CFG(&n->dev, rf_ch, .RF_CH = 1);
+    nRF24L01_CFG(&n->dev, rx_addr_p0, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+    nRF24L01_CFG(&n->dev, tx_addr, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+
+    nRF24L01_bench_init(&n->bench, &n->dev, clock_us, initiator ? on_result : NULL, 0);
+    return nRF24L01_linux_flush(&n->hal);
+}
+
+static
+void stat(const node_t *n)
+{
+    fprintf(
+        stderr,
+        "%s: cmd %u byte %u ioctl %u ce %u irq %u event %u"
+        " rx_full %u rx_overflow %u rx_flush %u rx_spurious %u"
+        " turnaround %u avg %u max %u us\n",
+        n->bench.initiator ? "initiator" : "responder",
+        n->hal.stat.cmd,
+        n->hal.stat.byte,
+        n->hal.stat.ioctl,
+        n->hal.stat.ce,
+        n->hal.stat.irq,
+        n->hal.stat.event,
+        n->dev.stat.rx_full,
+        n->dev.stat.rx_overflow,
+        n->dev.stat.rx_flush,
+        n->dev.stat.rx_spurious,
+        n->dev.stat.turnaround_num,
+        n->dev.stat.turnaround_num
+        ? (unsigned)(n->dev.stat.turnaround_sum / n->dev.stat.turnaround_num)
+        : 0,
+        n->dev.stat.turnaround_max);
+}
+
+static
+int usage(const char *name)
+{
+    fprintf(
+        stderr,
+        "usage: %s loopback [loss_ppm [seed]]\n"
+        "       %s initiator|responder SPIDEV GPIOCHIP CE IRQ\n",
+        name, name);
+    return EXIT_FAILURE;
+}
+
+static
+int setup(int argc, char *argv[])
+{
+    if(!strcmp("loopback", argv[1]))
+    {
+        const uint32_t loss_ppm = 2 < argc ? strtoul(argv[2], NULL, 0) : 0;
+        const uint32_t seed = 3 < argc ? strtoul(argv[3], NULL, 0) : 1;
+        int r;
+
+        nRF24L01_sim_air_init(&air, loss_ppm, seed);
+        lossless_ = !loss_ppm;
+        for(node_num = 0; node_num < NODE_MAX; ++node_num)
+        {
+            node_t *n = node + node_num;
+
+            if(0 > (r = nRF24L01_linux_loopback_open(&n->loopback, &air))) return r;
+            if(0 > (r = node_init(n, &n->loopback.transport, !node_num))) return r;
+        }
+        return 0;
+    }
+
+    const uint8_t initiator = !strcmp("initiator", argv[1]);
+    int r;
+
+    if(6 > argc || (!initiator && strcmp("responder", argv[1]))) return -EINVAL;
+
+    r = nRF24L01_linux_spidev_open(
+        &node[0].spidev,
+        argv[2], argv[3],
+        strtoul(argv[4], NULL, 0), strtoul(argv[5], NULL, 0));
+    if(0 > r) return r;
+    node_num = 1;
+    return node_init(node, &node[0].spidev.transport, initiator);
+}
+
+int main(int argc, char *argv[])
+{
+    if(2 > argc) return usage(argv[0]);
+
+    int r = setup(argc, argv);
+
+    if(-EINVAL == r) return usage(argv[0]);
+    if(0 > r)
+    {
+        fprintf(stderr, "setup: %s\n", strerror(-r));
+        return EXIT_FAILURE;
+    }
+
+    const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    const int tick_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    const struct itimerspec tick =
+    {
+        .it_interval = {.tv_nsec = TICK_PERIOD * 1000},
+        .it_value = {.tv_nsec = TICK_PERIOD * 1000}
+    };
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    node_t *initiator = NULL;
+
+    if(0 > epoll_fd || 0 > tick_fd) goto error;
+    if(0 > timerfd_settime(tick_fd, 0, &tick, NULL)) goto error;
+    if(0 > epoll_ctl(epoll_fd, EPOLL_CTL_ADD, tick_fd, &ev)) goto error;
+
+    for(uint8_t i = 0; i < node_num; ++i)
+    {
+        ev.data.ptr = node + i;
+        if(0 > epoll_ctl(epoll_fd, EPOLL_CTL_ADD, nRF24L01_linux_irq_fd(&node[i].hal), &ev))
+        {
+            goto error;
+        }
+    }
+
+    /* responder first, it has to listen when first setup frame is sent */
+    for(uint8_t i = node_num; i--;)
+    {
+        if(node[i].bench.cb)
+        {
+            initiator = node + i;
+            nRF24L01_bench_initiator_start(&initiator->bench);
+        }
+        else nRF24L01_bench_responder_start(&node[i].bench);
+    }
+
+    while(!initiator || !nRF24L01_bench_done(&initiator->bench))
+    {
+        struct epoll_event events[EVENT_MAX];
+
+        for(uint8_t i = 0; i < node_num; ++i)
+        {
+            if(0 > (r = nRF24L01_linux_flush(&node[i].hal))) goto exit;
+        }
+
+        const int num = epoll_wait(epoll_fd, events, EVENT_MAX, -1);
+
+        if(0 > num && EINTR == errno) continue;
+        if(0 > num) goto error;
+
+        uint8_t irq = 0;
+
+        for(int i = 0; i < num; ++i)
+        {
+            node_t *n = events[i].data.ptr;
+
+            if(n)
+            {
+                irq = 1;
+                continue;
+            }
+
+            uint64_t expired;
+
+            if(0 > read(tick_fd, &expired, sizeof(expired)) && EAGAIN != errno) goto error;
+            for(uint8_t j = 0; j < node_num; ++j) nRF24L01_bench_tick(&node[j].bench);
+        }
+
+        /* loopback devices share this thread and air time runs while one
+         * of them is served, IRQs asserted at once may wake process one by
+         * one - all are served in node order (initiator first) so ping
+         * initiator turns around to RX before echo goes on air as on two
+         * MCUs (responder reads and writes payload meanwhile), dispatch
+         * without IRQ asserted does nothing */
+        for(uint8_t i = 0; irq && i < node_num; ++i)
+        {
+            if(0 > (r = nRF24L01_linux_dispatch(&node[i].hal))) goto exit;
+        }
+    }
+    r = 0;
+    goto exit;
+error:
+    r = -errno;
+exit:
+    if(0 > r) fprintf(stderr, "error: %s\n", strerror(-r));
+    if(failed_) fprintf(stderr, "error: %u runs lost payloads without configured loss\n", failed_);
+    for(uint8_t i = 0; i < node_num; ++i)
+    {
+        stat(node + i);
+        nRF24L01_linux_release(&node[i].hal);
+    }
+    if(0 <= tick_fd) close(tick_fd);
+    if(0 <= epoll_fd) close(epoll_fd);
+    return 0 > r || failed_ ? EXIT_FAILURE : EXIT_SUCCESS;
+}
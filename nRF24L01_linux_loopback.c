@@ -0,0 +1,190 @@
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/timerfd.h>
+
+#include "nRF24L01_linux_loopback.h"
+
+#define DEV_MAX nRF24L01_SIM_DEV_MAX
+#define PAYLOAD_SIZE nRF24L01_PAYLOAD_SIZE
+/* air runs at most this far past event not seen by process yet (us) */
+#define STALL_US UINT64_C(200)
+
+static nRF24L01_linux_loopback_t *dev_[DEV_MAX];
+static uint64_t lag_; // air time behind CLOCK_MONOTONIC (us)
+
+static
+uint64_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* every device on air gets woken up for next event, its IRQ may change
+ * due to other device (packet delivered / ACK received), device with IRQ
+ * asserted (possibly by event processed on behalf of other device) is woken
+ * up immediately - re-arming timerfd drops its pending expiration */
+static
+int arm(nRF24L01_sim_air_t *air)
+{
+    const uint64_t next = nRF24L01_sim_next(air);
+    struct itimerspec its;
+    /* zero disarms timer, (absolute) time in past expires immediately */
+    const struct itimerspec asap = {.it_value = {.tv_nsec = 1}};
+
+    memset(&its, 0, sizeof(its));
+    if(nRF24L01_SIM_NEVER != next)
+    {
+        its.it_value.tv_sec = (next + lag_) / 1000000;
+        its.it_value.tv_nsec = (next + lag_) % 1000000 * 1000;
+        if(!its.it_value.tv_sec && !its.it_value.tv_nsec) its = asap;
+    }
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(!dev_[i] || air != dev_[i]->sim.air) continue;
+
+        const struct itimerspec *value = nRF24L01_sim_irq(&dev_[i]->sim) ? &asap : &its;
+
+        if(0 > timerfd_settime(dev_[i]->timer_fd, TFD_TIMER_ABSTIME, value, NULL)) return -errno;
+    }
+    return 0;
+}
+
+/* process (all devices are served by it) may not be scheduled for a while,
+ * air time stops STALL_US after first event processed meanwhile, rest of
+ * stall is added to lag_ - radios do not run ahead of hosts as on MCUs */
+static
+void advance(nRF24L01_linux_loopback_t *loopback)
+{
+    nRF24L01_sim_air_t *air = loopback->sim.air;
+    uint64_t time = now() - lag_;
+    const uint64_t next = nRF24L01_sim_next(air);
+
+    if(nRF24L01_SIM_NEVER != next && next + STALL_US < time)
+    {
+        lag_ += time - next - STALL_US;
+        time = next + STALL_US;
+    }
+    nRF24L01_sim_run(air, time);
+}
+
+static
+int loopback_transfer(
+    nRF24L01_linux_transport_t *transport,
+    struct spi_ioc_transfer *xfer,
+    uint8_t num)
+{
+    nRF24L01_linux_loopback_t *loopback = (nRF24L01_linux_loopback_t *)transport;
+    const nRF24L01_spi_xchg_t xchg = nRF24L01_sim_spi_xchg(&loopback->sim);
+
+    advance(loopback);
+    for(uint8_t i = 0; i < num; ++i)
+    {
+        uint8_t tmp[1 + PAYLOAD_SIZE];
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)xfer[i].tx_buf;
+        uint8_t *rx = xfer[i].rx_buf ? (uint8_t *)(uintptr_t)xfer[i].rx_buf : tmp;
+        const uint32_t size = xfer[i].len;
+
+        if(!tx || sizeof(tmp) < size) return -EINVAL;
+        /* simulator exchanges data in place */
+        if(rx != tx) memcpy(rx, tx, size);
+        (*xchg)(rx, rx + size);
+    }
+    return arm(loopback->sim.air);
+}
+
+static
+int loopback_ce_set(nRF24L01_linux_transport_t *transport, uint8_t value)
+{
+    nRF24L01_linux_loopback_t *loopback = (nRF24L01_linux_loopback_t *)transport;
+
+    advance(loopback);
+    (*nRF24L01_sim_ce_set(&loopback->sim))((nRF24L01_ce_t){.CE = value ? 1 : 0});
+    return arm(loopback->sim.air);
+}
+
+static
+int loopback_irq_fd(nRF24L01_linux_transport_t *transport)
+{
+    return ((nRF24L01_linux_loopback_t *)transport)->timer_fd;
+}
+
+static
+int loopback_irq_get(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_loopback_t *loopback = (nRF24L01_linux_loopback_t *)transport;
+    int r;
+
+    advance(loopback);
+    if(0 > (r = arm(loopback->sim.air))) return r;
+    return nRF24L01_sim_irq(&loopback->sim);
+}
+
+static
+int loopback_irq_ack(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_loopback_t *loopback = (nRF24L01_linux_loopback_t *)transport;
+    uint64_t expired;
+
+    if(0 > read(loopback->timer_fd, &expired, sizeof(expired)) && EAGAIN != errno)
+    {
+        return -errno;
+    }
+    /* wakeup counts as edge only if IRQ is asserted */
+    return loopback_irq_get(transport);
+}
+
+static
+void loopback_close(nRF24L01_linux_transport_t *transport)
+{
+    nRF24L01_linux_loopback_t *loopback = (nRF24L01_linux_loopback_t *)transport;
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(loopback == dev_[i]) dev_[i] = NULL;
+    }
+    nRF24L01_sim_release(&loopback->sim);
+    if(0 <= loopback->timer_fd) close(loopback->timer_fd);
+    loopback->timer_fd = -1;
+}
+
+int nRF24L01_linux_loopback_open(
+    nRF24L01_linux_loopback_t *loopback,
+    nRF24L01_sim_air_t *air)
+{
+    loopback->transport = (nRF24L01_linux_transport_t)
+    {
+        .transfer = loopback_transfer,
+        .ce_set = loopback_ce_set,
+        .irq_fd = loopback_irq_fd,
+        .irq_ack = loopback_irq_ack,
+        .irq_get = loopback_irq_get,
+        .close = loopback_close
+    };
+    loopback->timer_fd = -1;
+
+    nRF24L01_sim_init(&loopback->sim, air);
+    if(!nRF24L01_sim_spi_xchg(&loopback->sim)) return -ENOSPC;
+
+    loopback->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(0 > loopback->timer_fd)
+    {
+        const int r = -errno;
+
+        nRF24L01_sim_release(&loopback->sim);
+        return r;
+    }
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(dev_[i]) continue;
+        dev_[i] = loopback;
+        break;
+    }
+    return 0;
+}
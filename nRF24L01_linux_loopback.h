@@ -0,0 +1,24 @@
+#pragma once
+
+#include "nRF24L01_linux.h"
+#include "nRF24L01_sim.h"
+
+/* Loopback transport (CI, no hardware): SPI commands and CE go to simulated
+ * radio (nRF24L01_sim), all loopback devices opened on same air hear each
+ * other. Air time follows CLOCK_MONOTONIC (us) so driver and timeouts run in
+ * real time, simulator is advanced on every transport call (process stalls
+ * past pending simulator event do not count as air time). irq_fd() is
+ * timerfd armed for next simulator event (of any device on air), it is
+ * readable when IRQ may have changed - same epoll loop serves hardware and
+ * loopback devices. */
+
+typedef struct
+{
+    nRF24L01_linux_transport_t transport;
+    nRF24L01_sim_t sim;
+    int timer_fd;
+} nRF24L01_linux_loopback_t;
+
+/* air has to be initialized (nRF24L01_sim_air_init()),
+ * returns -ENOSPC if all simulator devices are taken */
+int nRF24L01_linux_loopback_open(nRF24L01_linux_loopback_t *, nRF24L01_sim_air_t *);
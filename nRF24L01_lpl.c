@@ -0,0 +1,256 @@
+#include <string.h>
+
+#include "nRF24L01_lpl.h"
+
+#define STATE_IDLE 0 // not started
+#define STATE_SLEEP 1 // powered down
+#define STATE_POWER_UP 2 // crystal start-up
+#define STATE_CHECK 3 // listening for window
+#define STATE_AWAKE 4 // listening until linger expires
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void arm(nRF24L01_lpl_t *lpl, uint32_t us)
+{
+    (*lpl->timer)(us, (uintptr_t)lpl);
+}
+
+static
+void listen(nRF24L01_lpl_t *lpl)
+{
+    nRF24L01_recv(
+        lpl->dev,
+        lpl->rx_frame, lpl->rx_frame + sizeof(lpl->rx_frame),
+        on_frame,
+        on_rx_error,
+        (uintptr_t)lpl);
+}
+
+static
+void transmit(nRF24L01_lpl_t *lpl)
+{
+    nRF24L01_send(
+        lpl->dev,
+        lpl->tx.begin, lpl->tx.end,
+        on_sent,
+        on_error,
+        (uintptr_t)lpl);
+}
+
+static
+void sleep(nRF24L01_lpl_t *lpl)
+{
+    const uint32_t awake =
+        nRF24L01_POWER_UP_US + nRF24L01_SETTLE_US + lpl->window_us;
+
+    nRF24L01_power_down(lpl->dev);
+    lpl->state = STATE_SLEEP;
+    /* checks are interval_us apart (start to start) */
+    arm(lpl, lpl->interval_us > awake ? lpl->interval_us - awake : 0);
+}
+
+static
+void wake(nRF24L01_lpl_t *lpl)
+{
+    nRF24L01_power_up(lpl->dev);
+    lpl->state = STATE_POWER_UP;
+    arm(lpl, nRF24L01_POWER_UP_US);
+}
+
+static
+void stay(nRF24L01_lpl_t *lpl)
+{
+    lpl->state = STATE_AWAKE;
+    lpl->active = 0;
+    arm(lpl, lpl->linger_us);
+}
+
+static
+void burst(nRF24L01_lpl_t *lpl)
+{
+    lpl->t_burst = (*lpl->clock)();
+    lpl->pending = 0;
+    lpl->busy = 1;
+    transmit(lpl);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_lpl_t *lpl = (nRF24L01_lpl_t *)user_data;
+
+    if(STATE_CHECK == lpl->state)
+    {
+        ++lpl->stat.woken;
+        stay(lpl);
+    }
+    else lpl->active = 1;
+
+    /* radio is not re-armed while burst is sent (switched back once done) */
+    if(!lpl->busy) listen(lpl);
+    if(lpl->recv_cb && curr != lpl->rx_frame)
+    {
+        (*lpl->recv_cb)(lpl->rx_frame, curr, lpl->recv_user_data);
+    }
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_lpl_t *lpl = (nRF24L01_lpl_t *)user_data;
+
+    if(!lpl->busy) listen(lpl);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_lpl_t *lpl = (nRF24L01_lpl_t *)user_data;
+    const nRF24L01_send_cb_t cb = lpl->tx.cb;
+    const uintptr_t cb_user_data = lpl->tx.user_data;
+
+    ++lpl->stat.sent;
+    memset(&lpl->tx, 0, sizeof(lpl->tx));
+    lpl->busy = 0;
+    lpl->active = 1;
+    listen(lpl);
+
+    if(cb) (*cb)(cb_user_data);
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_lpl_t *lpl = (nRF24L01_lpl_t *)user_data;
+    const uint32_t elapsed = (*lpl->clock)() - lpl->t_burst;
+
+    /* receiver checks at least once every interval_us */
+    if(status.MAX_RT && lpl->interval_us + lpl->window_us > elapsed)
+    {
+        ++lpl->stat.resend;
+        transmit(lpl);
+        return;
+    }
+
+    const nRF24L01_err_cb_t err_cb = lpl->tx.err_cb;
+    const uintptr_t cb_user_data = lpl->tx.user_data;
+
+    ++lpl->stat.tx_err;
+    memset(&lpl->tx, 0, sizeof(lpl->tx));
+    lpl->busy = 0;
+    listen(lpl);
+
+    if(err_cb) (*err_cb)(status, fifo_status, cb_user_data);
+}
+
+void nRF24L01_lpl_init(
+    nRF24L01_lpl_t *lpl,
+    nRF24L01_t *dev,
+    nRF24L01_lpl_timer_t timer,
+    nRF24L01_clock_t clock)
+{
+    memset(lpl, 0, sizeof(nRF24L01_lpl_t));
+    lpl->dev = dev;
+    lpl->timer = timer;
+    lpl->clock = clock;
+    lpl->interval_us = nRF24L01_LPL_INTERVAL_US;
+    lpl->window_us = nRF24L01_LPL_WINDOW_US;
+    lpl->linger_us = nRF24L01_LPL_LINGER_US;
+    lpl->state = STATE_IDLE;
+}
+
+void nRF24L01_lpl_start(
+    nRF24L01_lpl_t *lpl,
+    nRF24L01_lpl_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    lpl->recv_cb = cb;
+    lpl->recv_user_data = user_data;
+    sleep(lpl);
+}
+
+void nRF24L01_lpl_send(
+    nRF24L01_lpl_t *lpl,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    lpl->tx.begin = begin;
+    lpl->tx.end = end;
+    lpl->tx.cb = cb;
+    lpl->tx.err_cb = err_cb;
+    lpl->tx.user_data = user_data;
+
+    switch(lpl->state)
+    {
+        case STATE_SLEEP:
+            lpl->pending = 1;
+            wake(lpl);
+            break;
+        case STATE_POWER_UP:
+            lpl->pending = 1;
+            break;
+        case STATE_CHECK:
+            stay(lpl);
+            burst(lpl);
+            break;
+        default:
+            burst(lpl);
+            break;
+    }
+}
+
+void nRF24L01_lpl_timeout(nRF24L01_lpl_t *lpl)
+{
+    switch(lpl->state)
+    {
+        case STATE_SLEEP:
+            wake(lpl);
+            break;
+        case STATE_POWER_UP:
+            if(lpl->pending)
+            {
+                stay(lpl);
+                burst(lpl);
+                break;
+            }
+            ++lpl->stat.check;
+            lpl->state = STATE_CHECK;
+            listen(lpl);
+            arm(lpl, nRF24L01_SETTLE_US + lpl->window_us);
+            break;
+        case STATE_CHECK:
+            sleep(lpl);
+            break;
+        case STATE_AWAKE:
+            if(lpl->busy || lpl->active) stay(lpl);
+            else sleep(lpl);
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Duty-cycled low-power listening.
+ *
+ * Radio is powered down (PWR_UP = 0) between channel checks. Every
+ * interval_us it is powered up, once crystal has started
+ * (nRF24L01_POWER_UP_US) it is switched to RX and listens for window_us
+ * after RX settling (nRF24L01_SETTLE_US). Nothing received: radio is
+ * powered down again. Payload received (or sent): node stays awake,
+ * listening, until nothing was received or sent for linger_us so follow-up
+ * traffic needs no wake-up.
+ *
+ * Sender reaches sleeping node by wake-up burst: payload (auto ACK) is sent
+ * again after every MAX_RT until it is ACKed or interval_us + window_us
+ * elapsed, one of receiver checks falls into burst. window_us has to cover
+ * longest gap between transmissions of burst (ARD, MAX_RT handling, TX
+ * settling) plus air time of payload. Awake receiver ACKs first attempt.
+ * Worst case delivery latency is interval_us + window_us (+ power up if
+ * sender slept), receiver average current is roughly
+ * I_rx * (SETTLE + window) / interval (+ lingering after traffic).
+ *
+ * Delays are timer expiries, nothing busy waits: timer callback arms
+ * one-shot expiry after us and nRF24L01_lpl_timeout() has to be called
+ * then, i.e. cyclic_tmr_start_us_rt() with callback calling timeout()
+ * (every timeout re-arms timer so cyclic timer is fine). Clock (us) bounds
+ * burst. Parameters are set to defaults by init() and can be changed
+ * before start(). */
+
+#define nRF24L01_LPL_INTERVAL_US UINT32_C(100000)
+#define nRF24L01_LPL_WINDOW_US 1000 // burst gap @ ARD 250us + 2Mbps payload
+#define nRF24L01_LPL_LINGER_US 5000
+
+typedef
+void (*nRF24L01_lpl_timer_t)(uint32_t us, uintptr_t);
+typedef
+void (*nRF24L01_lpl_recv_cb_t)(const uint8_t *begin, const uint8_t *const end, uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_lpl_timer_t timer;
+    nRF24L01_clock_t clock;
+    nRF24L01_lpl_recv_cb_t recv_cb;
+    uintptr_t recv_user_data;
+    uint32_t interval_us;
+    uint16_t window_us;
+    uint16_t linger_us;
+    uint32_t t_burst; // first transmission of current payload
+    uint8_t state;
+    uint8_t rx_frame[nRF24L01_PAYLOAD_SIZE];
+    struct
+    {
+        uint8_t busy : 1; // payload in flight (burst)
+        uint8_t pending : 1; // payload waits for power up
+        uint8_t active : 1; // traffic since linger was armed
+        uint8_t : 5;
+    };
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+    struct
+    {
+        uint32_t check; // channel checks
+        uint32_t woken; // checks which received payload
+        uint32_t resend; // burst transmissions after MAX_RT
+        uint32_t sent;
+        uint16_t tx_err; // not ACKed within burst
+    } stat;
+} nRF24L01_lpl_t;
+
+void nRF24L01_lpl_init(
+    nRF24L01_lpl_t *,
+    nRF24L01_t *,
+    nRF24L01_lpl_timer_t,
+    nRF24L01_clock_t);
+
+/* powers radio down and arms first check, cb is called with every payload
+ * received (auto ACK has to be enabled on receiving pipe) */
+void nRF24L01_lpl_start(
+    nRF24L01_lpl_t *,
+    nRF24L01_lpl_recv_cb_t,
+    uintptr_t user_data);
+
+/* single payload at a time (up to nRF24L01_PAYLOAD_SIZE), sleeping radio is
+ * powered up first, err_cb is called with MAX_RT set once burst ends */
+void nRF24L01_lpl_send(
+    nRF24L01_lpl_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* call once armed delay has elapsed (timer callback) */
+void nRF24L01_lpl_timeout(nRF24L01_lpl_t *);
@@ -0,0 +1,300 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_lpl.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Low-power listening benchmark against simulated radios (nRF24L01_sim).
+ *
+ * Sensor sends single payload (auto ACK) to sink every period (uniform
+ * jitter +-50%), sink only receives. Radios stay powered and listening
+ * (always on, plain driver) or are duty cycled by nRF24L01_lpl at several
+ * check intervals. Average current of both radios is derived from time spent
+ * in every power state (nRF24L01+ datasheet: power down 0.9uA, standby-I
+ * 26uA, RX @ 2Mbps 13.5mA, TX @ 0dBm 11.3mA), delivery latency is measured
+ * from send request to reception. Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_lpl_bench [period_ms [seed [duration_ms]]] */
+
+#define ALWAYS_ON 0 // interval
+
+#define I_OFF_NA UINT64_C(900)
+#define I_STANDBY_NA UINT64_C(26000)
+#define I_RX_NA UINT64_C(13500000)
+#define I_TX_NA UINT64_C(11300000)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_lpl_t lpl;
+    uint64_t deadline; // armed timer
+} node_t;
+
+static nRF24L01_sim_air_t air;
+static node_t node_[2]; // sensor, sink
+static uint8_t frame_[nRF24L01_PAYLOAD_SIZE];
+static uint8_t rx_frame_[nRF24L01_PAYLOAD_SIZE];
+static uint32_t seed_;
+static uint16_t seq_;
+static uint8_t busy_;
+static uint64_t t_req; // send requested at
+static uint64_t t_next; // next payload
+static uint32_t sent;
+static uint32_t delivered;
+static uint64_t latency_sum;
+static uint64_t latency_max;
+
+static
+uint32_t clock_us(void)
+{
+    return air.now;
+}
+
+static
+void timer(uint32_t us, uintptr_t user_data)
+{
+    for(uint8_t i = 0; i < 2; ++i)
+    {
+        if(&node_[i].lpl == (nRF24L01_lpl_t *)user_data) node_[i].deadline = air.now + us;
+    }
+}
+
+static
+void configure(node_t *node)
+{
+    nRF24L01_t *dev = &node->dev;
+
+    nRF24L01_sim_bench_init(dev, &node->sim, &air);
+    nRF24L01_CFG(dev, en_aa, .ENAA_P0 = 1);
+    nRF24L01_CFG(dev, setup_retr, .ARC = 15, .ARD = 0);
+    nRF24L01_lpl_init(&node->lpl, dev, timer, clock_us);
+    node->deadline = nRF24L01_SIM_NEVER;
+}
+
+static
+void on_data(const uint8_t *begin, const uint8_t *const end, uintptr_t user_data)
+{
+    const uint16_t seq = begin[0] | begin[1] << 8;
+
+    /* re-sent payload (ACK lost) is counted once */
+    if(end - begin < 2 || seq != seq_) return;
+
+    const uint64_t latency = air.now - t_req;
+
+    ++delivered;
+    ++seq_;
+    latency_sum += latency;
+    if(latency > latency_max) latency_max = latency;
+}
+
+/* always on: plain driver */
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(nRF24L01_t *dev)
+{
+    nRF24L01_recv(dev, rx_frame_, rx_frame_ + sizeof(rx_frame_), on_frame, on_rx_error, (uintptr_t)dev);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    on_data(rx_frame_, curr, 0);
+    listen((nRF24L01_t *)user_data);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_t *)user_data);
+}
+
+static
+void think(void)
+{
+    busy_ = 0;
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    if(user_data) listen((nRF24L01_t *)user_data);
+    think();
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    if(user_data) listen((nRF24L01_t *)user_data);
+    think();
+}
+
+static
+void send(uint32_t interval)
+{
+    node_t *sensor = node_ + 0;
+
+    frame_[0] = seq_;
+    frame_[1] = seq_ >> 8;
+    busy_ = 1;
+    t_req = air.now;
+    ++sent;
+
+    if(ALWAYS_ON == interval)
+    {
+        nRF24L01_send(
+            &sensor->dev,
+            frame_, frame_ + sizeof(frame_),
+            on_sent, on_error, (uintptr_t)&sensor->dev);
+    }
+    else
+    {
+        nRF24L01_lpl_send(&sensor->lpl, frame_, frame_ + sizeof(frame_), on_sent, on_error, 0);
+    }
+}
+
+static
+uint32_t current_ua(const nRF24L01_sim_t *sim)
+{
+    const uint64_t total =
+        sim->stat.off_us + sim->stat.standby_us + sim->stat.rx_us + sim->stat.tx_us;
+    const uint64_t charge =
+        sim->stat.off_us * I_OFF_NA
+        + sim->stat.standby_us * I_STANDBY_NA
+        + sim->stat.rx_us * I_RX_NA
+        + sim->stat.tx_us * I_TX_NA;
+
+    return total ? charge / total / 1000 : 0;
+}
+
+static
+void run(uint32_t interval, uint32_t period, uint32_t duration)
+{
+    const uint64_t span = (uint64_t)duration * 1000;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    for(uint8_t i = 0; i < 2; ++i)
+    {
+        configure(node_ + i);
+        node_[i].lpl.interval_us = interval;
+    }
+    seq_ = 0;
+    busy_ = 0;
+    sent = 0;
+    delivered = 0;
+    latency_sum = 0;
+    latency_max = 0;
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    if(ALWAYS_ON == interval)
+    {
+        listen(&node_[0].dev);
+        listen(&node_[1].dev);
+    }
+    else
+    {
+        nRF24L01_lpl_start(&node_[0].lpl, NULL, 0);
+        nRF24L01_lpl_start(&node_[1].lpl, on_data, 0);
+    }
+
+    /* energy is accounted from here */
+    for(uint8_t i = 0; i < 2; ++i)
+    {
+        nRF24L01_sim_t *sim = &node_[i].sim;
+
+        sim->stat.off_us = sim->stat.standby_us = sim->stat.rx_us = sim->stat.tx_us = 0;
+    }
+
+    const uint64_t end = air.now + span;
+
+    t_next = air.now + xorshift32(&seed_) % period;
+    while(air.now < end)
+    {
+        nRF24L01_sim_bench_dispatch(&node_[0].dev, &node_[0].sim);
+        nRF24L01_sim_bench_dispatch(&node_[1].dev, &node_[1].sim);
+
+        for(uint8_t i = 0; i < 2; ++i)
+        {
+            node_t *node = node_ + i;
+
+            if(node->deadline > air.now) continue;
+            node->deadline = nRF24L01_SIM_NEVER;
+            nRF24L01_lpl_timeout(&node->lpl);
+        }
+
+        if(!busy_ && t_next <= air.now)
+        {
+            send(interval);
+            t_next = air.now + period / 2 + xorshift32(&seed_) % period;
+        }
+
+        uint64_t next = nRF24L01_sim_next(&air);
+
+        if(node_[0].deadline < next) next = node_[0].deadline;
+        if(node_[1].deadline < next) next = node_[1].deadline;
+        if(!busy_ && t_next < next) next = t_next;
+        if(end < next) next = end;
+        nRF24L01_sim_run(&air, next);
+    }
+
+    printf(
+        "{\"mode\":\"%s\",\"interval_ms\":%" PRIu32 ",\"sent\":%" PRIu32
+        ",\"delivered\":%" PRIu32 ",\"latency_avg_ms\":%.2f,\"latency_max_ms\":%.2f"
+        ",\"sink_uA\":%" PRIu32 ",\"sensor_uA\":%" PRIu32 ",\"checks\":%" PRIu32
+        ",\"woken\":%" PRIu32 ",\"resend\":%" PRIu32 ",\"tx_err\":%" PRIu16 "}\n",
+        ALWAYS_ON == interval ? "always_on" : "lpl",
+        interval / 1000,
+        sent,
+        delivered,
+        delivered ? (double)latency_sum / delivered / 1000 : 0.0,
+        (double)latency_max / 1000,
+        current_ua(&node_[1].sim),
+        current_ua(&node_[0].sim),
+        node_[1].lpl.stat.check,
+        node_[1].lpl.stat.woken,
+        node_[0].lpl.stat.resend,
+        node_[0].lpl.stat.tx_err);
+
+    nRF24L01_sim_release(&node_[0].sim);
+    nRF24L01_sim_release(&node_[1].sim);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t interval[] = {ALWAYS_ON, 20000, 50000, 100000, 200000, 500000};
+    const uint32_t period = 1 < argc ? strtoul(argv[1], NULL, 0) : 1000;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+    const uint32_t duration = 3 < argc ? strtoul(argv[3], NULL, 0) : 60000;
+
+    if(!period || !duration)
+    {
+        fprintf(stderr, "usage: %s [period_ms [seed [duration_ms]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(uint8_t i = 0; i < sizeof(frame_); ++i) frame_[i] = i;
+    for(uint8_t i = 0; i < sizeof(interval) / sizeof(interval[0]); ++i)
+    {
+        seed_ = seed ? seed : 1;
+        run(interval[i], period * 1000, duration);
+    }
+    return EXIT_SUCCESS;
+}
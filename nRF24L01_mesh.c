@@ -0,0 +1,429 @@
+#include <string.h>
+
+#include "nRF24L01_mesh.h"
+#include "xorshift.h"
+
+#define FRAME_SIZE nRF24L01_MESH_FRAME_SIZE
+#define DATA_SIZE nRF24L01_MESH_DATA_SIZE
+#define BROADCAST nRF24L01_MESH_BROADCAST
+#define ROUTE_NUM nRF24L01_MESH_ROUTE_NUM
+#define SEEN_NUM nRF24L01_MESH_SEEN_NUM
+#define ROUTE_INVALID UINT8_C(0xFF)
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+typedef struct
+{
+    uint8_t dst; // final destination
+    uint8_t src; // originator
+    uint8_t prev; // transmitter of this hop
+    uint8_t next; // receiver of this hop
+    uint8_t seq; // originator sequence number
+    uint8_t ttl : 4;
+    uint8_t hops : 4;
+} header_t;
+
+typedef union
+{
+    struct
+    {
+        header_t header;
+        uint8_t data[DATA_SIZE];
+    };
+    uint8_t byte[0];
+} frame_t;
+
+/* routing ------------------------------------------------------------------*/
+
+static
+nRF24L01_mesh_route_t *route_find(nRF24L01_mesh_t *mesh, uint8_t dst)
+{
+    for(uint8_t i = 0; i < ROUTE_NUM; ++i)
+    {
+        nRF24L01_mesh_route_t *route = mesh->route + i;
+
+        if(ROUTE_INVALID != route->age && dst == route->dst) return route;
+    }
+    return NULL;
+}
+
+static
+void route_learn(nRF24L01_mesh_t *mesh, uint8_t dst, uint8_t next, uint8_t hops)
+{
+    if(mesh->id == dst || BROADCAST == dst) return;
+
+    nRF24L01_mesh_route_t *route = route_find(mesh, dst);
+
+    if(route)
+    {
+        /* refresh current path or switch to shorter one */
+        if(next != route->next && hops > route->hops) return;
+    }
+    else
+    {
+        /* free or oldest entry */
+        route = mesh->route;
+        for(uint8_t i = 1; i < ROUTE_NUM; ++i)
+        {
+            if(ROUTE_INVALID == route->age) break;
+            if(mesh->route[i].age > route->age) route = mesh->route + i;
+        }
+    }
+
+    route->dst = dst;
+    route->next = next;
+    route->hops = hops;
+    route->age = 0;
+}
+
+static
+uint8_t next_hop(nRF24L01_mesh_t *mesh, uint8_t dst)
+{
+    if(BROADCAST == dst) return BROADCAST;
+
+    const nRF24L01_mesh_route_t *route = route_find(mesh, dst);
+
+    return route ? route->next : BROADCAST;
+}
+
+/* returns 1 if frame was already seen, records it otherwise */
+static
+uint8_t seen(nRF24L01_mesh_t *mesh, uint8_t src, uint8_t seq)
+{
+    for(uint8_t i = 0; i < SEEN_NUM; ++i)
+    {
+        if(src == mesh->seen[i].src && seq == mesh->seen[i].seq) return 1;
+    }
+
+    mesh->seen[mesh->seen_pos].src = src;
+    mesh->seen[mesh->seen_pos].seq = seq;
+    mesh->seen_pos = (mesh->seen_pos + 1) % SEEN_NUM;
+    return 0;
+}
+
+/* radio --------------------------------------------------------------------*/
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_forwarded(uintptr_t);
+
+static
+void on_forward_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(nRF24L01_mesh_t *mesh)
+{
+    uint8_t *frame = mesh->rx_frame[mesh->rx];
+
+    mesh->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        mesh->dev,
+        frame, frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)mesh);
+}
+
+/* starts waiting payload if radio is free, own payload goes first */
+static
+void kick(nRF24L01_mesh_t *mesh)
+{
+    if(mesh->busy) return;
+
+    if(mesh->pending)
+    {
+        const frame_t *frame = (const frame_t *)mesh->tx_frame;
+
+        mesh->pending = 0;
+        mesh->busy = 1;
+        mesh->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+        nRF24L01_send(
+            mesh->dev,
+            mesh->tx_frame, frame->data + mesh->tx.size,
+            on_sent,
+            on_send_error,
+            (uintptr_t)mesh);
+    }
+    else if(mesh->forwarding && !mesh->wait)
+    {
+        uint8_t *frame = mesh->rx_frame[!mesh->rx];
+
+        mesh->busy = 1;
+        mesh->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+        nRF24L01_send(
+            mesh->dev,
+            frame, frame + mesh->fwd_size,
+            on_forwarded,
+            on_forward_error,
+            (uintptr_t)mesh);
+    }
+}
+
+/* payload completed, next one or back to listening */
+static
+void resume(nRF24L01_mesh_t *mesh)
+{
+    mesh->busy = 0;
+    kick(mesh);
+    if(!mesh->busy) listen(mesh);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+
+    if(!mesh->busy) listen(mesh);
+}
+
+static
+void on_forwarded(uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+
+    ++mesh->stats.forwarded;
+    mesh->forwarding = 0;
+
+    if(mesh->clock)
+    {
+        const uint32_t latency = (*mesh->clock)() - mesh->rx_time;
+
+        mesh->stats.latency_sum += latency;
+        if(latency > mesh->stats.latency_max) mesh->stats.latency_max = latency;
+    }
+    resume(mesh);
+}
+
+static
+void on_forward_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+
+    mesh->forwarding = 0;
+    resume(mesh);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+    uint8_t *const begin = mesh->rx_frame[mesh->rx];
+    frame_t *frame = (frame_t *)begin;
+    const uint8_t size = curr - begin;
+    const uint32_t now = mesh->clock ? (*mesh->clock)() : 0;
+
+    if(sizeof(header_t) > size) goto listen;
+
+    header_t *header = &frame->header;
+
+    if(mesh->id == header->prev || mesh->id == header->src) goto listen;
+
+    /* neighbour and originator are reachable via transmitter of this hop */
+    route_learn(mesh, header->prev, header->prev, 1);
+    route_learn(mesh, header->src, header->prev, header->hops + 1);
+
+    if(mesh->id != header->next && BROADCAST != header->next) goto listen;
+    /* flood copies and retransmissions along route alike */
+    if(seen(mesh, header->src, header->seq))
+    {
+        ++mesh->stats.dup;
+        goto listen;
+    }
+
+    if(mesh->id == header->dst || BROADCAST == header->dst)
+    {
+        if(mesh->cb)
+        {
+            (*mesh->cb)(
+                frame->data, curr,
+                header->src,
+                header->hops + 1,
+                mesh->user_data);
+        }
+        if(mesh->id == header->dst) goto listen;
+    }
+
+    if(1 >= header->ttl)
+    {
+        ++mesh->stats.dropped;
+        goto listen;
+    }
+    if(mesh->forwarding)
+    {
+        ++mesh->stats.overrun;
+        goto listen;
+    }
+
+    /* forward in place, keep listening into other buffer */
+    const uint8_t flood = BROADCAST == header->next;
+
+    --header->ttl;
+    ++header->hops;
+    header->prev = mesh->id;
+    header->next = next_hop(mesh, header->dst);
+
+    mesh->rx_time = now;
+    mesh->fwd_size = size;
+    mesh->forwarding = 1;
+    mesh->rx = !mesh->rx;
+    mesh->wait = flood ? 1 + xorshift32(&mesh->seed) % nRF24L01_MESH_JITTER_MAX : 0;
+    kick(mesh);
+listen:
+    if(!mesh->busy) listen(mesh);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+    const nRF24L01_send_cb_t cb = mesh->tx.cb;
+    const uintptr_t tx_user_data = mesh->tx.user_data;
+
+    mesh->tx.cb = NULL;
+    mesh->tx.err_cb = NULL;
+    mesh->tx.user_data = 0;
+
+    resume(mesh);
+    if(cb) (*cb)(tx_user_data);
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_mesh_t *mesh = (nRF24L01_mesh_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = mesh->tx.err_cb;
+    const uintptr_t tx_user_data = mesh->tx.user_data;
+
+    mesh->tx.cb = NULL;
+    mesh->tx.err_cb = NULL;
+    mesh->tx.user_data = 0;
+
+    resume(mesh);
+    if(err_cb) (*err_cb)(status, fifo_status, tx_user_data);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void nRF24L01_mesh_init(
+    nRF24L01_mesh_t *mesh,
+    nRF24L01_t *dev,
+    uint8_t id,
+    uint8_t ttl,
+    uint8_t route_age_max,
+    nRF24L01_clock_t clock)
+{
+    memset(mesh, 0, sizeof(nRF24L01_mesh_t));
+    mesh->dev = dev;
+    mesh->id = id;
+    mesh->ttl = MIN(ttl, nRF24L01_MESH_TTL_MAX);
+    mesh->route_age_max = route_age_max;
+    mesh->clock = clock;
+    /* jitter differs per node, never 0 */
+    mesh->seed = UINT32_C(0x9E3779B9) * ((uint32_t)id + 1);
+
+    for(uint8_t i = 0; i < ROUTE_NUM; ++i) mesh->route[i].age = ROUTE_INVALID;
+    /* BROADCAST is never a valid originator */
+    for(uint8_t i = 0; i < SEEN_NUM; ++i) mesh->seen[i].src = BROADCAST;
+}
+
+void nRF24L01_mesh_start(
+    nRF24L01_mesh_t *mesh,
+    const uint8_t *addr,
+    nRF24L01_mesh_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    mesh->cb = cb;
+    mesh->user_data = user_data;
+
+    mesh->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_write_register(
+        mesh->dev, nRF24L01_ADDR_tx_addr,
+        addr, addr + sizeof(nRF24L01_addr40_t));
+    nRF24L01_write_register(
+        mesh->dev, nRF24L01_ADDR_rx_addr_p0,
+        addr, addr + sizeof(nRF24L01_addr40_t));
+    listen(mesh);
+}
+
+void nRF24L01_mesh_send(
+    nRF24L01_mesh_t *mesh,
+    uint8_t dst,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    frame_t *frame = (frame_t *)mesh->tx_frame;
+    const uint8_t size = MIN((size_t)(end - begin), DATA_SIZE);
+
+    mesh->tx.cb = cb;
+    mesh->tx.err_cb = err_cb;
+    mesh->tx.user_data = user_data;
+    mesh->tx.size = size;
+
+    frame->header = (header_t)
+    {
+        .dst = dst,
+        .src = mesh->id,
+        .prev = mesh->id,
+        .next = next_hop(mesh, dst),
+        .seq = ++mesh->seq,
+        .ttl = mesh->ttl,
+        .hops = 0
+    };
+    memcpy(frame->data, begin, size);
+
+    /* radio may be forwarding */
+    mesh->pending = 1;
+    kick(mesh);
+}
+
+void nRF24L01_mesh_route_set(
+    nRF24L01_mesh_t *mesh,
+    uint8_t dst,
+    uint8_t next,
+    uint8_t hops)
+{
+    route_learn(mesh, dst, next, hops);
+}
+
+void nRF24L01_mesh_tick(nRF24L01_mesh_t *mesh)
+{
+    if(mesh->wait && !--mesh->wait) kick(mesh);
+
+    for(uint8_t i = 0; i < ROUTE_NUM; ++i)
+    {
+        nRF24L01_mesh_route_t *route = mesh->route + i;
+
+        if(ROUTE_INVALID == route->age) continue;
+        if(++route->age >= mesh->route_age_max) route->age = ROUTE_INVALID;
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Multi-hop relaying (mesh) over shared address.
+ *
+ * All nodes listen and transmit on the same address (auto ACK must be
+ * disabled), frames carry 1B node ids: final destination, originator,
+ * transmitter of current hop and next hop. Node forwards frame if it is the
+ * next hop, frame header is updated in place and payload is transmitted
+ * straight from receive buffer (no intermediate copy), node keeps
+ * listening into the other one of two receive buffers meanwhile. Frame
+ * needing forward while previous one still waits is dropped.
+ *
+ * Routes are learned from traffic (reverse path: originator is reachable
+ * via transmitter of the hop), unknown destinations are flooded with TTL
+ * limit and duplicate suppression (every frame for this node, delivered or
+ * forwarded, is checked). Rebroadcast is delayed by random 1 -
+ * nRF24L01_MESH_JITTER_MAX ticks so neighbours which got the same frame do
+ * not collide. Routing table is fixed size array, oldest entry is replaced
+ * when full.
+ *
+ * Own payload waits while forwarded frame is in flight (and vice versa),
+ * single own payload at a time.
+ *
+ * If clock is provided, time between reception and forwarded frame being
+ * sent is accumulated to measure per hop latency. */
+
+#define nRF24L01_MESH_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_MESH_DATA_SIZE (nRF24L01_MESH_FRAME_SIZE - 6)
+#define nRF24L01_MESH_BROADCAST UINT8_C(0xFF)
+#define nRF24L01_MESH_TTL_MAX 15
+
+#ifndef nRF24L01_MESH_ROUTE_NUM
+#define nRF24L01_MESH_ROUTE_NUM 16
+#endif
+
+#ifndef nRF24L01_MESH_SEEN_NUM
+#define nRF24L01_MESH_SEEN_NUM 8
+#endif
+
+#ifndef nRF24L01_MESH_JITTER_MAX
+#define nRF24L01_MESH_JITTER_MAX 4 // ticks
+#endif
+
+typedef
+void (*nRF24L01_mesh_recv_cb_t)(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t src,
+    uint8_t hops,
+    uintptr_t);
+
+typedef struct
+{
+    uint8_t dst;
+    uint8_t next;
+    uint8_t hops;
+    uint8_t age; // ticks since last refresh, 0xFF: invalid
+} nRF24L01_mesh_route_t;
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_clock_t clock;
+    nRF24L01_mesh_recv_cb_t cb;
+    uintptr_t user_data;
+    uint8_t id;
+    uint8_t ttl; // initial TTL of originated frames
+    uint8_t seq;
+    uint8_t route_age_max; // ticks
+    uint8_t wait; // ticks until rebroadcast
+    uint32_t seed; // jitter PRNG
+    uint8_t rx_frame[2][nRF24L01_MESH_FRAME_SIZE]; // alternate, see rx
+    uint8_t fwd_size; // forwarded frame
+    uint8_t tx_frame[nRF24L01_MESH_FRAME_SIZE];
+    nRF24L01_mesh_route_t route[nRF24L01_MESH_ROUTE_NUM];
+    struct
+    {
+        uint8_t src;
+        uint8_t seq;
+    } seen[nRF24L01_MESH_SEEN_NUM];
+    uint8_t seen_pos;
+    uint32_t rx_time; // clock at reception of frame being forwarded
+    struct
+    {
+        uint8_t rx : 1; // receive buffer, other one holds forwarded frame
+        uint8_t busy : 1; // payload in flight
+        uint8_t pending : 1; // own payload waits
+        uint8_t forwarding : 1; // forwarded frame waits or is in flight
+        uint8_t : 4;
+    };
+    struct
+    {
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+        uint8_t size; // data of tx_frame
+    } tx;
+    struct
+    {
+        uint16_t forwarded;
+        uint16_t dropped; // TTL expired
+        uint16_t overrun; // previous forwarded frame still waits
+        uint16_t dup; // already seen
+        uint32_t latency_max; // clock ticks
+        uint32_t latency_sum; // clock ticks
+    } stats;
+} nRF24L01_mesh_t;
+
+void nRF24L01_mesh_init(
+    nRF24L01_mesh_t *,
+    nRF24L01_t *,
+    uint8_t id,
+    uint8_t ttl,
+    uint8_t route_age_max,
+    nRF24L01_clock_t);
+
+/* sets tx_addr and rx_addr_p0 to shared mesh address and starts listening,
+ * cb is called for frames addressed to this node or broadcast */
+void nRF24L01_mesh_start(
+    nRF24L01_mesh_t *,
+    const uint8_t *addr, // 5B
+    nRF24L01_mesh_recv_cb_t,
+    uintptr_t user_data);
+
+/* [begin, end) must not exceed nRF24L01_MESH_DATA_SIZE, payload may wait
+ * for forwarded frame in flight, single payload at a time (until cb) */
+void nRF24L01_mesh_send(
+    nRF24L01_mesh_t *,
+    uint8_t dst,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* route to known neighbour/topology, ages and may be replaced like learned ones */
+void nRF24L01_mesh_route_set(nRF24L01_mesh_t *, uint8_t dst, uint8_t next, uint8_t hops);
+
+/* call periodically (i.e. from cyclic timer callback), drives route aging
+ * and rebroadcast jitter */
+void nRF24L01_mesh_tick(nRF24L01_mesh_t *);
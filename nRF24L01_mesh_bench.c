@@ -0,0 +1,384 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_mesh.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Mesh relaying test against simulated radios (nRF24L01_sim).
+ *
+ * Nodes form a line, each one hears its neighbours only: mesh address of
+ * node has its id as LSB and node listens on addresses of neighbours
+ * (pipes 1, 2), pipe 0 (own address) is not enabled. Checked in order:
+ *  - unknown destination is flooded end to end (hops), rebroadcast waits
+ *    1 - nRF24L01_MESH_JITTER_MAX ticks, own payload sent during that wait
+ *    goes out first and forward follows (nothing lost), relays learn
+ *    reverse route to originator
+ *  - reply goes back along learned route: single forward per relay, own
+ *    payload sent while forwarded frame is in flight waits for it
+ *  - frame is dropped by relay once TTL runs out
+ *  - broadcast is delivered to every node once, copies heard from next
+ *    node are suppressed
+ *  - routes expire after route_age_max ticks, flood is used again
+ *
+ * Reported: nodes, frames on air, forwarded, duplicates, TTL drops.
+ * Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_mesh_bench [nodes [seed]] */
+
+#define TICK_PERIOD 1000 // us
+#define ROUTE_AGE_MAX 200 // ticks
+#define WAIT_MAX 400 // ticks
+#define NODE_MAX nRF24L01_MESH_TTL_MAX
+#define DATA_SIZE nRF24L01_MESH_DATA_SIZE
+#define FAIL(what) nRF24L01_sim_bench_fail("mesh: %s", what)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_mesh_t mesh;
+    uint8_t addr[5]; // transmits on
+    /* last delivery */
+    uint32_t recv;
+    uint8_t src;
+    uint8_t hops;
+    uint8_t size;
+    uint8_t data[DATA_SIZE];
+} node_t;
+
+typedef struct
+{
+    uint8_t size;
+    uint8_t data[DATA_SIZE];
+} msg_t;
+
+typedef struct
+{
+    uint32_t forwarded;
+    uint32_t dup;
+    uint32_t dropped;
+} total_t;
+
+static const uint8_t base_[] = {0xC2, 0xC2, 0xC2, 0xC2};
+
+static nRF24L01_sim_air_t air;
+static node_t node_[NODE_MAX];
+static uint8_t num_;
+static uint64_t tick;
+static uint32_t sent_;
+static uint32_t seed_ = 1;
+
+static
+void configure(uint8_t id)
+{
+    node_t *node = node_ + id;
+    nRF24L01_t *dev = &node->dev;
+    nRF24L01_en_rxaddr_t en_rxaddr = {.value = 0};
+    uint8_t pipe_no = 1;
+
+    nRF24L01_sim_bench_init(dev, &node->sim, &air);
+
+    /* neighbours: pipe 1 holds shared upper bytes, pipe 2 LSB only */
+    for(uint8_t i = 0; i < 2; ++i)
+    {
+        const uint8_t nb = i ? id + 1 : id - 1;
+
+        if(num_ <= nb) continue;
+        if(1 == pipe_no)
+        {
+            const uint8_t addr[] = {nb, base_[0], base_[1], base_[2], base_[3]};
+            nRF24L01_write_register(dev, nRF24L01_ADDR_rx_addr_p1, addr, addr + sizeof(addr));
+        }
+        else nRF24L01_write_register(dev, nRF24L01_ADDR_rx_addr_p(pipe_no), &nb, &nb + 1);
+        en_rxaddr.value |= 1 << pipe_no++;
+    }
+    nRF24L01_write_register(dev, nRF24L01_ADDR_en_rxaddr, en_rxaddr.byte, en_rxaddr.byte + sizeof(en_rxaddr));
+
+    nRF24L01_mesh_init(&node->mesh, dev, id, nRF24L01_MESH_TTL_MAX, ROUTE_AGE_MAX, NULL);
+    /* own address is mesh address of node, its pipe 0 is disabled */
+    node->addr[0] = id;
+    memcpy(node->addr + 1, base_, sizeof(base_));
+}
+
+static
+void on_recv(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t src,
+    uint8_t hops,
+    uintptr_t user_data)
+{
+    node_t *node = (node_t *)user_data;
+
+    ++node->recv;
+    node->src = src;
+    node->hops = hops;
+    node->size = end - begin;
+    memcpy(node->data, begin, node->size);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    ++sent_;
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    FAIL("send error");
+}
+
+/* runs air until next event or tick, returns 1 on tick */
+static
+uint8_t advance(void)
+{
+    for(uint8_t i = 0; i < num_; ++i) nRF24L01_sim_bench_dispatch(&node_[i].dev, &node_[i].sim);
+
+    const uint64_t next = nRF24L01_sim_next(&air);
+
+    nRF24L01_sim_run(&air, next < tick ? next : tick);
+    if(tick > air.now) return 0;
+
+    tick += TICK_PERIOD;
+    for(uint8_t i = 0; i < num_; ++i) nRF24L01_mesh_tick(&node_[i].mesh);
+    return 1;
+}
+
+/* runs air until next tick (included) */
+static
+void step(void)
+{
+    while(!advance());
+}
+
+/* runs until no payload waits or is in flight */
+static
+void settle(void)
+{
+    for(uint32_t i = 0;; ++i)
+    {
+        uint8_t active = 0;
+
+        if(WAIT_MAX == i) FAIL("mesh does not settle");
+        step();
+        for(uint8_t j = 0; j < num_; ++j)
+        {
+            const nRF24L01_mesh_t *mesh = &node_[j].mesh;
+
+            active |= mesh->busy || mesh->pending || mesh->forwarding;
+        }
+        if(!active) break;
+    }
+    /* last frame is dispatched */
+    step();
+}
+
+static
+void send(uint8_t id, uint8_t dst, msg_t *msg)
+{
+    msg->size = xorshift32(&seed_) % (DATA_SIZE + 1);
+    for(uint8_t i = 0; i < msg->size; ++i) msg->data[i] = xorshift32(&seed_);
+    nRF24L01_mesh_send(&node_[id].mesh, dst, msg->data, msg->data + msg->size, on_sent, on_send_error, 0);
+}
+
+static
+void check_recv(uint8_t id, uint32_t recv, uint8_t src, uint8_t hops, const msg_t *msg, const char *what)
+{
+    const node_t *node = node_ + id;
+
+    if(recv != node->recv || src != node->src || hops != node->hops) FAIL(what);
+    if(msg->size != node->size || memcmp(msg->data, node->data, msg->size)) FAIL(what);
+}
+
+static
+const nRF24L01_mesh_route_t *route(uint8_t id, uint8_t dst)
+{
+    const nRF24L01_mesh_t *mesh = &node_[id].mesh;
+
+    for(uint8_t i = 0; i < nRF24L01_MESH_ROUTE_NUM; ++i)
+    {
+        if(0xFF != mesh->route[i].age && dst == mesh->route[i].dst) return mesh->route + i;
+    }
+    return NULL;
+}
+
+static
+total_t total(void)
+{
+    total_t total = {0};
+
+    for(uint8_t i = 0; i < num_; ++i)
+    {
+        total.forwarded += node_[i].mesh.stats.forwarded;
+        total.dup += node_[i].mesh.stats.dup;
+        total.dropped += node_[i].mesh.stats.dropped;
+    }
+    return total;
+}
+
+static
+void check_flood(void)
+{
+    const uint8_t last = num_ - 1;
+    msg_t flood;
+    msg_t own;
+
+    if(route(0, last)) FAIL("flood: route known");
+    send(0, last, &flood);
+
+    /* first relay holds frame for jitter */
+    for(uint32_t i = 0; !node_[1].mesh.forwarding; ++i)
+    {
+        if(WAIT_MAX == i) FAIL("flood: not forwarded");
+        step();
+    }
+    if(!node_[1].mesh.wait || nRF24L01_MESH_JITTER_MAX < node_[1].mesh.wait) FAIL("flood: jitter");
+    send(1, 0, &own);
+    if(!node_[1].mesh.busy || !node_[1].mesh.forwarding) FAIL("busy: own payload not sent first");
+    settle();
+
+    if(2 != sent_) FAIL("busy: payload not sent");
+    check_recv(0, 1, 1, 1, &own, "busy: own payload");
+    check_recv(last, 1, 0, last, &flood, "flood: not delivered");
+    if((uint32_t)num_ - 2 != total().forwarded) FAIL("flood: forwarded");
+    for(uint8_t i = 1; i < num_; ++i)
+    {
+        const nRF24L01_mesh_route_t *r = route(i, 0);
+
+        if(!r || i - 1 != r->next || i != r->hops) FAIL("flood: reverse route");
+    }
+}
+
+static
+void check_route(void)
+{
+    const uint8_t last = num_ - 1;
+    const total_t before = total();
+    msg_t reply;
+    msg_t own;
+
+    send(last, 0, &reply);
+    /* first relay forwards at once (no jitter) */
+    for(uint32_t i = 0; !node_[1].mesh.busy; ++i)
+    {
+        if(WAIT_MAX * 8 == i) FAIL("route: not forwarded");
+        advance();
+    }
+    if(!node_[1].mesh.forwarding) FAIL("route: reply not forwarded by relay");
+    /* waits for forwarded frame in flight */
+    send(1, 2, &own);
+    if(!node_[1].mesh.pending) FAIL("busy: own payload sent during forward");
+    settle();
+
+    if(4 != sent_) FAIL("busy: payload not sent");
+    check_recv(0, 2, last, last, &reply, "route: reply not delivered");
+    check_recv(2, 1, 1, 1, &own, "busy: own payload");
+    /* single copy per relay */
+    const total_t after = total();
+
+    if(before.forwarded + num_ - 2 != after.forwarded || before.dup != after.dup) FAIL("route: reply flooded");
+
+    const nRF24L01_mesh_route_t *r = route(0, last);
+
+    if(!r || 1 != r->next || last != r->hops) FAIL("route: not learned");
+}
+
+static
+void check_ttl(void)
+{
+    const uint8_t last = num_ - 1;
+    const uint32_t recv = node_[last].recv;
+    const uint16_t dropped = node_[last - 1].mesh.stats.dropped;
+    msg_t msg;
+
+    /* one hop short */
+    node_[0].mesh.ttl = last - 1;
+    send(0, last, &msg);
+    settle();
+    node_[0].mesh.ttl = nRF24L01_MESH_TTL_MAX;
+
+    if(recv != node_[last].recv) FAIL("ttl: delivered");
+    if(dropped + 1 != node_[last - 1].mesh.stats.dropped) FAIL("ttl: not dropped by relay");
+}
+
+static
+void check_broadcast(void)
+{
+    const uint32_t dup = total().dup;
+    uint32_t recv[NODE_MAX];
+    msg_t msg;
+
+    for(uint8_t i = 0; i < num_; ++i) recv[i] = node_[i].recv;
+    send(0, nRF24L01_MESH_BROADCAST, &msg);
+    settle();
+
+    for(uint8_t i = 1; i < num_; ++i) check_recv(i, recv[i] + 1, 0, i, &msg, "broadcast: not delivered once");
+    /* relay hears copy of next node */
+    if(dup + num_ - 2 != total().dup) FAIL("broadcast: copies not suppressed");
+}
+
+static
+void check_age(void)
+{
+    const uint8_t last = num_ - 1;
+    const uint32_t recv = node_[last].recv;
+    msg_t msg;
+
+    for(uint16_t i = 0; i < ROUTE_AGE_MAX; ++i) step();
+    if(route(0, last)) FAIL("age: route not expired");
+
+    send(0, last, &msg);
+    settle();
+    check_recv(last, recv + 1, 0, last, &msg, "age: flood not delivered");
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t num = 1 < argc ? strtoul(argv[1], NULL, 0) : 6;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+
+    if(4 > num || NODE_MAX < num)
+    {
+        fprintf(stderr, "usage: %s [nodes (4..%u) [seed]]\n", argv[0], NODE_MAX);
+        return EXIT_FAILURE;
+    }
+    num_ = num;
+    seed_ = seed ? seed : 1;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    for(uint8_t i = 0; i < num_; ++i) configure(i);
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    tick = air.now + TICK_PERIOD;
+    for(uint8_t i = 0; i < num_; ++i) nRF24L01_mesh_start(&node_[i].mesh, node_[i].addr, on_recv, (uintptr_t)(node_ + i));
+
+    check_flood();
+    check_route();
+    check_ttl();
+    check_broadcast();
+    check_age();
+
+    const total_t stat = total();
+    uint32_t tx = 0;
+
+    for(uint8_t i = 0; i < num_; ++i) tx += node_[i].sim.stat.tx;
+
+    printf(
+        "{\"nodes\":%" PRIu32 ",\"payloads\":%" PRIu32 ",\"forwarded\":%" PRIu32
+        ",\"dup\":%" PRIu32 ",\"dropped\":%" PRIu32 ",\"ok\":1}\n",
+        num,
+        tx,
+        stat.forwarded,
+        stat.dup,
+        stat.dropped);
+
+    for(uint8_t i = 0; i < num_; ++i) nRF24L01_sim_release(&node_[i].sim);
+    return EXIT_SUCCESS;
+}
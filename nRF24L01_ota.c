@@ -0,0 +1,538 @@
+#include <string.h>
+
+#include "crc.h"
+#include "nRF24L01_ota.h"
+#include "xorshift.h"
+
+#define FRAME_SIZE nRF24L01_OTA_FRAME_SIZE
+#define BLOCK_SIZE nRF24L01_OTA_BLOCK_SIZE
+#define PAGE_SIZE nRF24L01_OTA_PAGE_SIZE
+#define PAGE_BLOCK_NUM (PAGE_SIZE / BLOCK_SIZE) // at most 8 (cached)
+#define NO_PAGE UINT16_MAX
+#define SLOTS_MAX UINT8_C(128)
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+#define TYPE_DATA UINT8_C(0x44) // 'D'
+#define TYPE_QUERY UINT8_C(0x51) // 'Q'
+#define TYPE_NACK UINT8_C(0x4E) // 'N'
+
+/* type, image, size, index, block */
+#define DATA_SIZE (7 + BLOCK_SIZE)
+/* type, image, size, crc, slots */
+#define QUERY_SIZE 10
+/* type, image, base, bitmap of blocks [base, base + NACK_BLOCK_NUM) */
+#define NACK_HEADER_SIZE 5
+#define NACK_BLOCK_NUM ((FRAME_SIZE - NACK_HEADER_SIZE) * 8)
+
+#define STATE_IDLE 0
+#define STATE_DATA 1 // sender: round in progress
+#define STATE_GAP 2 // sender: page written by receivers
+#define STATE_QUERY 3 // sender: collecting NACKs
+#define STATE_REPLY 4 // receiver: NACK scheduled
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+uint16_t load16(const uint8_t *src)
+{
+    return src[0] | (uint16_t)src[1] << 8;
+}
+
+static
+void store16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = value;
+    dst[1] = value >> 8;
+}
+
+static
+uint8_t test(const uint8_t *bitmap, uint16_t index)
+{
+    return bitmap[index >> 3] & 1 << (index & 7);
+}
+
+static
+void set(uint8_t *bitmap, uint16_t index)
+{
+    bitmap[index >> 3] |= 1 << (index & 7);
+}
+
+static
+uint16_t block_num(const nRF24L01_ota_t *ota)
+{
+    return (ota->size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+static
+void listen(nRF24L01_ota_t *ota)
+{
+    if(ota->busy) return;
+
+    nRF24L01_recv(
+        ota->dev,
+        ota->rx_frame, ota->rx_frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)ota);
+}
+
+static
+void transmit(nRF24L01_ota_t *ota, uint8_t size)
+{
+    ota->busy = 1;
+    /* leave RX */
+    ota->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        ota->dev,
+        ota->frame, ota->frame + size,
+        on_sent,
+        on_error,
+        (uintptr_t)ota);
+}
+
+/* sender ------------------------------------------------------------------ */
+
+static
+void query(nRF24L01_ota_t *ota)
+{
+    ota->frame[0] = TYPE_QUERY;
+    store16(ota->frame + 1, ota->image);
+    store16(ota->frame + 3, ota->size);
+    store16(ota->frame + 5, ota->crc);
+    store16(ota->frame + 7, ota->crc >> 16);
+    ota->frame[9] = ota->slots;
+    ota->state = STATE_QUERY;
+    ota->heard = 0;
+    /* NACKs are sent in slots [1, slots], one spare */
+    ota->wait = ota->slots + 2;
+    ++ota->stat.query;
+    transmit(ota, QUERY_SIZE);
+}
+
+static
+void next_block(nRF24L01_ota_t *ota)
+{
+    const uint16_t num = block_num(ota);
+
+    while(ota->index < num && !test(ota->bitmap, ota->index)) ++ota->index;
+    if(ota->index == num)
+    {
+        query(ota);
+        return;
+    }
+
+    const uint16_t page = ota->index / PAGE_BLOCK_NUM;
+
+    if(page != ota->page)
+    {
+        const uint8_t first = NO_PAGE == ota->page;
+
+        ota->page = page;
+        /* receivers write previous page */
+        if(!first && ota->gap)
+        {
+            ota->state = STATE_GAP;
+            ota->wait = ota->gap;
+            return;
+        }
+    }
+
+    const uint16_t offset = ota->index * BLOCK_SIZE;
+    uint8_t *block = ota->frame + DATA_SIZE - BLOCK_SIZE;
+
+    /* last block is padded as erased flash */
+    memset(block, 0xFF, BLOCK_SIZE);
+    (*ota->read)(offset, block, block + MIN(BLOCK_SIZE, ota->size - offset), ota->user_data);
+    ota->frame[0] = TYPE_DATA;
+    store16(ota->frame + 1, ota->image);
+    store16(ota->frame + 3, ota->size);
+    store16(ota->frame + 5, ota->index);
+    ota->bitmap[ota->index >> 3] &= ~(1 << (ota->index & 7));
+    ++ota->index;
+    ++ota->stat.block;
+    transmit(ota, DATA_SIZE);
+}
+
+static
+void round_begin(nRF24L01_ota_t *ota)
+{
+    ++ota->stat.round;
+    ota->state = STATE_DATA;
+    ota->index = 0;
+    ota->page = NO_PAGE;
+    next_block(ota);
+}
+
+static
+void on_nack(nRF24L01_ota_t *ota, const uint8_t *frame)
+{
+    const uint16_t num = block_num(ota);
+    const uint16_t base = load16(frame + 3);
+    const uint8_t *bits = frame + NACK_HEADER_SIZE;
+
+    ++ota->stat.nack;
+    if(UINT8_MAX > ota->heard) ++ota->heard;
+    for(uint16_t i = 0; i < NACK_BLOCK_NUM && base + i < num; ++i)
+    {
+        if(test(bits, i)) set(ota->bitmap, base + i);
+    }
+}
+
+static
+void sender_tick(nRF24L01_ota_t *ota)
+{
+    if(ota->busy || !ota->wait || --ota->wait) return;
+
+    if(STATE_GAP == ota->state)
+    {
+        ota->state = STATE_DATA;
+        next_block(ota);
+        return;
+    }
+
+    if(STATE_QUERY != ota->state) return;
+
+    if(ota->heard)
+    {
+        /* crowded slots collide, more of them next time */
+        if(ota->heard > ota->slots / 4 && SLOTS_MAX / 2 >= ota->slots) ota->slots *= 2;
+        ota->silent = 0;
+        round_begin(ota);
+        return;
+    }
+
+    if(++ota->silent < ota->quiet)
+    {
+        query(ota);
+        return;
+    }
+
+    const nRF24L01_ota_done_cb_t cb = ota->done_cb;
+    const uintptr_t user_data = ota->user_data;
+
+    ota->state = STATE_IDLE;
+    if(cb) (*cb)(user_data);
+}
+
+/* receiver ---------------------------------------------------------------- */
+
+static
+void restart(nRF24L01_ota_t *ota, uint16_t image, uint16_t size)
+{
+    ota->image = image;
+    ota->size = size;
+    ota->page = NO_PAGE;
+    ota->cached = 0;
+    ota->state = STATE_IDLE;
+    ota->known = 1;
+    ota->queried = 0;
+    ota->complete = 0;
+    memset(ota->bitmap, 0, sizeof(ota->bitmap));
+}
+
+/* frame of other image restarts reception, returns 0 if it is not usable */
+static
+uint8_t adopt(nRF24L01_ota_t *ota, uint16_t image, uint16_t size)
+{
+    if(!size || size > nRF24L01_OTA_SIZE_MAX) return 0;
+    if(!ota->known || image != ota->image) restart(ota, image, size);
+    return size == ota->size && !ota->complete;
+}
+
+/* writes cached blocks, blocks of page not cached are read back */
+static
+void flush(nRF24L01_ota_t *ota)
+{
+    if(!ota->cached) return;
+
+    const uint16_t offset = ota->page * PAGE_SIZE;
+
+    for(uint8_t i = 0; i < PAGE_BLOCK_NUM; ++i)
+    {
+        uint8_t *block = ota->cache + i * BLOCK_SIZE;
+
+        if(ota->cached & 1 << i) continue;
+        (*ota->read)(offset + i * BLOCK_SIZE, block, block + BLOCK_SIZE, ota->user_data);
+    }
+    (*ota->write)(offset, ota->cache, ota->cache + PAGE_SIZE, ota->user_data);
+    ota->cached = 0;
+    ++ota->stat.page;
+}
+
+static
+void store(nRF24L01_ota_t *ota, uint16_t index, const uint8_t *data)
+{
+    const uint16_t page = index / PAGE_BLOCK_NUM;
+    const uint8_t i = index % PAGE_BLOCK_NUM;
+    const uint16_t num = block_num(ota);
+    const uint8_t page_num = MIN(PAGE_BLOCK_NUM, num - page * PAGE_BLOCK_NUM);
+
+    if(page != ota->page)
+    {
+        flush(ota);
+        ota->page = page;
+    }
+    memcpy(ota->cache + i * BLOCK_SIZE, data, BLOCK_SIZE);
+    ota->cached |= 1 << i;
+    set(ota->bitmap, index);
+    ++ota->stat.block;
+    /* all blocks of page are cached */
+    if((uint8_t)((1 << page_num) - 1) == ota->cached) flush(ota);
+}
+
+/* first missing block, block_num() if none */
+static
+uint16_t missing(const nRF24L01_ota_t *ota, uint16_t index)
+{
+    const uint16_t num = block_num(ota);
+
+    while(index < num && test(ota->bitmap, index)) ++index;
+    return index;
+}
+
+static
+uint8_t verify(nRF24L01_ota_t *ota)
+{
+    uint8_t block[BLOCK_SIZE];
+    uint32_t crc = CRC32_INIT;
+
+    for(uint16_t offset = 0; offset < ota->size; offset += BLOCK_SIZE)
+    {
+        const uint8_t size = MIN(BLOCK_SIZE, ota->size - offset);
+
+        (*ota->read)(offset, block, block + size, ota->user_data);
+        crc = crc32_update(crc, block, block + size);
+    }
+    return ~crc == ota->crc;
+}
+
+static
+void on_query(nRF24L01_ota_t *ota, const uint8_t *frame)
+{
+    if(!adopt(ota, load16(frame + 1), load16(frame + 3))) return;
+
+    ota->crc = load16(frame + 5) | (uint32_t)load16(frame + 7) << 16;
+    ota->slots = frame[9] ? frame[9] : 1;
+    ota->queried = 1;
+    flush(ota);
+
+    if(missing(ota, 0) < block_num(ota))
+    {
+        ota->state = STATE_REPLY;
+        ota->wait = 1 + xorshift32(&ota->seed) % ota->slots;
+        return;
+    }
+
+    if(!verify(ota))
+    {
+        ++ota->stat.crc_err;
+        restart(ota, ota->image, ota->size);
+        return;
+    }
+
+    const nRF24L01_ota_done_cb_t cb = ota->done_cb;
+    const uintptr_t user_data = ota->user_data;
+
+    ota->complete = 1;
+    ota->state = STATE_IDLE;
+    if(cb) (*cb)(user_data);
+}
+
+/* overheard NACK covers all blocks own NACK would report */
+static
+void on_other_nack(nRF24L01_ota_t *ota, const uint8_t *frame)
+{
+    if(STATE_REPLY != ota->state || load16(frame + 1) != ota->image) return;
+
+    const uint16_t num = block_num(ota);
+    const uint16_t base = load16(frame + 3);
+    const uint16_t first = missing(ota, 0);
+    const uint16_t last = MIN(num, first + NACK_BLOCK_NUM);
+
+    for(uint16_t i = first; i < last; ++i)
+    {
+        if(test(ota->bitmap, i)) continue;
+        if(i < base || i >= base + NACK_BLOCK_NUM || !test(frame + NACK_HEADER_SIZE, i - base)) return;
+    }
+    ota->state = STATE_IDLE;
+    ++ota->stat.suppressed;
+}
+
+static
+void nack(nRF24L01_ota_t *ota)
+{
+    const uint16_t num = block_num(ota);
+    const uint16_t base = missing(ota, 0);
+    uint8_t *bits = ota->frame + NACK_HEADER_SIZE;
+
+    ota->frame[0] = TYPE_NACK;
+    store16(ota->frame + 1, ota->image);
+    store16(ota->frame + 3, base);
+    memset(bits, 0, FRAME_SIZE - NACK_HEADER_SIZE);
+    for(uint16_t i = 0; i < NACK_BLOCK_NUM && base + i < num; ++i)
+    {
+        if(!test(ota->bitmap, base + i)) set(bits, i);
+    }
+    ota->state = STATE_IDLE;
+    ++ota->stat.nack;
+    transmit(ota, FRAME_SIZE);
+}
+
+static
+void receiver_tick(nRF24L01_ota_t *ota)
+{
+    if(STATE_REPLY != ota->state || ota->busy || --ota->wait) return;
+    nack(ota);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_ota_t *ota = (nRF24L01_ota_t *)user_data;
+    const uint8_t *frame = ota->rx_frame;
+    const uint8_t size = curr - ota->rx_frame;
+
+    listen(ota);
+    if(!size) return;
+
+    if(ota->sender)
+    {
+        if(
+            TYPE_NACK == frame[0] && FRAME_SIZE == size
+            && STATE_QUERY == ota->state && load16(frame + 1) == ota->image)
+        {
+            on_nack(ota, frame);
+        }
+        return;
+    }
+
+    if(TYPE_DATA == frame[0] && DATA_SIZE == size)
+    {
+        const uint16_t index = load16(frame + 5);
+
+        if(
+            adopt(ota, load16(frame + 1), load16(frame + 3))
+            && index < block_num(ota) && !test(ota->bitmap, index))
+        {
+            store(ota, index, frame + DATA_SIZE - BLOCK_SIZE);
+        }
+    }
+    else if(TYPE_QUERY == frame[0] && QUERY_SIZE == size) on_query(ota, frame);
+    else if(TYPE_NACK == frame[0] && FRAME_SIZE == size) on_other_nack(ota, frame);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_ota_t *)user_data);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_ota_t *ota = (nRF24L01_ota_t *)user_data;
+
+    ota->busy = 0;
+    if(ota->sender && STATE_DATA == ota->state) next_block(ota);
+    else listen(ota);
+}
+
+/* no ACK, only cancelled transmission ends up here */
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    on_sent(user_data);
+}
+
+void nRF24L01_ota_init(
+    nRF24L01_ota_t *ota,
+    nRF24L01_t *dev,
+    uint32_t seed)
+{
+    memset(ota, 0, sizeof(nRF24L01_ota_t));
+    ota->dev = dev;
+    ota->seed = seed ? seed : 1;
+    ota->slots = nRF24L01_OTA_SLOTS;
+    ota->gap = nRF24L01_OTA_GAP;
+    ota->quiet = nRF24L01_OTA_QUIET;
+    ota->page = NO_PAGE;
+    ota->state = STATE_IDLE;
+}
+
+void nRF24L01_ota_send(
+    nRF24L01_ota_t *ota,
+    uint16_t image,
+    uint16_t size,
+    nRF24L01_ota_read_t read,
+    nRF24L01_ota_done_cb_t cb,
+    uintptr_t user_data)
+{
+    uint8_t block[BLOCK_SIZE];
+    uint32_t crc = CRC32_INIT;
+
+    size = MIN(size, nRF24L01_OTA_SIZE_MAX);
+    ota->sender = 1;
+    ota->image = image;
+    ota->size = size;
+    ota->read = read;
+    ota->done_cb = cb;
+    ota->user_data = user_data;
+    ota->silent = 0;
+    for(uint16_t offset = 0; offset < size; offset += BLOCK_SIZE)
+    {
+        const uint8_t len = MIN(BLOCK_SIZE, size - offset);
+
+        (*read)(offset, block, block + len, user_data);
+        crc = crc32_update(crc, block, block + len);
+    }
+    ota->crc = ~crc;
+    /* first round sends all blocks */
+    memset(ota->bitmap, 0, sizeof(ota->bitmap));
+    for(uint16_t i = 0; i < block_num(ota); ++i) set(ota->bitmap, i);
+    round_begin(ota);
+}
+
+void nRF24L01_ota_recv(
+    nRF24L01_ota_t *ota,
+    nRF24L01_ota_read_t read,
+    nRF24L01_ota_write_t write,
+    nRF24L01_ota_done_cb_t cb,
+    uintptr_t user_data)
+{
+    ota->sender = 0;
+    ota->read = read;
+    ota->write = write;
+    ota->done_cb = cb;
+    ota->user_data = user_data;
+    listen(ota);
+}
+
+void nRF24L01_ota_tick(nRF24L01_ota_t *ota)
+{
+    if(ota->sender) sender_tick(ota);
+    else receiver_tick(ota);
+}
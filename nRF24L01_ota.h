@@ -0,0 +1,129 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Broadcast firmware distribution (over the air update of many nodes).
+ *
+ * Sender broadcasts image in blocks (no ACK, all radios share address with
+ * auto ACK disabled), receivers store every block they get and track
+ * received ones in bitmap. Round of blocks is followed by QUERY (image
+ * size, CRC-32): receiver which still misses blocks replies with NACK
+ * (first missing block and bitmap of following ones) in random one of
+ * slots ticks, other receivers overhearing NACK which covers their own
+ * missing blocks suppress theirs. Sender doubles slots (up to 128) when
+ * NACKs fill more than quarter of them. Next (repair) round re-sends only
+ * union of reported blocks. Sender is done once quiet QUERYs in row got no
+ * NACK. Time grows with union of lost blocks (and pages holding them), not
+ * with number of nodes.
+ *
+ * Receiver accesses flash (staging area, image offset 0) by callbacks which
+ * call bootloader (application can not write flash itself): blocks are
+ * gathered in page cache, page is written whole (write() erases and
+ * programs nRF24L01_OTA_PAGE_SIZE bytes), blocks of page not received yet
+ * are read back first (read()). Sender pauses for gap ticks after every
+ * page worth of blocks so page write (CPU halted) does not overflow RX
+ * FIFO. Once bitmap is full image CRC-32 is verified (read back) and done
+ * callback is called, i.e. to hand image to bootloader, CRC mismatch
+ * restarts reception. New image id (QUERY or block) restarts reception.
+ *
+ * nRF24L01_ota_tick() is called periodically (1ms), tick period has to
+ * exceed NACK air time. Instance is either sender or receiver. */
+
+#define nRF24L01_OTA_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_OTA_BLOCK_SIZE 16
+
+#ifndef nRF24L01_OTA_PAGE_SIZE
+#define nRF24L01_OTA_PAGE_SIZE 128 // SPM_PAGESIZE of ATmega328p
+#endif
+
+#ifndef nRF24L01_OTA_SIZE_MAX
+#define nRF24L01_OTA_SIZE_MAX UINT16_C(16384) // staging area
+#endif
+
+#define nRF24L01_OTA_BLOCK_MAX_NUM (nRF24L01_OTA_SIZE_MAX / nRF24L01_OTA_BLOCK_SIZE)
+#define nRF24L01_OTA_SLOTS 32 // ticks
+#define nRF24L01_OTA_GAP 10 // ticks, page erase + write ~9ms
+#define nRF24L01_OTA_QUIET 3
+
+typedef
+void (*nRF24L01_ota_read_t)(uint16_t offset, uint8_t *begin, const uint8_t *const end, uintptr_t);
+typedef
+void (*nRF24L01_ota_write_t)(uint16_t offset, const uint8_t *begin, const uint8_t *const end, uintptr_t);
+typedef
+void (*nRF24L01_ota_done_cb_t)(uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_ota_read_t read;
+    nRF24L01_ota_write_t write; // receiver
+    nRF24L01_ota_done_cb_t done_cb;
+    uintptr_t user_data;
+    uint8_t state;
+    uint16_t image; // id
+    uint16_t size;
+    uint32_t crc;
+    uint16_t index; // sender: next block to consider
+    uint16_t page; // receiver: cached page
+    uint8_t slots; // ticks
+    uint8_t gap; // ticks
+    uint8_t quiet; // QUERYs
+    uint8_t wait; // ticks
+    uint8_t silent; // sender: QUERYs without NACK in row
+    uint8_t heard; // sender: NACKs in current window
+    uint32_t seed; // receiver: slot PRNG
+    /* sender: blocks to be sent, receiver: blocks received */
+    uint8_t bitmap[nRF24L01_OTA_BLOCK_MAX_NUM / 8];
+    uint8_t cache[nRF24L01_OTA_PAGE_SIZE];
+    uint8_t cached; // bitmap of cached blocks
+    uint8_t frame[nRF24L01_OTA_FRAME_SIZE];
+    uint8_t rx_frame[nRF24L01_OTA_FRAME_SIZE];
+    struct
+    {
+        uint8_t sender : 1;
+        uint8_t busy : 1; // payload in flight
+        uint8_t known : 1; // receiver: image id valid
+        uint8_t queried : 1; // receiver: size and CRC valid
+        uint8_t complete : 1; // receiver: verified
+        uint8_t : 3;
+    };
+    struct
+    {
+        uint16_t round;
+        uint32_t block; // sender: sent, receiver: stored (new)
+        uint16_t query;
+        uint16_t nack; // sender: received, receiver: sent
+        uint16_t suppressed; // receiver: NACK cancelled by overheard one
+        uint16_t page; // receiver: page writes
+        uint8_t crc_err; // receiver: verification failed
+    } stat;
+} nRF24L01_ota_t;
+
+/* receiver: seed (i.e. address or serial number) has to differ per node,
+ * defaults of slots/gap/quiet are set and can be changed before start */
+void nRF24L01_ota_init(
+    nRF24L01_ota_t *,
+    nRF24L01_t *,
+    uint32_t seed);
+
+/* broadcasts image [0, size) (read() from offset) identified by id, cb is
+ * called once no receiver reports missing blocks */
+void nRF24L01_ota_send(
+    nRF24L01_ota_t *,
+    uint16_t image,
+    uint16_t size,
+    nRF24L01_ota_read_t,
+    nRF24L01_ota_done_cb_t,
+    uintptr_t user_data);
+
+/* starts listening, cb is called once image was received and verified
+ * (image id and size are in instance) */
+void nRF24L01_ota_recv(
+    nRF24L01_ota_t *,
+    nRF24L01_ota_read_t,
+    nRF24L01_ota_write_t,
+    nRF24L01_ota_done_cb_t,
+    uintptr_t user_data);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_ota_tick(nRF24L01_ota_t *);
@@ -0,0 +1,177 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_ota.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Broadcast update benchmark against simulated radios (nRF24L01_sim).
+ *
+ * Sender distributes random image to 1 - 50 receivers (no ACK, 2Mbps,
+ * every payload lost with loss_ppm probability per receiver). Receivers
+ * "flash" is RAM, page write time is not modeled (sender gap covers it).
+ * Reported: time until sender is done, rounds, blocks sent (repair =
+ * beyond image), QUERYs, NACKs sent/suppressed, average page writes per
+ * node and nodes holding verified image. Virtual time, reproducible for
+ * given seed.
+ *
+ * usage: nRF24L01_ota_bench [loss_ppm [seed [size]]] */
+
+#define TICK_PERIOD 1000 // us
+#define NODE_MAX (nRF24L01_SIM_DEV_MAX - 1)
+#define TIMEOUT_US UINT64_C(600000000)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_ota_t ota;
+    uint8_t done;
+} node_t;
+
+static nRF24L01_sim_air_t air;
+static node_t node_[1 + NODE_MAX]; // sender, receivers
+static uint8_t image_[nRF24L01_OTA_SIZE_MAX];
+static uint8_t flash_[NODE_MAX][nRF24L01_OTA_SIZE_MAX];
+static uint8_t sent_;
+
+static
+void configure(node_t *node, uint32_t seed)
+{
+    /* broadcast */
+    nRF24L01_sim_bench_init(&node->dev, &node->sim, &air);
+    nRF24L01_ota_init(&node->ota, &node->dev, seed);
+    node->done = 0;
+}
+
+static
+void image_read(uint16_t offset, uint8_t *begin, const uint8_t *const end, uintptr_t user_data)
+{
+    memcpy(begin, image_ + offset, end - begin);
+}
+
+static
+void flash_read(uint16_t offset, uint8_t *begin, const uint8_t *const end, uintptr_t user_data)
+{
+    memcpy(begin, flash_[user_data] + offset, end - begin);
+}
+
+static
+void flash_write(uint16_t offset, const uint8_t *begin, const uint8_t *const end, uintptr_t user_data)
+{
+    memcpy(flash_[user_data] + offset, begin, end - begin);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    sent_ = 1;
+}
+
+static
+void on_image(uintptr_t user_data)
+{
+    node_[1 + user_data].done = 1;
+}
+
+static
+void run(uint8_t node_num, uint32_t loss_ppm, uint32_t seed, uint16_t size)
+{
+    nRF24L01_sim_air_init(&air, loss_ppm, seed);
+    for(uint8_t i = 0; i <= node_num; ++i)
+    {
+        configure(node_ + i, seed + i);
+        /* erased */
+        if(i) memset(flash_[i - 1], 0xFF, sizeof(flash_[i - 1]));
+    }
+    sent_ = 0;
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    for(uint8_t i = 1; i <= node_num; ++i)
+    {
+        nRF24L01_ota_recv(&node_[i].ota, flash_read, flash_write, on_image, i - 1);
+    }
+
+    const uint64_t begin = air.now;
+    uint64_t tick = air.now + TICK_PERIOD;
+
+    nRF24L01_ota_send(&node_[0].ota, 1, size, image_read, on_sent, 0);
+    while(!sent_ && air.now < begin + TIMEOUT_US)
+    {
+        for(uint8_t i = 0; i <= node_num; ++i) nRF24L01_sim_bench_dispatch(&node_[i].dev, &node_[i].sim);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        for(uint8_t i = 0; i <= node_num; ++i) nRF24L01_ota_tick(&node_[i].ota);
+    }
+
+    const nRF24L01_ota_t *sender = &node_[0].ota;
+    uint32_t nack = 0;
+    uint32_t suppressed = 0;
+    uint32_t page = 0;
+    uint8_t done = 0;
+
+    for(uint8_t i = 1; i <= node_num; ++i)
+    {
+        const nRF24L01_ota_t *ota = &node_[i].ota;
+
+        nack += ota->stat.nack;
+        suppressed += ota->stat.suppressed;
+        page += ota->stat.page;
+        done += node_[i].done && !memcmp(flash_[i - 1], image_, size);
+    }
+
+    printf(
+        "{\"nodes\":%" PRIu8 ",\"loss_ppm\":%" PRIu32 ",\"size\":%" PRIu16
+        ",\"time_ms\":%.1f,\"rounds\":%" PRIu16 ",\"blocks\":%" PRIu32
+        ",\"repair\":%" PRIu32 ",\"queries\":%" PRIu16 ",\"nacks\":%" PRIu32
+        ",\"nack_rx\":%" PRIu16 ",\"suppressed\":%" PRIu32
+        ",\"pages_avg\":%.1f,\"done\":%" PRIu8 "}\n",
+        node_num,
+        loss_ppm,
+        size,
+        (double)(air.now - begin) / 1000,
+        sender->stat.round,
+        sender->stat.block,
+        sender->stat.block - (size + nRF24L01_OTA_BLOCK_SIZE - 1) / nRF24L01_OTA_BLOCK_SIZE,
+        sender->stat.query,
+        nack,
+        sender->stat.nack,
+        suppressed,
+        (double)page / node_num,
+        done);
+
+    for(uint8_t i = 0; i <= node_num; ++i) nRF24L01_sim_release(&node_[i].sim);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint8_t node_num[] = {1, 5, 10, 25, 50};
+    const uint32_t loss_ppm = 1 < argc ? strtoul(argv[1], NULL, 0) : 10000;
+    const uint32_t seed = 2 < argc ? strtoul(argv[2], NULL, 0) : 1;
+    const uint32_t size = 3 < argc ? strtoul(argv[3], NULL, 0) : 8192;
+    uint32_t state = seed ? seed : 1;
+
+    if(!size || size > nRF24L01_OTA_SIZE_MAX || loss_ppm >= 1000000)
+    {
+        fprintf(stderr, "usage: %s [loss_ppm [seed [size]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(uint16_t i = 0; i < sizeof(image_); ++i)
+    {
+        image_[i] = xorshift32(&state);
+    }
+    for(uint8_t i = 0; i < sizeof(node_num); ++i)
+    {
+        if(node_num[i] <= NODE_MAX) run(node_num[i], loss_ppm, seed, size);
+    }
+    return EXIT_SUCCESS;
+}
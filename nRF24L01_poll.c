@@ -0,0 +1,143 @@
+#include <string.h>
+
+#include "nRF24L01_poll.h"
+
+#define SERVICE_MAX nRF24L01_POLL_SERVICE_MAX
+#define HOLDOFF nRF24L01_POLL_HOLDOFF
+#define DECAY_SHIFT nRF24L01_POLL_DECAY_SHIFT
+/* fixed point event count, fraction survives decay */
+#define EVENT 16
+
+/* interrupts which can be masked while polling */
+#define MASK ((nRF24L01_config_t){.MASK_RX_DR = 1, .MASK_TX_DS = 1}.value)
+
+static
+void config_mask(nRF24L01_poll_t *poll, uint8_t mask)
+{
+    /* other bits are kept as set by driver/application */
+    nRF24L01_config_t config =
+    {
+        .value = nRF24L01_read_register(poll->dev, nRF24L01_ADDR_config)
+    };
+
+    config.value = (config.value & ~poll->mask) | mask;
+    nRF24L01_write_register(
+        poll->dev,
+        nRF24L01_ADDR_config,
+        &config.value, &config.value + 1);
+}
+
+static
+void enter(nRF24L01_poll_t *poll)
+{
+    const nRF24L01_config_t config =
+    {
+        .value = nRF24L01_read_register(poll->dev, nRF24L01_ADDR_config)
+    };
+
+    poll->app_mask = config.value & poll->mask;
+    config_mask(poll, poll->mask);
+    poll->polling = 1;
+    poll->idle = 0;
+    poll->rx_full = poll->dev->stat.rx_full;
+    ++poll->stat.enter;
+}
+
+static
+void leave(nRF24L01_poll_t *poll)
+{
+    config_mask(poll, poll->app_mask);
+    poll->polling = 0;
+    poll->events = 0;
+    ++poll->stat.leave;
+}
+
+/* returns number of events handled */
+static
+uint8_t service(nRF24L01_poll_t *poll)
+{
+    uint8_t num = 0;
+    uint8_t draining = 0;
+
+    while(SERVICE_MAX > num)
+    {
+        const nRF24L01_status_t status = nRF24L01_status(poll->dev);
+
+        ++poll->stat.poll;
+
+        /* RX_DR is cleared with every payload read, rest of FIFO is
+         * reported by RX_P_NO */
+        const uint8_t rx =
+            status.RX_DR
+            || (draining && nRF24L01_RX_PIPE_NUM > status.RX_P_NO);
+
+        if(!rx && !status.TX_DS && !status.MAX_RT) break;
+
+        draining = rx;
+        poll->dev->updated = 1;
+        nRF24L01_event(poll->dev);
+        ++num;
+    }
+    poll->stat.polled += num;
+    return num;
+}
+
+void nRF24L01_poll_init(
+    nRF24L01_poll_t *poll,
+    nRF24L01_t *dev,
+    uint8_t threshold,
+    uint8_t idle_ticks,
+    nRF24L01_config_t mask)
+{
+    memset(poll, 0, sizeof(nRF24L01_poll_t));
+    poll->dev = dev;
+    poll->threshold = threshold;
+    poll->idle_ticks = idle_ticks;
+    poll->mask = mask.value & MASK;
+}
+
+/* event is going to be served by masked interrupt */
+static
+uint8_t maskable(const nRF24L01_poll_t *poll)
+{
+    const nRF24L01_config_t mask = {.value = poll->mask};
+
+    return
+        (mask.MASK_RX_DR && poll->dev->rx.end)
+        || (mask.MASK_TX_DS && poll->dev->tx.end);
+}
+
+void nRF24L01_poll_irq(nRF24L01_poll_t *poll)
+{
+    const uint8_t count = maskable(poll);
+
+    poll->dev->updated = 1;
+    nRF24L01_event(poll->dev);
+    ++poll->stat.irq;
+
+    if(!poll->threshold || poll->polling || poll->holdoff || !count) return;
+    poll->events += EVENT;
+    if((uint16_t)poll->threshold * EVENT <= poll->events) enter(poll);
+}
+
+void nRF24L01_poll_tick(nRF24L01_poll_t *poll)
+{
+    if(!poll->polling)
+    {
+        poll->events -= poll->events >> DECAY_SHIFT;
+        if(poll->holdoff) --poll->holdoff;
+        return;
+    }
+
+    const uint8_t num = service(poll);
+
+    if(poll->rx_full != poll->dev->stat.rx_full)
+    {
+        /* tick is too slow for this rate, payloads were dropped */
+        ++poll->stat.overrun;
+        poll->holdoff = HOLDOFF;
+        leave(poll);
+    }
+    else if(num) poll->idle = 0;
+    else if(++poll->idle >= poll->idle_ticks) leave(poll);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Hybrid interrupt/polling dispatch (portable, AVR and host).
+ *
+ * Interrupt mode: application calls nRF24L01_poll_irq() instead of
+ * nRF24L01_event() while IRQ is asserted, events are counted with decay of
+ * 1/2^nRF24L01_POLL_DECAY_SHIFT per tick (rate of N events per tick settles
+ * at N * 2^nRF24L01_POLL_DECAY_SHIFT). Once count reaches threshold
+ * selected interrupts (RX_DR
+ * and/or TX_DS, MAX_RT is never masked) are masked in CONFIG and FIFOs are
+ * serviced from nRF24L01_poll_tick(): STATUS is polled (single byte) and
+ * event is handled while RX_DR/TX_DS/MAX_RT are set or RX FIFO drains, so
+ * one wakeup serves several payloads. After idle_ticks ticks without traffic
+ * masks are restored, status bits set meanwhile assert IRQ right away.
+ *
+ * Masking TX_DS pays off only if nRF24L01_send() is given several payloads
+ * at once (FIFO is refilled once per tick), single payload sends are limited
+ * to one per tick.
+ *
+ * Tick period must be shorter than time needed to fill RX FIFO
+ * (nRF24L01_FIFO_SIZE payloads), if RX FIFO is found full while polling
+ * (dev->stat.rx_full) interrupt mode is restored and polling is not entered
+ * again for nRF24L01_POLL_HOLDOFF ticks.
+ *
+ * CONFIG written by application (nRF24L01_CFG) while polling loses masks. */
+
+#ifndef nRF24L01_POLL_DECAY_SHIFT
+#define nRF24L01_POLL_DECAY_SHIFT 2
+#endif
+
+#ifndef nRF24L01_POLL_HOLDOFF
+#define nRF24L01_POLL_HOLDOFF 64 // ticks
+#endif
+
+/* events handled per tick at most (FIFO drain + TX refill) */
+#define nRF24L01_POLL_SERVICE_MAX (2 * nRF24L01_FIFO_SIZE)
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    uint8_t threshold; // decayed event count to enter polling, 0: never
+    uint8_t idle_ticks; // ticks without traffic to leave polling
+    uint16_t events; // interrupt mode: decayed event count (x16)
+    uint8_t idle; // polling: ticks without traffic
+    uint8_t holdoff; // ticks polling is not entered
+    uint8_t mask; // CONFIG bits masked while polling
+    uint8_t app_mask; // CONFIG mask bits of application (restored)
+    uint16_t rx_full; // dev->stat.rx_full when polling was entered
+    struct
+    {
+        uint8_t polling : 1;
+        uint8_t : 7;
+    };
+    struct
+    {
+        uint32_t irq; // events handled in interrupt mode
+        uint32_t polled; // events handled from tick
+        uint32_t poll; // STATUS reads from tick
+        uint16_t enter;
+        uint16_t leave;
+        uint16_t overrun; // polling left because RX FIFO was full
+    } stat;
+} nRF24L01_poll_t;
+
+/* dev has to be initialized, CONFIG set up,
+ * mask: interrupts masked while polling (MASK_RX_DR, MASK_TX_DS) */
+void nRF24L01_poll_init(
+    nRF24L01_poll_t *,
+    nRF24L01_t *,
+    uint8_t threshold,
+    uint8_t idle_ticks,
+    nRF24L01_config_t mask);
+
+/* IRQ asserted (replaces dev->updated = 1; nRF24L01_event(dev)) */
+void nRF24L01_poll_irq(nRF24L01_poll_t *);
+
+/* periodically (i.e. from cyclic timer callback) */
+void nRF24L01_poll_tick(nRF24L01_poll_t *);
@@ -0,0 +1,475 @@
+#include <string.h>
+
+#include "nRF24L01_rate.h"
+
+#define FRAME_SIZE nRF24L01_RATE_FRAME_SIZE
+#define WINDOW nRF24L01_RATE_WINDOW
+#define HOLDOFF_MAX nRF24L01_RATE_HOLDOFF_MAX
+#define RATE_250K nRF24L01_RATE_250K
+#define RATE_2M nRF24L01_RATE_2M
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+
+#define TYPE_DATA UINT8_C(0x44) // 'D'
+#define TYPE_SWITCH UINT8_C(0x53) // 'S'
+#define TYPE_PROBE UINT8_C(0x50) // 'P'
+
+/* ticks between SWITCH ACK and PROBE, follower switches on its next tick */
+#define PROBE_DELAY 2
+/* ticks SWITCH is re-transmitted, follower which got it switched meanwhile */
+#define SWITCH_TIMEOUT 5
+
+/* re-transmits per 8 payloads above which lower rate has better goodput,
+ * attempt takes ARD (750us, ACK @ 250kbps) or air time whichever is longer:
+ * ~0.75ms @ 2Mbps, ~1ms @ 1Mbps, ~2ms @ 250kbps (32B payload) */
+static const uint8_t down_retx_[nRF24L01_RATE_NUM] = {0, 8, 2};
+/* re-transmits per 8 payloads new rate may take, it has to be about as clean
+ * as one it was chosen over */
+#define FRESH_RETX 2
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_sent(uintptr_t);
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(nRF24L01_rate_t *rate)
+{
+    if(rate->busy) return;
+
+    nRF24L01_recv(
+        rate->dev,
+        rate->rx_frame, rate->rx_frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)rate);
+}
+
+/* radio must not transmit, caller resumes listening */
+static
+void apply(nRF24L01_rate_t *rate, uint8_t value)
+{
+    nRF24L01_t *dev = rate->dev;
+    nRF24L01_rf_setup_t rf_setup = {.value = nRF24L01_read_register(dev, nRF24L01_ADDR_rf_setup)};
+
+    rf_setup.RF_DR_LOW = RATE_250K == value;
+    rf_setup.RF_DR_HIGH = RATE_2M == value;
+    /* RX is entered again (settled) at new rate */
+    dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_write_register(dev, nRF24L01_ADDR_rf_setup, &rf_setup.value, &rf_setup.value + 1);
+    rate->rate = value;
+}
+
+static
+void transmit(nRF24L01_rate_t *rate, uint8_t type, uint8_t size)
+{
+    rate->tx_frame[0] = type;
+    rate->busy = 1;
+    nRF24L01_send(
+        rate->dev,
+        rate->tx_frame, rate->tx_frame + size,
+        on_sent,
+        on_error,
+        (uintptr_t)rate);
+}
+
+static
+void kick(nRF24L01_rate_t *rate)
+{
+    if(rate->busy || rate->confirming) return;
+
+    if(rate->leader && rate->next != rate->rate)
+    {
+        rate->switch_age = 0;
+        rate->tx_frame[1] = rate->next;
+        transmit(rate, TYPE_SWITCH, 2);
+        return;
+    }
+
+    if(rate->pending)
+    {
+        const uint8_t size = rate->tx.end - rate->tx.begin;
+
+        memcpy(rate->tx_frame + 1, rate->tx.begin, size);
+        transmit(rate, TYPE_DATA, 1 + size);
+    }
+}
+
+/* re-transmits per 8 payloads of current window above which rate is left */
+static
+uint8_t budget(const nRF24L01_rate_t *rate)
+{
+    return rate->fresh ? FRESH_RETX : down_retx_[rate->rate];
+}
+
+/* upshift to rate did not hold, next one is tried much later (single
+ * attempt costs several windows worth of re-transmits at worse link), lower
+ * rates are not held off */
+static
+void penalize(nRF24L01_rate_t *rate, uint8_t value)
+{
+    rate->holdoff_len[value] = MIN(4 * rate->holdoff_len[value], HOLDOFF_MAX);
+    rate->holdoff[value] = rate->holdoff_len[value];
+}
+
+static
+void adapt(nRF24L01_rate_t *rate)
+{
+    const uint16_t sent = rate->window.sent;
+    const uint16_t retx = rate->window.retx;
+    const uint8_t fail = rate->window.fail;
+    const uint8_t limit = budget(rate);
+    const uint8_t fresh = rate->fresh;
+    const uint8_t perfect = rate->perfect;
+    const uint8_t curr = rate->rate;
+
+    memset(&rate->window, 0, sizeof(rate->window));
+    rate->fresh = 0;
+    rate->perfect = !retx;
+
+    /* change in progress */
+    if(rate->next != curr) return;
+
+    if(RATE_250K != curr && (fail || 8 * retx > sent * limit))
+    {
+        if(fresh) penalize(rate, curr);
+        /* payload failed all re-transmits, link is far below this rate */
+        rate->next = fail ? RATE_250K : curr - 1;
+        rate->upshift = 0;
+        return;
+    }
+
+    if(fresh) rate->holdoff_len[curr] = 1;
+
+    if(RATE_2M != curr && retx * 8 <= sent)
+    {
+        uint8_t *const holdoff = rate->holdoff + curr + 1;
+
+        /* windows without re-transmit in row suggest link got better */
+        if(*holdoff) *holdoff = retx || !perfect ? *holdoff - 1 : *holdoff / 4;
+        else
+        {
+            rate->next = curr + 1;
+            rate->upshift = 1;
+        }
+    }
+}
+
+/* peer lost, best sensitivity is common ground,
+ * radio must not transmit, caller resumes listening */
+static
+void fall(nRF24L01_rate_t *rate)
+{
+    ++rate->stat.fallback;
+    apply(rate, RATE_250K);
+    rate->prev = RATE_250K;
+    rate->next = RATE_250K;
+    rate->age = 0;
+    rate->confirming = 0;
+    rate->probe_wait = 0;
+    rate->switching = 0;
+    rate->confirmed = 1;
+}
+
+/* leader: change was not confirmed, follower may have switched if only ACKs
+ * were lost, it is switched back by SWITCH at new rate (PROBE at previous one
+ * tells if it fails) */
+static
+void abandon(nRF24L01_rate_t *rate)
+{
+    ++rate->stat.revert;
+    /* new rate could not carry single PROBE */
+    if(rate->upshift) penalize(rate, rate->rate);
+    rate->next = rate->prev;
+    rate->upshift = 0;
+}
+
+/* leader: switch to decided rate, PROBE confirms it,
+ * radio must not transmit, caller resumes listening */
+static
+void enter(nRF24L01_rate_t *rate)
+{
+    rate->prev = rate->rate;
+    apply(rate, rate->next);
+    rate->confirming = 1;
+    rate->probe_wait = PROBE_DELAY;
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_rate_t *rate = (nRF24L01_rate_t *)user_data;
+    const uint8_t type = rate->tx_frame[0];
+
+    rate->busy = 0;
+    rate->age = 0;
+
+    if(TYPE_SWITCH == type)
+    {
+        enter(rate);
+        goto listen;
+    }
+
+    if(TYPE_PROBE == type)
+    {
+        if(!rate->confirming) goto listen;
+        rate->confirming = 0;
+        if(rate->upshift)
+        {
+            ++rate->stat.up;
+            rate->fresh = 1;
+        }
+        else ++rate->stat.down;
+        /* new rate starts with clean window */
+        memset(&rate->window, 0, sizeof(rate->window));
+        goto listen;
+    }
+
+    if(rate->leader)
+    {
+        const nRF24L01_observe_tx_t observe_tx =
+            {.value = nRF24L01_read_register(rate->dev, nRF24L01_ADDR_observe_tx)};
+
+        /* new rate is judged on first quarter of window, window is decided
+         * once re-transmits exceed its budget (no lower rate than 250kbps) */
+        const uint8_t len = rate->fresh ? WINDOW / 4 : WINDOW;
+
+        rate->window.retx += observe_tx.ARC_CNT;
+        if(
+            len <= ++rate->window.sent
+            || (RATE_250K != rate->rate && 8 * rate->window.retx > len * budget(rate)))
+        {
+            adapt(rate);
+        }
+    }
+
+    {
+        const nRF24L01_send_cb_t cb = rate->tx.cb;
+        const uintptr_t cb_user_data = rate->tx.user_data;
+
+        rate->pending = 0;
+        memset(&rate->tx, 0, sizeof(rate->tx));
+
+        if(cb) (*cb)(cb_user_data);
+    }
+listen:
+    listen(rate);
+    kick(rate);
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_rate_t *rate = (nRF24L01_rate_t *)user_data;
+    const uint8_t type = rate->tx_frame[0];
+
+    rate->busy = 0;
+
+    /* failing sender is busy most of time, silence is checked here too */
+    if(rate->silent <= rate->age && RATE_250K != rate->rate) fall(rate);
+
+    if(TYPE_SWITCH == type)
+    {
+        /* follower switched anyway if only ACK was lost, PROBE tells */
+        enter(rate);
+        goto listen;
+    }
+
+    if(TYPE_PROBE == type)
+    {
+        if(!rate->confirming) goto listen;
+        rate->confirming = 0;
+        abandon(rate);
+        goto listen;
+    }
+
+    ++rate->stat.tx_err;
+    if(rate->leader)
+    {
+        const nRF24L01_observe_tx_t observe_tx =
+            {.value = nRF24L01_read_register(rate->dev, nRF24L01_ADDR_observe_tx)};
+
+        rate->window.retx += observe_tx.ARC_CNT;
+        ++rate->window.sent;
+        ++rate->window.fail;
+        adapt(rate);
+    }
+
+    {
+        const nRF24L01_err_cb_t err_cb = rate->tx.err_cb;
+        const uintptr_t cb_user_data = rate->tx.user_data;
+
+        rate->pending = 0;
+        memset(&rate->tx, 0, sizeof(rate->tx));
+
+        if(err_cb) (*err_cb)(status, fifo_status, cb_user_data);
+    }
+listen:
+    listen(rate);
+    kick(rate);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_rate_t *rate = (nRF24L01_rate_t *)user_data;
+    const uint8_t size = curr - rate->rx_frame;
+
+    rate->age = 0;
+    if(!rate->switching) rate->confirmed = 1;
+
+    if(!size) goto listen;
+
+    if(
+        TYPE_SWITCH == rate->rx_frame[0]
+        && 2 <= size
+        && !rate->leader
+        && nRF24L01_RATE_NUM > rate->rx_frame[1])
+    {
+        /* ACK is sent at current rate, switch is applied on tick */
+        rate->next = rate->rx_frame[1];
+        rate->switching = 1;
+        goto listen;
+    }
+
+    if(TYPE_DATA == rate->rx_frame[0] && rate->recv_cb)
+    {
+        (*rate->recv_cb)(rate->rx_frame + 1, curr, rate->recv_user_data);
+    }
+listen:
+    listen(rate);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_rate_t *)user_data);
+}
+
+void nRF24L01_rate_init(
+    nRF24L01_rate_t *rate,
+    nRF24L01_t *dev,
+    uint8_t leader,
+    uint8_t fallback,
+    uint8_t silent)
+{
+    memset(rate, 0, sizeof(nRF24L01_rate_t));
+    rate->dev = dev;
+    rate->leader = leader;
+    rate->fallback = fallback;
+    rate->silent = silent;
+    memset(rate->holdoff_len, 1, sizeof(rate->holdoff_len));
+    rate->confirmed = 1;
+}
+
+void nRF24L01_rate_start(
+    nRF24L01_rate_t *rate,
+    nRF24L01_rate_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    rate->recv_cb = cb;
+    rate->recv_user_data = user_data;
+    apply(rate, RATE_250K);
+    rate->prev = RATE_250K;
+    rate->next = RATE_250K;
+    /* initial rate is judged on first quarter of window too */
+    rate->fresh = rate->leader;
+    listen(rate);
+}
+
+void nRF24L01_rate_send(
+    nRF24L01_rate_t *rate,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    rate->tx.begin = begin;
+    rate->tx.end = end;
+    rate->tx.cb = cb;
+    rate->tx.err_cb = err_cb;
+    rate->tx.user_data = user_data;
+    rate->pending = 1;
+    kick(rate);
+}
+
+void nRF24L01_rate_tick(nRF24L01_rate_t *rate)
+{
+    if(UINT8_MAX > rate->age) ++rate->age;
+
+    if(
+        rate->leader
+        && rate->busy
+        && TYPE_SWITCH == rate->tx_frame[0]
+        && SWITCH_TIMEOUT <= ++rate->switch_age)
+    {
+        /* only ACK can be lost now, PROBE tells */
+        nRF24L01_cancel(rate->dev);
+        rate->busy = 0;
+        enter(rate);
+        listen(rate);
+        goto exit;
+    }
+    if(rate->busy) goto exit;
+
+    if(rate->silent <= rate->age && RATE_250K != rate->rate)
+    {
+        fall(rate);
+        listen(rate);
+    }
+
+    if(!rate->leader)
+    {
+        if(rate->switching)
+        {
+            rate->switching = 0;
+            rate->prev = rate->rate;
+            apply(rate, rate->next);
+            rate->switch_age = 0;
+            rate->confirmed = 0;
+            listen(rate);
+        }
+        else if(!rate->confirmed && rate->fallback <= ++rate->switch_age)
+        {
+            ++rate->stat.revert;
+            apply(rate, rate->prev);
+            rate->confirmed = 1;
+            listen(rate);
+        }
+        goto exit;
+    }
+
+    if(rate->probe_wait)
+    {
+        if(!--rate->probe_wait) transmit(rate, TYPE_PROBE, 1);
+        goto exit;
+    }
+
+    /* keep follower from falling back */
+    if(!rate->confirming && !rate->pending && rate->silent / 2 <= rate->age)
+    {
+        transmit(rate, TYPE_PROBE, 1);
+        goto exit;
+    }
+    kick(rate);
+exit:
+    ; // this is required by syntax
+}
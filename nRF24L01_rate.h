@@ -0,0 +1,128 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Negotiated data rate adaptation of point-to-point link (auto ACK).
+ *
+ * Leader decides, follower follows. Leader counts re-transmits
+ * (observe_tx.ARC_CNT) and failures (MAX_RT) of its data payloads over
+ * window of nRF24L01_RATE_WINDOW sends. Rate is stepped down once
+ * re-transmits cost more than lower rate would (2M: above 1/4, 1M: above 1
+ * per payload, attempt time is bound by ARD at higher rates) or straight to
+ * 250kbps if payload failed, and stepped up after window with at most 1/8
+ * payloads re-transmitted. Window is decided early once its re-transmits
+ * exceed the budget.
+ *
+ * New rate (initial one too) is judged on first quarter of window, it has to
+ * stay within 1/4 re-transmits per payload. Upshift which does not hold (or
+ * is not confirmed) multiplies hold-off of that rate by 4 (windows before
+ * next upshift to it, up to nRF24L01_RATE_HOLDOFF_MAX), upshift which holds
+ * resets it. Hold-off counts down per window with at most 1/8 re-transmits
+ * and drops to quarter after two windows without re-transmit in row.
+ *
+ * Change: leader sends SWITCH at current rate, once it is ACKed both ends
+ * switch (follower on its next tick as ACK has to go out first) and leader
+ * sends PROBE at new rate. If SWITCH is not ACKed (fails or is not through
+ * within few ticks) leader switches anyway as follower might have got it,
+ * PROBE tells. If PROBE fails leader sends SWITCH back at new rate, follower
+ * reverts on its own if nothing is received within fallback ticks after
+ * switch.
+ *
+ * Silent peer: leader without ACK and follower without payload for silent
+ * ticks fall to 250kbps (best sensitivity) which is also the initial rate.
+ * Idle leader sends PROBE once nothing was heard for silent / 2 ticks so
+ * follower does not fall back needlessly.
+ *
+ * Payloads are framed (1B type), both ends listen whenever not sending.
+ * Tick period has to exceed ACK time (1ms is enough). */
+
+#define nRF24L01_RATE_250K 0
+#define nRF24L01_RATE_1M 1
+#define nRF24L01_RATE_2M 2
+#define nRF24L01_RATE_NUM 3
+
+#define nRF24L01_RATE_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_RATE_DATA_SIZE (nRF24L01_RATE_FRAME_SIZE - 1)
+#define nRF24L01_RATE_WINDOW 32
+#define nRF24L01_RATE_HOLDOFF_MAX 64
+
+typedef
+void (*nRF24L01_rate_recv_cb_t)(const uint8_t *begin, const uint8_t *const end, uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_rate_recv_cb_t recv_cb;
+    uintptr_t recv_user_data;
+    uint8_t rate; // current
+    uint8_t prev; // before last switch
+    uint8_t next; // leader: decided, follower: requested
+    uint8_t fallback; // ticks
+    uint8_t silent; // ticks
+    uint8_t age; // ticks since peer was heard (ACK or payload)
+    uint8_t probe_wait; // leader: ticks before PROBE of new rate
+    uint8_t switch_age; // ticks since switch, leader: since SWITCH was sent
+    uint8_t holdoff[nRF24L01_RATE_NUM]; // leader: clean windows before upshift to rate
+    uint8_t holdoff_len[nRF24L01_RATE_NUM];
+    uint8_t tx_frame[nRF24L01_RATE_FRAME_SIZE];
+    uint8_t rx_frame[nRF24L01_RATE_FRAME_SIZE];
+    struct
+    {
+        uint8_t sent;
+        uint8_t fail;
+        uint16_t retx;
+    } window;
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+    struct
+    {
+        uint16_t up;
+        uint16_t down;
+        uint16_t revert; // change not confirmed
+        uint16_t fallback; // silent peer
+        uint16_t tx_err; // MAX_RT of data payloads
+    } stat;
+    struct
+    {
+        uint8_t leader : 1;
+        uint8_t busy : 1; // payload in flight
+        uint8_t pending : 1; // data payload waits
+        uint8_t confirming : 1; // leader: switched, PROBE not ACKed yet
+        uint8_t upshift : 1; // leader: last change
+        uint8_t fresh : 1; // leader: new rate (upshift or initial) judged in current window
+        uint8_t perfect : 1; // leader: previous window without re-transmit
+        uint8_t switching : 1; // follower: switch on next tick
+        uint8_t confirmed : 1; // follower: payload received since switch
+    };
+} nRF24L01_rate_t;
+
+void nRF24L01_rate_init(
+    nRF24L01_rate_t *,
+    nRF24L01_t *,
+    uint8_t leader,
+    uint8_t fallback,
+    uint8_t silent);
+
+/* sets initial rate and starts listening, cb is called with received data */
+void nRF24L01_rate_start(
+    nRF24L01_rate_t *,
+    nRF24L01_rate_recv_cb_t,
+    uintptr_t user_data);
+
+/* size of [begin, end) must not exceed nRF24L01_RATE_DATA_SIZE, payload may
+ * wait for rate change in progress, single payload at a time */
+void nRF24L01_rate_send(
+    nRF24L01_rate_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_rate_tick(nRF24L01_rate_t *);
@@ -0,0 +1,265 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_rate.h"
+#include "nRF24L01_sim_bench.h"
+
+/* Data rate adaptation benchmark against simulated radios (nRF24L01_sim).
+ *
+ * Leader floods follower with data payloads (auto ACK, 15 re-transmits) over
+ * link profiles which differ in loss per data rate (nRF24L01_sim
+ * rate_loss_ppm), fade profile switches from near to far and back during
+ * run. Each profile is run at every fixed rate and with nRF24L01_rate,
+ * goodput delivered to follower is reported. Adaptive goodput must not fall
+ * more than TOL_PCT below best fixed rate of profile (exit status, start at
+ * 250kbps is not amortized in runs much shorter than default). Virtual time,
+ * reproducible for given seed.
+ *
+ * usage: nRF24L01_rate_bench [seed [duration_ms]] */
+
+#define TICK_PERIOD 1000 // us
+#define FALLBACK 20 // ticks
+#define SILENT 100 // ticks
+#define ADAPTIVE nRF24L01_RATE_NUM
+#define TOL_PCT 7 // probing of higher rates and changes cost airtime
+
+typedef struct
+{
+    const char *name;
+    uint32_t loss_ppm[nRF24L01_SIM_RATE_NUM]; // 250k, 1M, 2M
+} profile_t;
+
+static const profile_t profile_[] =
+{
+    {"near", {0, 0, 0}},
+    {"mid", {0, 20000, 400000}},
+    {"far", {20000, 500000, 900000}},
+    {"fade", {0, 0, 0}} // near, far in middle third
+};
+#define PROFILE_NUM (sizeof(profile_) / sizeof(profile_[0]))
+#define FADE (PROFILE_NUM - 1)
+
+static nRF24L01_sim_air_t air;
+static nRF24L01_sim_t sim_[2];
+static nRF24L01_t dev_[2];
+static nRF24L01_rate_t rate_[2];
+static uint8_t frame_[nRF24L01_RATE_FRAME_SIZE]; // fixed rate sends type byte too
+static uint8_t rx_frame_[nRF24L01_PAYLOAD_SIZE - 1];
+static uint32_t delivered; // bytes
+static uint8_t mode_;
+
+static
+void configure(nRF24L01_t *dev, nRF24L01_sim_t *sim, uint8_t rate)
+{
+    nRF24L01_sim_bench_init(dev, sim, &air);
+    nRF24L01_CFG(dev, en_aa, .ENAA_P0 = 1);
+    /* 15 re-transmits 750us apart (ACK fits even @ 250kbps) */
+    nRF24L01_CFG(dev, setup_retr, .ARC = 15, .ARD = 2);
+    nRF24L01_CFG(
+        dev, rf_setup,
+        .RF_PWR = 3,
+        .RF_DR_HIGH = nRF24L01_RATE_2M == rate,
+        .PLL_LOCK = 0,
+        .RF_DR_LOW = nRF24L01_RATE_250K == rate,
+        .CONT_WAVE = 0);
+}
+
+static
+void link(const profile_t *profile)
+{
+    memcpy(air.rate_loss_ppm, profile->loss_ppm, sizeof(air.rate_loss_ppm));
+}
+
+static
+void on_data(const uint8_t *begin, const uint8_t *const end, uintptr_t user_data)
+{
+    delivered += end - begin;
+}
+
+/* fixed rate: plain driver, follower counts its own frames */
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void listen(void)
+{
+    nRF24L01_recv(
+        dev_ + 1,
+        rx_frame_, rx_frame_ + sizeof(rx_frame_),
+        on_frame,
+        on_rx_error,
+        0);
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    /* same accounting as framed payload (type byte excluded) */
+    if(curr != rx_frame_) delivered += curr - rx_frame_ - 1;
+    listen();
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen();
+}
+
+static
+void flood(void);
+
+static
+void on_sent(uintptr_t user_data)
+{
+    flood();
+}
+
+static
+void on_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    flood();
+}
+
+static
+void flood(void)
+{
+    if(ADAPTIVE == mode_)
+    {
+        nRF24L01_rate_send(rate_, frame_ + 1, frame_ + sizeof(frame_), on_sent, on_error, 0);
+        return;
+    }
+    nRF24L01_send(dev_, frame_, frame_ + sizeof(frame_), on_sent, on_error, 0);
+}
+
+/* returns goodput (B/s) */
+static
+uint32_t run(uint8_t p, uint8_t mode, uint32_t seed, uint32_t duration)
+{
+    static const char *const mode_name[] = {"250k", "1M", "2M", "adaptive"};
+    const uint64_t span = (uint64_t)duration * 1000;
+
+    nRF24L01_sim_air_init(&air, 0, seed);
+    link(profile_ + p);
+    mode_ = mode;
+    delivered = 0;
+
+    for(uint8_t i = 0; i < 2; ++i)
+    {
+        configure(dev_ + i, sim_ + i, ADAPTIVE == mode ? nRF24L01_RATE_250K : mode);
+        nRF24L01_rate_init(rate_ + i, dev_ + i, !i, FALLBACK, SILENT);
+    }
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    if(ADAPTIVE == mode)
+    {
+        nRF24L01_rate_start(rate_ + 0, NULL, 0);
+        nRF24L01_rate_start(rate_ + 1, on_data, 0);
+    }
+    else listen();
+
+    const uint64_t begin = air.now;
+    uint64_t tick = air.now + TICK_PERIOD;
+
+    flood();
+    while(air.now < begin + span)
+    {
+        if(FADE == p)
+        {
+            const uint64_t t = air.now - begin;
+
+            link(profile_ + (span / 3 <= t && t < 2 * span / 3 ? FADE - 1 : 0));
+        }
+
+        nRF24L01_sim_bench_dispatch(dev_ + 0, sim_ + 0);
+        nRF24L01_sim_bench_dispatch(dev_ + 1, sim_ + 1);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        if(ADAPTIVE != mode) continue;
+        nRF24L01_rate_tick(rate_ + 0);
+        nRF24L01_rate_tick(rate_ + 1);
+    }
+
+    const nRF24L01_rate_t *leader = rate_ + 0;
+    const nRF24L01_rate_t *follower = rate_ + 1;
+    const uint32_t goodput = (uint64_t)delivered * 1000 / duration;
+
+    printf(
+        "{\"profile\":\"%s\",\"mode\":\"%s\",\"goodput_Bps\":%" PRIu32
+        ",\"up\":%" PRIu16 ",\"down\":%" PRIu16 ",\"revert\":%" PRIu16
+        ",\"fallback\":%" PRIu16 ",\"follower_revert\":%" PRIu16
+        ",\"follower_fallback\":%" PRIu16 ",\"rate\":\"%s\"}\n",
+        profile_[p].name,
+        mode_name[mode],
+        goodput,
+        leader->stat.up,
+        leader->stat.down,
+        leader->stat.revert,
+        leader->stat.fallback,
+        follower->stat.revert,
+        follower->stat.fallback,
+        mode_name[ADAPTIVE == mode ? leader->rate : mode]);
+
+    nRF24L01_sim_release(sim_ + 0);
+    nRF24L01_sim_release(sim_ + 1);
+    return goodput;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t seed = 1 < argc ? strtoul(argv[1], NULL, 0) : 1;
+    const uint32_t duration = 2 < argc ? strtoul(argv[2], NULL, 0) : 3000;
+
+    if(!duration)
+    {
+        fprintf(stderr, "usage: %s [seed [duration_ms]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int r = EXIT_SUCCESS;
+
+    for(uint8_t i = 0; i < sizeof(frame_); ++i) frame_[i] = i;
+    for(uint8_t p = 0; p < PROFILE_NUM; ++p)
+    {
+        uint32_t best = 0;
+
+        for(uint8_t mode = 0; mode < ADAPTIVE; ++mode)
+        {
+            const uint32_t goodput = run(p, mode, seed, duration);
+
+            if(best < goodput) best = goodput;
+        }
+
+        const uint32_t adaptive = run(p, ADAPTIVE, seed, duration);
+
+        if((uint64_t)adaptive * 100 < (uint64_t)best * (100 - TOL_PCT))
+        {
+            fprintf(
+                stderr,
+                "error: %s adaptive %" PRIu32 " B/s below best fixed rate %" PRIu32 " B/s\n",
+                profile_[p].name, adaptive, best);
+            r = EXIT_FAILURE;
+        }
+    }
+    return r;
+}
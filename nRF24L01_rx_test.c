@@ -1,5 +1,4 @@
 #include <string.h>
-#include <stdio.h>
 
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
@@ -11,6 +10,7 @@
 #include <bootloader/fixed.h>
 
 #include "cyclic_timer.h"
+#include "dlog_usart0.h"
 #include "nRF24L01.h"
 
 // nRF IRQ      PC.2/PCINT10       pin: A2 pro-mini
@@ -166,7 +166,14 @@ void on_recv_error(
     nRF24L01_t *dev = (nRF24L01_t *)user_data;
 
     dev->ce_set((nRF24L01_ce_t){.CE = 0});
-    usart0_send_str("recv_err\n");
+    DLOG(RECV_ERROR, status.value, fifo_status.value);
+}
+
+/* big endian so hex dump reads in payload order, zero padded */
+static
+uint16_t word(const uint8_t *p, const uint8_t *const end)
+{
+    return (p < end ? p[0] << 8 : 0) | (p + 1 < end ? p[1] : 0);
 }
 
 static
@@ -178,7 +185,15 @@ void recv(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
 
     dev->ce_set((nRF24L01_ce_t){.CE = 0});
 
-    if(curr) usart0_send_str_r((const char *)rxbuf, (const char *)curr);
+    if(curr)
+    {
+        DLOG(RECV, pipe_no, curr - rxbuf);
+        /* payload itself, 8B per record */
+        for(const uint8_t *p = rxbuf; p < curr; p += 8)
+        {
+            DLOG(RECV_DATA, word(p, curr), word(p + 2, curr), word(p + 4, curr), word(p + 6, curr));
+        }
+    }
 
     nRF24L01_recv(
         dev,
@@ -196,9 +211,7 @@ void cyclic_tmr_cb(uintptr_t user_data)
     nRF24L01_t *dev = (nRF24L01_t *)user_data;
     nRF24L01_rpd_t rpd = nRF24L01_rpd(dev);
 
-    char str[16];
-    sprintf(str, "RPD: %" PRIx8 "\n", rpd.value);
-    usart0_send_str(str);
+    DLOG(RPD, rpd.value);
 }
 
 
@@ -227,20 +240,23 @@ void main(void)
     {
         cli();
         {
-            usart0_send_str("+\n");
-
             /* TODO: do event dispatch once per main event loop
              * provide periodic timer, for now dispatch all events to avoid
              * missing some */
             while(0 == (PINC & M1(PINC2)))
             {
-                usart0_send_str("*\n");
+                DLOG(EVENT);
                 dev.updated = 1;
                 nRF24L01_event(&dev);
             }
         }
+        /* log is sent by USART interrupt while CPU sleeps,
+         * wakeups it causes are not logged */
+        const uint8_t idle = !dlog_usart0_drain();
+
         sei();
         sleep_cpu();
+        if(idle) DLOG(WAKEUP);
     }
 }
 
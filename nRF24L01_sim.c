@@ -0,0 +1,750 @@
+#include <string.h>
+
+#include "nRF24L01_sim.h"
+#include "xorshift.h"
+
+#define DEV_MAX nRF24L01_SIM_DEV_MAX
+#define FIFO_SIZE nRF24L01_SIM_FIFO_SIZE
+#define PAYLOAD_SIZE nRF24L01_PAYLOAD_SIZE
+#define NEVER nRF24L01_SIM_NEVER
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define MAX(a, b) ((b) > (a) ? (b) : (a))
+
+#define SETTLE_TIME 130 // us, TX/RX settling
+#define POWER_UP_TIME 1500 // us, power down -> standby
+#define ARD_STEP 250 // us
+#define PCF_BITS 9 // packet control field
+#define STATUS_FLAGS UINT8_C(0x70) // RX_DR | TX_DS | MAX_RT
+#define ADDR_SIZE_MAX 5
+
+static nRF24L01_sim_t *dev_[DEV_MAX];
+
+static
+uint8_t rnd_lost(nRF24L01_sim_air_t *air, uint8_t rate)
+{
+    const uint32_t loss_ppm = air->loss_ppm + air->rate_loss_ppm[rate];
+
+    if(!loss_ppm) return 0;
+
+    return xorshift32(&air->seed) % UINT32_C(1000000) < loss_ppm;
+}
+
+static
+nRF24L01_config_t config(const nRF24L01_sim_t *sim)
+{
+    return (nRF24L01_config_t){.value = sim->reg[nRF24L01_ADDR_config]};
+}
+
+static
+uint8_t addr_size(const nRF24L01_sim_t *sim)
+{
+    const nRF24L01_setup_aw_t setup_aw = {.value = sim->reg[nRF24L01_ADDR_setup_aw]};
+
+    return setup_aw.AW ? setup_aw.AW + 2 : ADDR_SIZE_MAX;
+}
+
+static
+uint8_t crc_size(const nRF24L01_sim_t *sim)
+{
+    /* CRC is forced if auto ACK is enabled on any pipe */
+    if(!config(sim).EN_CRC && !sim->reg[nRF24L01_ADDR_en_aa]) return 0;
+    return config(sim).CRCO ? 2 : 1;
+}
+
+static
+uint32_t data_rate(const nRF24L01_sim_t *sim)
+{
+    const nRF24L01_rf_setup_t rf_setup = {.value = sim->reg[nRF24L01_ADDR_rf_setup]};
+
+    if(rf_setup.RF_DR_LOW) return UINT32_C(250000);
+    if(rf_setup.RF_DR_HIGH) return UINT32_C(2000000);
+    return UINT32_C(1000000);
+}
+
+static
+uint8_t rate_index(const nRF24L01_sim_t *sim)
+{
+    const nRF24L01_rf_setup_t rf_setup = {.value = sim->reg[nRF24L01_ADDR_rf_setup]};
+
+    if(rf_setup.RF_DR_LOW) return nRF24L01_SIM_RATE_250K;
+    if(rf_setup.RF_DR_HIGH) return nRF24L01_SIM_RATE_2M;
+    return nRF24L01_SIM_RATE_1M;
+}
+
+/* us on air: preamble, address, PCF, payload, CRC */
+static
+uint32_t air_time(const nRF24L01_sim_t *sim, uint8_t payload_size)
+{
+    const uint32_t bits =
+        8 * (1 + addr_size(sim) + payload_size + crc_size(sim)) + PCF_BITS;
+
+    return (bits * UINT32_C(1000000) + data_rate(sim) - 1) / data_rate(sim);
+}
+
+static
+uint8_t status(const nRF24L01_sim_t *sim)
+{
+    nRF24L01_status_t status = {.value = sim->reg[nRF24L01_ADDR_status] & STATUS_FLAGS};
+
+    status.TX_FULL = FIFO_SIZE == sim->tx_fifo.num;
+    status.RX_P_NO =
+        sim->rx_fifo.num
+        ? sim->rx_fifo.payload[0].pipe_no
+        : 7; // RX FIFO empty
+    return status.value;
+}
+
+static
+void flag_set(nRF24L01_sim_t *sim, nRF24L01_status_t flag)
+{
+    sim->reg[nRF24L01_ADDR_status] |= flag.value & STATUS_FLAGS;
+}
+
+static
+uint8_t fifo_status(const nRF24L01_sim_t *sim)
+{
+    return
+        (nRF24L01_fifo_status_t)
+        {
+            .RX_EMPTY = !sim->rx_fifo.num,
+            .RX_FULL = FIFO_SIZE == sim->rx_fifo.num,
+            .TX_EMPTY = !sim->tx_fifo.num,
+            .TX_FULL = FIFO_SIZE == sim->tx_fifo.num
+        }.value;
+}
+
+/* carrier of other device on same channel right now,
+ * measured only in RX once settled */
+static
+uint8_t rpd(const nRF24L01_sim_t *sim)
+{
+    const uint64_t now = sim->air->now;
+
+    if(nRF24L01_SIM_RX != sim->state || sim->ready > now) return 0;
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        const nRF24L01_sim_t *other = dev_[i];
+
+        if(!other || other == sim || other->air != sim->air) continue;
+        if(other->reg[nRF24L01_ADDR_rf_ch] != sim->reg[nRF24L01_ADDR_rf_ch]) continue;
+        if(nRF24L01_SIM_TX == other->state && other->tx_begin <= now && now < other->tx_end)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static
+void fifo_pop(nRF24L01_sim_fifo_t *fifo)
+{
+    if(!fifo->num) return;
+    --fifo->num;
+    memmove(fifo->payload, fifo->payload + 1, fifo->num * sizeof(nRF24L01_sim_payload_t));
+}
+
+static
+uint8_t reg_read(const nRF24L01_sim_t *sim, uint8_t addr, uint8_t i)
+{
+    switch(addr)
+    {
+        case nRF24L01_ADDR_rx_addr_p0: return ADDR_SIZE_MAX > i ? sim->rx_addr_p0[i] : 0;
+        case nRF24L01_ADDR_rx_addr_p1: return ADDR_SIZE_MAX > i ? sim->rx_addr_p1[i] : 0;
+        case nRF24L01_ADDR_tx_addr: return ADDR_SIZE_MAX > i ? sim->tx_addr[i] : 0;
+        case nRF24L01_ADDR_status: return i ? 0 : status(sim);
+        case nRF24L01_ADDR_fifo_status: return i ? 0 : fifo_status(sim);
+        case nRF24L01_ADDR_rpd: return i ? 0 : rpd(sim);
+        default: return i || nRF24L01_SIM_REG_NUM <= addr ? 0 : sim->reg[addr];
+    }
+}
+
+static
+void reg_write(nRF24L01_sim_t *sim, uint8_t addr, const uint8_t *data, uint8_t size)
+{
+    if(!size) return;
+
+    switch(addr)
+    {
+        case nRF24L01_ADDR_rx_addr_p0:
+            memcpy(sim->rx_addr_p0, data, MIN(size, ADDR_SIZE_MAX));
+            break;
+        case nRF24L01_ADDR_rx_addr_p1:
+            memcpy(sim->rx_addr_p1, data, MIN(size, ADDR_SIZE_MAX));
+            break;
+        case nRF24L01_ADDR_tx_addr:
+            memcpy(sim->tx_addr, data, MIN(size, ADDR_SIZE_MAX));
+            break;
+        case nRF24L01_ADDR_status:
+            /* write 1 to clear */
+            sim->reg[nRF24L01_ADDR_status] &= ~(data[0] & STATUS_FLAGS);
+            break;
+        case nRF24L01_ADDR_observe_tx:
+        case nRF24L01_ADDR_rpd:
+        case nRF24L01_ADDR_fifo_status:
+            /* read only */
+            break;
+        default:
+            if(nRF24L01_SIM_REG_NUM > addr) sim->reg[addr] = data[0];
+            break;
+    }
+}
+
+/* re-evaluate mode after register/CE/FIFO change */
+static
+void update(nRF24L01_sim_t *sim)
+{
+    const uint64_t now = sim->air->now;
+    const nRF24L01_config_t cfg = config(sim);
+    const nRF24L01_status_t flags = {.value = status(sim)};
+
+    if(!cfg.PWR_UP)
+    {
+        sim->state = nRF24L01_SIM_OFF;
+        sim->event = NEVER;
+        return;
+    }
+
+    if(nRF24L01_SIM_OFF == sim->state)
+    {
+        sim->state = nRF24L01_SIM_STANDBY;
+        sim->ready = now + POWER_UP_TIME;
+    }
+
+    /* packet on air (and its ACK) is finished first */
+    if(nRF24L01_SIM_TX == sim->state || nRF24L01_SIM_ACK_WAIT == sim->state) return;
+
+    if(sim->ce && cfg.PRIM_RX)
+    {
+        if(nRF24L01_SIM_RX != sim->state)
+        {
+            sim->state = nRF24L01_SIM_RX;
+            sim->ready = MAX(sim->ready, now) + SETTLE_TIME;
+            sim->event = NEVER;
+        }
+        return;
+    }
+
+    /* transmission is halted until MAX_RT is cleared */
+    if(sim->ce && !cfg.PRIM_RX && sim->tx_fifo.num && !flags.MAX_RT)
+    {
+        if(nRF24L01_SIM_TX_SETTLE != sim->state)
+        {
+            sim->state = nRF24L01_SIM_TX_SETTLE;
+            sim->event = MAX(sim->ready, now) + SETTLE_TIME;
+        }
+        return;
+    }
+
+    sim->state = nRF24L01_SIM_STANDBY;
+    sim->event = NEVER;
+}
+
+static
+uint8_t addr_match(
+    const nRF24L01_sim_t *sim,
+    uint8_t pipe_no,
+    const uint8_t *addr,
+    uint8_t size)
+{
+    if(1 < pipe_no)
+    {
+        /* LSB is unique, rest is shared with pipe 1 */
+        return
+            addr[0] == sim->reg[nRF24L01_ADDR_rx_addr_p(pipe_no)]
+            && !memcmp(addr + 1, sim->rx_addr_p1 + 1, size - 1);
+    }
+    return !memcmp(addr, pipe_no ? sim->rx_addr_p1 : sim->rx_addr_p0, size);
+}
+
+static
+uint8_t collided(const nRF24L01_sim_t *tx, const nRF24L01_sim_t *rx)
+{
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        const nRF24L01_sim_t *other = dev_[i];
+
+        if(!other || other == tx || other == rx || other->air != tx->air) continue;
+        if(!other->stat.tx) continue;
+        if(other->reg[nRF24L01_ADDR_rf_ch] != tx->reg[nRF24L01_ADDR_rf_ch]) continue;
+        if(other->tx_begin < tx->tx_end && tx->tx_begin < other->tx_end) return 1;
+    }
+    return 0;
+}
+
+static
+void deliver(nRF24L01_sim_t *tx, nRF24L01_sim_t *rx, uint8_t ack_req)
+{
+    const uint8_t size = addr_size(tx);
+    const nRF24L01_en_rxaddr_t en_rxaddr = {.value = rx->reg[nRF24L01_ADDR_en_rxaddr]};
+    uint8_t pipe_no = 0;
+
+    /* receiver has to listen since packet start */
+    if(nRF24L01_SIM_RX != rx->state || rx->ready > tx->tx_begin) return;
+    if(rx->reg[nRF24L01_ADDR_rf_ch] != tx->reg[nRF24L01_ADDR_rf_ch]) return;
+    if(data_rate(rx) != data_rate(tx)) return;
+    if(addr_size(rx) != size || crc_size(rx) != crc_size(tx)) return;
+
+    for(; pipe_no < nRF24L01_RX_PIPE_NUM; ++pipe_no)
+    {
+        if(!(en_rxaddr.value & (1 << pipe_no))) continue;
+        if(addr_match(rx, pipe_no, tx->tx_addr, size)) break;
+    }
+    if(nRF24L01_RX_PIPE_NUM == pipe_no) return;
+
+    if(collided(tx, rx))
+    {
+        ++rx->stat.collided;
+        return;
+    }
+
+    if(rnd_lost(tx->air, rate_index(tx)))
+    {
+        ++rx->stat.lost;
+        return;
+    }
+
+    const uint8_t ack = ack_req && (rx->reg[nRF24L01_ADDR_en_aa] & (1 << pipe_no));
+    const nRF24L01_sim_payload_t *head = tx->tx_fifo.payload;
+    nRF24L01_sim_payload_t *last = rx->rx_last + pipe_no;
+
+    /* re-transmission of packet already received (ACK was lost), same PID
+     * and CRC (content) */
+    if(
+        ack
+        && last->pipe_no
+        && head->pid == last->pid
+        && !memcmp(head->data, last->data, PAYLOAD_SIZE))
+    {
+        ++rx->stat.dup;
+        goto ack;
+    }
+
+    if(FIFO_SIZE == rx->rx_fifo.num)
+    {
+        /* no ACK, PTX re-transmits */
+        ++rx->stat.overflow;
+        return;
+    }
+
+    {
+        nRF24L01_sim_payload_t *payload = rx->rx_fifo.payload + rx->rx_fifo.num++;
+
+        payload->pipe_no = pipe_no;
+        memcpy(payload->data, head->data, PAYLOAD_SIZE);
+    }
+    /* pipe_no is used as valid flag */
+    *last = *head;
+    last->pipe_no = ack;
+    ++rx->stat.rx;
+    flag_set(rx, (nRF24L01_status_t){.RX_DR = 1});
+ack:
+    if(ack && !rnd_lost(tx->air, rate_index(tx))) tx->acked = 1;
+}
+
+static
+void tx_begin(nRF24L01_sim_t *sim)
+{
+    if(!sim->tx_fifo.num)
+    {
+        sim->state = nRF24L01_SIM_STANDBY;
+        update(sim);
+        return;
+    }
+
+    sim->state = nRF24L01_SIM_TX;
+    sim->tx_begin = sim->air->now;
+    sim->tx_end = sim->tx_begin + air_time(sim, PAYLOAD_SIZE);
+    sim->event = sim->tx_end;
+    ++sim->stat.tx;
+}
+
+static
+void tx_complete(nRF24L01_sim_t *sim)
+{
+    fifo_pop(&sim->tx_fifo);
+    sim->retry = 0;
+    flag_set(sim, (nRF24L01_status_t){.TX_DS = 1});
+    sim->state = nRF24L01_SIM_STANDBY;
+    update(sim);
+}
+
+static
+void tx_end(nRF24L01_sim_t *sim)
+{
+    const nRF24L01_en_aa_t en_aa = {.value = sim->reg[nRF24L01_ADDR_en_aa]};
+    const uint8_t ack_req = en_aa.ENAA_P0;
+
+    sim->acked = 0;
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        nRF24L01_sim_t *rx = dev_[i];
+
+        if(rx && rx != sim && rx->air == sim->air) deliver(sim, rx, ack_req);
+    }
+
+    if(!ack_req)
+    {
+        tx_complete(sim);
+        return;
+    }
+
+    /* ACK is expected back on pipe 0 */
+    if(memcmp(sim->rx_addr_p0, sim->tx_addr, addr_size(sim))) sim->acked = 0;
+
+    const nRF24L01_setup_retr_t setup_retr = {.value = sim->reg[nRF24L01_ADDR_setup_retr]};
+    const uint32_t ack_time = SETTLE_TIME + air_time(sim, 0);
+
+    sim->state = nRF24L01_SIM_ACK_WAIT;
+    sim->event =
+        sim->tx_end
+        + (
+            sim->acked
+            ? ack_time
+            : MAX(ack_time, (uint32_t)ARD_STEP * (setup_retr.ARD + 1)));
+}
+
+static
+void ack_wait_end(nRF24L01_sim_t *sim)
+{
+    const nRF24L01_setup_retr_t setup_retr = {.value = sim->reg[nRF24L01_ADDR_setup_retr]};
+    nRF24L01_observe_tx_t observe_tx = {.value = sim->reg[nRF24L01_ADDR_observe_tx]};
+
+    if(sim->acked)
+    {
+        observe_tx.ARC_CNT = sim->retry;
+        sim->reg[nRF24L01_ADDR_observe_tx] = observe_tx.value;
+        tx_complete(sim);
+        return;
+    }
+
+    if(sim->retry < setup_retr.ARC)
+    {
+        ++sim->retry;
+        tx_begin(sim);
+        return;
+    }
+
+    /* payload stays in TX FIFO */
+    observe_tx.ARC_CNT = sim->retry;
+    if(15 > observe_tx.PLOS_CNT) ++observe_tx.PLOS_CNT;
+    sim->reg[nRF24L01_ADDR_observe_tx] = observe_tx.value;
+    sim->retry = 0;
+    flag_set(sim, (nRF24L01_status_t){.MAX_RT = 1});
+    sim->state = nRF24L01_SIM_STANDBY;
+    update(sim);
+}
+
+static
+void process(nRF24L01_sim_t *sim)
+{
+    switch(sim->state)
+    {
+        case nRF24L01_SIM_TX_SETTLE: tx_begin(sim); break;
+        case nRF24L01_SIM_TX: tx_end(sim); break;
+        case nRF24L01_SIM_ACK_WAIT: ack_wait_end(sim); break;
+        default: sim->event = NEVER; break;
+    }
+}
+
+static
+void xchg(nRF24L01_sim_t *sim, uint8_t *begin, const uint8_t *const end)
+{
+    if(end == begin) return;
+
+    /* data is exchanged in place */
+    uint8_t in[1 + PAYLOAD_SIZE];
+    const uint8_t size = MIN((size_t)(end - begin) - 1, PAYLOAD_SIZE);
+    const uint8_t cmd = begin[0];
+    uint8_t *out = begin + 1;
+
+    memcpy(in, begin, 1 + size);
+    begin[0] = status(sim);
+
+    if(nRF24L01_W_REGISTER(0) == (cmd & 0xE0))
+    {
+        reg_write(sim, cmd & 0x1F, in + 1, size);
+    }
+    else if(nRF24L01_R_REGISTER(0) == (cmd & 0xE0))
+    {
+        for(uint8_t i = 0; i < size; ++i) out[i] = reg_read(sim, cmd & 0x1F, i);
+    }
+    else if(nRF24L01_R_RX_PAYLOAD == cmd)
+    {
+        if(sim->rx_fifo.num)
+        {
+            memcpy(out, sim->rx_fifo.payload[0].data, size);
+            fifo_pop(&sim->rx_fifo);
+        }
+        else memset(out, 0, size);
+    }
+    else if(nRF24L01_W_TX_PAYLOAD == cmd)
+    {
+        if(FIFO_SIZE > sim->tx_fifo.num)
+        {
+            nRF24L01_sim_payload_t *payload = sim->tx_fifo.payload + sim->tx_fifo.num++;
+
+            /* PID is incremented for every new payload */
+            payload->pid = ++sim->pid & 3;
+            memset(payload->data, 0, PAYLOAD_SIZE);
+            memcpy(payload->data, in + 1, size);
+        }
+    }
+    else if(nRF24L01_FLUSH_TX == cmd)
+    {
+        sim->tx_fifo.num = 0;
+    }
+    else if(nRF24L01_FLUSH_RX == cmd)
+    {
+        sim->rx_fifo.num = 0;
+    }
+    update(sim);
+}
+
+static
+void ce_set(nRF24L01_sim_t *sim, nRF24L01_ce_t ce)
+{
+    sim->ce = ce.CE;
+    update(sim);
+}
+
+#define TRAMPOLINE(i) \
+    static \
+    void spi_xchg_##i(uint8_t *begin, const uint8_t *const end) \
+    { \
+        xchg(dev_[i], begin, end); \
+    } \
+    static \
+    void ce_set_##i(nRF24L01_ce_t ce) \
+    { \
+        ce_set(dev_[i], ce); \
+    }
+
+TRAMPOLINE(0)
+TRAMPOLINE(1)
+TRAMPOLINE(2)
+TRAMPOLINE(3)
+TRAMPOLINE(4)
+TRAMPOLINE(5)
+TRAMPOLINE(6)
+TRAMPOLINE(7)
+TRAMPOLINE(8)
+TRAMPOLINE(9)
+TRAMPOLINE(10)
+TRAMPOLINE(11)
+TRAMPOLINE(12)
+TRAMPOLINE(13)
+TRAMPOLINE(14)
+TRAMPOLINE(15)
+TRAMPOLINE(16)
+TRAMPOLINE(17)
+TRAMPOLINE(18)
+TRAMPOLINE(19)
+TRAMPOLINE(20)
+TRAMPOLINE(21)
+TRAMPOLINE(22)
+TRAMPOLINE(23)
+TRAMPOLINE(24)
+TRAMPOLINE(25)
+TRAMPOLINE(26)
+TRAMPOLINE(27)
+TRAMPOLINE(28)
+TRAMPOLINE(29)
+TRAMPOLINE(30)
+TRAMPOLINE(31)
+TRAMPOLINE(32)
+TRAMPOLINE(33)
+TRAMPOLINE(34)
+TRAMPOLINE(35)
+TRAMPOLINE(36)
+TRAMPOLINE(37)
+TRAMPOLINE(38)
+TRAMPOLINE(39)
+TRAMPOLINE(40)
+TRAMPOLINE(41)
+TRAMPOLINE(42)
+TRAMPOLINE(43)
+TRAMPOLINE(44)
+TRAMPOLINE(45)
+TRAMPOLINE(46)
+TRAMPOLINE(47)
+TRAMPOLINE(48)
+TRAMPOLINE(49)
+TRAMPOLINE(50)
+TRAMPOLINE(51)
+TRAMPOLINE(52)
+TRAMPOLINE(53)
+TRAMPOLINE(54)
+TRAMPOLINE(55)
+TRAMPOLINE(56)
+TRAMPOLINE(57)
+TRAMPOLINE(58)
+TRAMPOLINE(59)
+TRAMPOLINE(60)
+TRAMPOLINE(61)
+TRAMPOLINE(62)
+TRAMPOLINE(63)
+
+static const nRF24L01_spi_xchg_t spi_xchg_[DEV_MAX] =
+{
+    spi_xchg_0, spi_xchg_1, spi_xchg_2, spi_xchg_3,
+    spi_xchg_4, spi_xchg_5, spi_xchg_6, spi_xchg_7,
+    spi_xchg_8, spi_xchg_9, spi_xchg_10, spi_xchg_11,
+    spi_xchg_12, spi_xchg_13, spi_xchg_14, spi_xchg_15,
+    spi_xchg_16, spi_xchg_17, spi_xchg_18, spi_xchg_19,
+    spi_xchg_20, spi_xchg_21, spi_xchg_22, spi_xchg_23,
+    spi_xchg_24, spi_xchg_25, spi_xchg_26, spi_xchg_27,
+    spi_xchg_28, spi_xchg_29, spi_xchg_30, spi_xchg_31,
+    spi_xchg_32, spi_xchg_33, spi_xchg_34, spi_xchg_35,
+    spi_xchg_36, spi_xchg_37, spi_xchg_38, spi_xchg_39,
+    spi_xchg_40, spi_xchg_41, spi_xchg_42, spi_xchg_43,
+    spi_xchg_44, spi_xchg_45, spi_xchg_46, spi_xchg_47,
+    spi_xchg_48, spi_xchg_49, spi_xchg_50, spi_xchg_51,
+    spi_xchg_52, spi_xchg_53, spi_xchg_54, spi_xchg_55,
+    spi_xchg_56, spi_xchg_57, spi_xchg_58, spi_xchg_59,
+    spi_xchg_60, spi_xchg_61, spi_xchg_62, spi_xchg_63
+};
+
+static const nRF24L01_ce_set_t ce_set_[DEV_MAX] =
+{
+    ce_set_0, ce_set_1, ce_set_2, ce_set_3,
+    ce_set_4, ce_set_5, ce_set_6, ce_set_7,
+    ce_set_8, ce_set_9, ce_set_10, ce_set_11,
+    ce_set_12, ce_set_13, ce_set_14, ce_set_15,
+    ce_set_16, ce_set_17, ce_set_18, ce_set_19,
+    ce_set_20, ce_set_21, ce_set_22, ce_set_23,
+    ce_set_24, ce_set_25, ce_set_26, ce_set_27,
+    ce_set_28, ce_set_29, ce_set_30, ce_set_31,
+    ce_set_32, ce_set_33, ce_set_34, ce_set_35,
+    ce_set_36, ce_set_37, ce_set_38, ce_set_39,
+    ce_set_40, ce_set_41, ce_set_42, ce_set_43,
+    ce_set_44, ce_set_45, ce_set_46, ce_set_47,
+    ce_set_48, ce_set_49, ce_set_50, ce_set_51,
+    ce_set_52, ce_set_53, ce_set_54, ce_set_55,
+    ce_set_56, ce_set_57, ce_set_58, ce_set_59,
+    ce_set_60, ce_set_61, ce_set_62, ce_set_63
+};
+
+void nRF24L01_sim_air_init(nRF24L01_sim_air_t *air, uint32_t loss_ppm, uint32_t seed)
+{
+    air->now = 0;
+    air->loss_ppm = loss_ppm;
+    memset(air->rate_loss_ppm, 0, sizeof(air->rate_loss_ppm));
+    air->seed = seed ? seed : 1;
+}
+
+void nRF24L01_sim_init(nRF24L01_sim_t *sim, nRF24L01_sim_air_t *air)
+{
+    memset(sim, 0, sizeof(nRF24L01_sim_t));
+    sim->air = air;
+    sim->state = nRF24L01_SIM_OFF;
+    sim->event = NEVER;
+
+    /* PoR */
+    sim->reg[nRF24L01_ADDR_config] = (nRF24L01_config_t){.EN_CRC = 1}.value;
+    sim->reg[nRF24L01_ADDR_en_aa] = UINT8_C(0x3F);
+    sim->reg[nRF24L01_ADDR_en_rxaddr] = UINT8_C(0x03);
+    sim->reg[nRF24L01_ADDR_setup_aw] = UINT8_C(0x03);
+    sim->reg[nRF24L01_ADDR_setup_retr] = UINT8_C(0x03);
+    sim->reg[nRF24L01_ADDR_rf_ch] = UINT8_C(0x02);
+    sim->reg[nRF24L01_ADDR_rf_setup] = UINT8_C(0x0F);
+    sim->reg[nRF24L01_ADDR_rx_addr_p2] = UINT8_C(0xC3);
+    sim->reg[nRF24L01_ADDR_rx_addr_p3] = UINT8_C(0xC4);
+    sim->reg[nRF24L01_ADDR_rx_addr_p4] = UINT8_C(0xC5);
+    sim->reg[nRF24L01_ADDR_rx_addr_p5] = UINT8_C(0xC6);
+    memset(sim->rx_addr_p0, 0xE7, ADDR_SIZE_MAX);
+    memset(sim->rx_addr_p1, 0xC2, ADDR_SIZE_MAX);
+    memset(sim->tx_addr, 0xE7, ADDR_SIZE_MAX);
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(dev_[i]) continue;
+        dev_[i] = sim;
+        sim->index = i;
+        return;
+    }
+    /* all trampolines taken */
+    sim->index = DEV_MAX;
+}
+
+void nRF24L01_sim_release(nRF24L01_sim_t *sim)
+{
+    if(DEV_MAX > sim->index && sim == dev_[sim->index]) dev_[sim->index] = NULL;
+}
+
+nRF24L01_spi_xchg_t nRF24L01_sim_spi_xchg(const nRF24L01_sim_t *sim)
+{
+    return DEV_MAX > sim->index ? spi_xchg_[sim->index] : NULL;
+}
+
+nRF24L01_ce_set_t nRF24L01_sim_ce_set(const nRF24L01_sim_t *sim)
+{
+    return DEV_MAX > sim->index ? ce_set_[sim->index] : NULL;
+}
+
+uint8_t nRF24L01_sim_irq(const nRF24L01_sim_t *sim)
+{
+    const nRF24L01_config_t cfg = config(sim);
+    const nRF24L01_status_t flags = {.value = sim->reg[nRF24L01_ADDR_status]};
+
+    return
+        (flags.RX_DR && !cfg.MASK_RX_DR)
+        || (flags.TX_DS && !cfg.MASK_TX_DS)
+        || (flags.MAX_RT && !cfg.MASK_MAX_RT);
+}
+
+uint64_t nRF24L01_sim_next(const nRF24L01_sim_air_t *air)
+{
+    uint64_t next = NEVER;
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        if(dev_[i] && air == dev_[i]->air) next = MIN(next, dev_[i]->event);
+    }
+    return next;
+}
+
+static
+void account(nRF24L01_sim_air_t *air, uint64_t time)
+{
+    if(time <= air->now) return;
+
+    const uint64_t elapsed = time - air->now;
+
+    for(uint8_t i = 0; i < DEV_MAX; ++i)
+    {
+        nRF24L01_sim_t *sim = dev_[i];
+
+        if(!sim || air != sim->air) continue;
+
+        switch(sim->state)
+        {
+            case nRF24L01_SIM_OFF: sim->stat.off_us += elapsed; break;
+            case nRF24L01_SIM_STANDBY: sim->stat.standby_us += elapsed; break;
+            case nRF24L01_SIM_RX:
+            case nRF24L01_SIM_ACK_WAIT: sim->stat.rx_us += elapsed; break;
+            default: sim->stat.tx_us += elapsed; break;
+        }
+    }
+}
+
+void nRF24L01_sim_run(nRF24L01_sim_air_t *air, uint64_t time)
+{
+    for(;;)
+    {
+        nRF24L01_sim_t *sim = NULL;
+
+        for(uint8_t i = 0; i < DEV_MAX; ++i)
+        {
+            if(!dev_[i] || air != dev_[i]->air || time < dev_[i]->event) continue;
+            if(!sim || dev_[i]->event < sim->event) sim = dev_[i];
+        }
+        if(!sim) break;
+
+        account(air, sim->event);
+        air->now = MAX(air->now, sim->event);
+        process(sim);
+    }
+    account(air, time);
+    air->now = MAX(air->now, time);
+}
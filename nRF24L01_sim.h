@@ -0,0 +1,118 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Simulated nRF24L01 (host only).
+ *
+ * Register file, 3 level TX/RX FIFOs and Enhanced ShockBurst (auto ACK,
+ * auto re-transmit, duplicate detection by PID) are modeled at SPI command
+ * level so real driver (nRF24L01.c) runs on top of it unmodified.
+ *
+ * Devices share air (virtual time in us): packet is delivered to devices
+ * in RX mode (settled before packet started) on same channel and data rate
+ * with matching pipe address, packets overlapping in time on same channel
+ * collide, every packet (including ACK) is lost with loss_ppm probability
+ * plus rate_loss_ppm of its data rate (weak link: lower rate has better
+ * sensitivity).
+ * Air time follows data rate, 130us settling is applied on every switch to
+ * RX/TX mode and 1.5ms on power up. Time spent in every power state is
+ * accounted (stat) so average current can be derived.
+ *
+ * spi_xchg/ce_set callbacks have no context so every device is bound to
+ * static trampoline, at most nRF24L01_SIM_DEV_MAX devices exist at a time. */
+
+#define nRF24L01_SIM_DEV_MAX 64
+#define nRF24L01_SIM_FIFO_SIZE 3
+#define nRF24L01_SIM_REG_NUM (nRF24L01_ADDR_fifo_status + 1)
+#define nRF24L01_SIM_NEVER UINT64_MAX
+
+typedef struct
+{
+    uint8_t pipe_no; // RX
+    uint8_t pid; // TX, packet id (2 bits)
+    uint8_t data[nRF24L01_PAYLOAD_SIZE];
+} nRF24L01_sim_payload_t;
+
+typedef struct
+{
+    nRF24L01_sim_payload_t payload[nRF24L01_SIM_FIFO_SIZE];
+    uint8_t num;
+} nRF24L01_sim_fifo_t;
+
+#define nRF24L01_SIM_RATE_250K 0
+#define nRF24L01_SIM_RATE_1M 1
+#define nRF24L01_SIM_RATE_2M 2
+#define nRF24L01_SIM_RATE_NUM 3
+
+typedef struct
+{
+    uint64_t now; // us
+    uint32_t loss_ppm;
+    uint32_t rate_loss_ppm[nRF24L01_SIM_RATE_NUM]; // 0 after init
+    uint32_t seed; // PRNG state
+} nRF24L01_sim_air_t;
+
+typedef enum
+{
+    nRF24L01_SIM_OFF,
+    nRF24L01_SIM_STANDBY,
+    nRF24L01_SIM_RX,
+    nRF24L01_SIM_TX_SETTLE,
+    nRF24L01_SIM_TX,
+    nRF24L01_SIM_ACK_WAIT
+} nRF24L01_sim_state_t;
+
+typedef struct
+{
+    nRF24L01_sim_air_t *air;
+    uint8_t index; // trampoline
+    uint8_t reg[nRF24L01_SIM_REG_NUM];
+    uint8_t rx_addr_p0[5];
+    uint8_t rx_addr_p1[5];
+    uint8_t tx_addr[5];
+    nRF24L01_sim_fifo_t tx_fifo;
+    nRF24L01_sim_fifo_t rx_fifo;
+    nRF24L01_sim_state_t state;
+    uint8_t ce;
+    uint8_t pid; // PID of last payload written
+    uint8_t retry;
+    uint8_t acked; // ACK of last transmitted packet will be received
+    nRF24L01_sim_payload_t rx_last[nRF24L01_RX_PIPE_NUM]; // duplicate detection
+    uint64_t ready; // power up / RX settling done at
+    uint64_t event; // next state transition
+    uint64_t tx_begin; // air time of last transmitted packet
+    uint64_t tx_end;
+    struct
+    {
+        uint32_t tx; // packets on air (including re-transmits)
+        uint32_t rx; // packets stored in RX FIFO
+        uint32_t lost; // dropped by loss model
+        uint32_t collided;
+        uint32_t overflow; // dropped, RX FIFO full
+        uint32_t dup; // dropped, duplicate (ACK re-sent)
+        /* time per power state (us), crystal start-up counts as standby,
+         * waiting for ACK as RX, TX settling as TX */
+        uint64_t off_us;
+        uint64_t standby_us;
+        uint64_t rx_us;
+        uint64_t tx_us;
+    } stat;
+} nRF24L01_sim_t;
+
+void nRF24L01_sim_air_init(nRF24L01_sim_air_t *, uint32_t loss_ppm, uint32_t seed);
+
+/* device is in PoR state */
+void nRF24L01_sim_init(nRF24L01_sim_t *, nRF24L01_sim_air_t *);
+void nRF24L01_sim_release(nRF24L01_sim_t *);
+
+nRF24L01_spi_xchg_t nRF24L01_sim_spi_xchg(const nRF24L01_sim_t *);
+nRF24L01_ce_set_t nRF24L01_sim_ce_set(const nRF24L01_sim_t *);
+
+/* IRQ pin asserted (active low on real device) */
+uint8_t nRF24L01_sim_irq(const nRF24L01_sim_t *);
+
+/* time of next event of all devices (nRF24L01_SIM_NEVER if none) */
+uint64_t nRF24L01_sim_next(const nRF24L01_sim_air_t *);
+
+/* process all events up to time and advance air time to it */
+void nRF24L01_sim_run(nRF24L01_sim_air_t *, uint64_t time);
@@ -0,0 +1,54 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nRF24L01_sim_bench.h"
+
+void nRF24L01_sim_bench_init(nRF24L01_t *dev, nRF24L01_sim_t *sim, nRF24L01_sim_air_t *air)
+{
+    nRF24L01_sim_init(sim, air);
+    nRF24L01_init(dev, nRF24L01_sim_ce_set(sim), nRF24L01_sim_spi_xchg(sim));
+    nRF24L01_CFG(
+        dev, config,
+        .PRIM_RX = 0,
+        .PWR_UP = 1,
+        .CRCO = 1,
+        .EN_CRC = 1,
+        .MASK_MAX_RT = 0,
+        .MASK_TX_DS = 0,
+        .MASK_RX_DR = 0);
+    nRF24L01_CFG(dev, setup_aw, .AW = 3);
+    nRF24L01_CFG(dev, rf_ch, .RF_CH = 1);
+    nRF24L01_CFG(dev, en_aa, .ENAA_P0 = 0);
+    nRF24L01_CFG(dev, en_rxaddr, .ERX_P0 = 1);
+    nRF24L01_CFG(dev, setup_retr, .ARC = 0, .ARD = 0);
+    nRF24L01_CFG(
+        dev, rf_setup,
+        .RF_PWR = 3,
+        .RF_DR_HIGH = 1,
+        .PLL_LOCK = 0,
+        .RF_DR_LOW = 0,
+        .CONT_WAVE = 0);
+    nRF24L01_CFG(dev, rx_addr_p0, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+    nRF24L01_CFG(dev, tx_addr, .addr = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7});
+}
+
+void nRF24L01_sim_bench_dispatch(nRF24L01_t *dev, const nRF24L01_sim_t *sim)
+{
+    for(uint8_t i = 0; i < nRF24L01_SIM_BENCH_DISPATCH_MAX && nRF24L01_sim_irq(sim); ++i)
+    {
+        dev->updated = 1;
+        nRF24L01_event(dev);
+    }
+}
+
+void nRF24L01_sim_bench_fail(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    exit(EXIT_FAILURE);
+}
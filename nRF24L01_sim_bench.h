@@ -0,0 +1,24 @@
+#pragma once
+
+#include "nRF24L01.h"
+#include "nRF24L01_sim.h"
+#include "xorshift.h"
+
+/* Common fixture of host benches against simulated radios (nRF24L01_sim).
+ *
+ * init() binds sim to air and driver to sim, radio is powered up as PTX
+ * with 2B CRC, 5B address E7E7E7E7E7 on pipe 0 (enabled) and TX, channel 1,
+ * 2Mbps, 0dBm, no auto ACK and re-transmit. Bench reconfigures registers
+ * it needs different afterwards. */
+
+#define nRF24L01_SIM_BENCH_DISPATCH_MAX 8
+
+void nRF24L01_sim_bench_init(nRF24L01_t *, nRF24L01_sim_t *, nRF24L01_sim_air_t *);
+
+/* dispatches events while IRQ is asserted (same as firmware main loop),
+ * at most DISPATCH_MAX so stuck IRQ does not hang bench */
+void nRF24L01_sim_bench_dispatch(nRF24L01_t *, const nRF24L01_sim_t *);
+
+/* prints message (newline appended) to stderr and exits with failure */
+__attribute__((noreturn, format(printf, 1, 2)))
+void nRF24L01_sim_bench_fail(const char *format, ...);
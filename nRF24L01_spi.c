@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "nRF24L01_spi.h"
+
+#define ADDR_SIZE sizeof(nRF24L01_addr40_t)
+#define ROUNDS nRF24L01_SPI_ROUNDS
+
+static const uint8_t reg_[] =
+{
+    nRF24L01_ADDR_tx_addr,
+    nRF24L01_ADDR_rx_addr_p0,
+    nRF24L01_ADDR_rx_addr_p1
+};
+#define REG_NUM sizeof(reg_)
+
+static const uint8_t pattern_[][ADDR_SIZE] =
+{
+    {0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0x55, 0xAA, 0x55, 0xAA, 0x55},
+    {0xAA, 0x55, 0xAA, 0x55, 0xAA},
+    {0x01, 0x02, 0x04, 0x08, 0x10},
+    {0xFE, 0xFD, 0xFB, 0xF7, 0xEF},
+    {0x80, 0x40, 0x20, 0x10, 0x08},
+    {0x7F, 0xBF, 0xDF, 0xEF, 0xF7}
+};
+#define PATTERN_NUM (sizeof(pattern_) / sizeof(pattern_[0]))
+
+/* returns 0 if reserved STATUS bit (always 0) is set */
+static
+uint8_t read_addr(nRF24L01_t *dev, uint8_t addr, uint8_t *dst)
+{
+    uint8_t xdata[1 + ADDR_SIZE];
+
+    memset(xdata, nRF24L01_NOP, sizeof(xdata));
+    xdata[0] = nRF24L01_R_REGISTER(addr);
+    dev->spi_xchg(xdata, xdata + sizeof(xdata));
+    memcpy(dst, xdata + 1, ADDR_SIZE);
+    return !(xdata[0] & 0x80);
+}
+
+static
+uint8_t self_test(nRF24L01_t *dev, uint8_t rounds)
+{
+    uint8_t value[ADDR_SIZE];
+
+    for(uint8_t round = 0; round < rounds; ++round)
+    {
+        for(uint8_t i = 0; i < PATTERN_NUM; ++i)
+        {
+            /* neighbours hold different patterns */
+            for(uint8_t j = 0; j < REG_NUM; ++j)
+            {
+                const uint8_t *pattern = pattern_[(i + j) % PATTERN_NUM];
+
+                nRF24L01_write_register(dev, reg_[j], pattern, pattern + ADDR_SIZE);
+            }
+            for(uint8_t j = 0; j < REG_NUM; ++j)
+            {
+                if(!read_addr(dev, reg_[j], value)) return 0;
+                if(memcmp(value, pattern_[(i + j) % PATTERN_NUM], ADDR_SIZE)) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void nRF24L01_spi_init(
+    nRF24L01_spi_t *spi,
+    nRF24L01_t *dev,
+    nRF24L01_spi_clock_t clock,
+    uint8_t level_num,
+    uint8_t cap)
+{
+    memset(spi, 0, sizeof(nRF24L01_spi_t));
+    spi->dev = dev;
+    spi->clock = clock;
+    spi->cap = cap < level_num ? cap : level_num - 1;
+}
+
+uint8_t nRF24L01_spi_calibrate(nRF24L01_spi_t *spi)
+{
+    nRF24L01_t *dev = spi->dev;
+    uint8_t saved[REG_NUM][ADDR_SIZE];
+    const uint8_t setup_aw = nRF24L01_read_register(dev, nRF24L01_ADDR_setup_aw);
+    const nRF24L01_setup_aw_t aw = {.AW = 3};
+    uint8_t ok = 0;
+
+    (*spi->clock)(0);
+    spi->level = 0;
+    /* addresses are read/written as wide as SETUP_AW */
+    nRF24L01_write_register(dev, nRF24L01_ADDR_setup_aw, &aw.value, &aw.value + 1);
+    for(uint8_t j = 0; j < REG_NUM; ++j) read_addr(dev, reg_[j], saved[j]);
+
+    /* wiring check only, slowest level takes long */
+    if(!self_test(dev, 1)) goto exit;
+    ok = 1;
+
+    for(uint8_t level = 1; level <= spi->cap; ++level)
+    {
+        (*spi->clock)(level);
+        if(!self_test(dev, ROUNDS)) break;
+        spi->level = level;
+    }
+
+exit:
+    (*spi->clock)(spi->level);
+    for(uint8_t j = 0; j < REG_NUM; ++j)
+    {
+        nRF24L01_write_register(dev, reg_[j], saved[j], saved[j] + ADDR_SIZE);
+    }
+    nRF24L01_write_register(dev, nRF24L01_ADDR_setup_aw, &setup_aw, &setup_aw + 1);
+    spi->fail = 0;
+    spi->pass = 0;
+    return ok;
+}
+
+uint8_t nRF24L01_spi_verify(nRF24L01_spi_t *spi)
+{
+    uint8_t first[ADDR_SIZE];
+    uint8_t second[ADDR_SIZE];
+
+    ++spi->stat.verify;
+    if(
+        read_addr(spi->dev, nRF24L01_ADDR_tx_addr, first)
+        && read_addr(spi->dev, nRF24L01_ADDR_tx_addr, second)
+        && !memcmp(first, second, ADDR_SIZE))
+    {
+        /* sporadic failures add up until enough passes in row */
+        if(nRF24L01_SPI_PASS_MIN > spi->pass) ++spi->pass;
+        else spi->fail = 0;
+        return 1;
+    }
+
+    ++spi->stat.fail;
+    spi->pass = 0;
+    if(nRF24L01_SPI_FAIL_MAX <= ++spi->fail && spi->level)
+    {
+        --spi->level;
+        spi->cap = spi->level;
+        spi->fail = 0;
+        ++spi->stat.fallback;
+        (*spi->clock)(spi->level);
+    }
+    return 0;
+}
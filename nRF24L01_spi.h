@@ -0,0 +1,62 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* SPI link self-test and clock calibration.
+ *
+ * Platform provides SPI clock levels (0 slowest, i.e. dividers of MCU
+ * clock, nRF24L01 accepts up to 8MHz) by callback. Calibration (radio in
+ * power down/standby, before configuration as registers are rewritten)
+ * writes patterns (solid, alternating, walking bits) to 5B address
+ * registers (TX_ADDR, RX_ADDR_P0/P1, SETUP_AW forced to 5B) and reads them
+ * back once at level 0 (wiring check) and then nRF24L01_SPI_ROUNDS times at
+ * every faster level up to cap, fastest level which passed (all slower ones
+ * passed too) is selected, original register values are restored.
+ *
+ * Wiring degrades (temperature, supply) so run-time verify (no register is
+ * written, safe in any mode) reads TX_ADDR twice and checks reserved STATUS
+ * bit: nRF24L01_SPI_FAIL_MAX failures (not separated by
+ * nRF24L01_SPI_PASS_MIN passes in row) step clock one level down and lower
+ * cap, any SPI error corrupts data silently (radio CRC covers air only).
+ * Cap is meant to be stored (i.e. EEPROM) and passed to next calibration so
+ * level found unreliable at run-time is not selected again. */
+
+#define nRF24L01_SPI_ROUNDS 32
+#define nRF24L01_SPI_FAIL_MAX 3
+#define nRF24L01_SPI_PASS_MIN 255
+
+typedef
+void (*nRF24L01_spi_clock_t)(uint8_t level);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_spi_clock_t clock;
+    uint8_t level; // selected
+    uint8_t cap; // highest level allowed
+    uint8_t fail; // verify failures
+    uint8_t pass; // verify passes in row
+    struct
+    {
+        uint16_t verify;
+        uint16_t fail; // verify failed
+        uint8_t fallback; // level stepped down
+    } stat;
+} nRF24L01_spi_t;
+
+/* level_num: levels provided by clock callback, cap: stored one (level_num
+ * or more if none) */
+void nRF24L01_spi_init(
+    nRF24L01_spi_t *,
+    nRF24L01_t *,
+    nRF24L01_spi_clock_t,
+    uint8_t level_num,
+    uint8_t cap);
+
+/* selects and sets fastest reliable level, returns 0 if self-test fails
+ * even at level 0 (no radio, broken wiring) */
+uint8_t nRF24L01_spi_calibrate(nRF24L01_spi_t *);
+
+/* returns 0 if verification failed, level is stepped down after
+ * nRF24L01_SPI_FAIL_MAX failures in row (check cap afterwards) */
+uint8_t nRF24L01_spi_verify(nRF24L01_spi_t *);
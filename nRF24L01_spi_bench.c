@@ -0,0 +1,145 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_sim.h"
+#include "nRF24L01_spi.h"
+#include "xorshift.h"
+
+/* SPI clock calibration benchmark against simulated radio (nRF24L01_sim).
+ *
+ * SPI levels of ATmega328p @ 16MHz (divider 128 - 2: 125kHz - 8MHz).
+ * Board models corrupt bits of SPI bytes (both directions) with probability
+ * per level: up to reliable level none, above it wiring errs more the faster
+ * clock is. Degrading board starts clean and errs at 8MHz after calibration
+ * (i.e. warmed up). Calibration is followed by periodic verify.
+ *
+ * Reported: selected level (SPI clock), wire time of 33B payload transfer
+ * (W_TX_PAYLOAD) and speed-up against fixed 1MHz, verify failures and
+ * fallbacks, final level.
+ *
+ * usage: nRF24L01_spi_bench [seed [verify_num]] */
+
+#define LEVEL_NUM 7
+#define LEVEL_1MHZ 3
+#define PAYLOAD_XCHG_SIZE (1 + nRF24L01_PAYLOAD_SIZE)
+
+static const uint32_t khz_[LEVEL_NUM] = {125, 250, 500, 1000, 2000, 4000, 8000};
+
+typedef struct
+{
+    const char *name;
+    uint32_t err_ppm[LEVEL_NUM]; // per byte
+    uint32_t err_after_ppm[LEVEL_NUM]; // once calibrated
+} board_t;
+
+static const board_t board_[] =
+{
+    {"short", {0}, {0}},
+    {"dupont_10cm", {0, 0, 0, 0, 0, 0, 20000}, {0, 0, 0, 0, 0, 0, 20000}},
+    {"dupont_30cm", {0, 0, 0, 0, 0, 500, 50000}, {0, 0, 0, 0, 0, 500, 50000}},
+    {"degrading", {0}, {0, 0, 0, 0, 0, 0, 10000}}
+};
+#define BOARD_NUM (sizeof(board_) / sizeof(board_[0]))
+
+static nRF24L01_sim_air_t air;
+static nRF24L01_sim_t sim_;
+static nRF24L01_spi_xchg_t sim_xchg_;
+static const uint32_t *err_ppm_;
+static uint8_t level_;
+static uint32_t seed_ = 1;
+
+static
+uint32_t rnd(void)
+{
+    return xorshift32(&seed_);
+}
+
+static
+void corrupt(uint8_t *begin, const uint8_t *const end)
+{
+    const uint32_t ppm = err_ppm_[level_];
+
+    if(!ppm) return;
+    for(; begin != end; ++begin)
+    {
+        if(rnd() % 1000000 < ppm) *begin ^= 1 << (rnd() & 7);
+    }
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    /* command byte is not corrupted (would hit other registers) */
+    if(end - begin > 1) corrupt(begin + 1, end);
+    (*sim_xchg_)(begin, end);
+    corrupt(begin, end);
+}
+
+static
+void spi_clock(uint8_t level)
+{
+    level_ = level;
+}
+
+static
+void run(const board_t *board, uint32_t verify_num)
+{
+    nRF24L01_t dev;
+    nRF24L01_spi_t spi;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    nRF24L01_sim_init(&sim_, &air);
+    sim_xchg_ = nRF24L01_sim_spi_xchg(&sim_);
+    err_ppm_ = board->err_ppm;
+    nRF24L01_init(&dev, nRF24L01_sim_ce_set(&sim_), spi_xchg);
+    nRF24L01_spi_init(&spi, &dev, spi_clock, LEVEL_NUM, UINT8_MAX);
+
+    const uint8_t ok = nRF24L01_spi_calibrate(&spi);
+    const uint8_t calibrated = spi.level;
+
+    err_ppm_ = board->err_after_ppm;
+    for(uint32_t i = 0; i < verify_num; ++i) nRF24L01_spi_verify(&spi);
+
+    const double wire_us = PAYLOAD_XCHG_SIZE * 8 * 1000.0 / khz_[calibrated];
+    const double wire_1mhz_us = PAYLOAD_XCHG_SIZE * 8 * 1000.0 / khz_[LEVEL_1MHZ];
+
+    printf(
+        "{\"board\":\"%s\",\"ok\":%" PRIu8 ",\"level\":%" PRIu8 ",\"spi_khz\":%" PRIu32
+        ",\"payload_us\":%.1f,\"speedup\":%.1f,\"verify\":%" PRIu16 ",\"fail\":%" PRIu16
+        ",\"fallback\":%" PRIu8 ",\"final_khz\":%" PRIu32 ",\"cap\":%" PRIu8 "}\n",
+        board->name,
+        ok,
+        calibrated,
+        khz_[calibrated],
+        wire_us,
+        wire_1mhz_us / wire_us,
+        spi.stat.verify,
+        spi.stat.fail,
+        spi.stat.fallback,
+        khz_[spi.level],
+        spi.cap);
+
+    nRF24L01_sim_release(&sim_);
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t seed = 1 < argc ? strtoul(argv[1], NULL, 0) : 1;
+    const uint32_t verify_num = 2 < argc ? strtoul(argv[2], NULL, 0) : 1000;
+
+    if(!verify_num || verify_num > UINT16_MAX)
+    {
+        fprintf(stderr, "usage: %s [seed [verify_num]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(uint8_t i = 0; i < BOARD_NUM; ++i)
+    {
+        seed_ = seed ? seed : 1;
+        run(board_ + i, verify_num);
+    }
+    return EXIT_SUCCESS;
+}
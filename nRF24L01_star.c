@@ -0,0 +1,464 @@
+#include <string.h>
+
+#include "nRF24L01_star.h"
+
+#define FRAME_SIZE nRF24L01_STAR_FRAME_SIZE
+#define PIPE_NUM nRF24L01_RX_PIPE_NUM
+#define ADDR_LSB nRF24L01_STAR_ADDR_LSB
+
+#define TYPE_JOIN_REQ UINT8_C(0x4A) // 'J'
+#define TYPE_JOIN_ACK UINT8_C(0x41) // 'A'
+
+typedef union
+{
+    struct
+    {
+        uint8_t type;
+        uint8_t id[4]; // LSB first
+    } req;
+    struct
+    {
+        uint8_t type;
+        uint8_t id[4]; // LSB first
+        uint8_t pipe_no;
+        nRF24L01_addr40_t addr;
+    } ack;
+    uint8_t byte[0];
+} join_t;
+
+static
+void id_store(uint8_t *dst, uint32_t id)
+{
+    for(uint8_t i = 0; i < 4; ++i, id >>= 8) dst[i] = id;
+}
+
+static
+uint32_t id_load(const uint8_t *src)
+{
+    uint32_t id = 0;
+
+    for(uint8_t i = 4; i; --i) id = (id << 8) | src[i - 1];
+    return id;
+}
+
+static
+void addr_write(nRF24L01_t *dev, uint8_t reg, const nRF24L01_addr40_t *addr)
+{
+    nRF24L01_write_register(dev, reg, addr->addr, addr->addr + sizeof(addr->addr));
+}
+
+/* gateway ------------------------------------------------------------------*/
+
+static
+nRF24L01_addr40_t pipe_addr(const nRF24L01_star_gw_t *gw, uint8_t pipe_no)
+{
+    nRF24L01_addr40_t addr = {.addr = {ADDR_LSB(pipe_no)}};
+
+    memcpy(addr.addr + 1, gw->base, sizeof(gw->base));
+    return addr;
+}
+
+/* pipe 0 either listens on join address or is assigned to a node */
+static
+void update_rx(nRF24L01_star_gw_t *gw)
+{
+    nRF24L01_en_rxaddr_t en_rxaddr = {.ERX_P0 = 1};
+
+    for(uint8_t i = 1; i < PIPE_NUM; ++i)
+    {
+        if(gw->pipe[i].assigned) en_rxaddr.value |= 1 << i;
+    }
+
+    if(gw->pipe[0].assigned)
+    {
+        const nRF24L01_addr40_t addr = pipe_addr(gw, 0);
+        addr_write(gw->dev, nRF24L01_ADDR_rx_addr_p0, &addr);
+    }
+    else addr_write(gw->dev, nRF24L01_ADDR_rx_addr_p0, &gw->join_addr);
+
+    nRF24L01_write_register(
+        gw->dev, nRF24L01_ADDR_en_rxaddr,
+        en_rxaddr.byte, en_rxaddr.byte + sizeof(en_rxaddr));
+}
+
+static
+void gw_on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void gw_on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void gw_listen(nRF24L01_star_gw_t *gw)
+{
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        gw->dev,
+        gw->frame, gw->frame + FRAME_SIZE,
+        gw_on_frame,
+        gw_on_rx_error,
+        (uintptr_t)gw);
+}
+
+static
+void gw_on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    gw_listen((nRF24L01_star_gw_t *)user_data);
+}
+
+static
+void gw_on_join_sent(uintptr_t user_data)
+{
+    nRF24L01_star_gw_t *gw = (nRF24L01_star_gw_t *)user_data;
+
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    update_rx(gw);
+    gw_listen(gw);
+}
+
+static
+void gw_on_join_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    /* node will retry, assignment is kept */
+    gw_on_join_sent(user_data);
+}
+
+static
+void gw_on_join(nRF24L01_star_gw_t *gw, uint8_t size)
+{
+    join_t *join = (join_t *)gw->frame;
+
+    if(sizeof(join->req) > size || TYPE_JOIN_REQ != join->req.type) goto listen;
+
+    const uint32_t id = id_load(join->req.id);
+    uint8_t pipe_no = PIPE_NUM;
+
+    /* same node joining again (i.e. after reset) keeps its pipe */
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        if(gw->pipe[i].assigned && id == gw->pipe[i].node_id) pipe_no = i;
+    }
+
+    /* pipe 0 is assigned last as it is also used for joining */
+    for(uint8_t i = 1; PIPE_NUM == pipe_no && i <= PIPE_NUM; ++i)
+    {
+        if(!gw->pipe[i % PIPE_NUM].assigned) pipe_no = i % PIPE_NUM;
+    }
+
+    if(PIPE_NUM == pipe_no) goto listen;
+
+    nRF24L01_star_pipe_t *pipe = gw->pipe + pipe_no;
+
+    pipe->node_id = id;
+    pipe->idle = 0;
+    pipe->full = 0;
+    pipe->assigned = 1;
+
+    join->ack.type = TYPE_JOIN_ACK;
+    join->ack.pipe_no = pipe_no;
+    join->ack.addr = pipe_addr(gw, pipe_no);
+
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    addr_write(gw->dev, nRF24L01_ADDR_tx_addr, &gw->join_addr);
+    nRF24L01_send(
+        gw->dev,
+        join->byte, join->byte + sizeof(join->ack),
+        gw_on_join_sent,
+        gw_on_join_error,
+        (uintptr_t)gw);
+    return;
+listen:
+    gw_listen(gw);
+}
+
+static
+void gw_on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_star_gw_t *gw = (nRF24L01_star_gw_t *)user_data;
+    const uint8_t size = curr - gw->frame;
+
+    if(PIPE_NUM <= pipe_no) goto listen;
+
+    nRF24L01_star_pipe_t *pipe = gw->pipe + pipe_no;
+
+    if(!pipe->assigned)
+    {
+        if(0 == pipe_no)
+        {
+            gw_on_join(gw, size);
+            return;
+        }
+        goto listen;
+    }
+
+    pipe->idle = 0;
+    if(pipe->full) ++pipe->dropped;
+    else
+    {
+        memcpy(pipe->buf, gw->frame, size);
+        pipe->size = size;
+        pipe->full = 1;
+    }
+listen:
+    gw_listen(gw);
+}
+
+static
+void gw_tx_complete(nRF24L01_star_gw_t *gw)
+{
+    gw->tx.begin = NULL;
+    gw->tx.end = NULL;
+    gw->tx.cb = NULL;
+    gw->tx.err_cb = NULL;
+    gw->tx.user_data = 0;
+
+    /* restore pipe 0 address used for ACK reception */
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    update_rx(gw);
+    gw_listen(gw);
+}
+
+static
+void gw_on_sent(uintptr_t user_data)
+{
+    nRF24L01_star_gw_t *gw = (nRF24L01_star_gw_t *)user_data;
+    const nRF24L01_send_cb_t cb = gw->tx.cb;
+    const uintptr_t tx_user_data = gw->tx.user_data;
+
+    gw_tx_complete(gw);
+    if(cb) (*cb)(tx_user_data);
+}
+
+static
+void gw_on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_star_gw_t *gw = (nRF24L01_star_gw_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = gw->tx.err_cb;
+    const uintptr_t tx_user_data = gw->tx.user_data;
+
+    gw_tx_complete(gw);
+    if(err_cb) (*err_cb)(status, fifo_status, tx_user_data);
+}
+
+void nRF24L01_star_gw_init(
+    nRF24L01_star_gw_t *gw,
+    nRF24L01_t *dev,
+    const uint8_t *join_addr,
+    const uint8_t *base,
+    uint8_t idle_max)
+{
+    memset(gw, 0, sizeof(nRF24L01_star_gw_t));
+    gw->dev = dev;
+    memcpy(gw->join_addr.addr, join_addr, sizeof(gw->join_addr.addr));
+    memcpy(gw->base, base, sizeof(gw->base));
+    gw->idle_max = idle_max;
+}
+
+void nRF24L01_star_gw_start(nRF24L01_star_gw_t *gw)
+{
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+
+    /* pipes 2-5 share upper 4 bytes with pipe 1 */
+    const nRF24L01_addr40_t addr = pipe_addr(gw, 1);
+
+    addr_write(gw->dev, nRF24L01_ADDR_rx_addr_p1, &addr);
+    for(uint8_t i = 2; i < PIPE_NUM; ++i)
+    {
+        const uint8_t lsb = ADDR_LSB(i);
+        nRF24L01_write_register(gw->dev, nRF24L01_ADDR_rx_addr_p(i), &lsb, &lsb + 1);
+    }
+    update_rx(gw);
+    gw_listen(gw);
+}
+
+void nRF24L01_star_gw_poll(
+    nRF24L01_star_gw_t *gw,
+    nRF24L01_star_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        const uint8_t pipe_no = (gw->rr + i) % PIPE_NUM;
+        nRF24L01_star_pipe_t *pipe = gw->pipe + pipe_no;
+
+        if(!pipe->full) continue;
+        if(cb) (*cb)(pipe->buf, pipe->buf + pipe->size, pipe_no, pipe->node_id, user_data);
+        pipe->full = 0;
+    }
+    gw->rr = (gw->rr + 1) % PIPE_NUM;
+}
+
+void nRF24L01_star_gw_send(
+    nRF24L01_star_gw_t *gw,
+    uint8_t pipe_no,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    gw->tx.begin = begin;
+    gw->tx.end = end;
+    gw->tx.cb = cb;
+    gw->tx.err_cb = err_cb;
+    gw->tx.user_data = user_data;
+
+    const nRF24L01_addr40_t addr = pipe_addr(gw, pipe_no);
+
+    gw->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    /* pipe 0 has to match tx_addr to receive auto ACK */
+    addr_write(gw->dev, nRF24L01_ADDR_tx_addr, &addr);
+    addr_write(gw->dev, nRF24L01_ADDR_rx_addr_p0, &addr);
+    nRF24L01_send(gw->dev, begin, end, gw_on_sent, gw_on_send_error, (uintptr_t)gw);
+}
+
+void nRF24L01_star_gw_tick(nRF24L01_star_gw_t *gw)
+{
+    if(!gw->idle_max) return;
+
+    uint8_t released = 0;
+
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        nRF24L01_star_pipe_t *pipe = gw->pipe + i;
+
+        if(!pipe->assigned || ++pipe->idle < gw->idle_max) continue;
+        pipe->assigned = 0;
+        released = 1;
+    }
+    /* do not touch addresses while downlink is in flight */
+    if(released && !gw->tx.begin) update_rx(gw);
+}
+
+/* node ---------------------------------------------------------------------*/
+
+static
+void node_send_request(nRF24L01_star_node_t *);
+
+static
+void node_on_reply(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data);
+
+static
+void node_listen(nRF24L01_star_node_t *node)
+{
+    node->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        node->dev,
+        node->frame, node->frame + FRAME_SIZE,
+        node_on_reply,
+        NULL,
+        (uintptr_t)node);
+}
+
+static
+void node_on_request_sent(uintptr_t user_data)
+{
+    node_listen((nRF24L01_star_node_t *)user_data);
+}
+
+static
+void node_on_reply(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_star_node_t *node = (nRF24L01_star_node_t *)user_data;
+    const join_t *join = (const join_t *)node->frame;
+
+    if(!node->joining) return;
+
+    if(
+        sizeof(join->ack) > (size_t)(curr - node->frame)
+        || TYPE_JOIN_ACK != join->ack.type
+        || node->id != id_load(join->ack.id)
+        || PIPE_NUM <= join->ack.pipe_no)
+    {
+        node_listen(node);
+        return;
+    }
+
+    node->addr = join->ack.addr;
+    node->pipe_no = join->ack.pipe_no;
+    node->joining = 0;
+    node->joined = 1;
+
+    node->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    addr_write(node->dev, nRF24L01_ADDR_tx_addr, &node->addr);
+    addr_write(node->dev, nRF24L01_ADDR_rx_addr_p0, &node->addr);
+
+    if(node->cb) (*node->cb)(node->pipe_no, node->user_data);
+}
+
+static
+void node_send_request(nRF24L01_star_node_t *node)
+{
+    join_t *join = (join_t *)node->frame;
+
+    join->req.type = TYPE_JOIN_REQ;
+    id_store(join->req.id, node->id);
+    node->age = 0;
+
+    node->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        node->dev,
+        join->byte, join->byte + sizeof(join->req),
+        node_on_request_sent,
+        NULL,
+        (uintptr_t)node);
+}
+
+void nRF24L01_star_node_init(
+    nRF24L01_star_node_t *node,
+    nRF24L01_t *dev,
+    uint32_t id,
+    const uint8_t *join_addr,
+    uint8_t timeout)
+{
+    memset(node, 0, sizeof(nRF24L01_star_node_t));
+    node->dev = dev;
+    node->id = id;
+    memcpy(node->join_addr.addr, join_addr, sizeof(node->join_addr.addr));
+    node->timeout = timeout;
+}
+
+void nRF24L01_star_node_join(
+    nRF24L01_star_node_t *node,
+    nRF24L01_star_join_cb_t cb,
+    uintptr_t user_data)
+{
+    node->cb = cb;
+    node->user_data = user_data;
+    node->joining = 1;
+    node->joined = 0;
+
+    nRF24L01_en_rxaddr_t en_rxaddr =
+    {
+        .value = nRF24L01_read_register(node->dev, nRF24L01_ADDR_en_rxaddr)
+    };
+
+    en_rxaddr.ERX_P0 = 1;
+
+    node->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_write_register(
+        node->dev, nRF24L01_ADDR_en_rxaddr,
+        en_rxaddr.byte, en_rxaddr.byte + sizeof(en_rxaddr));
+    addr_write(node->dev, nRF24L01_ADDR_tx_addr, &node->join_addr);
+    addr_write(node->dev, nRF24L01_ADDR_rx_addr_p0, &node->join_addr);
+    node_send_request(node);
+}
+
+void nRF24L01_star_node_tick(nRF24L01_star_node_t *node)
+{
+    if(!node->joining) return;
+
+    /* id based jitter keeps nodes powered up together from colliding */
+    if(++node->age < node->timeout + (node->id & 0x7)) return;
+    node_send_request(node);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Star network: single gateway (PRX) serving up to 6 nodes, one per pipe.
+ *
+ * Pipe 0 listens on well-known join address. Joining node sends its unique
+ * id there and gateway replies with assigned pipe and address. Addresses of
+ * pipes 1-5 differ only in LSB (upper 4 bytes are shared with pipe 1),
+ * pipe 0 is handed out last which closes joining until some pipe is
+ * released (node silent for idle_max ticks).
+ *
+ * Node uses assigned address both as tx_addr and rx_addr_p0 so auto ACK
+ * and gateway-to-node (downlink) payloads are received on its pipe 0.
+ *
+ * Gateway queues at most one payload per pipe, received payloads are
+ * handed to application in round robin order so single chatty node can not
+ * starve others (overflowing pipe drops its own payloads). */
+
+#define nRF24L01_STAR_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_STAR_ADDR_LSB(pipe_no) (UINT8_C(0xC0) | (pipe_no))
+
+typedef
+void (*nRF24L01_star_recv_cb_t)(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t pipe_no,
+    uint32_t node_id,
+    uintptr_t);
+typedef
+void (*nRF24L01_star_join_cb_t)(uint8_t pipe_no, uintptr_t);
+
+typedef struct
+{
+    uint32_t node_id;
+    uint16_t dropped; // statistics
+    uint8_t idle; // ticks since last payload
+    uint8_t size;
+    uint8_t buf[nRF24L01_STAR_FRAME_SIZE];
+    struct
+    {
+        uint8_t assigned : 1;
+        uint8_t full : 1;
+        uint8_t : 6;
+    };
+} nRF24L01_star_pipe_t;
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_addr40_t join_addr;
+    uint8_t base[4]; // shared upper bytes of pipe addresses
+    uint8_t frame[nRF24L01_STAR_FRAME_SIZE];
+    uint8_t idle_max; // 0: pipes are never released
+    uint8_t rr; // next pipe to be serviced
+    nRF24L01_star_pipe_t pipe[nRF24L01_RX_PIPE_NUM];
+    struct
+    {
+        const uint8_t *begin;
+        const uint8_t *end;
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+} nRF24L01_star_gw_t;
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    uint32_t id;
+    nRF24L01_addr40_t join_addr;
+    nRF24L01_addr40_t addr; // assigned
+    uint8_t pipe_no; // assigned
+    uint8_t frame[nRF24L01_STAR_FRAME_SIZE];
+    uint8_t timeout; // ticks to wait for join reply
+    uint8_t age;
+    nRF24L01_star_join_cb_t cb;
+    uintptr_t user_data;
+    struct
+    {
+        uint8_t joining : 1;
+        uint8_t joined : 1;
+        uint8_t : 6;
+    };
+} nRF24L01_star_node_t;
+
+/* gateway ------------------------------------------------------------------*/
+
+void nRF24L01_star_gw_init(
+    nRF24L01_star_gw_t *,
+    nRF24L01_t *,
+    const uint8_t *join_addr, // 5B
+    const uint8_t *base, // 4B
+    uint8_t idle_max);
+
+/* programs pipe addresses and starts listening */
+void nRF24L01_star_gw_start(nRF24L01_star_gw_t *);
+
+/* hands out at most one queued payload per pipe, call from main loop */
+void nRF24L01_star_gw_poll(
+    nRF24L01_star_gw_t *,
+    nRF24L01_star_recv_cb_t,
+    uintptr_t user_data);
+
+/* downlink to node assigned to pipe_no, gateway resumes listening after */
+void nRF24L01_star_gw_send(
+    nRF24L01_star_gw_t *,
+    uint8_t pipe_no,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_star_gw_tick(nRF24L01_star_gw_t *);
+
+/* node ---------------------------------------------------------------------*/
+
+void nRF24L01_star_node_init(
+    nRF24L01_star_node_t *,
+    nRF24L01_t *,
+    uint32_t id,
+    const uint8_t *join_addr, // 5B
+    uint8_t timeout);
+
+/* on success tx_addr and rx_addr_p0 are set to assigned address,
+ * node then uses nRF24L01_send()/nRF24L01_recv() directly */
+void nRF24L01_star_node_join(
+    nRF24L01_star_node_t *,
+    nRF24L01_star_join_cb_t,
+    uintptr_t user_data);
+
+/* call periodically (i.e. from cyclic timer callback) */
+void nRF24L01_star_node_tick(nRF24L01_star_node_t *);
@@ -0,0 +1,303 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_sim_bench.h"
+#include "nRF24L01_star.h"
+
+/* Star network test against simulated radios (nRF24L01_sim).
+ *
+ * Gateway and 7 nodes, nodes join one after another on join address
+ * (gateway pipe 0). Checked: nodes get pipes 1-5 and then pipe 0 (join
+ * reply matches gateway table), 7th node is refused (pipe 0 no longer
+ * listens on join address). Then in every round each node sends one
+ * payload (node on pipe 1 two, second one is dropped by full pipe), single
+ * poll hands out every pipe once starting at round robin position which
+ * advances by one per poll, payload, pipe and node id match sender, and
+ * gateway sends payload to every node (downlink) which it receives on its
+ * pipe 0.
+ *
+ * Reported: joined nodes, uplink/downlink payloads, dropped payloads,
+ * payloads on air. Virtual time, reproducible for given seed.
+ *
+ * usage: nRF24L01_star_bench [seed [rounds]] */
+
+#define TICK_PERIOD 1000 // us
+#define JOIN_TIMEOUT 5 // ticks
+#define WAIT_MAX 200 // ticks
+#define NODE_NUM (nRF24L01_RX_PIPE_NUM + 1)
+#define PIPE_NUM nRF24L01_RX_PIPE_NUM
+#define FRAME_SIZE nRF24L01_STAR_FRAME_SIZE
+#define NODE_ID(i) (UINT32_C(0x5AA50000) + (i))
+#define FAIL(what) nRF24L01_sim_bench_fail("star: %s", what)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_star_node_t star;
+    uint8_t frame[FRAME_SIZE]; // downlink
+} node_t;
+
+typedef struct
+{
+    uint8_t size;
+    uint8_t data[FRAME_SIZE];
+} payload_t;
+
+static const uint8_t join_addr_[] = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7};
+static const uint8_t base_[] = {0xC2, 0xC2, 0xC2, 0xC2};
+
+static nRF24L01_sim_air_t air;
+static nRF24L01_sim_t gw_sim;
+static nRF24L01_t gw_dev;
+static nRF24L01_star_gw_t gw;
+static node_t node_[NODE_NUM];
+static uint8_t active_; // nodes ticked
+static uint64_t tick;
+static payload_t tx_;
+static payload_t up_[PIPE_NUM]; // expected on pipe
+static uint8_t order_[PIPE_NUM]; // pipes in order of poll
+static uint32_t joined_;
+static uint32_t sent_;
+static uint32_t uplink_;
+static uint32_t downlink_;
+static uint32_t polled_;
+static uint32_t seed_ = 1;
+
+static
+void configure(nRF24L01_t *dev, nRF24L01_sim_t *sim)
+{
+    nRF24L01_sim_bench_init(dev, sim, &air);
+    nRF24L01_CFG(
+        dev, en_aa,
+        .ENAA_P0 = 1,
+        .ENAA_P1 = 1,
+        .ENAA_P2 = 1,
+        .ENAA_P3 = 1,
+        .ENAA_P4 = 1,
+        .ENAA_P5 = 1);
+    nRF24L01_CFG(dev, setup_retr, .ARC = 15, .ARD = 1);
+}
+
+/* runs air until next tick (included) */
+static
+void step(void)
+{
+    for(;;)
+    {
+        nRF24L01_sim_bench_dispatch(&gw_dev, &gw_sim);
+        for(uint8_t i = 0; i < NODE_NUM; ++i) nRF24L01_sim_bench_dispatch(&node_[i].dev, &node_[i].sim);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < tick ? next : tick);
+        if(tick > air.now) continue;
+
+        tick += TICK_PERIOD;
+        nRF24L01_star_gw_tick(&gw);
+        for(uint8_t i = 0; i < active_; ++i) nRF24L01_star_node_tick(&node_[i].star);
+        return;
+    }
+}
+
+static
+void wait(const uint32_t *counter, uint32_t value, const char *what)
+{
+    for(uint32_t i = 0; value != *counter; ++i)
+    {
+        if(WAIT_MAX == i) FAIL(what);
+        step();
+    }
+}
+
+static
+void on_join(uint8_t pipe_no, uintptr_t user_data)
+{
+    ++joined_;
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    ++sent_;
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    FAIL("payload not acknowledged");
+}
+
+static
+void check_join(void)
+{
+    for(uint8_t i = 0; i < NODE_NUM; ++i)
+    {
+        node_t *node = node_ + i;
+
+        active_ = i + 1;
+        nRF24L01_star_node_join(&node->star, on_join, 0);
+        if(PIPE_NUM == i) break;
+        wait(&joined_, i + 1, "node not joined");
+
+        /* pipe 0 is handed out last */
+        const uint8_t pipe_no = (i + 1) % PIPE_NUM;
+
+        if(pipe_no != node->star.pipe_no) FAIL("join: pipe order");
+        if(!gw.pipe[pipe_no].assigned || NODE_ID(i) != gw.pipe[pipe_no].node_id) FAIL("join: gateway table");
+        if(nRF24L01_STAR_ADDR_LSB(pipe_no) != node->star.addr.addr[0]) FAIL("join: address");
+    }
+    /* 7th node retries, nobody listens on join address */
+    for(uint8_t i = 0; i < 10 * JOIN_TIMEOUT; ++i) step();
+    if(PIPE_NUM != joined_ || node_[PIPE_NUM].star.joined) FAIL("join: 7th node accepted");
+    if(2 > node_[PIPE_NUM].sim.stat.tx) FAIL("join: 7th node did not retry");
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        if(NODE_ID((i + PIPE_NUM - 1) % PIPE_NUM) != gw.pipe[i].node_id) FAIL("join: pipe taken over");
+    }
+    /* application gives up, node is not ticked anymore */
+    active_ = PIPE_NUM;
+    for(uint8_t i = 0; i < 2 * JOIN_TIMEOUT; ++i) step();
+}
+
+static
+void uplink(uint8_t index)
+{
+    node_t *node = node_ + index;
+
+    tx_.size = 1 + xorshift32(&seed_) % FRAME_SIZE;
+    tx_.data[0] = index;
+    for(uint8_t i = 1; i < tx_.size; ++i) tx_.data[i] = xorshift32(&seed_);
+
+    node->dev.ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(&node->dev, tx_.data, tx_.data + tx_.size, on_sent, on_send_error, 0);
+    wait(&sent_, sent_ + 1, "uplink not sent");
+}
+
+static
+void on_poll(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t pipe_no,
+    uint32_t node_id,
+    uintptr_t user_data)
+{
+    const payload_t *up = up_ + pipe_no;
+
+    if(PIPE_NUM == polled_) FAIL("poll: pipe handed out twice");
+    if(node_[begin[0]].star.pipe_no != pipe_no || NODE_ID(begin[0]) != node_id) FAIL("poll: pipe of other node");
+    if(up->size != (size_t)(end - begin) || memcmp(begin, up->data, up->size)) FAIL("poll: payload corrupted");
+    order_[polled_++] = pipe_no;
+    ++uplink_;
+}
+
+static
+void on_downlink(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    const node_t *node = (const node_t *)user_data;
+
+    if(pipe_no) FAIL("downlink: not on pipe 0");
+    if(tx_.size != curr - node->frame || memcmp(node->frame, tx_.data, tx_.size)) FAIL("downlink: payload corrupted");
+    ++downlink_;
+}
+
+static
+void round_(void)
+{
+    const uint8_t rr = gw.rr;
+
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        uplink(i);
+        up_[node_[i].star.pipe_no] = tx_;
+    }
+    /* pipe is full until polled, second payload is dropped */
+    const uint16_t dropped = gw.pipe[1].dropped;
+
+    uplink(0);
+    if(dropped + 1 != gw.pipe[1].dropped) FAIL("full pipe: payload not dropped");
+
+    polled_ = 0;
+    nRF24L01_star_gw_poll(&gw, on_poll, 0);
+    if(PIPE_NUM != polled_) FAIL("poll: pipe not handed out");
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        if((rr + i) % PIPE_NUM != order_[i]) FAIL("poll: not round robin");
+    }
+    if((rr + 1) % PIPE_NUM != gw.rr) FAIL("poll: round robin not advanced");
+
+    for(uint8_t i = 0; i < PIPE_NUM; ++i)
+    {
+        node_t *node = node_ + i;
+        const uint32_t downlink = downlink_;
+
+        node->dev.ce_set((nRF24L01_ce_t){.CE = 0});
+        nRF24L01_recv(&node->dev, node->frame, node->frame + FRAME_SIZE, on_downlink, NULL, (uintptr_t)node);
+
+        tx_.size = 1 + xorshift32(&seed_) % FRAME_SIZE;
+        for(uint8_t j = 0; j < tx_.size; ++j) tx_.data[j] = xorshift32(&seed_);
+        /* node settles to RX */
+        step();
+        nRF24L01_star_gw_send(&gw, node->star.pipe_no, tx_.data, tx_.data + tx_.size, on_sent, on_send_error, 0);
+        wait(&sent_, sent_ + 1, "downlink not sent");
+        wait(&downlink_, downlink + 1, "downlink not received");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t seed = 1 < argc ? strtoul(argv[1], NULL, 0) : 1;
+    const uint32_t rounds = 2 < argc ? strtoul(argv[2], NULL, 0) : 10;
+
+    if(!rounds)
+    {
+        fprintf(stderr, "usage: %s [seed [rounds]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    seed_ = seed ? seed : 1;
+
+    nRF24L01_sim_air_init(&air, 0, seed_);
+    configure(&gw_dev, &gw_sim);
+    nRF24L01_star_gw_init(&gw, &gw_dev, join_addr_, base_, 0);
+    for(uint8_t i = 0; i < NODE_NUM; ++i)
+    {
+        node_t *node = node_ + i;
+
+        configure(&node->dev, &node->sim);
+        nRF24L01_star_node_init(&node->star, &node->dev, NODE_ID(i), join_addr_, JOIN_TIMEOUT);
+    }
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    tick = air.now + TICK_PERIOD;
+    nRF24L01_star_gw_start(&gw);
+
+    check_join();
+    for(uint32_t i = 0; i < rounds; ++i) round_();
+
+    uint32_t tx = gw_sim.stat.tx;
+    uint32_t dropped = 0;
+
+    for(uint8_t i = 0; i < NODE_NUM; ++i) tx += node_[i].sim.stat.tx;
+    for(uint8_t i = 0; i < PIPE_NUM; ++i) dropped += gw.pipe[i].dropped;
+
+    printf(
+        "{\"nodes\":%u,\"joined\":%" PRIu32 ",\"rounds\":%" PRIu32 ",\"uplink\":%" PRIu32
+        ",\"downlink\":%" PRIu32 ",\"dropped\":%" PRIu32 ",\"payloads\":%" PRIu32 ",\"ok\":1}\n",
+        NODE_NUM,
+        joined_,
+        rounds,
+        uplink_,
+        downlink_,
+        dropped,
+        tx);
+
+    nRF24L01_sim_release(&gw_sim);
+    for(uint8_t i = 0; i < NODE_NUM; ++i) nRF24L01_sim_release(&node_[i].sim);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "nRF24L01_sync.h"
+
+#define TYPE_SYNC UINT8_C(0x53) // 'S'
+#define DRIFT_SHIFT 24
+
+typedef union
+{
+    struct
+    {
+        uint8_t type;
+        uint8_t seq;
+        uint8_t prev_valid; // prev_time is valid
+        uint8_t prev_time[4]; // LSB first, TX_DS time of beacon seq - 1
+    };
+    uint8_t byte[nRF24L01_SYNC_FRAME_SIZE];
+} frame_t;
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void listen(nRF24L01_sync_t *sync)
+{
+    sync->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        sync->dev,
+        sync->frame, sync->frame + sizeof(frame_t),
+        on_frame,
+        NULL,
+        (uintptr_t)sync);
+}
+
+static
+void sample(nRF24L01_sync_t *sync, uint32_t master, uint32_t local)
+{
+    if(sync->offset_valid)
+    {
+        const int32_t dl = local - sync->ref_local;
+        const int32_t dm = master - sync->ref_master;
+
+        if(0 < dl)
+        {
+            const int32_t drift =
+                ((int64_t)(dm - dl) * ((int32_t)1 << DRIFT_SHIFT)) / dl;
+
+            /* smooth out timestamp jitter */
+            if(sync->drift_valid) sync->drift += (drift - sync->drift) / 4;
+            else sync->drift = drift;
+            sync->drift_valid = 1;
+        }
+    }
+
+    sync->ref_master = master;
+    sync->ref_local = local;
+    sync->offset_valid = 1;
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_sync_t *sync = (nRF24L01_sync_t *)user_data;
+    const frame_t *frame = (const frame_t *)sync->frame;
+    /* RX_DR interrupt of this beacon */
+    const uint32_t rx_time = sync->irq_time;
+
+    if(sizeof(frame_t) != curr - sync->frame || TYPE_SYNC != frame->type) goto listen;
+
+    if(
+        frame->prev_valid
+        && sync->rx_valid
+        && (uint8_t)(frame->seq - 1) == sync->seq)
+    {
+        const uint32_t prev_time =
+            frame->prev_time[0]
+            | (uint32_t)frame->prev_time[1] << 8
+            | (uint32_t)frame->prev_time[2] << 16
+            | (uint32_t)frame->prev_time[3] << 24;
+
+        sample(sync, prev_time, sync->rx_time);
+    }
+
+    sync->seq = frame->seq;
+    sync->rx_time = rx_time;
+    sync->rx_valid = 1;
+listen:
+    listen(sync);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_sync_t *sync = (nRF24L01_sync_t *)user_data;
+
+    /* TX_DS interrupt of this beacon */
+    sync->tx_time = sync->irq_time;
+    sync->tx_valid = 1;
+    if(sync->cb) (*sync->cb)(sync->user_data);
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_sync_t *sync = (nRF24L01_sync_t *)user_data;
+
+    sync->tx_valid = 0;
+    if(sync->cb) (*sync->cb)(sync->user_data);
+}
+
+void nRF24L01_sync_init(
+    nRF24L01_sync_t *sync,
+    nRF24L01_t *dev,
+    nRF24L01_sync_clock_t clock)
+{
+    memset(sync, 0, sizeof(nRF24L01_sync_t));
+    sync->dev = dev;
+    sync->clock = clock;
+}
+
+void nRF24L01_sync_irq(nRF24L01_sync_t *sync)
+{
+    sync->irq_time = (*sync->clock)();
+}
+
+void nRF24L01_sync_beacon(
+    nRF24L01_sync_t *sync,
+    nRF24L01_send_cb_t cb,
+    uintptr_t user_data)
+{
+    frame_t *frame = (frame_t *)sync->frame;
+
+    sync->cb = cb;
+    sync->user_data = user_data;
+
+    frame->type = TYPE_SYNC;
+    frame->seq = ++sync->seq;
+    frame->prev_valid = sync->tx_valid;
+    frame->prev_time[0] = sync->tx_time;
+    frame->prev_time[1] = sync->tx_time >> 8;
+    frame->prev_time[2] = sync->tx_time >> 16;
+    frame->prev_time[3] = sync->tx_time >> 24;
+
+    sync->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        sync->dev,
+        frame->byte, frame->byte + sizeof(frame_t),
+        on_sent,
+        on_send_error,
+        (uintptr_t)sync);
+}
+
+void nRF24L01_sync_listen(nRF24L01_sync_t *sync)
+{
+    listen(sync);
+}
+
+uint8_t nRF24L01_sync_valid(const nRF24L01_sync_t *sync)
+{
+    return sync->offset_valid;
+}
+
+uint32_t nRF24L01_sync_now(const nRF24L01_sync_t *sync)
+{
+    const uint32_t local = (*sync->clock)();
+
+    if(!sync->offset_valid) return local;
+
+    const int32_t dl = local - sync->ref_local;
+
+    return
+        sync->ref_master + dl
+        + (int32_t)(((int64_t)dl * sync->drift) >> DRIFT_SHIFT);
+}
+
+uint32_t nRF24L01_sync_to_local(const nRF24L01_sync_t *sync, uint32_t master_time)
+{
+    if(!sync->offset_valid) return master_time;
+
+    const int32_t dm = master_time - sync->ref_master;
+
+    /* dl = dm / (1 + drift), exact inverse of sync_now() */
+    return
+        sync->ref_local
+        + (int32_t)(
+            ((int64_t)dm * ((int32_t)1 << DRIFT_SHIFT))
+            / (((int32_t)1 << DRIFT_SHIFT) + sync->drift));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* Over-the-air time synchronization.
+ *
+ * Master broadcasts beacons, every beacon carries master time captured at
+ * TX_DS interrupt of previous beacon (two-step, time is known only after
+ * transmission). Slave captures its local time at RX_DR interrupt of every
+ * beacon and pairs it with master time received in following one. Both
+ * interrupts fire at the end of same packet on air so difference of the
+ * two is clock offset, rate of change of offset between beacons is drift.
+ *
+ * Interrupt timestamps are taken by nRF24L01_sync_irq() which has to be
+ * called from IRQ pin interrupt on falling edge (before event dispatch).
+ * Accuracy is bound by clock resolution and IRQ latency. */
+
+#define nRF24L01_SYNC_FRAME_SIZE 7
+
+typedef
+uint32_t (*nRF24L01_sync_clock_t)(void);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_sync_clock_t clock; // local time (i.e. cyclic_tmr_ticks)
+    volatile uint32_t irq_time; // local time of last IRQ
+    uint32_t tx_time; // master: TX_DS time of last beacon
+    uint32_t rx_time; // slave: RX_DR time of last beacon
+    uint32_t ref_master; // slave: master time of reference point
+    uint32_t ref_local; // slave: local time of reference point
+    int32_t drift; // slave: (master - local) / local rate, Q24
+    uint8_t seq;
+    uint8_t frame[nRF24L01_SYNC_FRAME_SIZE];
+    nRF24L01_send_cb_t cb;
+    uintptr_t user_data;
+    struct
+    {
+        uint8_t tx_valid : 1; // master: tx_time belongs to seq
+        uint8_t rx_valid : 1; // slave: rx_time belongs to seq
+        uint8_t offset_valid : 1;
+        uint8_t drift_valid : 1;
+        uint8_t : 4;
+    };
+} nRF24L01_sync_t;
+
+void nRF24L01_sync_init(nRF24L01_sync_t *, nRF24L01_t *, nRF24L01_sync_clock_t);
+
+/* call from IRQ pin interrupt (falling edge) */
+void nRF24L01_sync_irq(nRF24L01_sync_t *);
+
+/* master: send beacon (i.e. periodically from cyclic timer callback) */
+void nRF24L01_sync_beacon(
+    nRF24L01_sync_t *,
+    nRF24L01_send_cb_t,
+    uintptr_t user_data);
+
+/* slave: listen for beacons, listening is resumed after every beacon */
+void nRF24L01_sync_listen(nRF24L01_sync_t *);
+
+/* slave: 1 once offset is known */
+uint8_t nRF24L01_sync_valid(const nRF24L01_sync_t *);
+
+/* synchronized (master) time now, local time on master */
+uint32_t nRF24L01_sync_now(const nRF24L01_sync_t *);
+
+/* local clock value at given master time (i.e. to schedule RX windows) */
+uint32_t nRF24L01_sync_to_local(const nRF24L01_sync_t *, uint32_t master_time);
@@ -0,0 +1,195 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_sim_bench.h"
+#include "nRF24L01_sync.h"
+
+/* Time synchronization test against simulated radios (nRF24L01_sim).
+ *
+ * Master broadcasts beacon every second, its clock is air time (us).
+ * Slave clock runs drift_ppm faster (slower if negative), both clocks
+ * start at different offsets close to uint32_t wrap which happens during
+ * the test. Beacons are lost with loss_ppm probability. Checked: slave is
+ * not synchronized before second beacon, Q24 drift converges to
+ * -ppm / (1e6 + ppm), synchronized time (sync_now) matches master clock
+ * after last beacon and after EXTRAPOLATE_US without beacons, master time
+ * converted to local (sync_to_local) is hit by slave clock.
+ *
+ * Reported: beacons sent and received, drift (ppm, Q24 and expected Q24),
+ * errors of synchronized time (us). Virtual time, reproducible for given
+ * seed.
+ *
+ * usage: nRF24L01_sync_bench [drift_ppm [loss_ppm [seed [beacons]]]] */
+
+#define BEACON_PERIOD UINT64_C(1000000) // us
+#define EXTRAPOLATE_US UINT64_C(10000000)
+#define MASTER_OFFSET UINT32_C(0xFFF00000)
+#define SLAVE_OFFSET UINT32_C(0xFF000000)
+#define DRIFT_TOL_PPM 2
+#define OFFSET_TOL_US 2
+#define DRIFT_MAX_PPM 10000
+#define FAIL(what) nRF24L01_sim_bench_fail("sync: %s (beacon %" PRIu32 ")", what, sent_)
+
+typedef struct
+{
+    nRF24L01_sim_t sim;
+    nRF24L01_t dev;
+    nRF24L01_sync_t sync;
+} node_t;
+
+static nRF24L01_sim_air_t air;
+static node_t master_;
+static node_t slave_;
+static int32_t ppm_;
+static uint32_t sent_;
+
+static
+uint32_t master_clock(void)
+{
+    return MASTER_OFFSET + air.now;
+}
+
+static
+uint32_t slave_clock(void)
+{
+    const int64_t now = air.now;
+
+    return SLAVE_OFFSET + now + now * ppm_ / 1000000;
+}
+
+static
+void configure(node_t *node, nRF24L01_sync_clock_t clock)
+{
+    nRF24L01_sim_bench_init(&node->dev, &node->sim, &air);
+    nRF24L01_sync_init(&node->sync, &node->dev, clock);
+}
+
+/* IRQ timestamp on assertion, then events (sim IRQ is asserted at the end
+ * of packet on air, same time for both ends) */
+static
+void dispatch(node_t *node)
+{
+    if(nRF24L01_sim_irq(&node->sim)) nRF24L01_sync_irq(&node->sync);
+    nRF24L01_sim_bench_dispatch(&node->dev, &node->sim);
+}
+
+/* runs air until time */
+static
+void advance(uint64_t time)
+{
+    while(air.now < time)
+    {
+        dispatch(&master_);
+        dispatch(&slave_);
+
+        const uint64_t next = nRF24L01_sim_next(&air);
+
+        nRF24L01_sim_run(&air, next < time ? next : time);
+    }
+    dispatch(&master_);
+    dispatch(&slave_);
+}
+
+static
+int32_t error_us(void)
+{
+    return (int32_t)(nRF24L01_sync_now(&slave_.sync) - master_clock());
+}
+
+/* drift error accumulates since last reference point */
+static
+int32_t tolerance_us(void)
+{
+    const uint32_t age = master_clock() - slave_.sync.ref_master;
+
+    return OFFSET_TOL_US + (uint64_t)DRIFT_TOL_PPM * age / 1000000;
+}
+
+int main(int argc, char *argv[])
+{
+    const int32_t ppm = 1 < argc ? strtol(argv[1], NULL, 0) : 100;
+    const uint32_t loss_ppm = 2 < argc ? strtoul(argv[2], NULL, 0) : 100000;
+    const uint32_t seed = 3 < argc ? strtoul(argv[3], NULL, 0) : 1;
+    const uint32_t num = 4 < argc ? strtoul(argv[4], NULL, 0) : 30;
+
+    if(DRIFT_MAX_PPM < labs(ppm) || loss_ppm >= 500000 || 3 > num)
+    {
+        fprintf(
+            stderr,
+            "usage: %s [drift_ppm (-%u..%u) [loss_ppm [seed [beacons (3..)]]]]\n",
+            argv[0], DRIFT_MAX_PPM, DRIFT_MAX_PPM);
+        return EXIT_FAILURE;
+    }
+    ppm_ = ppm;
+
+    nRF24L01_sim_air_init(&air, loss_ppm, seed ? seed : 1);
+    configure(&master_, master_clock);
+    configure(&slave_, slave_clock);
+
+    /* power up */
+    nRF24L01_sim_run(&air, 2000);
+    nRF24L01_sync_listen(&slave_.sync);
+    advance(air.now + BEACON_PERIOD);
+
+    const uint32_t local = slave_clock();
+
+    if(nRF24L01_sync_valid(&slave_.sync)) FAIL("synchronized without beacon");
+    if(local != nRF24L01_sync_now(&slave_.sync)) FAIL("local time before synchronization");
+
+    for(sent_ = 0; sent_ < num; ++sent_)
+    {
+        nRF24L01_sync_beacon(&master_.sync, NULL, 0);
+        advance(air.now + BEACON_PERIOD);
+        /* offset is taken from previous beacon */
+        if(!sent_ && nRF24L01_sync_valid(&slave_.sync)) FAIL("synchronized on single beacon");
+    }
+
+    if(!nRF24L01_sync_valid(&slave_.sync) || !slave_.sync.drift_valid) FAIL("not synchronized");
+
+    const int32_t expected = -((int64_t)ppm * (1 << 24)) / (1000000 + ppm);
+    const int32_t drift_err = slave_.sync.drift - expected;
+    const int32_t offset_err = error_us();
+
+    if(labs(drift_err) > DRIFT_TOL_PPM * (1 << 24) / 1000000) FAIL("drift");
+    if(labs(offset_err) > tolerance_us()) FAIL("offset");
+
+    /* no beacons, drift keeps time */
+    const uint32_t target = master_clock() + EXTRAPOLATE_US;
+    const uint32_t target_local = nRF24L01_sync_to_local(&slave_.sync, target);
+
+    advance(air.now + EXTRAPOLATE_US);
+
+    const int32_t extrapolated_err = error_us();
+    const int32_t to_local_err = (int32_t)(slave_clock() - target_local);
+
+    if(labs(extrapolated_err) > tolerance_us()) FAIL("extrapolated time");
+    if(labs(to_local_err) > tolerance_us()) FAIL("master time to local");
+    /* would be off by ppm without drift compensation */
+    if(DRIFT_TOL_PPM < labs(ppm) && labs(extrapolated_err) >= labs(ppm) * EXTRAPOLATE_US / 1000000)
+    {
+        FAIL("drift not compensated");
+    }
+
+    printf(
+        "{\"drift_ppm\":%" PRId32 ",\"loss_ppm\":%" PRIu32 ",\"beacons\":%" PRIu32
+        ",\"lost\":%" PRIu32 ",\"received\":%" PRIu32 ",\"drift_q24\":%" PRId32
+        ",\"expected_q24\":%" PRId32 ",\"offset_err_us\":%" PRId32
+        ",\"extrapolated_err_us\":%" PRId32 ",\"to_local_err_us\":%" PRId32 ",\"ok\":1}\n",
+        ppm,
+        loss_ppm,
+        sent_,
+        slave_.sim.stat.lost,
+        slave_.sim.stat.rx,
+        slave_.sync.drift,
+        expected,
+        offset_err,
+        extrapolated_err,
+        to_local_err);
+
+    nRF24L01_sim_release(&master_.sim);
+    nRF24L01_sim_release(&slave_.sim);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+#include <string.h>
+
+#include "cyclic_timer.h"
+#include "nRF24L01_tdma.h"
+
+#define FRAME_SIZE nRF24L01_TDMA_FRAME_SIZE
+#define DATA_SIZE nRF24L01_TDMA_DATA_SIZE
+#define SLOT_MAX_NUM nRF24L01_TDMA_SLOT_MAX_NUM
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+/* cyclic_tmr_start() runs at F_CPU / 1024 */
+#define BEACON_DELAY \
+    cyclic_tmr_us_to_ticks(nRF24L01_TDMA_BEACON_DELAY_US, CYCLIC_TMR_CLK_DIV_1024)
+
+#define TYPE_BEACON UINT8_C(0x42) // 'B'
+#define TYPE_DATA UINT8_C(0x44) // 'D'
+
+typedef union
+{
+    struct
+    {
+        uint8_t type;
+        uint8_t seq;
+        uint8_t slot_num;
+        uint8_t slot_period[2]; // LSB first
+        uint8_t map[SLOT_MAX_NUM];
+    } beacon;
+    struct
+    {
+        uint8_t type;
+        uint8_t src;
+        uint8_t data[DATA_SIZE];
+    } data;
+    uint8_t byte[0];
+} frame_t;
+
+static
+void on_frame(uint8_t *, uint8_t, uintptr_t);
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data);
+
+static
+void on_slot(uintptr_t);
+
+static
+void listen(nRF24L01_tdma_t *tdma)
+{
+    tdma->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_recv(
+        tdma->dev,
+        tdma->rx_frame, tdma->rx_frame + FRAME_SIZE,
+        on_frame,
+        on_rx_error,
+        (uintptr_t)tdma);
+}
+
+static
+void on_rx_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_tdma_t *)user_data);
+}
+
+static
+void on_beacon_sent(uintptr_t user_data)
+{
+    listen((nRF24L01_tdma_t *)user_data);
+}
+
+static
+void on_beacon_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    listen((nRF24L01_tdma_t *)user_data);
+}
+
+static
+void on_sent(uintptr_t user_data)
+{
+    nRF24L01_tdma_t *tdma = (nRF24L01_tdma_t *)user_data;
+    const nRF24L01_send_cb_t cb = tdma->tx.cb;
+    const uintptr_t tx_user_data = tdma->tx.user_data;
+
+    tdma->tx.cb = NULL;
+    tdma->tx.err_cb = NULL;
+    tdma->tx.user_data = 0;
+
+    listen(tdma);
+    if(cb) (*cb)(tx_user_data);
+}
+
+static
+void on_send_error(
+    nRF24L01_status_t status,
+    nRF24L01_fifo_status_t fifo_status,
+    uintptr_t user_data)
+{
+    nRF24L01_tdma_t *tdma = (nRF24L01_tdma_t *)user_data;
+    const nRF24L01_err_cb_t err_cb = tdma->tx.err_cb;
+    const uintptr_t tx_user_data = tdma->tx.user_data;
+
+    tdma->tx.cb = NULL;
+    tdma->tx.err_cb = NULL;
+    tdma->tx.user_data = 0;
+
+    listen(tdma);
+    if(err_cb) (*err_cb)(status, fifo_status, tx_user_data);
+}
+
+/* beacon is built in receive buffer, radio does not listen while sending */
+static
+void send_beacon(nRF24L01_tdma_t *tdma)
+{
+    frame_t *frame = (frame_t *)tdma->rx_frame;
+
+    frame->beacon.type = TYPE_BEACON;
+    frame->beacon.seq = ++tdma->seq;
+    frame->beacon.slot_num = tdma->slot_num;
+    frame->beacon.slot_period[0] = tdma->slot_period;
+    frame->beacon.slot_period[1] = tdma->slot_period >> 8;
+    memcpy(frame->beacon.map, tdma->map, tdma->slot_num);
+
+    tdma->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        tdma->dev,
+        frame->byte,
+        frame->beacon.map + tdma->slot_num,
+        on_beacon_sent,
+        on_beacon_error,
+        (uintptr_t)tdma);
+}
+
+static
+void on_beacon(nRF24L01_tdma_t *tdma, const frame_t *frame, uint8_t size)
+{
+    const uint8_t slot_num = MIN(frame->beacon.slot_num, SLOT_MAX_NUM);
+
+    if(tdma->coordinator) return;
+    if(!slot_num || size < frame->beacon.map + slot_num - frame->byte) return;
+
+    /* align slot boundaries to coordinator frame */
+    tdma->slot_period =
+        frame->beacon.slot_period[0]
+        | (uint16_t)frame->beacon.slot_period[1] << 8;
+    cyclic_tmr_start(tdma->slot_period, on_slot, (uintptr_t)tdma);
+    /* coordinator slot 0 started before beacon was sent */
+    if(BEACON_DELAY < tdma->slot_period) cyclic_tmr_advance(BEACON_DELAY);
+
+    tdma->slot = 0;
+    tdma->slot_num = slot_num;
+    tdma->seq = frame->beacon.seq;
+    memcpy(tdma->map, frame->beacon.map, slot_num);
+    tdma->missed = 0;
+    tdma->beacon = 1;
+    tdma->synced = 1;
+}
+
+static
+void on_frame(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    nRF24L01_tdma_t *tdma = (nRF24L01_tdma_t *)user_data;
+    const frame_t *frame = (const frame_t *)tdma->rx_frame;
+    const uint8_t size = curr - tdma->rx_frame;
+
+    if(!size) goto listen;
+
+    if(TYPE_BEACON == frame->beacon.type) on_beacon(tdma, frame, size);
+    else if(TYPE_DATA == frame->data.type && size >= frame->data.data - frame->byte)
+    {
+        if(tdma->cb)
+        {
+            (*tdma->cb)(
+                frame->data.data, tdma->rx_frame + size,
+                frame->data.src,
+                tdma->user_data);
+        }
+    }
+listen:
+    listen(tdma);
+}
+
+static
+void on_slot(uintptr_t user_data)
+{
+    nRF24L01_tdma_t *tdma = (nRF24L01_tdma_t *)user_data;
+
+    tdma->slot = (tdma->slot + 1) % tdma->slot_num;
+
+    if(!tdma->slot)
+    {
+        if(tdma->coordinator)
+        {
+            send_beacon(tdma);
+            return;
+        }
+
+        /* timer is restarted on beacon reception, frame which ends here
+         * had no beacon if flag was not set in meantime */
+        if(!tdma->beacon && ++tdma->missed >= tdma->sync_max) tdma->synced = 0;
+        tdma->beacon = 0;
+        return;
+    }
+
+    if(!tdma->pending || !tdma->synced || tdma->id != tdma->map[tdma->slot]) return;
+
+    tdma->pending = 0;
+    tdma->dev->ce_set((nRF24L01_ce_t){.CE = 0});
+    nRF24L01_send(
+        tdma->dev,
+        tdma->tx_frame, tdma->tx_frame + tdma->tx.size,
+        on_sent,
+        on_send_error,
+        (uintptr_t)tdma);
+}
+
+void nRF24L01_tdma_init(
+    nRF24L01_tdma_t *tdma,
+    nRF24L01_t *dev,
+    uint8_t id,
+    uint8_t sync_max,
+    nRF24L01_tdma_recv_cb_t cb,
+    uintptr_t user_data)
+{
+    memset(tdma, 0, sizeof(nRF24L01_tdma_t));
+    tdma->dev = dev;
+    tdma->id = id;
+    tdma->sync_max = sync_max;
+    tdma->cb = cb;
+    tdma->user_data = user_data;
+    tdma->slot_num = 1;
+    memset(tdma->map, nRF24L01_TDMA_SLOT_FREE, sizeof(tdma->map));
+}
+
+void nRF24L01_tdma_assign(nRF24L01_tdma_t *tdma, uint8_t slot, uint8_t id)
+{
+    if(!slot || SLOT_MAX_NUM <= slot) return;
+    tdma->map[slot] = id;
+}
+
+void nRF24L01_tdma_coordinator_start(
+    nRF24L01_tdma_t *tdma,
+    uint8_t slot_num,
+    uint16_t slot_period)
+{
+    tdma->coordinator = 1;
+    tdma->synced = 1;
+    tdma->slot = 0;
+    tdma->slot_num = slot_num ? MIN(slot_num, SLOT_MAX_NUM) : 1;
+    tdma->slot_period = slot_period;
+    tdma->map[0] = tdma->id;
+
+    cyclic_tmr_start(slot_period, on_slot, (uintptr_t)tdma);
+    send_beacon(tdma);
+}
+
+void nRF24L01_tdma_node_start(nRF24L01_tdma_t *tdma)
+{
+    tdma->coordinator = 0;
+    tdma->synced = 0;
+    listen(tdma);
+}
+
+void nRF24L01_tdma_stop(nRF24L01_tdma_t *tdma)
+{
+    cyclic_tmr_stop();
+    tdma->synced = 0;
+    tdma->pending = 0;
+}
+
+void nRF24L01_tdma_send(
+    nRF24L01_tdma_t *tdma,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t cb,
+    nRF24L01_err_cb_t err_cb,
+    uintptr_t user_data)
+{
+    frame_t *frame = (frame_t *)tdma->tx_frame;
+    const uint8_t size = MIN((size_t)(end - begin), DATA_SIZE);
+
+    frame->data.type = TYPE_DATA;
+    frame->data.src = tdma->id;
+    memcpy(frame->data.data, begin, size);
+
+    tdma->tx.size = frame->data.data + size - frame->byte;
+    tdma->tx.cb = cb;
+    tdma->tx.err_cb = err_cb;
+    tdma->tx.user_data = user_data;
+    /* set last, slot timer runs from interrupt */
+    tdma->pending = 1;
+}
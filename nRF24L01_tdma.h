@@ -0,0 +1,99 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* TDMA (time division multiple access) driven by cyclic timer.
+ *
+ * Time is divided into frames of slot_num slots, slot_period timer ticks
+ * each. Coordinator transmits beacon in slot 0 carrying slot period and
+ * slot map (owner id of every slot), nodes restart their slot timer on
+ * beacon reception so slot boundaries are aligned to coordinator frame.
+ * Node transmits only in slots it owns (single payload per slot), all
+ * other slots it listens. Node which misses sync_max beacons in a row
+ * stops transmitting until next beacon is received.
+ *
+ * Beacon is handled nRF24L01_TDMA_BEACON_DELAY_US after coordinator slot 0
+ * started (TX settling, air time, IRQ), node slot timer is restarted that
+ * far into the slot.
+ *
+ * slot_period has to cover payload air time, radio settling and beacon
+ * reception jitter (guard time). Timer1 is used via cyclic_tmr_*(). */
+
+#define nRF24L01_TDMA_FRAME_SIZE (nRF24L01_PAYLOAD_SIZE - 1)
+#define nRF24L01_TDMA_DATA_SIZE (nRF24L01_TDMA_FRAME_SIZE - 2)
+#define nRF24L01_TDMA_SLOT_MAX_NUM (nRF24L01_TDMA_FRAME_SIZE - 5)
+#define nRF24L01_TDMA_SLOT_FREE UINT8_C(0xFF)
+
+/* 130us TX settling + 32B payload at 1Mbps (~330us) + IRQ and SPI read */
+#ifndef nRF24L01_TDMA_BEACON_DELAY_US
+#define nRF24L01_TDMA_BEACON_DELAY_US 500
+#endif
+
+typedef
+void (*nRF24L01_tdma_recv_cb_t)(
+    const uint8_t *begin, const uint8_t *const end,
+    uint8_t src,
+    uintptr_t);
+
+typedef struct
+{
+    nRF24L01_t *dev;
+    nRF24L01_tdma_recv_cb_t cb;
+    uintptr_t user_data;
+    uint16_t slot_period; // cyclic timer ticks
+    uint8_t slot_num;
+    uint8_t slot; // current slot
+    uint8_t id;
+    uint8_t seq; // beacon sequence number
+    uint8_t missed; // beacons missed in a row
+    uint8_t sync_max;
+    uint8_t map[nRF24L01_TDMA_SLOT_MAX_NUM]; // slot owner ids
+    uint8_t rx_frame[nRF24L01_TDMA_FRAME_SIZE];
+    uint8_t tx_frame[nRF24L01_TDMA_FRAME_SIZE];
+    struct
+    {
+        uint8_t size;
+        nRF24L01_send_cb_t cb;
+        nRF24L01_err_cb_t err_cb;
+        uintptr_t user_data;
+    } tx;
+    struct
+    {
+        uint8_t coordinator : 1;
+        uint8_t synced : 1;
+        uint8_t beacon : 1; // beacon received in current frame
+        uint8_t pending : 1; // payload waits for slot
+        uint8_t : 4;
+    };
+} nRF24L01_tdma_t;
+
+void nRF24L01_tdma_init(
+    nRF24L01_tdma_t *,
+    nRF24L01_t *,
+    uint8_t id,
+    uint8_t sync_max,
+    nRF24L01_tdma_recv_cb_t,
+    uintptr_t user_data);
+
+/* coordinator only, slot 0 is reserved for beacon */
+void nRF24L01_tdma_assign(nRF24L01_tdma_t *, uint8_t slot, uint8_t id);
+
+/* coordinator owns time base and transmits beacons */
+void nRF24L01_tdma_coordinator_start(
+    nRF24L01_tdma_t *,
+    uint8_t slot_num,
+    uint16_t slot_period);
+
+/* node listens for beacon and then follows its slot map */
+void nRF24L01_tdma_node_start(nRF24L01_tdma_t *);
+
+void nRF24L01_tdma_stop(nRF24L01_tdma_t *);
+
+/* queues single payload, it is transmitted in next slot owned by this node,
+ * [begin, end) must not exceed nRF24L01_TDMA_DATA_SIZE */
+void nRF24L01_tdma_send(
+    nRF24L01_tdma_t *,
+    const uint8_t *begin, const uint8_t *const end,
+    nRF24L01_send_cb_t,
+    nRF24L01_err_cb_t,
+    uintptr_t user_data);
@@ -0,0 +1,185 @@
+#include <string.h>
+
+#include "nRF24L01_trace.h"
+
+#define RECORD_MAX nRF24L01_TRACE_RECORD_MAX
+#define W_REGISTER_DATA_MAX 5
+#define HEAD(type, x) ((type) << 5 | ((x) & 0x1F))
+
+static struct
+{
+    uint8_t *buf;
+    uint16_t mask;
+    uint16_t head; // write index
+    uint16_t tail; // read index
+    uint16_t lost;
+    uint32_t time; // of last record
+    nRF24L01_trace_clock_t clock;
+    nRF24L01_spi_xchg_t spi_xchg;
+    nRF24L01_ce_set_t ce_set;
+} trace_;
+
+static
+uint8_t varint(uint8_t *dst, uint32_t value)
+{
+    uint8_t size = 0;
+
+    while(0x7F < value)
+    {
+        dst[size++] = 0x80 | (value & 0x7F);
+        value >>= 7;
+    }
+    dst[size++] = value;
+    return size;
+}
+
+static
+void put(const uint8_t *begin, const uint8_t *const end)
+{
+    while(begin != end) trace_.buf[trace_.head++ & trace_.mask] = *begin++;
+}
+
+/* record = head, dt, prefix, data - dropped if it does not fit */
+static
+void emit(
+    uint8_t head,
+    const uint8_t *prefix, uint8_t prefix_size,
+    const uint8_t *data, uint8_t data_size)
+{
+    if(!trace_.buf) return;
+
+    const uint32_t now = (*trace_.clock)();
+    uint8_t rec[RECORD_MAX];
+    uint8_t size = 0;
+
+    /* gap is reported ahead of first record which fits */
+    if(trace_.lost)
+    {
+        rec[size++] = HEAD(nRF24L01_TRACE_LOST, 0);
+        size += varint(rec + size, now - trace_.time);
+        size += varint(rec + size, trace_.lost);
+        rec[size++] = head;
+        rec[size++] = 0;
+    }
+    else
+    {
+        rec[size++] = head;
+        size += varint(rec + size, now - trace_.time);
+    }
+    if(prefix_size) memcpy(rec + size, prefix, prefix_size);
+    size += prefix_size;
+
+    const uint16_t free = trace_.mask + 1 - (uint16_t)(trace_.head - trace_.tail);
+
+    if(free < size + data_size)
+    {
+        if(UINT16_MAX > trace_.lost) ++trace_.lost;
+        return;
+    }
+
+    put(rec, rec + size);
+    if(data_size) put(data, data + data_size);
+    trace_.lost = 0;
+    trace_.time = now;
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    const uint8_t size = end - begin;
+    uint8_t mosi[1 + W_REGISTER_DATA_MAX];
+    uint8_t data_size = 0;
+    const uint8_t *data = NULL;
+
+    memcpy(mosi, begin, size < sizeof(mosi) ? size : sizeof(mosi));
+    (*trace_.spi_xchg)(begin, end);
+
+    if(!size) return;
+
+    const uint8_t cmd = mosi[0];
+
+    if(nRF24L01_W_REGISTER(0) == (cmd & 0xE0))
+    {
+        data = mosi + 1;
+        data_size = size - 1 < W_REGISTER_DATA_MAX ? size - 1 : W_REGISTER_DATA_MAX;
+    }
+    else if(
+        nRF24L01_R_REGISTER(0) == (cmd & 0xE0)
+        || nRF24L01_R_RX_PAYLOAD == cmd)
+    {
+        data = begin + 1;
+        data_size = size - 1 < (int)nRF24L01_PAYLOAD_SIZE ? size - 1 : (int)nRF24L01_PAYLOAD_SIZE;
+    }
+
+    const uint8_t prefix[] = {size, cmd, begin[0]};
+
+    emit(HEAD(nRF24L01_TRACE_XCHG, 0), prefix, sizeof(prefix), data, data_size);
+}
+
+static
+void ce_set(nRF24L01_ce_t ce)
+{
+    (*trace_.ce_set)(ce);
+    emit(HEAD(nRF24L01_TRACE_CE, ce.CE), NULL, 0, NULL, 0);
+}
+
+void nRF24L01_trace_init(uint8_t *buf, uint16_t size, nRF24L01_trace_clock_t clock)
+{
+    static const uint8_t header[] = {'n', 'R', 'T', nRF24L01_TRACE_VERSION};
+
+    trace_.buf = buf;
+    trace_.mask = size - 1;
+    trace_.head = 0;
+    trace_.tail = 0;
+    trace_.lost = 0;
+    trace_.clock = clock;
+    trace_.time = (*clock)();
+    put(header, header + sizeof(header));
+}
+
+nRF24L01_spi_xchg_t nRF24L01_trace_spi_xchg(nRF24L01_spi_xchg_t xchg)
+{
+    trace_.spi_xchg = xchg;
+    return spi_xchg;
+}
+
+nRF24L01_ce_set_t nRF24L01_trace_ce_set(nRF24L01_ce_set_t set)
+{
+    trace_.ce_set = set;
+    return ce_set;
+}
+
+void nRF24L01_trace_irq(void)
+{
+    emit(HEAD(nRF24L01_TRACE_IRQ, 0), NULL, 0, NULL, 0);
+}
+
+void nRF24L01_trace_begin(nRF24L01_spi_xchg_t xchg, uint8_t op, uint16_t arg)
+{
+    if(spi_xchg != xchg) return;
+
+    uint8_t prefix[3];
+
+    emit(HEAD(nRF24L01_TRACE_BEGIN_OP, op), prefix, varint(prefix, arg), NULL, 0);
+}
+
+void nRF24L01_trace_end(nRF24L01_spi_xchg_t xchg, uint8_t op)
+{
+    if(spi_xchg != xchg) return;
+
+    emit(HEAD(nRF24L01_TRACE_END_OP, op), NULL, 0, NULL, 0);
+}
+
+uint16_t nRF24L01_trace_read(uint8_t *begin, const uint8_t *const end)
+{
+    const uint16_t avail = trace_.head - trace_.tail;
+    const uint16_t size = (size_t)(end - begin) < avail ? (uint16_t)(end - begin) : avail;
+
+    for(uint16_t i = 0; i < size; ++i) begin[i] = trace_.buf[trace_.tail++ & trace_.mask];
+    return size;
+}
+
+uint16_t nRF24L01_trace_lost(void)
+{
+    return trace_.lost;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "nRF24L01.h"
+
+/* SPI/CE/IRQ trace (portable, AVR and host).
+ *
+ * Wrappers around spi_xchg/ce_set record every transaction and CE edge,
+ * driver (built with -DnRF24L01_TRACE) records boundaries of API calls
+ * (nRF24L01_TRACE_OP_*) so traffic can be attributed to operations.
+ * Records go to RAM ring, trace is drained by nRF24L01_trace_read() (i.e.
+ * to USART or file), records which do not fit are dropped and counted.
+ * Single device (the one bound to wrappers) is traced.
+ *
+ * Stream: 'n' 'R' 'T' nRF24L01_TRACE_VERSION, then records:
+ *   head: type << 5 | x
+ *   dt: LEB128, clock ticks since previous record
+ *   XCHG  x = 0  : size, MOSI[0], MISO[0], data
+ *                  data: MOSI[1..] (W_REGISTER), MISO[1..] (R_REGISTER,
+ *                  R_RX_PAYLOAD), none for other commands
+ *   CE    x = CE
+ *   IRQ   x = 0
+ *   BEGIN x = op : arg (LEB128)
+ *   END   x = op
+ *   LOST  x = 0  : number of records dropped (LEB128)
+ * nRF24L01_trace_replay (host) replays stream against driver. */
+
+#define nRF24L01_TRACE_VERSION 1
+
+#define nRF24L01_TRACE_XCHG 0
+#define nRF24L01_TRACE_CE 1
+#define nRF24L01_TRACE_IRQ 2
+#define nRF24L01_TRACE_BEGIN_OP 3
+#define nRF24L01_TRACE_END_OP 4
+#define nRF24L01_TRACE_LOST 5
+
+#define nRF24L01_TRACE_TYPE(head) ((head) >> 5)
+#define nRF24L01_TRACE_X(head) ((head) & 0x1F)
+
+/* head + dt + size/MOSI[0]/MISO[0] + data */
+#define nRF24L01_TRACE_RECORD_MAX (1 + 5 + 3 + nRF24L01_PAYLOAD_SIZE)
+
+typedef
+uint32_t (*nRF24L01_trace_clock_t)(void);
+
+/* size must be power of 2, clock in us */
+void nRF24L01_trace_init(uint8_t *buf, uint16_t size, nRF24L01_trace_clock_t);
+
+/* wrap callbacks before passing them to nRF24L01_init() */
+nRF24L01_spi_xchg_t nRF24L01_trace_spi_xchg(nRF24L01_spi_xchg_t);
+nRF24L01_ce_set_t nRF24L01_trace_ce_set(nRF24L01_ce_set_t);
+
+/* IRQ asserted (before nRF24L01_event() dispatch) */
+void nRF24L01_trace_irq(void);
+
+/* drains ring, returns number of bytes copied */
+uint16_t nRF24L01_trace_read(uint8_t *begin, const uint8_t *const end);
+
+/* records dropped since last record which fit */
+uint16_t nRF24L01_trace_lost(void);
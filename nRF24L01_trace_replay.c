@@ -0,0 +1,474 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nRF24L01.h"
+#include "nRF24L01_trace.h"
+
+/* Replays SPI trace (nRF24L01_trace.h) against driver: API calls recorded
+ * in trace are repeated, driver transactions and CE edges are checked against
+ * trace (command, size, register data) and answered with recorded MISO data.
+ * Any difference in command sequence (extra, missing or changed transaction)
+ * fails replay. Transactions issued by application (outside of driver API,
+ * including nRF24L01_CFG) are not checked.
+ *
+ * Prints JSON line per operation (calls, transactions, bytes, CE edges,
+ * inclusive time) and summary line, exit status is non-zero if replay fails.
+ * Trace with gap (dropped records) is not replayed.
+ *
+ * usage: nRF24L01_trace_replay TRACE */
+
+#define W_REGISTER_DATA_MAX 5
+#define DEPTH_MAX 8
+#define APP nRF24L01_TRACE_OP_NUM
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t x;
+    uint32_t time; // us, absolute
+    uint32_t arg; // BEGIN: argument, LOST: count
+    uint8_t size; // XCHG
+    uint8_t mosi;
+    uint8_t miso;
+    uint8_t data_size;
+    uint8_t data[nRF24L01_PAYLOAD_SIZE];
+} record_t;
+
+typedef struct
+{
+    uint32_t calls;
+    uint32_t xchg;
+    uint32_t bytes;
+    uint32_t ce;
+    uint32_t time;
+} op_stat_t;
+
+static const char *const op_name_[APP + 1] =
+{
+    "init", "event", "send", "recv", "rpd", "read_reg", "write_reg", "cfg",
+    "status", "transceive", "cancel", "power", "app"
+};
+
+static record_t *rec_;
+static size_t rec_num_;
+static size_t cursor_;
+static nRF24L01_t dev_;
+static jmp_buf fail_;
+static char error_[160];
+static uint8_t buf_[UINT16_MAX + 1];
+
+/* parsing ------------------------------------------------------------------*/
+
+static
+const uint8_t *varint(const uint8_t *begin, const uint8_t *const end, uint32_t *value)
+{
+    *value = 0;
+    for(uint8_t shift = 0; begin != end && 32 > shift; shift += 7)
+    {
+        const uint8_t byte = *begin++;
+
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return begin;
+    }
+    return NULL;
+}
+
+static
+uint8_t data_size(uint8_t cmd, uint8_t size)
+{
+    if(!size) return 0;
+    if(nRF24L01_W_REGISTER(0) == (cmd & 0xE0))
+    {
+        return size - 1 < W_REGISTER_DATA_MAX ? size - 1 : W_REGISTER_DATA_MAX;
+    }
+    if(nRF24L01_R_REGISTER(0) == (cmd & 0xE0) || nRF24L01_R_RX_PAYLOAD == cmd)
+    {
+        return size - 1 < (int)nRF24L01_PAYLOAD_SIZE ? size - 1 : (int)nRF24L01_PAYLOAD_SIZE;
+    }
+    return 0;
+}
+
+/* returns number of records, -1 on malformed trace */
+static
+long parse(const uint8_t *begin, const uint8_t *const end)
+{
+    static const uint8_t header[] = {'n', 'R', 'T', nRF24L01_TRACE_VERSION};
+    size_t capacity = 0;
+    uint32_t time = 0;
+
+    if((size_t)(end - begin) < sizeof(header) || memcmp(begin, header, sizeof(header)))
+    {
+        return -1;
+    }
+    begin += sizeof(header);
+
+    while(begin != end)
+    {
+        if(capacity == rec_num_)
+        {
+            capacity = capacity ? 2 * capacity : 1024;
+            rec_ = realloc(rec_, capacity * sizeof(record_t));
+            if(!rec_) return -1;
+        }
+
+        record_t *rec = rec_ + rec_num_;
+        uint32_t dt;
+
+        memset(rec, 0, sizeof(record_t));
+        rec->type = nRF24L01_TRACE_TYPE(*begin);
+        rec->x = nRF24L01_TRACE_X(*begin);
+        ++begin;
+        if(!(begin = varint(begin, end, &dt))) return -1;
+        time += dt;
+        rec->time = time;
+
+        switch(rec->type)
+        {
+            case nRF24L01_TRACE_XCHG:
+                if(3 > end - begin) return -1;
+                rec->size = begin[0];
+                rec->mosi = begin[1];
+                rec->miso = begin[2];
+                begin += 3;
+                rec->data_size = data_size(rec->mosi, rec->size);
+                if(rec->data_size > end - begin) return -1;
+                memcpy(rec->data, begin, rec->data_size);
+                begin += rec->data_size;
+                break;
+            case nRF24L01_TRACE_BEGIN_OP:
+            case nRF24L01_TRACE_LOST:
+                if(!(begin = varint(begin, end, &rec->arg))) return -1;
+                break;
+            case nRF24L01_TRACE_CE:
+            case nRF24L01_TRACE_IRQ:
+            case nRF24L01_TRACE_END_OP:
+                break;
+            default:
+                return -1;
+        }
+        ++rec_num_;
+    }
+    return rec_num_;
+}
+/*----------------------------------------------------------------------------*/
+
+/* recorded traffic per operation, attributed to innermost operation */
+static
+void stat(op_stat_t *op_stat, uint32_t *irq, uint32_t *lost)
+{
+    uint8_t stack[DEPTH_MAX];
+    uint32_t begin[DEPTH_MAX];
+    uint8_t depth = 0;
+
+    for(size_t i = 0; i < rec_num_; ++i)
+    {
+        const record_t *rec = rec_ + i;
+        op_stat_t *curr = op_stat + (depth ? stack[depth - 1] : APP);
+
+        switch(rec->type)
+        {
+            case nRF24L01_TRACE_XCHG:
+                ++curr->xchg;
+                curr->bytes += rec->size;
+                break;
+            case nRF24L01_TRACE_CE:
+                ++curr->ce;
+                break;
+            case nRF24L01_TRACE_IRQ:
+                ++*irq;
+                break;
+            case nRF24L01_TRACE_LOST:
+                *lost += rec->arg;
+                /* nesting is unknown after gap */
+                depth = 0;
+                break;
+            case nRF24L01_TRACE_BEGIN_OP:
+                if(APP <= rec->x) break;
+                ++op_stat[rec->x].calls;
+                if(DEPTH_MAX > depth)
+                {
+                    stack[depth] = rec->x;
+                    begin[depth] = rec->time;
+                    ++depth;
+                }
+                break;
+            case nRF24L01_TRACE_END_OP:
+                if(depth && rec->x == stack[depth - 1])
+                {
+                    --depth;
+                    op_stat[rec->x].time += rec->time - begin[depth];
+                }
+                break;
+        }
+    }
+}
+
+/* replay -------------------------------------------------------------------*/
+
+__attribute__((noreturn, format(printf, 1, 2)))
+static
+void fail(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(error_, sizeof(error_), fmt, args);
+    va_end(args);
+    longjmp(fail_, 1);
+}
+
+/* IRQ records are informational */
+static
+const record_t *peek(void)
+{
+    while(cursor_ < rec_num_ && nRF24L01_TRACE_IRQ == rec_[cursor_].type) ++cursor_;
+    return cursor_ < rec_num_ ? rec_ + cursor_ : NULL;
+}
+
+static
+const record_t *expect(uint8_t type, const char *what)
+{
+    const record_t *rec = peek();
+
+    if(!rec || type != rec->type)
+    {
+        fail("record %zu: driver issued %s, trace has %s",
+            cursor_, what, rec ? "other record" : "end of trace");
+    }
+    ++cursor_;
+    return rec;
+}
+
+static
+void spi_xchg(uint8_t *begin, const uint8_t *const end)
+{
+    const uint8_t size = end - begin;
+
+    if(!size) return;
+
+    const record_t *rec = expect(nRF24L01_TRACE_XCHG, "SPI transaction");
+
+    if(rec->mosi != begin[0] || rec->size != size)
+    {
+        fail("record %zu: driver issued cmd 0x%02X size %u, trace has cmd 0x%02X size %u",
+            cursor_ - 1, begin[0], size, rec->mosi, rec->size);
+    }
+    if(
+        nRF24L01_W_REGISTER(0) == (rec->mosi & 0xE0)
+        && memcmp(begin + 1, rec->data, rec->data_size))
+    {
+        fail("record %zu: register 0x%02X written with different data",
+            cursor_ - 1, rec->mosi & 0x1F);
+    }
+
+    begin[0] = rec->miso;
+    if(nRF24L01_W_REGISTER(0) != (rec->mosi & 0xE0))
+    {
+        memcpy(begin + 1, rec->data, rec->data_size);
+    }
+}
+
+static
+void ce_set(nRF24L01_ce_t ce)
+{
+    const record_t *rec = expect(nRF24L01_TRACE_CE, "CE edge");
+
+    if(rec->x != ce.CE) fail("record %zu: driver set CE %u, trace has %u", cursor_ - 1, ce.CE, rec->x);
+}
+
+static
+void app(void);
+
+static
+void on_sent(uintptr_t user_data)
+{
+    app();
+}
+
+static
+void on_recv(uint8_t *curr, uint8_t pipe_no, uintptr_t user_data)
+{
+    app();
+}
+
+static
+void on_error(nRF24L01_status_t status, nRF24L01_fifo_status_t fifo_status, uintptr_t user_data)
+{
+    app();
+}
+
+static
+void execute(const record_t *begin)
+{
+    const uint8_t op = begin->x;
+    const uint16_t arg = begin->arg;
+
+    switch(op)
+    {
+        case nRF24L01_TRACE_OP_INIT:
+            nRF24L01_init(&dev_, ce_set, spi_xchg);
+            break;
+        case nRF24L01_TRACE_OP_EVENT:
+            dev_.updated = 1;
+            nRF24L01_event(&dev_);
+            break;
+        case nRF24L01_TRACE_OP_SEND:
+            nRF24L01_send(&dev_, buf_, buf_ + arg, on_sent, on_error, 0);
+            break;
+        case nRF24L01_TRACE_OP_RECV:
+            nRF24L01_recv(&dev_, buf_, buf_ + arg, on_recv, on_error, 0);
+            break;
+        case nRF24L01_TRACE_OP_RPD:
+            nRF24L01_rpd(&dev_);
+            break;
+        case nRF24L01_TRACE_OP_READ_REG:
+            nRF24L01_read_register(&dev_, arg);
+            break;
+        case nRF24L01_TRACE_OP_WRITE_REG:
+        {
+            /* data is not argument, take it from transaction */
+            const record_t *rec = peek();
+
+            if(!rec || nRF24L01_TRACE_XCHG != rec->type) fail("record %zu: write_reg without transaction", cursor_);
+            nRF24L01_write_register(&dev_, arg, rec->data, rec->data + rec->data_size);
+            break;
+        }
+        case nRF24L01_TRACE_OP_STATUS:
+            nRF24L01_status(&dev_);
+            break;
+        case nRF24L01_TRACE_OP_TRANSCEIVE:
+            nRF24L01_transceive(
+                &dev_,
+                buf_, buf_ + (arg & 0xFF),
+                buf_, buf_ + (arg >> 8),
+                on_sent, on_recv, on_error, 0);
+            break;
+        case nRF24L01_TRACE_OP_CANCEL:
+            nRF24L01_cancel(&dev_);
+            break;
+        case nRF24L01_TRACE_OP_POWER:
+            if(arg) nRF24L01_power_up(&dev_);
+            else nRF24L01_power_down(&dev_);
+            break;
+        case nRF24L01_TRACE_OP_CFG:
+            /* application side (macro), not checked */
+            app();
+            break;
+        default:
+            fail("record %zu: unknown operation %u", cursor_ - 1, op);
+    }
+
+    const record_t *end = expect(nRF24L01_TRACE_END_OP, "end of operation");
+
+    if(op != end->x)
+    {
+        fail("record %zu: %s ended, trace has end of %s",
+            cursor_ - 1, op_name_[op], APP > end->x ? op_name_[end->x] : "?");
+    }
+}
+
+/* application level: repeats recorded API calls, consumes direct accesses,
+ * returns at end of enclosing operation (callback) or trace */
+static
+void app(void)
+{
+    const record_t *rec;
+
+    while((rec = peek()) && nRF24L01_TRACE_END_OP != rec->type)
+    {
+        ++cursor_;
+        if(nRF24L01_TRACE_BEGIN_OP == rec->type) execute(rec);
+    }
+}
+/*----------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    if(2 != argc)
+    {
+        fprintf(stderr, "usage: %s TRACE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    uint8_t *trace = NULL;
+    size_t size = 0;
+
+    if(!file)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    for(size_t capacity = 0; !feof(file) && !ferror(file);)
+    {
+        if(capacity == size)
+        {
+            capacity = capacity ? 2 * capacity : 65536;
+            trace = realloc(trace, capacity);
+            if(!trace) abort();
+        }
+        size += fread(trace + size, 1, capacity - size, file);
+    }
+    fclose(file);
+
+    if(0 > parse(trace, trace + size))
+    {
+        fprintf(stderr, "%s: malformed trace\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    op_stat_t op_stat[APP + 1];
+    uint32_t irq = 0;
+    uint32_t lost = 0;
+    const char *result = "ok";
+
+    memset(op_stat, 0, sizeof(op_stat));
+    stat(op_stat, &irq, &lost);
+
+    if(lost) result = "skipped";
+    else if(setjmp(fail_))
+    {
+        fprintf(stderr, "replay: %s\n", error_);
+        result = "mismatch";
+    }
+    else
+    {
+        /* trace may start after init */
+        dev_.spi_xchg = spi_xchg;
+        dev_.ce_set = ce_set;
+        cursor_ = 0;
+        while(peek())
+        {
+            app();
+            /* END without BEGIN (trace started inside operation) */
+            if(peek()) ++cursor_;
+        }
+    }
+
+    uint32_t xchg = 0;
+    uint32_t bytes = 0;
+    uint32_t ce = 0;
+
+    for(uint8_t op = 0; op <= APP; ++op)
+    {
+        const op_stat_t *s = op_stat + op;
+
+        xchg += s->xchg;
+        bytes += s->bytes;
+        ce += s->ce;
+        if(!s->calls && !s->xchg && !s->ce) continue;
+        printf(
+            "{\"op\":\"%s\",\"calls\":%u,\"xchg\":%u,\"bytes\":%u,\"ce\":%u,\"time_us\":%u}\n",
+            op_name_[op], s->calls, s->xchg, s->bytes, s->ce, s->time);
+    }
+    printf(
+        "{\"records\":%zu,\"xchg\":%u,\"bytes\":%u,\"ce\":%u,\"irq\":%u,\"lost\":%u,\"replay\":\"%s\"}\n",
+        rec_num_, xchg, bytes, ce, irq, lost, result);
+
+    free(trace);
+    free(rec_);
+    return strcmp("ok", result) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 #include <bootloader/fixed.h>
 
 #include "cyclic_timer.h"
+#include "dlog_usart0.h"
 #include "nRF24L01.h"
 
 // nRF IRQ      PC.2/PCINT10       pin: A2 pro-mini
@@ -163,7 +164,7 @@ void on_send_error(
     nRF24L01_t *dev = (nRF24L01_t *)user_data;
 
     dev->ce_set((nRF24L01_ce_t){.CE = 0});
-    usart0_send_str("send_err\n");
+    DLOG(SEND_ERROR, status.value, fifo_status.value);
 }
 
 uint16_t cntr;
@@ -222,20 +223,23 @@ void main(void)
     {
         cli();
         {
-            usart0_send_str("+\n");
-
             /* TODO: do event dispatch once per main event loop
              * provide periodic timer, for now dispatch all events to avoid
              * missing some */
             while(0 == (PINC & M1(PINC2)))
             {
-                usart0_send_str("*\n");
+                DLOG(EVENT);
                 dev.updated = 1;
                 nRF24L01_event(&dev);
             }
         }
+        /* log is sent by USART interrupt while CPU sleeps,
+         * wakeups it causes are not logged */
+        const uint8_t idle = !dlog_usart0_drain();
+
         sei();
         sleep_cpu();
+        if(idle) DLOG(WAKEUP);
     }
 }
 
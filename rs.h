@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Systematic Reed-Solomon erasure code over GF(2^8) (Cauchy matrix).
+ *
+ * data_num fragments of equal size are protected with parity_num parity
+ * fragments, any data_num out of data_num + parity_num fragments are
+ * enough to reconstruct data. Fragments are stored back to back.
+ * Data fragments can be encoded one by one (i.e. while being sent). */
+
+#define RS_DATA_MAX_NUM 32
+#define RS_PARITY_MAX_NUM 4
+
+/* adds contribution of data fragment [index] to parity fragments,
+ * parity has to be zeroed before first fragment is added */
+void rs_encode(
+    uint8_t index, const uint8_t *fragment, uint8_t data_num,
+    uint8_t *parity, uint8_t parity_num,
+    uint8_t size);
+
+/* bit N of data_present/parity_present: fragment N was received,
+ * missing data fragments are reconstructed in place,
+ * returns 0 if there are not enough fragments */
+uint8_t rs_decode(
+    uint8_t *data, uint8_t data_num, uint32_t data_present,
+    const uint8_t *parity, uint8_t parity_num, uint32_t parity_present,
+    uint8_t size);
@@ -0,0 +1,228 @@
+#include "timer_wheel.h"
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include <drv/tmr1.h>
+
+#define BUCKET_NUM TMR_WHEEL_BUCKET_NUM
+#define BUCKET_SHIFT TMR_WHEEL_BUCKET_SHIFT
+#define BUCKET_MASK (BUCKET_NUM - 1)
+#define BUCKET(t) (((t) >> BUCKET_SHIFT) & BUCKET_MASK)
+/* counter wrap is detected only if it is read at least once per 2^16 ticks */
+#define WAKEUP_MAX INT32_C(0x8000)
+/* compare value must be ahead of counter when written */
+#define WAKEUP_MIN INT32_C(2)
+
+#if BUCKET_NUM & BUCKET_MASK
+#error "TMR_WHEEL_BUCKET_NUM must be power of 2"
+#endif
+
+static tmr_wheel_link_t bucket[BUCKET_NUM];
+static uint16_t epoch; // upper 16 bits of time
+static uint16_t last; // counter value at previous read
+static uint32_t cursor; // buckets were processed up to this time
+static uint32_t armed; // time compare is programmed for
+
+static
+void link_init(tmr_wheel_link_t *link)
+{
+    link->next = link;
+    link->prev = link;
+}
+
+static
+void link_remove(tmr_wheel_link_t *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link_init(link);
+}
+
+/* insert link after pos */
+static
+void link_insert(tmr_wheel_link_t *pos, tmr_wheel_link_t *link)
+{
+    link->next = pos->next;
+    link->prev = pos;
+    pos->next->prev = link;
+    pos->next = link;
+}
+
+/* interrupts must be disabled */
+static
+uint32_t now(void)
+{
+    const uint16_t cntr = TCNT1;
+
+    if(cntr < last) ++epoch;
+    last = cntr;
+    return (uint32_t)epoch << 16 | cntr;
+}
+
+static
+void program(uint32_t time, uint32_t deadline)
+{
+    int32_t delta = deadline - time;
+
+    if(WAKEUP_MIN > delta) delta = WAKEUP_MIN;
+    if(WAKEUP_MAX < delta) delta = WAKEUP_MAX;
+    armed = time + delta;
+    TMR1_WR16_A((uint16_t)armed);
+}
+
+static
+void insert(tmr_wheel_timer_t *timer)
+{
+    /* overdue timer goes to first bucket to be processed */
+    const uint32_t t =
+        0 > (int32_t)(timer->deadline - cursor) ? cursor : timer->deadline;
+
+    link_insert(bucket + BUCKET(t), &timer->link);
+}
+
+/* earliest deadline, scan stops at first bucket (in wheel order) holding timer
+ * due in its slot of current rotation, all buckets are scanned only if there
+ * is no such timer (i.e. all deadlines are far away) */
+static
+void schedule(void)
+{
+    const uint32_t time = now();
+    uint32_t next = time + WAKEUP_MAX;
+
+    for(uint8_t i = 0; i < BUCKET_NUM; ++i)
+    {
+        const uint32_t slot = (time >> BUCKET_SHIFT) + i;
+        const uint32_t slot_end = (slot + 1) << BUCKET_SHIFT;
+        tmr_wheel_link_t *head = bucket + (slot & BUCKET_MASK);
+
+        for(tmr_wheel_link_t *link = head->next; link != head; link = link->next)
+        {
+            const uint32_t deadline = ((tmr_wheel_timer_t *)link)->deadline;
+
+            if(0 > (int32_t)(deadline - next)) next = deadline;
+        }
+        if(0 > (int32_t)(next - slot_end)) break;
+    }
+    program(time, next);
+}
+
+static
+void on_compare(uintptr_t unused)
+{
+    const uint32_t time = now();
+    const uint32_t span = (time >> BUCKET_SHIFT) - (cursor >> BUCKET_SHIFT);
+    const uint8_t num = span < BUCKET_NUM ? span + 1 : BUCKET_NUM;
+    tmr_wheel_link_t expired;
+
+    link_init(&expired);
+
+    for(uint8_t i = 0; i < num; ++i)
+    {
+        tmr_wheel_link_t *head = bucket + (((cursor >> BUCKET_SHIFT) + i) & BUCKET_MASK);
+
+        for(tmr_wheel_link_t *link = head->next; link != head;)
+        {
+            tmr_wheel_link_t *next = link->next;
+
+            if(0 >= (int32_t)(((tmr_wheel_timer_t *)link)->deadline - time))
+            {
+                link_remove(link);
+                link_insert(expired.prev, link);
+            }
+            link = next;
+        }
+    }
+    cursor = time;
+
+    /* callbacks may start/cancel any timer (including expired ones) */
+    while(expired.next != &expired)
+    {
+        tmr_wheel_timer_t *timer = (tmr_wheel_timer_t *)expired.next;
+
+        link_remove(&timer->link);
+        if(timer->period)
+        {
+            timer->deadline += timer->period;
+            /* periods missed due to interrupt latency are skipped */
+            if(0 >= (int32_t)(timer->deadline - time))
+            {
+                timer->deadline = time + timer->period;
+            }
+            insert(timer);
+        }
+        if(timer->cb) (*timer->cb)(timer->user_data);
+    }
+    schedule();
+}
+
+void tmr_wheel_init(void)
+{
+    for(uint8_t i = 0; i < BUCKET_NUM; ++i) link_init(bucket + i);
+
+    epoch = 0;
+    last = 0;
+    cursor = 0;
+
+    TMR1_CLK_DISABLE();
+    TMR1_A_INT_DISABLE();
+    /* normal mode (WGM1[3:0] == 0), counter runs free */
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TMR1_WR16_CNTR(0);
+    timer1_cb(on_compare, 0);
+    program(0, WAKEUP_MAX);
+    TMR1_A_INT_CLEAR();
+    TMR1_A_INT_ENABLE();
+    /* 16MHz / 1024 = 15625Hz = 64us */
+    TMR1_CLK_DIV_1024();
+}
+
+uint32_t tmr_wheel_now(void)
+{
+    uint32_t time;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        time = now();
+    }
+    return time;
+}
+
+void tmr_wheel_start(
+    tmr_wheel_timer_t *timer,
+    uint32_t delay,
+    uint32_t period,
+    timer_cb_t cb,
+    uintptr_t user_data)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        const uint32_t time = now();
+
+        if(tmr_wheel_active(timer)) link_remove(&timer->link);
+
+        timer->deadline = time + delay;
+        timer->period = period;
+        timer->cb = cb;
+        timer->user_data = user_data;
+        insert(timer);
+
+        if(0 > (int32_t)(timer->deadline - armed)) program(time, timer->deadline);
+    }
+}
+
+void tmr_wheel_cancel(tmr_wheel_timer_t *timer)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        /* compare stays armed, spurious wakeup is harmless */
+        if(tmr_wheel_active(timer)) link_remove(&timer->link);
+    }
+}
+
+uint8_t tmr_wheel_active(const tmr_wheel_timer_t *timer)
+{
+    /* zero initialized timer is inactive */
+    return timer->link.next && timer->link.next != &timer->link;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <drv/tmrx.h>
+
+/* Software timers multiplexed on Timer1 (hashed timer wheel, tickless).
+ *
+ * Timers are kept in TMR_WHEEL_BUCKET_NUM buckets by deadline, each bucket
+ * covers 2^TMR_WHEEL_BUCKET_SHIFT ticks and list of timers is circular
+ * so start and cancel are O(1). Timer1 runs free (normal mode), compare A
+ * is programmed for next deadline only, callbacks are called from
+ * TIMER1_COMPA interrupt. Compare is also programmed at least every 2^15
+ * ticks to keep track of counter wrap (TIMER1_OVF is not used).
+ *
+ * Takes over Timer1, can not be used together with cyclic_tmr_*().
+ * Tick is 64us (16MHz / 1024). */
+
+#ifndef TMR_WHEEL_BUCKET_NUM
+#define TMR_WHEEL_BUCKET_NUM 16 // power of 2
+#endif
+
+#ifndef TMR_WHEEL_BUCKET_SHIFT
+#define TMR_WHEEL_BUCKET_SHIFT 6 // 64 ticks ~ 4ms per bucket
+#endif
+
+typedef struct tmr_wheel_link
+{
+    struct tmr_wheel_link *next;
+    struct tmr_wheel_link *prev;
+} tmr_wheel_link_t;
+
+typedef struct
+{
+    tmr_wheel_link_t link; // must be first
+    uint32_t deadline; // ticks
+    uint32_t period; // ticks, 0: one-shot
+    timer_cb_t cb;
+    uintptr_t user_data;
+} tmr_wheel_timer_t;
+
+void tmr_wheel_init(void);
+
+/* ticks since init() */
+uint32_t tmr_wheel_now(void);
+
+/* (re)starts timer, first expiry after delay ticks then every period ticks
+ * (0: one-shot, missed periods are skipped), timer must stay valid until
+ * expired/canceled */
+void tmr_wheel_start(
+    tmr_wheel_timer_t *,
+    uint32_t delay,
+    uint32_t period,
+    timer_cb_t,
+    uintptr_t user_data);
+
+/* safe to call for inactive timer and from timer callbacks */
+void tmr_wheel_cancel(tmr_wheel_timer_t *);
+
+uint8_t tmr_wheel_active(const tmr_wheel_timer_t *);
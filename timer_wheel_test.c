@@ -0,0 +1,93 @@
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include <drv/usart0.h>
+#include <drv/watchdog.h>
+
+#include <bootloader/fixed.h>
+
+#include "dlog_usart0.h"
+#include "timer_wheel.h"
+
+/* Timer wheel test, periodic timers (1s, 250ms, 20ms) and one-shot timer
+ * re-armed with varying delay log expiry lateness (ticks after deadline),
+ * fast timer is logged only every 50th expiry. One-shot cancels and
+ * restarts fast timer on every 8th expiry. */
+
+/* 64us ticks */
+#define SLOW_PERIOD UINT32_C(15625)
+#define MID_PERIOD UINT32_C(3906)
+#define FAST_PERIOD UINT32_C(312)
+#define FAST_LOG 50
+#define ONESHOT_MIN UINT32_C(100)
+#define ONESHOT_MAX UINT32_C(40000) // beyond wheel rotation
+
+enum
+{
+    SLOW,
+    MID,
+    FAST,
+    ONESHOT,
+    TMR_NUM
+};
+
+static tmr_wheel_timer_t tmr[TMR_NUM];
+static uint16_t fast_cntr;
+static uint8_t oneshot_cntr;
+static uint32_t delay = ONESHOT_MIN;
+
+static
+void on_expiry(uintptr_t id)
+{
+    const uint32_t time = tmr_wheel_now();
+    /* periodic timer deadline is already moved to next period */
+    const uint32_t deadline = tmr[id].deadline - tmr[id].period;
+
+    if(FAST == id && ++fast_cntr % FAST_LOG) return;
+    DLOG(TMR_WHEEL, id, time - deadline);
+
+    if(ONESHOT != id) return;
+
+    if(!(++oneshot_cntr % 8))
+    {
+        tmr_wheel_cancel(tmr + FAST);
+        tmr_wheel_start(tmr + FAST, FAST_PERIOD, FAST_PERIOD, on_expiry, FAST);
+    }
+    delay = delay * 3 % ONESHOT_MAX + ONESHOT_MIN;
+    tmr_wheel_start(tmr + ONESHOT, delay, 0, on_expiry, ONESHOT);
+}
+
+__attribute__((noreturn))
+void main(void)
+{
+    /* watchdog is enabled by bootloader whenever it "jumps" to app code */
+    fixed__.app_reset_code.curr = RESET_CODE_APP_IDLE;
+    watchdog_disable();
+
+    USART0_BR(CALC_BR(CPU_CLK, 19200));
+    USART0_PARITY_EVEN();
+    USART0_TX_ENABLE();
+
+    /* set SMCR SE (Sleep Enable bit) */
+    sleep_enable();
+    usart0_send_str("TIMER WHEEL\n");
+
+    tmr_wheel_init();
+    tmr_wheel_start(tmr + SLOW, SLOW_PERIOD, SLOW_PERIOD, on_expiry, SLOW);
+    tmr_wheel_start(tmr + MID, MID_PERIOD, MID_PERIOD, on_expiry, MID);
+    tmr_wheel_start(tmr + FAST, FAST_PERIOD, FAST_PERIOD, on_expiry, FAST);
+    tmr_wheel_start(tmr + ONESHOT, delay, 0, on_expiry, ONESHOT);
+    sei();
+
+    for(;;)
+    {
+        /* log is sent by USART interrupt while CPU sleeps,
+         * wakeups it causes are not logged */
+        cli();
+        const uint8_t idle = !dlog_usart0_drain();
+
+        sei();
+        sleep_cpu();
+        if(idle) DLOG(WAKEUP);
+    }
+}
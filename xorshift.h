@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+/* xorshift32 PRNG (Marsaglia), state must not be 0 */
+static inline
+uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}